@@ -97,7 +97,7 @@ RenderingContext::RenderingContext(QObject* parent)
         auto geometry_service = std::make_unique<TileLoadService>("https://alpinemaps.cg.tuwien.ac.at/tiles/alpine_png/", TilePattern::ZXY, ".png");
         m->geometry = nucleus::tile::setup::geometry_scheduler(std::move(geometry_service), m->aabb_decorator, m->scheduler_thread.get());
         m->scheduler_director->check_in("geometry", m->geometry.scheduler);
-        m->data_querier = std::make_shared<DataQuerier>(&m->geometry.scheduler->ram_cache());
+        m->data_querier = std::make_shared<DataQuerier>(&m->geometry.scheduler->ram_cache(), m->aabb_decorator);
         
         // auto ortho_service = std::make_unique<TileLoadService>("https://gataki.cg.tuwien.ac.at/raw/basemap/tiles/", TilePattern::ZYX_yPointingSouth, ".jpeg");
         auto ortho_service = std::make_unique<TileLoadService>("https://mapsneu.wien.gv.at/basemap/bmaporthofoto30cm/normal/google3857/", TilePattern::ZYX_yPointingSouth, ".jpeg");
@@ -188,10 +188,12 @@ void RenderingContext::initialise()
     const auto texture_compression = gl_engine::Texture::compression_algorithm();
     nucleus::utils::thread::async_call(m->ortho_texture.scheduler.get(), [this, texture_compression]() {
         m->ortho_texture.scheduler->set_texture_compression_algorithm(texture_compression);
+        m->ortho_texture.scheduler->set_texture_disk_cache_enabled(true);
         m->ortho_texture.scheduler->set_enabled(true);
     });
     nucleus::utils::thread::async_call(m->surfaceshaded_texture.scheduler.get(), [this, texture_compression]() {
         m->surfaceshaded_texture.scheduler->set_texture_compression_algorithm(texture_compression);
+        m->surfaceshaded_texture.scheduler->set_texture_disk_cache_enabled(true);
         m->surfaceshaded_texture.scheduler->set_enabled(true);
     });
     nucleus::utils::thread::async_call(m->eaws_texture.scheduler.get(), [this]() { m->eaws_texture.scheduler->set_enabled(true); });
@@ -49,12 +49,8 @@ QPointF TrackModel::lat_long(unsigned int index)
 {
     if (index >= unsigned(m_data.size()))
         return {};
-    const auto track = m_data.at(index);
-    if (0 < track.track.size() && 0 < track.track[0].size()) {
-        auto track_start = track.track[0][0];
-        return { track_start.latitude, track_start.longitude };
-    }
-    return {};
+    const auto& start = m_data.at(index).start_lat_long;
+    return { start.x, start.y };
 }
 
 #ifdef __EMSCRIPTEN__
@@ -97,9 +93,10 @@ void TrackModel::upload_track()
         (void)fileContent;
         QXmlStreamReader xmlReader(fileContent);
 
-        std::unique_ptr<nucleus::track::Gpx> gpx = nucleus::track::parse(xmlReader);
-        if (gpx != nullptr) {
-            m_data.push_back(*gpx);
+        // smoothed and transformed to world coordinates while streaming, no Gpx with all points is built
+        std::optional<nucleus::track::WorldTrack> track = nucleus::track::load_track(xmlReader);
+        if (track.has_value()) {
+            m_data.push_back(std::move(*track));
             emit tracks_changed(m_data);
         } else {
             qDebug("Could not parse GPX file!");
@@ -39,14 +39,14 @@ public slots:
     void upload_track();
 
 signals:
-    void tracks_changed(const QVector<nucleus::track::Gpx>& tracks);
+    void tracks_changed(const QVector<nucleus::track::WorldTrack>& tracks);
 
     void display_width_changed(float display_width);
 
     void shading_style_changed(unsigned int shading_style);
 
 private:
-    QVector<nucleus::track::Gpx> m_data;
+    QVector<nucleus::track::WorldTrack> m_data;
 
     float m_display_width = 7.f;
     unsigned m_shading_style = 0u;
@@ -22,7 +22,9 @@
 
 #include "webgpu/engine/Window.h"
 #include <QCoreApplication>
+#include <QDir>
 #include <QFile>
+#include <QStandardPaths>
 #include <cassert>
 #include <qthread.h> //TODO maybe only for threading enabled?
 #include <webgpu/base/webgpu_interface.hpp>
@@ -270,6 +272,7 @@ void App::start()
 
     m_camera_controller = std::make_unique<nucleus::camera::Controller>(
         nucleus::camera::PositionStorage::instance()->get("grossglockner"), m_webgpu_window.get(), m_context->data_querier());
+    m_camera_controller->set_cpu_ray_casting(true);
 
     // clang-format off
     // NOTICE ME!!!! READ THIS, IF YOU HAVE TROUBLES WITH SIGNALS NOT REACHING THE QML RENDERING THREAD!!!!111elevenone
@@ -642,6 +645,10 @@ void App::webgpu_create_context()
     qInfo() << "Got queue: " << m_queue;
 
     m_webgpu_ctx.init(m_instance, m_device, m_adapter, m_surface, m_queue);
+
+    const auto cache_dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(cache_dir);
+    m_webgpu_ctx.resource_registry().set_shader_bundle_path((cache_dir + "/shader_bundle.txt").toStdString());
 }
 
 void App::webgpu_release_context()
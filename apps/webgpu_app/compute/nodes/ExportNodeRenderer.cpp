@@ -54,6 +54,14 @@ void ExportNodeRenderer::render_settings_content()
         }
     };
 
+    int format = settings.file_format == nodes::ExportNode::FileFormat::GeoTiff ? 1 : 0;
+    if (ImGui::Combo("Format", &format, "PNG\0GeoTIFF\0")) {
+        settings.file_format = format == 1 ? nodes::ExportNode::FileFormat::GeoTiff : nodes::ExportNode::FileFormat::Png;
+        changed = true;
+    }
+    if (settings.file_format == nodes::ExportNode::FileFormat::GeoTiff && ImGui::SliderInt("Compression", &settings.compression_level, 0, 9))
+        changed = true;
+
     field("Buffer Output:", m_buffer_buf, sizeof(m_buffer_buf), settings.buffer_output_file, "buffer");
     field("Texture Output:", m_texture_buf, sizeof(m_texture_buf), settings.texture_output_file, "texture");
     field("AABB Output:", m_aabb_buf, sizeof(m_aabb_buf), settings.aabb_output_file, "region aabb");
@@ -51,7 +51,7 @@ void GPXTrackNodeRenderer::render_settings_content()
     ImGui::SameLine();
     m_want_open_dialog = ImGui::Button("Browse...");
 
-    if (ImGui::Checkbox("Cache (reload only on path change)", &settings.enable_caching)) {
+    if (ImGui::Checkbox("Cache (reload only if the file changed)", &settings.enable_caching)) {
         m_node->set_settings(settings);
         m_node->rerun();
     }
@@ -22,6 +22,7 @@
 #include "ShaderRegistry.h"
 #include "TileGeometry.h"
 #include <QOpenGLExtraFunctions>
+#include <algorithm>
 #include <TextureLayer.h>
 
 namespace gl_engine {
@@ -49,45 +50,52 @@ void gl_engine::AvalancheWarningLayer::init(ShaderRegistry* shader_registry, std
 }
 
 void AvalancheWarningLayer::draw(
-    const TileGeometry& tile_geometry, const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list) const
+    const TileGeometry& tile_geometry, const TileGeometry::InstanceBlock& instances, const std::vector<nucleus::tile::TileBounds>& draw_list) const
 {
     m_shader->bind();
     m_texture_array->bind(2);
     m_shader->set_uniform("texture_sampler", 2);
 
-    nucleus::Raster<uint8_t> zoom_level_raster = { glm::uvec2 { 1024, 1 } };
-    nucleus::Raster<uint16_t> array_index_raster = { glm::uvec2 { 1024, 1 } };
-    for (unsigned i = 0; i < std::min(unsigned(draw_list.size()), 1024u); ++i) {
-        const auto layer = m_gpu_array_helper.layer(draw_list[i].id);
-        zoom_level_raster.pixel({ i, 0 }) = layer.id.zoom_level;
-        array_index_raster.pixel({ i, 0 }) = layer.index;
-    }
+    update_instance_textures(draw_list);
 
     m_instanced_array_index->bind(7);
     m_shader->set_uniform("instanced_texture_array_index_sampler", 7);
-    m_instanced_array_index->upload(array_index_raster);
 
     m_instanced_zoom->bind(8);
     m_shader->set_uniform("instanced_texture_zoom_sampler", 8);
-    m_instanced_zoom->upload(zoom_level_raster);
 
+    // the surface shaded layer is drawn with the same draw list, its instance textures are usually up to date already
+    m_surfshaded_layer->update_instance_textures(draw_list);
     m_surfshaded_layer->m_texture_array->bind(9);
     m_shader->set_uniform("texture_sampler2", 9);
-    for (unsigned i = 0; i < std::min(unsigned(draw_list.size()), 1024u); ++i) {
-        const auto layer = m_surfshaded_layer->m_gpu_array_helper.layer(draw_list[i].id);
-        zoom_level_raster.pixel({ i, 0 }) = layer.id.zoom_level;
-        array_index_raster.pixel({ i, 0 }) = layer.index;
-    }
 
     m_surfshaded_layer->m_instanced_array_index->bind(10);
     m_shader->set_uniform("instanced_texture_array_index_sampler2", 10);
-    m_surfshaded_layer->m_instanced_array_index->upload(array_index_raster);
 
     m_surfshaded_layer->m_instanced_zoom->bind(11);
     m_shader->set_uniform("instanced_texture_zoom_sampler2", 11);
-    m_surfshaded_layer->m_instanced_zoom->upload(zoom_level_raster);
 
-    tile_geometry.draw(m_shader.get(), camera, draw_list);
+    tile_geometry.draw(m_shader.get(), instances);
+}
+
+void AvalancheWarningLayer::update_instance_textures(const std::vector<nucleus::tile::TileBounds>& draw_list) const
+{
+    const auto same_tiles = std::equal(draw_list.begin(), draw_list.end(), m_instance_texture_ids.begin(), m_instance_texture_ids.end(), [](const auto& bounds, const auto& id) {
+        return bounds.id == id;
+    });
+    if (same_tiles && !m_instance_textures_dirty)
+        return;
+
+    nucleus::Raster<uint8_t> zoom_level_raster = { glm::uvec2 { nucleus::tile::max_n_tile_instances, 1 } };
+    nucleus::Raster<uint16_t> array_index_raster = { glm::uvec2 { nucleus::tile::max_n_tile_instances, 1 } };
+    nucleus::tile::pack_texture_layers(draw_list, m_gpu_array_helper, array_index_raster, zoom_level_raster);
+    m_instanced_array_index->upload(array_index_raster);
+    m_instanced_zoom->upload(zoom_level_raster);
+
+    m_instance_texture_ids.clear();
+    for (const auto& bounds : draw_list)
+        m_instance_texture_ids.push_back(bounds.id);
+    m_instance_textures_dirty = false;
 }
 
 void AvalancheWarningLayer::update_gpu_tiles(const std::vector<nucleus::tile::Id>& deleted_tiles, const std::vector<nucleus::tile::GpuEawsTile>& new_tiles)
@@ -107,6 +115,8 @@ void AvalancheWarningLayer::update_gpu_tiles(const std::vector<nucleus::tile::Id
         const auto layer_index = m_gpu_array_helper.add_tile(tile.id);
         m_texture_array->upload(*tile.texture, layer_index);
     }
+    if (!deleted_tiles.empty() || !new_tiles.empty())
+        m_instance_textures_dirty = true;
 }
 
 void AvalancheWarningLayer::set_tile_limit(unsigned int new_limit)
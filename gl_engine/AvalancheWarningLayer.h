@@ -19,6 +19,7 @@
 #pragma once
 
 #include "Texture.h"
+#include "TileGeometry.h"
 #include <QObject>
 #include <nucleus/Raster.h>
 #include <nucleus/tile/DrawListGenerator.h>
@@ -36,7 +37,6 @@ class QOpenGLVertexArrayObject;
 namespace gl_engine {
 class ShaderRegistry;
 class ShaderProgram;
-class TileGeometry;
 class TextureLayer;
 
 class AvalancheWarningLayer : public QObject {
@@ -44,7 +44,8 @@ class AvalancheWarningLayer : public QObject {
 public:
     explicit AvalancheWarningLayer(QObject* parent = nullptr);
     void init(ShaderRegistry* shader_registry, std::shared_ptr<gl_engine::TextureLayer> surfaceshaded_layer); // needs OpenGL context
-    void draw(const TileGeometry& tile_geometry, const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list) const;
+    // instances must have been uploaded for draw_list
+    void draw(const TileGeometry& tile_geometry, const TileGeometry::InstanceBlock& instances, const std::vector<nucleus::tile::TileBounds>& draw_list) const;
 
     unsigned int tile_count() const;
 
@@ -53,6 +54,9 @@ public slots:
     void set_tile_limit(unsigned new_limit);
 
 private:
+    // repacks and uploads the instanced index and zoom textures only if the draw list or the tiles on the gpu changed since the last call
+    void update_instance_textures(const std::vector<nucleus::tile::TileBounds>& draw_list) const;
+
     const unsigned m_resolution = 512u;
 
     std::shared_ptr<ShaderProgram> m_shader;
@@ -60,6 +64,8 @@ private:
     std::unique_ptr<Texture> m_instanced_zoom;
     std::unique_ptr<Texture> m_instanced_array_index;
     nucleus::tile::GpuArrayHelper m_gpu_array_helper;
+    mutable std::vector<nucleus::tile::Id> m_instance_texture_ids;
+    mutable bool m_instance_textures_dirty = true;
     std::shared_ptr<gl_engine::TextureLayer> m_surfshaded_layer = nullptr;
 };
 } // namespace gl_engine
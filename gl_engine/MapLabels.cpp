@@ -28,6 +28,7 @@
 #include "ShaderProgram.h"
 #include "ShaderRegistry.h"
 #include "radix/tile.h"
+#include <cstddef>
 #include <nucleus/map_label/FontRenderer.h>
 #include <nucleus/srs.h>
 
@@ -72,6 +73,35 @@ void MapLabels::init(ShaderRegistry* shader_registry)
     m_index_buffer->setUsagePattern(QOpenGLBuffer::StaticDraw);
     m_index_buffer->allocate(m_mapLabelFactory.m_indices.data(), m_mapLabelFactory.m_indices.size() * sizeof(unsigned int));
     m_indices_count = m_mapLabelFactory.m_indices.size();
+
+    m_slot_texture = std::make_unique<Texture>(Texture::Target::_2d, Texture::Format::RGBA32F);
+    m_slot_texture->setParams(Texture::Filter::Nearest, Texture::Filter::Nearest);
+
+    const auto capacity = m_instance_allocator.capacity();
+    m_instance_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
+    m_instance_buffer->create();
+    m_instance_buffer->bind();
+    m_instance_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_instance_buffer->allocate(int(capacity * sizeof(nucleus::map_label::VertexData)));
+
+    const std::vector<uint32_t> unused_slots(capacity, 0);
+    m_slot_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
+    m_slot_buffer->create();
+    m_slot_buffer->bind();
+    m_slot_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_slot_buffer->allocate(unused_slots.data(), int(unused_slots.size() * sizeof(uint32_t)));
+
+    // the pointers are set per draw, they depend on the first instance of the drawn range
+    m_vao = std::make_unique<QOpenGLVertexArrayObject>();
+    m_vao->create();
+    m_vao->bind();
+    m_index_buffer->bind();
+    QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
+    for (GLuint location = 0; location < 7; ++location) {
+        f->glEnableVertexAttribArray(location);
+        f->glVertexAttribDivisor(location, 1); // buffer is active for 1 instance (for the whole quad)
+    }
+    m_vao->release();
 }
 
 MapLabels::TileSet MapLabels::generate_draw_list(const nucleus::camera::Definition& camera) const
@@ -84,63 +114,50 @@ void MapLabels::upload_to_gpu(const TileId& id, const PointOfInterestCollection&
     if (!QOpenGLContext::currentContext()) // can happen during shutdown.
         return;
 
-    std::shared_ptr<GPUVectorTile> vectortile = std::make_shared<GPUVectorTile>();
-    vectortile->id = id;
-
-    vectortile->vao = std::make_unique<QOpenGLVertexArrayObject>();
-    vectortile->vao->create();
-    vectortile->vao->bind();
-
     const auto [allLabels, reference_point, atlas_data] = m_mapLabelFactory.create_labels(features);
     if (atlas_data.changed) {
         for (unsigned int i = 0; i < atlas_data.font_atlas.size(); i++) {
             m_font_texture->upload(atlas_data.font_atlas[i], i);
         }
     }
-    vectortile->reference_point = reference_point;
-
-    { // vao state
-        m_index_buffer->bind();
-
-        vectortile->vertex_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
-        vectortile->vertex_buffer->create();
-        vectortile->vertex_buffer->bind();
-        vectortile->vertex_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
-        vectortile->vertex_buffer->allocate(allLabels.data(), allLabels.size() * sizeof(nucleus::map_label::VertexData));
-        vectortile->instance_count = allLabels.size();
-
-        QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
-
-        // vertex positions
-        f->glEnableVertexAttribArray(0);
-        f->glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(nucleus::map_label::VertexData), nullptr);
-        f->glVertexAttribDivisor(0, 1); // buffer is active for 1 instance (for the whole quad)
-        // uvs
-        f->glEnableVertexAttribArray(1);
-        f->glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(nucleus::map_label::VertexData), (GLvoid*)(sizeof(glm::vec4)));
-        f->glVertexAttribDivisor(1, 1); // buffer is active for 1 instance (for the whole quad)
-        // picker color
-        f->glEnableVertexAttribArray(2);
-        f->glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(nucleus::map_label::VertexData), (GLvoid*)(sizeof(glm::vec4) * 2));
-        f->glVertexAttribDivisor(2, 1); // buffer is active for 1 instance (for the whole quad)
-        // world position
-        f->glEnableVertexAttribArray(3);
-        f->glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(nucleus::map_label::VertexData), (GLvoid*)(sizeof(glm::vec4) * 3));
-        f->glVertexAttribDivisor(3, 1); // buffer is active for 1 instance (for the whole quad)
-        // label importance
-        f->glEnableVertexAttribArray(4);
-        f->glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, sizeof(nucleus::map_label::VertexData), (GLvoid*)((sizeof(glm::vec4) * 3 + (sizeof(glm::vec3)))));
-        f->glVertexAttribDivisor(4, 1); // buffer is active for 1 instance (for the whole quad)
-        // texture index
-        f->glEnableVertexAttribArray(5);
-        f->glVertexAttribIPointer(5, 1, GL_INT, sizeof(nucleus::map_label::VertexData), (GLvoid*)((sizeof(glm::vec4) * 3 + (sizeof(glm::vec3)) + sizeof(float))));
-        f->glVertexAttribDivisor(5, 1); // buffer is active for 1 instance (for the whole quad)
-    }
 
-    vectortile->vao->release();
+    const auto old_capacity = m_instance_allocator.capacity();
+    const auto& allocation = m_instance_allocator.allocate(id, unsigned(allLabels.size()), reference_point);
+    if (m_instance_allocator.capacity() != old_capacity)
+        grow_instance_buffers(old_capacity);
+    if (allocation.range.count == 0)
+        return;
 
-    // add vector tile to gpu tiles
-    m_gpu_tiles[id] = vectortile;
+    m_instance_buffer->bind();
+    m_instance_buffer->write(int(allocation.range.first * sizeof(nucleus::map_label::VertexData)), allLabels.data(), int(allLabels.size() * sizeof(nucleus::map_label::VertexData)));
+    const std::vector<uint32_t> slots(allocation.range.count, allocation.slot);
+    m_slot_buffer->bind();
+    m_slot_buffer->write(int(allocation.range.first * sizeof(uint32_t)), slots.data(), int(slots.size() * sizeof(uint32_t)));
+}
+
+void MapLabels::grow_instance_buffers(unsigned old_capacity)
+{
+    QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
+    const auto capacity = m_instance_allocator.capacity();
+    const auto grow = [&](std::unique_ptr<QOpenGLBuffer>& buffer, size_t bytes_per_instance) {
+        // zeroed, so that the new instances have slot 0 (i.e., are hidden)
+        const std::vector<uint8_t> zeros(capacity * bytes_per_instance, 0);
+        auto new_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
+        new_buffer->create();
+        new_buffer->bind();
+        new_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+        new_buffer->allocate(zeros.data(), int(zeros.size()));
+
+        f->glBindBuffer(GL_COPY_READ_BUFFER, buffer->bufferId());
+        f->glBindBuffer(GL_COPY_WRITE_BUFFER, new_buffer->bufferId());
+        f->glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, GLsizeiptr(old_capacity * bytes_per_instance));
+        f->glBindBuffer(GL_COPY_READ_BUFFER, 0);
+        f->glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        buffer->destroy();
+        buffer = std::move(new_buffer);
+    };
+    grow(m_instance_buffer, sizeof(nucleus::map_label::VertexData));
+    grow(m_slot_buffer, sizeof(uint32_t));
 }
 
 void MapLabels::update_labels(const std::vector<PoiTile>& updated_tiles, const std::vector<TileId>& removed_tiles)
@@ -152,7 +169,7 @@ void MapLabels::update_labels(const std::vector<PoiTile>& updated_tiles, const s
     }
 
     for (const auto& vectortile : updated_tiles) {
-        // since we are renewing the tile we remove it first to delete allocations like vao
+        // since we are renewing the tile we remove it first to free its instances
         remove_tile(vectortile.id);
 
         upload_to_gpu(vectortile.id, *vectortile.data);
@@ -165,17 +182,50 @@ void MapLabels::remove_tile(const TileId& tile_id)
     if (!QOpenGLContext::currentContext()) // can happen during shutdown.
         return;
 
-    // we can only remove something that exists
-    if (!m_gpu_tiles.contains(tile_id))
+    const auto allocation = m_instance_allocator.free(tile_id);
+    if (!allocation || allocation->range.count == 0)
         return;
 
-    if (m_gpu_tiles.at(tile_id)->vao)
-        m_gpu_tiles.at(tile_id)->vao->destroy(); // ecplicitly destroy vao
+    // the freed instances can still be drawn as part of a merged range, and the slot will be reused. point them to the hidden slot 0.
+    const std::vector<uint32_t> unused_slots(allocation->range.count, 0);
+    m_slot_buffer->bind();
+    m_slot_buffer->write(int(allocation->range.first * sizeof(uint32_t)), unused_slots.data(), int(unused_slots.size() * sizeof(uint32_t)));
+}
 
-    m_gpu_tiles.erase(tile_id);
+std::vector<nucleus::map_label::InstanceRange> MapLabels::prepare_draw(const nucleus::camera::Definition& camera, const TileSet& draw_tiles) const
+{
+    nucleus::map_label::pack_slots(m_instance_allocator, draw_tiles, camera.position(), slot_texture_width, m_packed_slots);
+    m_slot_texture->upload(m_packed_slots);
+    return nucleus::map_label::visible_ranges(m_instance_allocator, draw_tiles, max_n_draw_ranges);
 }
 
-void MapLabels::draw(Framebuffer* gbuffer, const nucleus::camera::Definition& camera, const TileSet& draw_tiles) const
+void MapLabels::set_instance_offset(unsigned first_instance) const
+{
+    using nucleus::map_label::VertexData;
+    QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
+    const auto stride = GLsizei(sizeof(VertexData));
+    const auto pointer = [&](size_t member_offset) { return reinterpret_cast<const void*>(first_instance * sizeof(VertexData) + member_offset); };
+
+    m_instance_buffer->bind();
+    // vertex positions
+    f->glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(VertexData, position)));
+    // uvs
+    f->glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(VertexData, uv)));
+    // picker color
+    f->glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(VertexData, picker_color)));
+    // world position
+    f->glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(VertexData, world_position)));
+    // label importance
+    f->glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride, pointer(offsetof(VertexData, importance)));
+    // texture index
+    f->glVertexAttribIPointer(5, 1, GL_INT, stride, pointer(offsetof(VertexData, texture_index)));
+
+    // tile slot
+    m_slot_buffer->bind();
+    f->glVertexAttribIPointer(6, 1, GL_UNSIGNED_INT, GLsizei(sizeof(uint32_t)), reinterpret_cast<const void*>(first_instance * sizeof(uint32_t)));
+}
+
+void MapLabels::draw(Framebuffer* gbuffer, const std::vector<nucleus::map_label::InstanceRange>& ranges) const
 {
     QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
 
@@ -191,28 +241,24 @@ void MapLabels::draw(Framebuffer* gbuffer, const nucleus::camera::Definition& ca
     m_font_texture->bind(1);
     m_label_shader->set_uniform("icon_sampler", 2);
     m_icon_texture->bind(2);
-
-    for (const auto& vectortile : m_gpu_tiles) {
-        if (!draw_tiles.contains(vectortile.first))
-            continue; // tile is not in draw_tiles -> look at next tile
-
-        if (vectortile.second->instance_count > 0) {
-            vectortile.second->vao->bind();
-            m_label_shader->set_uniform("reference_position", glm::vec3(vectortile.second->reference_point - camera.position()));
-
-            // if the labels wouldn't collide, we could use an extra buffer, one draw call and
-            // f->glBlendEquationSeparate(GL_MIN, GL_MAX);
-            m_label_shader->set_uniform("drawing_outline", true);
-            f->glDrawElementsInstanced(GL_TRIANGLES, m_indices_count, GL_UNSIGNED_INT, 0, vectortile.second->instance_count);
-            m_label_shader->set_uniform("drawing_outline", false);
-            f->glDrawElementsInstanced(GL_TRIANGLES, m_indices_count, GL_UNSIGNED_INT, 0, vectortile.second->instance_count);
-
-            vectortile.second->vao->release();
-        }
+    m_label_shader->set_uniform("slot_sampler", 3);
+    m_slot_texture->bind(3);
+
+    m_vao->bind();
+    for (const auto& range : ranges) {
+        set_instance_offset(range.first);
+
+        // if the labels wouldn't collide, we could use an extra buffer, one draw call and
+        // f->glBlendEquationSeparate(GL_MIN, GL_MAX);
+        m_label_shader->set_uniform("drawing_outline", true);
+        f->glDrawElementsInstanced(GL_TRIANGLES, GLsizei(m_indices_count), GL_UNSIGNED_INT, 0, GLsizei(range.count));
+        m_label_shader->set_uniform("drawing_outline", false);
+        f->glDrawElementsInstanced(GL_TRIANGLES, GLsizei(m_indices_count), GL_UNSIGNED_INT, 0, GLsizei(range.count));
     }
+    m_vao->release();
 }
 
-void MapLabels::draw_picker(Framebuffer* gbuffer, const nucleus::camera::Definition& camera, const TileSet& draw_tiles) const
+void MapLabels::draw_picker(Framebuffer* gbuffer, const std::vector<nucleus::map_label::InstanceRange>& ranges) const
 {
     QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
 
@@ -220,23 +266,17 @@ void MapLabels::draw_picker(Framebuffer* gbuffer, const nucleus::camera::Definit
     m_picker_shader->set_uniform("label_dist_scaling", true);
     m_picker_shader->set_uniform("texin_depth", 0);
     gbuffer->bind_colour_texture(1, 0);
+    m_picker_shader->set_uniform("slot_sampler", 3);
+    m_slot_texture->bind(3);
 
-    for (const auto& vectortile : m_gpu_tiles) {
-        if (!draw_tiles.contains(vectortile.first))
-            continue; // tile is not in draw_tiles -> look at next tile
-
-        // only draw if vector tile is fully loaded
-        if (vectortile.second->instance_count > 0) {
-            vectortile.second->vao->bind();
-            m_picker_shader->set_uniform("reference_position", glm::vec3(vectortile.second->reference_point - camera.position()));
-
-            f->glDrawElementsInstanced(GL_TRIANGLES, m_indices_count, GL_UNSIGNED_INT, 0, vectortile.second->instance_count);
-
-            vectortile.second->vao->release();
-        }
+    m_vao->bind();
+    for (const auto& range : ranges) {
+        set_instance_offset(range.first);
+        f->glDrawElementsInstanced(GL_TRIANGLES, GLsizei(m_indices_count), GL_UNSIGNED_INT, 0, GLsizei(range.count));
     }
+    m_vao->release();
 }
 
-unsigned MapLabels::tile_count() const { return unsigned(m_gpu_tiles.size()); }
+unsigned MapLabels::tile_count() const { return m_instance_allocator.n_tiles(); }
 
 } // namespace gl_engine
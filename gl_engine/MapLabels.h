@@ -22,13 +22,13 @@
 #include <QOpenGLBuffer>
 #include <QOpenGLTexture>
 #include <QOpenGLVertexArrayObject>
-#include <unordered_map>
 
 #include "Framebuffer.h"
 #include "Texture.h"
 #include "nucleus/camera/Definition.h"
 #include "nucleus/map_label/Factory.h"
 #include "nucleus/map_label/FilterDefinitions.h"
+#include "nucleus/map_label/InstanceAllocator.h"
 
 #include "nucleus/tile/DrawListGenerator.h"
 
@@ -38,25 +38,23 @@ namespace gl_engine {
 class ShaderProgram;
 class ShaderRegistry;
 
-struct GPUVectorTile {
-    nucleus::tile::Id id;
-    std::unique_ptr<QOpenGLBuffer> vertex_buffer;
-    std::unique_ptr<QOpenGLVertexArrayObject> vao;
-    size_t instance_count; // how many characters (+1 for icon)
-    glm::dvec3 reference_point = {};
-};
-
 class MapLabels : public QObject {
     Q_OBJECT
 
 public:
     using TileSet = nucleus::tile::DrawListGenerator::TileSet;
     using TileId = nucleus::tile::Id;
+    // draw calls per pass. the visible instance ranges are merged until there are at most this many.
+    static constexpr unsigned max_n_draw_ranges = 4;
+    static constexpr unsigned slot_texture_width = 256;
+
     explicit MapLabels(const nucleus::tile::utils::AabbDecoratorPtr& aabb_decorator, QObject* parent = nullptr);
 
     void init(ShaderRegistry* shader_registry);
-    void draw(Framebuffer* gbuffer, const nucleus::camera::Definition& camera, const TileSet& draw_tiles) const;
-    void draw_picker(Framebuffer* gbuffer, const nucleus::camera::Definition& camera, const TileSet& draw_tiles) const;
+    // uploads the slot texture and returns the instance ranges to draw. once per frame, the ranges are shared by draw and draw_picker.
+    std::vector<nucleus::map_label::InstanceRange> prepare_draw(const nucleus::camera::Definition& camera, const TileSet& draw_tiles) const;
+    void draw(Framebuffer* gbuffer, const std::vector<nucleus::map_label::InstanceRange>& ranges) const;
+    void draw_picker(Framebuffer* gbuffer, const std::vector<nucleus::map_label::InstanceRange>& ranges) const;
     TileSet generate_draw_list(const nucleus::camera::Definition& camera) const;
 
     void update_labels(const std::vector<nucleus::vector_tile::PoiTile>& updated_tiles, const std::vector<TileId>& removed_tiles);
@@ -66,19 +64,29 @@ public:
 private:
     void upload_to_gpu(const TileId& id, const PointOfInterestCollection& features);
     void remove_tile(const TileId& tile_id);
+    void grow_instance_buffers(unsigned old_capacity);
+    // points the instance attributes of the vao to first_instance (emulates base instance, which is not available in gles / webgl)
+    void set_instance_offset(unsigned first_instance) const;
 
     std::shared_ptr<ShaderProgram> m_label_shader;
     std::shared_ptr<ShaderProgram> m_picker_shader;
 
     std::unique_ptr<Texture> m_font_texture;
     std::unique_ptr<Texture> m_icon_texture;
+    std::unique_ptr<Texture> m_slot_texture;
+    mutable nucleus::Raster<glm::vec4> m_packed_slots;
 
     std::unique_ptr<QOpenGLBuffer> m_index_buffer;
     size_t m_indices_count; // how many vertices per character (most likely 6 since quads)
 
+    // labels of all tiles, sub-allocated by m_instance_allocator. the slot buffer holds the tile slot of every instance (0 for unused ones).
+    std::unique_ptr<QOpenGLBuffer> m_instance_buffer;
+    std::unique_ptr<QOpenGLBuffer> m_slot_buffer;
+    std::unique_ptr<QOpenGLVertexArrayObject> m_vao;
+    nucleus::map_label::InstanceAllocator m_instance_allocator;
+
     nucleus::map_label::Factory m_mapLabelFactory;
 
     nucleus::tile::DrawListGenerator m_draw_list_generator;
-    std::unordered_map<TileId, std::shared_ptr<GPUVectorTile>, TileId::Hasher> m_gpu_tiles;
 };
 } // namespace gl_engine
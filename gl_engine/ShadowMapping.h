@@ -21,6 +21,7 @@
 #include "UniformBuffer.h"
 #include "nucleus/camera/Definition.h"
 #include "nucleus/tile/DrawListGenerator.h"
+#include "nucleus/tile/ShadowCascadeCache.h"
 #include "types.h"
 #include <glm/glm.hpp>
 #include <memory>
@@ -50,7 +51,8 @@ public:
 
     ~ShadowMapping();
     
-    void draw(TileGeometry* tile_manager,
+    // returns the number of cascades that were redrawn
+    unsigned draw(TileGeometry* tile_manager,
         std::vector<nucleus::tile::TileBounds> draw_tileset,
         const nucleus::camera::Definition& camera,
         std::shared_ptr<UniformBuffer<uboShadowConfig>> shadow_config,
@@ -61,15 +63,11 @@ public:
 
 private:
     DepthBufferClipType m_depth_buffer_clip_type = DepthBufferClipType(-1);
+    nucleus::tile::ShadowCascadeCache m_cascade_cache;
     std::shared_ptr<ShaderProgram> m_shadow_program;
     std::vector<std::unique_ptr<Framebuffer>> m_shadowmapbuffer;
     QOpenGLExtraFunctions *m_f;
 
-    std::vector<glm::vec4> getFrustumCornersWorldSpace(const glm::mat4& projview) const;
-    std::vector<glm::vec4> getFrustumCornersWorldSpace(const glm::mat4& proj, const glm::mat4& view) const;
-    glm::mat4 getLightSpaceMatrix(const float nearPlane, const float farPlane, const nucleus::camera::Definition& camera, const glm::vec3& light_dir) const;
-    std::vector<glm::mat4> getLightSpaceMatrices(const nucleus::camera::Definition& camera, const glm::vec3& light_dir);
-
 };
 
 }
@@ -23,6 +23,7 @@
 #include "Texture.h"
 #include "TileGeometry.h"
 #include <QOpenGLExtraFunctions>
+#include <algorithm>
 
 namespace gl_engine {
 
@@ -49,29 +50,41 @@ void gl_engine::TextureLayer::init(ShaderRegistry* shader_registry)
 }
 
 void TextureLayer::draw(
-    const TileGeometry& tile_geometry, const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list) const
+    const TileGeometry& tile_geometry, const TileGeometry::InstanceBlock& instances, const std::vector<nucleus::tile::TileBounds>& draw_list) const
 {
     m_shader->bind();
     m_texture_array->bind(2);
     m_shader->set_uniform("texture_sampler", 2);
 
-    nucleus::Raster<uint8_t> zoom_level_raster = { glm::uvec2 { 1024, 1 } };
-    nucleus::Raster<uint16_t> array_index_raster = { glm::uvec2 { 1024, 1 } };
-    for (unsigned i = 0; i < std::min(unsigned(draw_list.size()), 1024u); ++i) {
-        const auto layer = m_gpu_array_helper.layer(draw_list[i].id);
-        zoom_level_raster.pixel({ i, 0 }) = layer.id.zoom_level;
-        array_index_raster.pixel({ i, 0 }) = layer.index;
-    }
+    update_instance_textures(draw_list);
 
     m_instanced_array_index->bind(7);
     m_shader->set_uniform("instanced_texture_array_index_sampler", 7);
-    m_instanced_array_index->upload(array_index_raster);
 
     m_instanced_zoom->bind(8);
     m_shader->set_uniform("instanced_texture_zoom_sampler", 8);
+
+    tile_geometry.draw(m_shader.get(), instances);
+}
+
+void TextureLayer::update_instance_textures(const std::vector<nucleus::tile::TileBounds>& draw_list) const
+{
+    const auto same_tiles = std::equal(draw_list.begin(), draw_list.end(), m_instance_texture_ids.begin(), m_instance_texture_ids.end(), [](const auto& bounds, const auto& id) {
+        return bounds.id == id;
+    });
+    if (same_tiles && !m_instance_textures_dirty)
+        return;
+
+    nucleus::Raster<uint8_t> zoom_level_raster = { glm::uvec2 { nucleus::tile::max_n_tile_instances, 1 } };
+    nucleus::Raster<uint16_t> array_index_raster = { glm::uvec2 { nucleus::tile::max_n_tile_instances, 1 } };
+    nucleus::tile::pack_texture_layers(draw_list, m_gpu_array_helper, array_index_raster, zoom_level_raster);
+    m_instanced_array_index->upload(array_index_raster);
     m_instanced_zoom->upload(zoom_level_raster);
 
-    tile_geometry.draw(m_shader.get(), camera, draw_list);
+    m_instance_texture_ids.clear();
+    for (const auto& bounds : draw_list)
+        m_instance_texture_ids.push_back(bounds.id);
+    m_instance_textures_dirty = false;
 }
 
 unsigned TextureLayer::tile_count() const { return m_gpu_array_helper.n_occupied(); }
@@ -93,6 +106,8 @@ void TextureLayer::update_gpu_tiles(const std::vector<nucleus::tile::Id>& delete
         const auto layer_index = m_gpu_array_helper.add_tile(tile.id);
         m_texture_array->upload(*tile.texture, layer_index);
     }
+    if (!deleted_tiles.empty() || !new_tiles.empty())
+        m_instance_textures_dirty = true;
 }
 
 void TextureLayer::set_tile_limit(unsigned int new_limit)
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include "TileGeometry.h"
 #include "UniformBuffer.h"
 #include <QObject>
 #include <nucleus/Raster.h>
@@ -37,7 +38,6 @@ namespace gl_engine {
 class ShaderRegistry;
 class ShaderProgram;
 class Texture;
-class TileGeometry;
 class AvalancheWarningLayer;
 
 class TextureLayer : public QObject {
@@ -47,7 +47,8 @@ class TextureLayer : public QObject {
 public:
     explicit TextureLayer(unsigned resolution = 256, QObject* parent = nullptr);
     void init(ShaderRegistry* shader_registry); // needs OpenGL context
-    void draw(const TileGeometry& tile_geometry, const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list) const;
+    // instances must have been uploaded for draw_list
+    void draw(const TileGeometry& tile_geometry, const TileGeometry::InstanceBlock& instances, const std::vector<nucleus::tile::TileBounds>& draw_list) const;
 
     unsigned int tile_count() const;
 
@@ -58,6 +59,9 @@ public slots:
     void set_tile_limit(unsigned new_limit);
 
 private:
+    // repacks and uploads the instanced index and zoom textures only if the draw list or the tiles on the gpu changed since the last call
+    void update_instance_textures(const std::vector<nucleus::tile::TileBounds>& draw_list) const;
+
     const unsigned m_resolution = 256u;
 
     std::shared_ptr<ShaderProgram> m_shader;
@@ -65,5 +69,7 @@ private:
     std::unique_ptr<Texture> m_instanced_zoom;
     std::unique_ptr<Texture> m_instanced_array_index;
     nucleus::tile::GpuArrayHelper m_gpu_array_helper;
+    mutable std::vector<nucleus::tile::Id> m_instance_texture_ids;
+    mutable bool m_instance_textures_dirty = true;
 };
 } // namespace gl_engine
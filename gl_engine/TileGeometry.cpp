@@ -26,6 +26,7 @@
 #include <QOpenGLFunctions>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLVertexArrayObject>
+#include <cstddef>
 #include <nucleus/camera/Definition.h>
 #include <nucleus/utils/terrain_mesh_index_generator.h>
 
@@ -43,9 +44,11 @@ TileGeometry::TileGeometry(unsigned int texture_resolution)
 void TileGeometry::init()
 {
 
-    using nucleus::utils::terrain_mesh_index_generator::surface_quads_with_curtains;
     assert(QOpenGLContext::currentContext());
-    const auto indices = surface_quads_with_curtains<uint16_t>(m_texture_resolution);
+    // the default triangle list in vertex cache order transforms ~0.67 instead of ~1.0 vertices per triangle (row by row strip) with a 32 entry cache
+    const auto mesh = nucleus::utils::terrain_mesh_index_generator::tile_mesh(m_texture_resolution, m_index_layout);
+    const auto indices = mesh.indices_as<uint16_t>();
+    m_index_topology = mesh.topology;
     auto index_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::IndexBuffer);
     index_buffer->create();
     index_buffer->bind();
@@ -55,29 +58,12 @@ void TileGeometry::init()
     m_index_buffer.first = std::move(index_buffer);
     m_index_buffer.second = indices.size();
 
-    m_instance_bounds_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
-    m_instance_bounds_buffer->create();
-    m_instance_bounds_buffer->bind();
-    m_instance_bounds_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
-    m_instance_bounds_buffer->allocate(GLsizei(1024 * sizeof(glm::vec4)));
-
-    m_instance_tile_id_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
-    m_instance_tile_id_buffer->create();
-    m_instance_tile_id_buffer->bind();
-    m_instance_tile_id_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
-    m_instance_tile_id_buffer->allocate(GLsizei(1024 * sizeof(glm::u32vec2)));
-
-    m_dtm_array_index_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
-    m_dtm_array_index_buffer->create();
-    m_dtm_array_index_buffer->bind();
-    m_dtm_array_index_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
-    m_dtm_array_index_buffer->allocate(GLsizei(1024 * sizeof(uint16_t)));
-
-    m_dtm_zoom_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
-    m_dtm_zoom_buffer->create();
-    m_dtm_zoom_buffer->bind();
-    m_dtm_zoom_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
-    m_dtm_zoom_buffer->allocate(GLsizei(1024 * sizeof(uint8_t)));
+    m_instance_buffer = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
+    m_instance_buffer->create();
+    m_instance_buffer->bind();
+    m_instance_buffer->setUsagePattern(QOpenGLBuffer::DynamicDraw);
+    m_instance_buffer->allocate(GLsizei(n_instance_blocks * nucleus::tile::max_n_tile_instances * sizeof(nucleus::tile::GpuTileInstance)));
+    m_packed_instances.reserve(nucleus::tile::max_n_tile_instances);
 
     m_vao = std::make_unique<QOpenGLVertexArrayObject>();
     m_vao->create();
@@ -88,47 +74,61 @@ void TileGeometry::init()
     m_dtm_textures = std::make_unique<Texture>(Texture::Target::_2dArray, Texture::Format::R16UI);
     m_dtm_textures->setParams(Texture::Filter::Nearest, Texture::Filter::Nearest);
     m_dtm_textures->allocate_array(m_texture_resolution, m_texture_resolution, unsigned(m_gpu_array_helper.size()));
+    m_layer_index_buffers.resize(m_gpu_array_helper.size());
 
     auto example_shader = std::make_shared<ShaderProgram>("tile.vert", "tile.frag");
-    const auto instance_bounds_location = example_shader->attribute_location("instance_bounds");
-    qDebug() << "attrib location for instance_bounds: " << instance_bounds_location;
-    const auto instance_tile_id_location = example_shader->attribute_location("instance_tile_id_packed");
-    qDebug() << "attrib location for instance_tile_id_packed: " << instance_tile_id_location;
-    const auto dtm_array_index_location = example_shader->attribute_location("dtm_array_index");
-    qDebug() << "attrib location for dtm_array_index: " << dtm_array_index_location;
-    const auto dtm_zoom_location = example_shader->attribute_location("dtm_zoom");
-    qDebug() << "attrib location for dtm_zoom: " << dtm_array_index_location;
-
+    m_instance_bounds_location = example_shader->attribute_location("instance_bounds");
+    qDebug() << "attrib location for instance_bounds: " << m_instance_bounds_location;
+    m_instance_tile_id_location = example_shader->attribute_location("instance_tile_id_packed");
+    qDebug() << "attrib location for instance_tile_id_packed: " << m_instance_tile_id_location;
+    m_dtm_array_index_location = example_shader->attribute_location("dtm_array_index");
+    qDebug() << "attrib location for dtm_array_index: " << m_dtm_array_index_location;
+    m_dtm_zoom_location = example_shader->attribute_location("dtm_zoom");
+    qDebug() << "attrib location for dtm_zoom: " << m_dtm_zoom_location;
+
+    // the pointers are set per draw, they depend on the instance block
     m_vao->bind();
     QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
-    if (instance_bounds_location != -1) {
-        m_instance_bounds_buffer->bind();
-        f->glEnableVertexAttribArray(GLuint(instance_bounds_location));
-        f->glVertexAttribPointer(GLuint(instance_bounds_location), /*size*/ 4, /*type*/ GL_FLOAT, /*normalised*/ GL_FALSE, /*stride*/ 0, nullptr);
-        f->glVertexAttribDivisor(GLuint(instance_bounds_location), 1);
-    }
-    if (instance_tile_id_location != -1) {
-        m_instance_tile_id_buffer->bind();
-        f->glEnableVertexAttribArray(GLuint(instance_tile_id_location));
-        f->glVertexAttribIPointer(GLuint(instance_tile_id_location), /*size*/ 2, /*type*/ GL_UNSIGNED_INT, /*stride*/ 0, nullptr);
-        f->glVertexAttribDivisor(GLuint(instance_tile_id_location), 1);
-    }
-    if (dtm_array_index_location != -1) {
-        m_dtm_array_index_buffer->bind();
-        f->glEnableVertexAttribArray(GLuint(dtm_array_index_location));
-        f->glVertexAttribIPointer(GLuint(dtm_array_index_location), /*size*/ 1, /*type*/ GL_UNSIGNED_SHORT, /*stride*/ 0, nullptr);
-        f->glVertexAttribDivisor(GLuint(dtm_array_index_location), 1);
+    for (const auto location : { m_instance_bounds_location, m_instance_tile_id_location, m_dtm_array_index_location, m_dtm_zoom_location }) {
+        if (location == -1)
+            continue;
+        f->glEnableVertexAttribArray(GLuint(location));
+        f->glVertexAttribDivisor(GLuint(location), 1);
     }
-    if (dtm_zoom_location != -1) {
-        m_dtm_zoom_buffer->bind();
-        f->glEnableVertexAttribArray(GLuint(dtm_zoom_location));
-        f->glVertexAttribIPointer(GLuint(dtm_zoom_location), /*size*/ 1, /*type*/ GL_UNSIGNED_BYTE, /*stride*/ 0, nullptr);
-        f->glVertexAttribDivisor(GLuint(dtm_zoom_location), 1);
+    m_vao->release();
+}
+
+TileGeometry::InstanceBlock TileGeometry::upload_instances(const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list)
+{
+    using nucleus::tile::GpuTileInstance;
+    nucleus::tile::pack_instances(draw_list, camera.position(), m_gpu_array_helper, m_packed_instances);
+    const InstanceBlock block { m_next_instance_block * nucleus::tile::max_n_tile_instances, unsigned(m_packed_instances.size()) };
+
+    // simplified tiles have their own index buffer. it only matches the tile's own heights, tiles drawn with an ancestor's heights use the grid.
+    auto& layers = m_instance_block_layers[m_next_instance_block];
+    layers.clear();
+    if (m_n_layer_index_buffers > 0) {
+        for (unsigned i = 0; i < block.n_instances; ++i) {
+            const auto layer = m_gpu_array_helper.layer(draw_list[i].id);
+            layers.push_back(layer.id == draw_list[i].id ? int(layer.index) : -1);
+        }
     }
+    m_next_instance_block = (m_next_instance_block + 1) % n_instance_blocks;
+
+    m_instance_buffer->bind();
+    m_instance_buffer->write(
+        GLsizei(block.first_instance * sizeof(GpuTileInstance)), m_packed_instances.data(), GLsizei(m_packed_instances.size() * sizeof(GpuTileInstance)));
+    return block;
 }
 
-void TileGeometry::draw(ShaderProgram* shader, const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list) const
+void TileGeometry::draw(ShaderProgram* shader, const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list)
 {
+    draw(shader, upload_instances(camera, draw_list));
+}
+
+void TileGeometry::draw(ShaderProgram* shader, const InstanceBlock& instances) const
+{
+    using nucleus::tile::GpuTileInstance;
     QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
     shader->set_uniform("n_edge_vertices", m_texture_resolution);
     shader->set_uniform("height_tex_sampler", 1);
@@ -136,49 +136,40 @@ void TileGeometry::draw(ShaderProgram* shader, const nucleus::camera::Definition
     m_dtm_textures->bind(1);
     m_vao->bind();
 
-    std::vector<glm::vec4> bounds;
-    bounds.reserve(draw_list.size());
-
-    std::vector<glm::u32vec2> packed_id;
-    packed_id.reserve(draw_list.size());
-
-    nucleus::Raster<uint8_t> zoom_level_raster = { glm::uvec2 { 1024, 1 } };
-    nucleus::Raster<uint16_t> array_index_raster = { glm::uvec2 { 1024, 1 } };
-    nucleus::Raster<glm::vec4> bounds_raster = { glm::uvec2 { 1024, 1 } };
-    for (unsigned i = 0; i < std::min(unsigned(draw_list.size()), 1024u); ++i) {
-        const auto& tile = draw_list[i];
-        bounds.push_back(glm::vec4 { tile.bounds.min.x - camera.position().x,
-            tile.bounds.min.y - camera.position().y,
-            tile.bounds.max.x - camera.position().x,
-            tile.bounds.max.y - camera.position().y });
-        packed_id.push_back(nucleus::srs::pack(tile.id));
-
-        const auto layer = m_gpu_array_helper.layer(draw_list[i].id);
-        if (layer.id.zoom_level > 50) // happens during startup
-            continue;
-
-        zoom_level_raster.pixel({ i, 0 }) = layer.id.zoom_level;
-        array_index_raster.pixel({ i, 0 }) = layer.index;
-        const auto geom_aabb = m_aabb_decorator->aabb(layer.id);
-        bounds_raster.pixel({ i, 0 }) = glm::vec4 { geom_aabb.min.x - camera.position().x,
-            geom_aabb.min.y - camera.position().y,
-            geom_aabb.max.x - camera.position().x,
-            geom_aabb.max.y - camera.position().y };
+    m_instance_buffer->bind();
+    const auto stride = GLsizei(sizeof(GpuTileInstance));
+    const auto set_instance_pointers = [&](unsigned first_instance) {
+        const auto pointer = [&](size_t member_offset) { return reinterpret_cast<const void*>(first_instance * sizeof(GpuTileInstance) + member_offset); };
+        if (m_instance_bounds_location != -1)
+            f->glVertexAttribPointer(GLuint(m_instance_bounds_location), /*size*/ 4, /*type*/ GL_FLOAT, /*normalised*/ GL_FALSE, stride, pointer(offsetof(GpuTileInstance, bounds)));
+        if (m_instance_tile_id_location != -1)
+            f->glVertexAttribIPointer(GLuint(m_instance_tile_id_location), /*size*/ 2, /*type*/ GL_UNSIGNED_INT, stride, pointer(offsetof(GpuTileInstance, packed_id)));
+        if (m_dtm_array_index_location != -1)
+            f->glVertexAttribIPointer(GLuint(m_dtm_array_index_location), /*size*/ 1, /*type*/ GL_UNSIGNED_SHORT, stride, pointer(offsetof(GpuTileInstance, dtm_array_index)));
+        if (m_dtm_zoom_location != -1)
+            f->glVertexAttribIPointer(GLuint(m_dtm_zoom_location), /*size*/ 1, /*type*/ GL_UNSIGNED_BYTE, stride, pointer(offsetof(GpuTileInstance, dtm_zoom)));
+    };
+
+    const auto grid_mode = m_index_topology == nucleus::utils::vertex_cache::Topology::TriangleStrip ? GL_TRIANGLE_STRIP : GL_TRIANGLES;
+    const auto& layers = m_instance_block_layers[instances.first_instance / nucleus::tile::max_n_tile_instances];
+    if (layers.empty()) {
+        shader->set_uniform("instance_offset", 0u);
+        set_instance_pointers(instances.first_instance);
+        f->glDrawElementsInstanced(grid_mode, GLsizei(m_index_buffer.second), GL_UNSIGNED_SHORT, nullptr, GLsizei(instances.n_instances));
+    } else {
+        // one draw per tile. instance_offset keeps the instance id that texture layers use for their per instance lookups.
+        for (unsigned i = 0; i < instances.n_instances; ++i) {
+            const auto& own = layers[i] == -1 ? m_index_buffer : m_layer_index_buffers[unsigned(layers[i])];
+            const auto& index_buffer = own.first ? own : m_index_buffer;
+            // simplified tiles are triangle lists
+            const auto mode = &index_buffer == &m_index_buffer ? grid_mode : GL_TRIANGLES;
+            index_buffer.first->bind();
+            shader->set_uniform("instance_offset", i);
+            set_instance_pointers(instances.first_instance + i);
+            f->glDrawElementsInstanced(mode, GLsizei(index_buffer.second), GL_UNSIGNED_SHORT, nullptr, 1);
+        }
+        m_index_buffer.first->bind(); // the vao keeps the grid index buffer
     }
-
-    m_instance_bounds_buffer->bind();
-    m_instance_bounds_buffer->write(0, bounds.data(), GLsizei(bounds.size() * sizeof(decltype(bounds)::value_type)));
-
-    m_instance_tile_id_buffer->bind();
-    m_instance_tile_id_buffer->write(0, packed_id.data(), GLsizei(packed_id.size() * sizeof(decltype(packed_id)::value_type)));
-
-    m_dtm_array_index_buffer->bind();
-    m_dtm_array_index_buffer->write(0, array_index_raster.bytes(), GLsizei(array_index_raster.width() * sizeof(uint16_t)));
-
-    m_dtm_zoom_buffer->bind();
-    m_dtm_zoom_buffer->write(0, zoom_level_raster.bytes(), GLsizei(zoom_level_raster.width() * sizeof(uint8_t)));
-
-    f->glDrawElementsInstanced(GL_TRIANGLE_STRIP, GLsizei(m_index_buffer.second), GL_UNSIGNED_SHORT, nullptr, GLsizei(draw_list.size()));
     f->glBindVertexArray(0);
 }
 
@@ -190,8 +181,16 @@ void TileGeometry::set_tile_limit(unsigned int new_limit)
     m_gpu_array_helper.set_tile_limit(new_limit);
 }
 
+void TileGeometry::set_index_layout(nucleus::utils::terrain_mesh_index_generator::Layout layout)
+{
+    assert(!m_index_buffer.first);
+    m_index_layout = layout;
+}
+
 unsigned TileGeometry::tile_count() const { return m_gpu_array_helper.n_occupied(); }
 
+nucleus::tile::Id TileGeometry::drawn_tile(const nucleus::tile::Id& tile_id) const { return m_gpu_array_helper.layer(tile_id).id; }
+
 void TileGeometry::update_gpu_tiles(const std::vector<radix::tile::Id>& deleted_tiles, const std::vector<nucleus::tile::GpuGeometryTile>& new_tiles)
 {
 
@@ -199,6 +198,8 @@ void TileGeometry::update_gpu_tiles(const std::vector<radix::tile::Id>& deleted_
         return;
 
     for (const auto& id : deleted_tiles) {
+        if (m_gpu_array_helper.contains(id))
+            set_layer_indices(m_gpu_array_helper.layer(id).index, nullptr);
         m_gpu_array_helper.remove_tile(id);
     }
     for (const auto& tile : new_tiles) {
@@ -209,7 +210,27 @@ void TileGeometry::update_gpu_tiles(const std::vector<radix::tile::Id>& deleted_
         // find empty spot and upload texture
         const auto layer_index = m_gpu_array_helper.add_tile(tile.id);
         m_dtm_textures->upload(*tile.surface, layer_index);
+        set_layer_indices(layer_index, tile.indices.get());
     }
 }
 
+void TileGeometry::set_layer_indices(unsigned layer, const std::vector<uint16_t>* indices)
+{
+    auto& buffer = m_layer_index_buffers[layer];
+    if (buffer.first) {
+        buffer = {};
+        --m_n_layer_index_buffers;
+    }
+    if (!indices)
+        return;
+    buffer.first = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::IndexBuffer);
+    buffer.first->create();
+    buffer.first->bind();
+    buffer.first->setUsagePattern(QOpenGLBuffer::StaticDraw);
+    buffer.first->allocate(indices->data(), bufferLengthInBytes(*indices));
+    buffer.first->release();
+    buffer.second = indices->size();
+    ++m_n_layer_index_buffers;
+}
+
 } // namespace gl_engine
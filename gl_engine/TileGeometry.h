@@ -19,10 +19,13 @@
 #pragma once
 
 #include <QObject>
+#include <array>
 #include <nucleus/Raster.h>
 #include <nucleus/tile/DrawListGenerator.h>
 #include <nucleus/tile/GpuArrayHelper.h>
+#include <nucleus/tile/instances.h>
 #include <nucleus/tile/types.h>
+#include <nucleus/utils/terrain_mesh_index_generator.h>
 
 namespace camera {
 class Definition;
@@ -41,28 +44,58 @@ class TileGeometry : public QObject {
     Q_OBJECT
 
 public:
+    // A range of packed instances in the ring buffer. It stays valid for n_instance_blocks uploads, i.e., the rest of the frame.
+    struct InstanceBlock {
+        unsigned first_instance = 0;
+        unsigned n_instances = 0;
+    };
+    static constexpr unsigned n_instance_blocks = 16;
+
     explicit TileGeometry(unsigned texture_resolution = 65);
     void init(); // needs OpenGL context
-    void draw(ShaderProgram* shader_program, const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list) const;
+    // Packs and uploads the instance data of a draw list (bounds relative to the camera). Upload once per frame and draw list, and draw the
+    // block in every pass.
+    InstanceBlock upload_instances(const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list);
+    void draw(ShaderProgram* shader_program, const InstanceBlock& instances) const;
+    // upload and draw, for draw lists that are used only once
+    void draw(ShaderProgram* shader_program, const nucleus::camera::Definition& camera, const std::vector<nucleus::tile::TileBounds>& draw_list);
 
     unsigned int tile_count() const;
+    // the tile whose geometry is drawn for tile_id, i.e., tile_id or its closest ancestor on the gpu
+    nucleus::tile::Id drawn_tile(const nucleus::tile::Id& tile_id) const;
 
 public slots:
     void update_gpu_tiles(const std::vector<nucleus::tile::Id>& deleted_tiles, const std::vector<nucleus::tile::GpuGeometryTile>& new_tiles);
     void set_aabb_decorator(const nucleus::tile::utils::AabbDecoratorPtr& new_aabb_decorator);
     /// must be called before init
     void set_tile_limit(unsigned new_limit);
+    /// must be called before init
+    void set_index_layout(nucleus::utils::terrain_mesh_index_generator::Layout layout);
 
 private:
+    // uploads the simplified index buffer of the tile in the given dtm layer, or drops it if indices is null
+    void set_layer_indices(unsigned layer, const std::vector<uint16_t>* indices);
+
     const unsigned m_texture_resolution;
 
     std::unique_ptr<Texture> m_dtm_textures;
     std::unique_ptr<QOpenGLVertexArrayObject> m_vao;
     std::pair<std::unique_ptr<QOpenGLBuffer>, size_t> m_index_buffer;
-    std::unique_ptr<QOpenGLBuffer> m_instance_bounds_buffer;
-    std::unique_ptr<QOpenGLBuffer> m_instance_tile_id_buffer;
-    std::unique_ptr<QOpenGLBuffer> m_dtm_array_index_buffer;
-    std::unique_ptr<QOpenGLBuffer> m_dtm_zoom_buffer;
+    nucleus::utils::terrain_mesh_index_generator::Layout m_index_layout = nucleus::utils::terrain_mesh_index_generator::Layout::CacheOptimisedList;
+    nucleus::utils::vertex_cache::Topology m_index_topology = nucleus::utils::vertex_cache::Topology::TriangleList;
+    // per dtm layer, the index buffer of simplified tiles (GpuGeometryTile::indices). null for tiles that use m_index_buffer.
+    std::vector<std::pair<std::unique_ptr<QOpenGLBuffer>, size_t>> m_layer_index_buffers;
+    unsigned m_n_layer_index_buffers = 0;
+    // per instance block, the dtm layer of every instance if any tile is simplified (-1 if the instance is drawn with an ancestor's heights).
+    // empty if all instances are drawn with m_index_buffer in one instanced draw call.
+    std::array<std::vector<int>, n_instance_blocks> m_instance_block_layers;
+    std::unique_ptr<QOpenGLBuffer> m_instance_buffer; // ring of n_instance_blocks blocks with max_n_tile_instances each
+    unsigned m_next_instance_block = 0;
+    std::vector<nucleus::tile::GpuTileInstance> m_packed_instances;
+    int m_instance_bounds_location = -1;
+    int m_instance_tile_id_location = -1;
+    int m_dtm_array_index_location = -1;
+    int m_dtm_zoom_location = -1;
 
     nucleus::tile::GpuArrayHelper m_gpu_array_helper;
     nucleus::tile::utils::AabbDecoratorPtr m_aabb_decorator;
@@ -71,31 +71,40 @@ void TrackManager::draw(const nucleus::camera::Definition& camera) const
     m_shader->set_uniform("shading_method", static_cast<int>(m_shading_method));
     m_shader->set_uniform("max_speed", m_max_speed);
     m_shader->set_uniform("max_vertical_speed", m_max_vertical_speed);
-    m_shader->set_uniform("end_index", static_cast<int>(m_total_point_count));
 
     for (const PolyLine& track : m_tracks) {
+        // only visible chunks, each on the coarsest level that stays within m_max_pixel_error
+        const auto draw_ranges = nucleus::track::select_polyline_lod(track.lod, camera, m_max_pixel_error);
+        const PolyLineLevel* bound_level = nullptr;
+
+        for (const auto& draw_range : draw_ranges) {
+            const PolyLineLevel& level = track.levels[draw_range.level];
+            if (&level != bound_level) {
+                level.texture->bind(8);
+                level.vao->bind();
+                m_shader->set_uniform("end_index", static_cast<int>(level.point_count));
+                bound_level = &level;
+            }
 
-        track.texture->bind(8);
-
-        track.vao->bind();
-
-        GLsizei vertex_count = (track.point_count - 1) * 6;
+            const GLint first_vertex = GLint(draw_range.range.first) * 6;
+            const GLsizei vertex_count = GLsizei(draw_range.range.n_points - 1) * 6;
 
-        m_shader->set_uniform("enable_intersection", true);
-        f->glDrawArrays(GL_TRIANGLES, 0, vertex_count);
+            m_shader->set_uniform("enable_intersection", true);
+            f->glDrawArrays(GL_TRIANGLES, first_vertex, vertex_count);
 
 #if ENABLE_BOUNDING_QUADS
 #if (defined(__linux) && !defined(__ANDROID__)) || defined(_WIN32) || defined(_WIN64)
-        if (funcs) funcs->glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+            if (funcs) funcs->glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 #endif
 
-        shader->set_uniform("enable_intersection", false);
-        f->glDrawArrays(GL_TRIANGLES, 0, vertex_count);
+            m_shader->set_uniform("enable_intersection", false);
+            f->glDrawArrays(GL_TRIANGLES, first_vertex, vertex_count);
 
 #if (defined(__linux) && !defined(__ANDROID__)) || defined(_WIN32) || defined(_WIN64)
-        if (funcs) funcs->glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+            if (funcs) funcs->glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 #endif
 #endif
+        }
     }
 
     m_shader->release();
@@ -103,22 +112,16 @@ void TrackManager::draw(const nucleus::camera::Definition& camera) const
     f->glEnable(GL_CULL_FACE);
 }
 
-void TrackManager::add_track(const nucleus::track::Gpx& gpx)
+void TrackManager::add_track(const nucleus::track::WorldTrack& track)
 {
     using namespace nucleus::track;
-    QOpenGLExtraFunctions *f = QOpenGLContext::currentContext()->extraFunctions();
 
-    qDebug() << "Segment Count: " << gpx.track.size();
+    qDebug() << "Segment Count: " << track.segments.size();
 
-    for (const Segment& segment : gpx.track) {
+    // points are in world coordinates and smoothed already (see load_track)
+    for (const std::vector<glm::vec4>& points : track.segments) {
 
-        qDebug() << "Point Count Per Segment: " << segment.size();
-
-        // transform from latitude and longitude into renderer world coordinates
-        std::vector<glm::vec4> points = to_world_points(segment);
-
-        // data cleanup
-        apply_gaussian_filter(points, 1.0f);
+        qDebug() << "Point Count Per Segment: " << points.size();
 
         for (size_t i = 0; i < points.size() - 1; ++i) {
             glm::vec4 a = points[i];
@@ -132,84 +135,96 @@ void TrackManager::add_track(const nucleus::track::Gpx& gpx)
             m_max_vertical_speed = glm::max(vertical_speed, m_max_vertical_speed);
         }
 
-        size_t point_count = points.size();
+        PolyLine polyline = {};
+        polyline.lod = build_polyline_lod(points);
 
-        std::vector<glm::vec3> basic_ribbon = triangles_ribbon(points, 0.0f, 0);
+        for (const auto& level_points : polyline.lod.levels) {
+            auto level = create_level(level_points);
+            if (!level)
+                return;
+            polyline.levels.push_back(std::move(*level));
+        }
 
-        PolyLine polyline = {};
+        qDebug() << "Lod Level Count: " << polyline.levels.size();
 
+        m_total_point_count += points.size();
+        m_tracks.push_back(std::move(polyline));
+    }
 
+    qDebug() << "Total Point Count: " << m_total_point_count;
+}
 
-        if (polyline.texture == nullptr) {
+std::optional<PolyLineLevel> TrackManager::create_level(const std::vector<glm::vec4>& points) const
+{
+    using namespace nucleus::track;
+    QOpenGLExtraFunctions* f = QOpenGLContext::currentContext()->extraFunctions();
 
-            int max_texture_size;
-            f->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+    size_t point_count = points.size();
 
-            qDebug() << "max texture size: " << max_texture_size;
+    std::vector<glm::vec3> basic_ribbon = triangles_ribbon(points, 0.0f, 0);
 
-            if (max_texture_size < int(point_count)) {
-                qDebug() << "Unable to add track with " << point_count << "points, maximum is " << max_texture_size;
-                return;
-            }
+    PolyLineLevel polyline = {};
 
-            // create texture to hold the point data
-            polyline.texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target::Target2D);
-            polyline.texture->setFormat(QOpenGLTexture::TextureFormat::RGBA32F);
-            polyline.texture->setSize(point_count, 1);
-            polyline.texture->setAutoMipMapGenerationEnabled(false);
-            polyline.texture->setMinMagFilters(QOpenGLTexture::Filter::Nearest, QOpenGLTexture::Filter::Nearest);
-            polyline.texture->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
-            polyline.texture->allocateStorage();
-
-            if (!polyline.texture->isStorageAllocated()) {
-                qDebug() << "Could not allocate texture storage!";
-                return;
-            }
-        }
+    int max_texture_size;
+    f->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
 
-        polyline.texture->bind();
-        polyline.texture->setData(0, 0, 0, point_count, 1, 0, QOpenGLTexture::RGBA, QOpenGLTexture::Float32, points.data());
+    if (max_texture_size < int(point_count)) {
+        qDebug() << "Unable to add track with " << point_count << "points, maximum is " << max_texture_size;
+        return {};
+    }
 
-        m_total_point_count += point_count;
+    // create texture to hold the point data
+    polyline.texture = std::make_unique<QOpenGLTexture>(QOpenGLTexture::Target::Target2D);
+    polyline.texture->setFormat(QOpenGLTexture::TextureFormat::RGBA32F);
+    polyline.texture->setSize(point_count, 1);
+    polyline.texture->setAutoMipMapGenerationEnabled(false);
+    polyline.texture->setMinMagFilters(QOpenGLTexture::Filter::Nearest, QOpenGLTexture::Filter::Nearest);
+    polyline.texture->setWrapMode(QOpenGLTexture::WrapMode::ClampToEdge);
+    polyline.texture->allocateStorage();
+
+    if (!polyline.texture->isStorageAllocated()) {
+        qDebug() << "Could not allocate texture storage!";
+        return {};
+    }
 
-        polyline.vao = std::make_unique<QOpenGLVertexArrayObject>();
-        polyline.point_count = point_count;
-        polyline.vao->create();
-        polyline.vao->bind();
+    polyline.texture->bind();
+    polyline.texture->setData(0, 0, 0, point_count, 1, 0, QOpenGLTexture::RGBA, QOpenGLTexture::Float32, points.data());
 
-        polyline.vbo = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
-        polyline.vbo->create();
+    polyline.vao = std::make_unique<QOpenGLVertexArrayObject>();
+    polyline.point_count = point_count;
+    polyline.vao->create();
+    polyline.vao->bind();
 
-        polyline.vbo->bind();
-        polyline.vbo->setUsagePattern(QOpenGLBuffer::StaticDraw);
+    polyline.vbo = std::make_unique<QOpenGLBuffer>(QOpenGLBuffer::VertexBuffer);
+    polyline.vbo->create();
 
-        polyline.vbo->allocate(basic_ribbon.data(), helpers::bufferLengthInBytes(basic_ribbon));
+    polyline.vbo->bind();
+    polyline.vbo->setUsagePattern(QOpenGLBuffer::StaticDraw);
 
-        GLsizei stride = 3 * sizeof(glm::vec3);
+    polyline.vbo->allocate(basic_ribbon.data(), helpers::bufferLengthInBytes(basic_ribbon));
 
-        const int position_attrib_location = m_shader->attribute_location("a_position");
-        f->glEnableVertexAttribArray(position_attrib_location);
-        f->glVertexAttribPointer(position_attrib_location, 3, GL_FLOAT, GL_FALSE, stride, nullptr);
+    GLsizei stride = 3 * sizeof(glm::vec3);
 
-        const int direction_attrib_location = m_shader->attribute_location("a_direction");
-        f->glEnableVertexAttribArray(direction_attrib_location);
-        f->glVertexAttribPointer(direction_attrib_location, 3, GL_FLOAT, GL_FALSE, stride, (void*)(1 * sizeof(glm::vec3)));
+    const int position_attrib_location = m_shader->attribute_location("a_position");
+    f->glEnableVertexAttribArray(position_attrib_location);
+    f->glVertexAttribPointer(position_attrib_location, 3, GL_FLOAT, GL_FALSE, stride, nullptr);
 
-        const int offset_attrib_location = m_shader->attribute_location("a_offset");
-        f->glEnableVertexAttribArray(offset_attrib_location);
-        f->glVertexAttribPointer(offset_attrib_location, 3, GL_FLOAT, GL_FALSE, stride, (void*)(2 * sizeof(glm::vec3)));
+    const int direction_attrib_location = m_shader->attribute_location("a_direction");
+    f->glEnableVertexAttribArray(direction_attrib_location);
+    f->glVertexAttribPointer(direction_attrib_location, 3, GL_FLOAT, GL_FALSE, stride, (void*)(1 * sizeof(glm::vec3)));
 
-        polyline.vao->release();
+    const int offset_attrib_location = m_shader->attribute_location("a_offset");
+    f->glEnableVertexAttribArray(offset_attrib_location);
+    f->glVertexAttribPointer(offset_attrib_location, 3, GL_FLOAT, GL_FALSE, stride, (void*)(2 * sizeof(glm::vec3)));
 
-        m_tracks.push_back(std::move(polyline));
-    }
+    polyline.vao->release();
 
-    qDebug() << "Total Point Count: " << m_total_point_count;
+    return polyline;
 }
 
 ShaderProgram* TrackManager::shader() const { return m_shader.get(); }
 
-void TrackManager::change_tracks(const QVector<nucleus::track::Gpx>& tracks)
+void TrackManager::change_tracks(const QVector<nucleus::track::WorldTrack>& tracks)
 {
     m_tracks.resize(0);
     for (const auto& t : tracks) {
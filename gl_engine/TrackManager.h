@@ -21,6 +21,7 @@
 
 #include <QObject>
 #include <memory>
+#include <optional>
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
 #include <QOpenGLTexture>
@@ -28,6 +29,8 @@
 #include <nucleus/camera/Definition.h>
 #include <nucleus/track/GPX.h>
 #include <nucleus/track/Manager.h>
+#include <nucleus/track/polyline_lod.h>
+#include <nucleus/track/streaming.h>
 
 class QOpenGLShaderProgram;
 
@@ -36,13 +39,18 @@ namespace gl_engine {
 class ShaderProgram;
 class ShaderRegistry;
 
-struct PolyLine {
+struct PolyLineLevel {
     GLsizei point_count;
     std::unique_ptr<QOpenGLVertexArrayObject> vao = nullptr;
     std::unique_ptr<QOpenGLBuffer> vbo = nullptr;
     std::unique_ptr<QOpenGLTexture> texture = nullptr;
 };
 
+struct PolyLine {
+    nucleus::track::PolylineLod lod;
+    std::vector<PolyLineLevel> levels; // one per lod level
+};
+
 class TrackManager : public nucleus::track::Manager {
     Q_OBJECT
 public:
@@ -53,16 +61,18 @@ public:
     [[nodiscard]] ShaderProgram* shader() const;
 
 public slots:
-    void change_tracks(const QVector<nucleus::track::Gpx>& tracks) override;
+    void change_tracks(const QVector<nucleus::track::WorldTrack>& tracks) override;
     void change_display_width(float new_width) override;
     void change_shading_style(unsigned int new_style) override;
 
 protected:
-    void add_track(const nucleus::track::Gpx& gpx);
+    void add_track(const nucleus::track::WorldTrack& track);
+    [[nodiscard]] std::optional<PolyLineLevel> create_level(const std::vector<glm::vec4>& points) const;
 
 private:
     unsigned int m_shading_method = 0U;
     float m_display_width = 7.0f;
+    float m_max_pixel_error = 0.5f;
     std::shared_ptr<ShaderProgram> m_shader;
     float m_max_speed = 0.0f;
     float m_max_vertical_speed = 0.0f;
@@ -304,9 +304,11 @@ void Window::paint(QOpenGLFramebufferObject* framebuffer)
     // Note: Could also just be done on camera change
     m_timer->start_timer("draw_list");
     QVariantMap tile_stats;
-    MapLabels::TileSet label_tile_set;
+    // label slots are uploaded once per frame, the ranges are shared by the picker and the label pass
+    std::vector<nucleus::map_label::InstanceRange> label_ranges;
     if (m_context->map_label_manager()) {
-        label_tile_set = m_context->map_label_manager()->generate_draw_list(m_camera);
+        const auto label_tile_set = m_context->map_label_manager()->generate_draw_list(m_camera);
+        label_ranges = m_context->map_label_manager()->prepare_draw(m_camera, label_tile_set);
         tile_stats["n_label_tiles_gpu"] = m_context->map_label_manager()->tile_count();
         tile_stats["n_label_tiles_drawn"] = unsigned(label_tile_set.size());
     }
@@ -318,12 +320,14 @@ void Window::paint(QOpenGLFramebufferObject* framebuffer)
     tile_stats["n_geometry_tiles_gpu"] = m_context->tile_geometry()->tile_count();
     tile_stats["n_ortho_tiles_gpu"] = m_context->ortho_layer()->tile_count();
     tile_stats["n_geometry_tiles_drawn"] = unsigned(culled_draw_list.size());
+    // uploaded once per frame, shared by all passes that draw the camera draw list
+    const auto tile_instances = m_context->tile_geometry()->upload_instances(m_camera, culled_draw_list);
     m_timer->stop_timer("draw_list");
 
     // DRAW SHADOWMAPS
     if (m_shared_config_ubo->data.m_csm_enabled) {
         m_timer->start_timer("shadowmap");
-        m_shadowmapping->draw(m_context->tile_geometry(), draw_list, m_camera, m_shadow_config_ubo, m_shared_config_ubo);
+        tile_stats["n_shadow_cascades_drawn"] = m_shadowmapping->draw(m_context->tile_geometry(), draw_list, m_camera, m_shadow_config_ubo, m_shared_config_ubo);
         m_timer->stop_timer("shadowmap");
     }
 
@@ -355,10 +359,10 @@ void Window::paint(QOpenGLFramebufferObject* framebuffer)
 
     if (m_shared_config_ubo->data.m_eaws_danger_rating_enabled || m_shared_config_ubo->data.m_eaws_risk_level_enabled
         || m_shared_config_ubo->data.m_eaws_slope_angle_enabled || m_shared_config_ubo->data.m_eaws_stop_or_go_enabled) {
-        m_context->surfaceshaded_layer()->draw(*m_context->tile_geometry(), m_camera, culled_draw_list);
-        m_context->eaws_layer()->draw(*m_context->tile_geometry(), m_camera, culled_draw_list);
+        m_context->surfaceshaded_layer()->draw(*m_context->tile_geometry(), tile_instances, culled_draw_list);
+        m_context->eaws_layer()->draw(*m_context->tile_geometry(), tile_instances, culled_draw_list);
     } else {
-        m_context->ortho_layer()->draw(*m_context->tile_geometry(), m_camera, culled_draw_list);
+        m_context->ortho_layer()->draw(*m_context->tile_geometry(), tile_instances, culled_draw_list);
     }
     m_timer->stop_timer("tiles");
 
@@ -382,7 +386,7 @@ void Window::paint(QOpenGLFramebufferObject* framebuffer)
 
         // DRAW Pickbuffer
         if (m_context->map_label_manager())
-            m_context->map_label_manager()->draw_picker(m_gbuffer.get(), m_camera, label_tile_set);
+            m_context->map_label_manager()->draw_picker(m_gbuffer.get(), label_ranges);
         m_timer->stop_timer("picker");
     }
 
@@ -420,7 +424,7 @@ void Window::paint(QOpenGLFramebufferObject* framebuffer)
     // DRAW LABELS
     if (m_context->map_label_manager()) {
         m_timer->start_timer("labels");
-        m_context->map_label_manager()->draw(m_gbuffer.get(), m_camera, label_tile_set);
+        m_context->map_label_manager()->draw(m_gbuffer.get(), label_ranges);
         m_timer->stop_timer("labels");
     }
 
@@ -27,10 +27,11 @@ const float nearLabel = 100.0f;
 
 const vec2 offset_mask[4] = vec2[4](vec2(0.0f,0.0f), vec2(0.0f,1.0f), vec2(1.0f,1.0f), vec2(1.0f,0.0f));
 
-uniform highp vec3 reference_position;
 uniform bool label_dist_scaling;
 
 uniform sampler2D texin_depth;
+// per tile slot: xyz reference position relative to the camera, w 1 if the tile is visible (see nucleus::map_label::pack_slots)
+uniform highp sampler2D slot_sampler;
 
 layout (location = 0) in vec4 pos;
 layout (location = 1) in vec4 vtexcoords;
@@ -38,6 +39,7 @@ layout (location = 2) in lowp vec4 picker_color_in;
 layout (location = 3) in vec3 label_position;
 layout (location = 4) in float importance;
 layout (location = 5) in int texture_index_in;
+layout (location = 6) in uint slot_in;
 
 out highp vec2 texcoords;
 flat out int texture_index;
@@ -81,7 +83,14 @@ bool label_visible(highp vec3 relative_to_cam, float dist_to_cam) {
 void main() {
     texture_index = texture_index_in;
     picker_color = picker_color_in;
-    highp vec3 relative_to_cam = label_position + reference_position;
+    // labels of all tiles are drawn in a few ranges, instances of hidden tiles and unused instances are skipped here
+    int slot_texture_width = textureSize(slot_sampler, 0).x;
+    highp vec4 slot = texelFetch(slot_sampler, ivec2(int(slot_in) % slot_texture_width, int(slot_in) / slot_texture_width), 0);
+    if (slot.w < 0.5) {
+        gl_Position = vec4(10.0f, 10.0f, 10.0f, 1.0f);
+        return;
+    }
+    highp vec3 relative_to_cam = label_position + slot.xyz;
     float dist_to_cam = length(relative_to_cam);
     float scale = 2.0f;
     vec3 label_shift = vec3(0.0, 0.0, 5.0) - relative_to_cam * 0.15; // shift the label a bit to the top and towards the camera so that it isn't in the ground
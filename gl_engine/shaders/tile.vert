@@ -33,11 +33,13 @@ flat out lowp vec3 vertex_color;
 flat out highp uint instance_id;
 out highp float var_altitude;
 
+uniform highp uint instance_offset; // first instance of the draw call within its instance block
+
 void main() {
     compute_vertex(var_pos_cws, var_uv, var_tile_id, conf.normal_mode == 1u, var_normal, var_altitude);
 
     gl_Position = camera.view_proj_matrix * vec4(var_pos_cws, 1);
-    instance_id = uint(gl_InstanceID);
+    instance_id = instance_offset + uint(gl_InstanceID);
 
     vertex_color = vec3(0.0);
     switch(conf.overlay_mode) {
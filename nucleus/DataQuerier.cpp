@@ -18,13 +18,30 @@
 
 #include "DataQuerier.h"
 
+#include <nucleus/tile/HeightfieldRaycaster.h>
 #include <nucleus/tile/cache_quieries.h>
 
-nucleus::DataQuerier::DataQuerier(tile::MemoryCache* cache)
+nucleus::DataQuerier::DataQuerier(tile::MemoryCache* cache, tile::utils::AabbDecoratorPtr aabb_decorator)
     : m_memory_cache(cache)
-{}
+{
+    if (aabb_decorator)
+        m_raycaster = std::make_unique<tile::HeightfieldRaycaster>(cache, std::move(aabb_decorator));
+}
+
+nucleus::DataQuerier::~DataQuerier() = default;
 
 tl::expected<float, QString> nucleus::DataQuerier::get_altitude(const glm::dvec2& lat_long) const
 {
     return tile::cache_queries::query_altitude(m_memory_cache, lat_long);
 }
+
+bool nucleus::DataQuerier::can_ray_cast() const { return bool(m_raycaster); }
+
+std::optional<glm::dvec3> nucleus::DataQuerier::ray_cast(const glm::dvec3& origin, const glm::dvec3& direction) const
+{
+    if (!m_raycaster)
+        return {};
+    if (const auto hit = m_raycaster->cast(origin, direction))
+        return hit->position;
+    return {};
+}
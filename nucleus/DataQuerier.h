@@ -19,19 +19,32 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <memory>
+#include <optional>
 
 #include <nucleus/tile/Cache.h>
+#include <nucleus/tile/utils.h>
+
+namespace nucleus::tile {
+class HeightfieldRaycaster;
+}
 
 namespace nucleus {
 
 class DataQuerier
 {
     tile::MemoryCache* m_memory_cache = nullptr;
+    std::unique_ptr<tile::HeightfieldRaycaster> m_raycaster;
 
 public:
-    DataQuerier(tile::MemoryCache* cache);
+    // ray casting is only available with an aabb decorator
+    DataQuerier(tile::MemoryCache* cache, tile::utils::AabbDecoratorPtr aabb_decorator = {});
+    ~DataQuerier();
 
     [[nodiscard]] tl::expected<float, QString> get_altitude(const glm::dvec2& lat_long) const;
+    [[nodiscard]] bool can_ray_cast() const;
+    // first intersection of the ray with the terrain in the cache, in world space. runs on the cpu and doesn't wait for the gpu.
+    [[nodiscard]] std::optional<glm::dvec3> ray_cast(const glm::dvec3& origin, const glm::dvec3& direction) const;
 };
 
 } // namespace nucleus
@@ -0,0 +1,253 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "RegionGeometryStore.h"
+
+#include "UIntIdManager.h"
+#include "eaws.h"
+#include <algorithm>
+#include <limits>
+
+namespace nucleus::avalanche {
+
+namespace detail {
+    namespace {
+        double distance_to_segment(const glm::dvec2& p, const glm::dvec2& a, const glm::dvec2& b)
+        {
+            const glm::dvec2 ab = b - a;
+            const double length_sq = glm::dot(ab, ab);
+            if (length_sq == 0.0)
+                return glm::distance(p, a);
+            const double t = std::clamp(glm::dot(p - a, ab) / length_sq, 0.0, 1.0);
+            return glm::distance(p, a + t * ab);
+        }
+    } // namespace
+
+    std::vector<glm::dvec2> simplify_polygon(const std::vector<glm::dvec2>& polygon, double tolerance)
+    {
+        const size_t n = polygon.size();
+        if (n <= 3)
+            return polygon;
+
+        // closed polygon: split at the vertex farthest away from the first one and simplify both halves.
+        // index n stands for vertex 0 (closing the ring).
+        size_t farthest = 0;
+        double max_distance_sq = -1;
+        for (size_t i = 1; i < n; ++i) {
+            const glm::dvec2 d = polygon[i] - polygon[0];
+            if (glm::dot(d, d) > max_distance_sq) {
+                max_distance_sq = glm::dot(d, d);
+                farthest = i;
+            }
+        }
+
+        std::vector<bool> keep(n, false);
+        keep[0] = true;
+        keep[farthest] = true;
+        std::vector<std::pair<size_t, size_t>> stack = { { 0, farthest }, { farthest, n } };
+        while (!stack.empty()) {
+            const auto [first, last] = stack.back();
+            stack.pop_back();
+            if (last - first < 2)
+                continue;
+            const glm::dvec2& a = polygon[first];
+            const glm::dvec2& b = polygon[last % n];
+            double max_distance = 0;
+            size_t index = first;
+            for (size_t i = first + 1; i < last; ++i) {
+                const double d = distance_to_segment(polygon[i], a, b);
+                if (d > max_distance) {
+                    max_distance = d;
+                    index = i;
+                }
+            }
+            if (max_distance > tolerance) {
+                keep[index] = true;
+                stack.emplace_back(first, index);
+                stack.emplace_back(index, last);
+            }
+        }
+
+        std::vector<glm::dvec2> simplified;
+        for (size_t i = 0; i < n; ++i) {
+            if (keep[i])
+                simplified.push_back(polygon[i]);
+        }
+        return simplified;
+    }
+} // namespace detail
+
+RegionGeometryStore::RegionGeometryStore(std::shared_ptr<UIntIdManager> internal_id_manager, unsigned tile_resolution, size_t max_n_source_tiles)
+    : m_internal_id_manager(std::move(internal_id_manager))
+    , m_tile_resolution(tile_resolution)
+    , m_max_n_source_tiles(max_n_source_tiles)
+{
+    assert(m_internal_id_manager);
+    assert(m_tile_resolution > 0);
+    assert(m_max_n_source_tiles > 0);
+}
+
+bool RegionGeometryStore::ingest(const QByteArray& data, const tile::Id& tile_id)
+{
+    if (m_sources.contains(tile_id))
+        return true;
+
+    const tl::expected<RegionTile, QString> result = vector_tile_reader(data, tile_id);
+    if (!result.has_value())
+        return false;
+    const std::vector<Region>& regions = result->second;
+
+    // output pixels should cover at least 2 mvt units, otherwise the geometry of finer tiles has to be parsed
+    const unsigned extent = regions.front().resolution.x;
+    unsigned n_levels = 1;
+    while ((extent >> n_levels) >= 2 * m_tile_resolution)
+        ++n_levels;
+
+    const double tile_size = 1.0 / double(1u << tile_id.zoom_level);
+    const glm::dvec2 tile_origin = glm::dvec2(tile_id.coords) * tile_size;
+    const QDate reference_date = m_internal_id_manager->get_reference_date();
+
+    SourceTile source;
+    source.max_zoom_level = tile_id.zoom_level + n_levels - 1;
+    source.pieces.reserve(regions.size());
+    std::vector<glm::dvec2> polygon;
+    for (const auto& region : regions) {
+        // only regions valid at the reference date are ever rasterised
+        if ((region.start_date.has_value() && region.start_date > reference_date) || (region.end_date.has_value() && region.end_date < reference_date))
+            continue;
+        if (region.vertices_in_local_coordinates.size() < 3)
+            continue;
+
+        Piece piece;
+        piece.bounds.min = glm::dvec2(std::numeric_limits<double>::max());
+        piece.bounds.max = glm::dvec2(std::numeric_limits<double>::lowest());
+        polygon.clear();
+        for (const auto& v : region.vertices_in_local_coordinates) {
+            polygon.push_back(tile_origin + glm::dvec2(v) * tile_size);
+            piece.bounds.min = glm::min(piece.bounds.min, polygon.back());
+            piece.bounds.max = glm::max(piece.bounds.max, polygon.back());
+        }
+        for (unsigned level = 0; level < n_levels; ++level) {
+            const double pixel_size = 1.0 / (double(m_tile_resolution) * double(1u << (tile_id.zoom_level + level)));
+            piece.simplified_polygons.push_back(detail::simplify_polygon(polygon, 0.5 * pixel_size));
+        }
+
+        auto [region_iter, inserted] = m_regions.try_emplace(region.id);
+        RegionGeometry& geometry = region_iter->second;
+        if (inserted) {
+            geometry.id = region.id;
+            geometry.internal_id = uint16_t(m_internal_id_manager->convert_region_id_to_internal_id(region.id));
+            geometry.bounds = piece.bounds;
+        } else {
+            geometry.bounds.min = glm::min(geometry.bounds.min, piece.bounds.min);
+            geometry.bounds.max = glm::max(geometry.bounds.max, piece.bounds.max);
+        }
+        if (geometry.sources.empty() || geometry.sources.back() != tile_id)
+            geometry.sources.push_back(tile_id);
+        piece.region = &geometry;
+        source.pieces.push_back(std::move(piece));
+    }
+
+    m_sources.emplace(tile_id, std::move(source));
+    m_ingestion_order.push_back(tile_id);
+    while (m_sources.size() > m_max_n_source_tiles)
+        evict_oldest_source();
+    return true;
+}
+
+std::optional<tile::Id> RegionGeometryStore::covering_source(const tile::Id& tile_id) const
+{
+    tile::Id id = tile_id;
+    while (true) {
+        const auto iter = m_sources.find(id);
+        if (iter != m_sources.end() && iter->second.max_zoom_level >= tile_id.zoom_level)
+            return id;
+        if (id.zoom_level == 0)
+            return {};
+        id = id.parent();
+    }
+}
+
+void RegionGeometryStore::rasterize(
+    const tile::Id& source_id, const tile::Id& tile_id_out, nucleus::Raster<uint16_t>& output, const glm::uvec2& offset, const glm::uvec2& size) const
+{
+    const auto iter = m_sources.find(source_id);
+    assert(iter != m_sources.end());
+    if (iter == m_sources.end())
+        return;
+    const SourceTile& source = iter->second;
+    assert(tile_id_out.zoom_level >= source_id.zoom_level);
+    assert(tile_id_out.zoom_level <= source.max_zoom_level);
+
+    const unsigned level = std::min(tile_id_out.zoom_level - source_id.zoom_level, source.max_zoom_level - source_id.zoom_level);
+    const double tile_size = 1.0 / double(1u << tile_id_out.zoom_level);
+    const glm::dvec2 tile_min = glm::dvec2(tile_id_out.coords) * tile_size;
+    const glm::dvec2 tile_max = tile_min + tile_size;
+    const glm::dvec2 scale = glm::dvec2(size) / tile_size;
+
+    // Scratch memory reused across pieces to avoid allocations
+    std::vector<std::vector<float>> crossings(size.y);
+    std::vector<glm::vec2> vertices;
+    for (const auto& piece : source.pieces) {
+        if (piece.bounds.max.x < tile_min.x || piece.bounds.max.y < tile_min.y || piece.bounds.min.x > tile_max.x || piece.bounds.min.y > tile_max.y)
+            continue;
+        const auto& polygon = piece.simplified_polygons[level];
+        vertices.clear();
+        for (const auto& p : polygon)
+            vertices.emplace_back((p - tile_min) * scale);
+        detail::fill_polygon(vertices, piece.region->internal_id, output, offset, size, crossings);
+    }
+}
+
+const RegionGeometryStore::RegionGeometry* RegionGeometryStore::region(const QString& region_id) const
+{
+    const auto iter = m_regions.find(region_id);
+    return iter == m_regions.end() ? nullptr : &iter->second;
+}
+
+const RegionGeometryStore::SourceTile* RegionGeometryStore::source(const tile::Id& tile_id) const
+{
+    const auto iter = m_sources.find(tile_id);
+    return iter == m_sources.end() ? nullptr : &iter->second;
+}
+
+void RegionGeometryStore::evict_oldest_source()
+{
+    const tile::Id tile_id = m_ingestion_order.front();
+    m_ingestion_order.pop_front();
+    const auto source_iter = m_sources.find(tile_id);
+    assert(source_iter != m_sources.end());
+
+    // collect ids first, a region can have several pieces in one source and is erased together with its last source
+    std::vector<QString> region_ids;
+    for (const auto& piece : source_iter->second.pieces)
+        region_ids.push_back(piece.region->id);
+    for (const auto& region_id : region_ids) {
+        const auto region_iter = m_regions.find(region_id);
+        if (region_iter == m_regions.end())
+            continue;
+        auto& sources = region_iter->second.sources;
+        sources.erase(std::remove(sources.begin(), sources.end(), tile_id), sources.end());
+        // region bounds stay conservative (not shrunk) while other pieces remain
+        if (sources.empty())
+            m_regions.erase(region_iter);
+    }
+    m_sources.erase(source_iter);
+}
+
+} // namespace nucleus::avalanche
@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <deque>
+#include <memory>
+#include <nucleus/Raster.h>
+#include <nucleus/tile/types.h>
+#include <optional>
+#include <radix/geometry.h>
+#include <unordered_map>
+
+namespace nucleus::avalanche {
+class UIntIdManager;
+
+// Parse-once store of EAWS region geometry, shared across zoom levels.
+// Coordinates are normalised slippy map coordinates (zoom level 0 tile space, [0, 1]^2, y pointing south).
+// Vector tiles are clipped, therefore a region consists of one piece per ingested source tile. Every piece keeps a Douglas-Peucker
+// simplified polygon for each zoom level that can be rasterised from it (source zoom up to the zoom where the mvt extent runs out of detail).
+// Tiles covered by an already ingested source tile are rasterised from the store without parsing their mvt again.
+class RegionGeometryStore {
+public:
+    struct RegionGeometry {
+        QString id;
+        uint16_t internal_id = 0;
+        radix::geometry::Aabb<2, double> bounds; // union of all pieces
+        std::vector<tile::Id> sources;
+    };
+
+    struct Piece {
+        const RegionGeometry* region = nullptr;
+        radix::geometry::Aabb<2, double> bounds;
+        std::vector<std::vector<glm::dvec2>> simplified_polygons; // index is output zoom level - source zoom level
+    };
+
+    struct SourceTile {
+        unsigned max_zoom_level = 0; // finest output zoom level that can be rasterised from this source
+        std::vector<Piece> pieces;
+    };
+
+    RegionGeometryStore(std::shared_ptr<UIntIdManager> internal_id_manager, unsigned tile_resolution = 256, size_t max_n_source_tiles = 4096);
+
+    // Parses data (unless tile_id was ingested already) and adds its regions that are valid at the reference date of the id manager.
+    // Returns false if the data could not be parsed.
+    bool ingest(const QByteArray& data, const tile::Id& tile_id);
+
+    // Returns the finest ingested tile (tile_id itself or one of its parents) that has enough detail to rasterise tile_id.
+    [[nodiscard]] std::optional<tile::Id> covering_source(const tile::Id& tile_id) const;
+
+    // Writes internal region ids of all pieces of source into the sub-rectangle [offset, offset + size) of output. Only reads from the store.
+    void rasterize(const tile::Id& source, const tile::Id& tile_id_out, nucleus::Raster<uint16_t>& output, const glm::uvec2& offset, const glm::uvec2& size) const;
+
+    [[nodiscard]] const RegionGeometry* region(const QString& region_id) const;
+    [[nodiscard]] const SourceTile* source(const tile::Id& tile_id) const;
+    [[nodiscard]] size_t n_regions() const { return m_regions.size(); }
+    [[nodiscard]] size_t n_source_tiles() const { return m_sources.size(); }
+    [[nodiscard]] unsigned tile_resolution() const { return m_tile_resolution; }
+
+private:
+    void evict_oldest_source();
+
+    std::shared_ptr<UIntIdManager> m_internal_id_manager;
+    unsigned m_tile_resolution;
+    size_t m_max_n_source_tiles;
+    std::unordered_map<QString, RegionGeometry> m_regions; // node based, pointers to elements stay valid
+    std::unordered_map<tile::Id, SourceTile, tile::Id::Hasher> m_sources;
+    std::deque<tile::Id> m_ingestion_order;
+};
+
+namespace detail {
+    // Douglas-Peucker simplification of a closed polygon, the first vertex is always kept
+    std::vector<glm::dvec2> simplify_polygon(const std::vector<glm::dvec2>& polygon, double tolerance);
+} // namespace detail
+
+} // namespace nucleus::avalanche
@@ -20,6 +20,9 @@
 #include "Scheduler.h"
 #include "eaws.h"
 #include <QDate>
+#include <algorithm>
+#include <functional>
+#include <thread>
 #include <nucleus/utils/image_loader.h>
 
 namespace nucleus::avalanche {
@@ -29,6 +32,7 @@ Scheduler::Scheduler(const Settings& settings)
     , m_default_raster(glm::uvec2(settings.tile_resolution), 0)
 {
     m_uint_id_manager = std::make_shared<UIntIdManager>(QDate(2025, 7, 1));
+    m_region_store = std::make_unique<RegionGeometryStore>(m_uint_id_manager, settings.tile_resolution);
 }
 
 Scheduler::~Scheduler() = default;
@@ -42,7 +46,7 @@ void Scheduler::transform_and_emit(const std::vector<nucleus::tile::DataQuad>& n
     for (const auto& quad : new_quads) {
         nucleus::tile::GpuEawsTile gpu_tile_from_quad;
         gpu_tile_from_quad.id = quad.id;
-        nucleus::Raster<glm::uint16> quad_as_raster = to_raster(quad, m_default_raster, m_uint_id_manager);
+        nucleus::Raster<glm::uint16> quad_as_raster = to_raster(quad, m_default_raster, *m_region_store);
         gpu_tile_from_quad.texture = std::make_shared<nucleus::Raster<glm::uint16>>(quad_as_raster);
         new_gpu_tiles.push_back(gpu_tile_from_quad);
     }
@@ -51,53 +55,57 @@ void Scheduler::transform_and_emit(const std::vector<nucleus::tile::DataQuad>& n
 }
 
 nucleus::Raster<glm::uint16> Scheduler::to_raster(
-    const nucleus::tile::DataQuad& quad, const nucleus::Raster<glm::uint16>& default_raster, std::shared_ptr<UIntIdManager> uint_id_manager)
+    const nucleus::tile::DataQuad& quad, const nucleus::Raster<glm::uint16>& default_raster, RegionGeometryStore& region_store)
 {
-    std::array<Raster<glm::uint16>, 4> quad_rasters;
-    std::array<tile::Id, 4> quad_ids;
+    // All 4 tiles are rasterised directly into their quadrant of the quad raster
+    const glm::uvec2 tile_size = default_raster.size();
+    nucleus::Raster<glm::uint16> quad_as_raster(tile_size * 2u, glm::uint16(0));
+    const auto copy_default_raster = [&](const glm::uvec2& offset) {
+        for (unsigned y = 0; y < tile_size.y; ++y)
+            std::copy_n(&default_raster.pixel({ 0, y }), tile_size.x, &quad_as_raster.pixel({ offset.x, offset.y + y }));
+    };
+
+    // Parse tiles whose geometry is not in the store yet (neither from this nor from a coarser tile). Ingesting modifies the store, and might
+    // evict older sources, hence all ingestion is done before the sources are resolved.
     for (const auto& tile : quad.tiles) {
-        const auto quad_index = unsigned(quad_position(tile.id));
-        quad_ids[quad_index] = tile.id;
-        if (!tile.data->size()) {
-            // Data not available use default raster
-            quad_rasters[quad_index] = default_raster;
-            continue;
-        }
-
-        // Read vector tile from data
-        tl::expected<RegionTile, QString> result = vector_tile_reader(*tile.data, tile.id);
+        if (tile.data->size() && !region_store.covering_source(tile.id).has_value())
+            region_store.ingest(*tile.data, tile.id);
+    }
 
-        // could not read vector tile from data, use default raster
-        if (!result.has_value()) {
-            quad_rasters[quad_index] = default_raster;
+    struct Job {
+        tile::Id source;
+        tile::Id tile_id;
+        glm::uvec2 offset;
+    };
+    std::vector<Job> jobs;
+    for (const auto& tile : quad.tiles) {
+        const auto position = quad_position(tile.id);
+        const glm::uvec2 offset = tile_size
+            * glm::uvec2(position == tile::QuadPosition::TopRight || position == tile::QuadPosition::BottomRight,
+                position == tile::QuadPosition::BottomLeft || position == tile::QuadPosition::BottomRight);
+        const auto source = tile.data->size() ? region_store.covering_source(tile.id) : std::nullopt;
+        if (!source.has_value()) {
+            // Data not available or could not be read, use default raster
+            copy_default_raster(offset);
             continue;
         }
-
-        // Reading tile worked. Create qimage with color coded eaws regions for current tile
-        RegionTile eaws_region_tile = result.value();
-        QImage eawsImage = draw_regions(eaws_region_tile, uint_id_manager, 256, 256, tile.id);
-
-        // Convert Qimage to raster with a 16bit uint region id
-        nucleus::Raster<glm::uint16> eaws_raster_16bit(glm::uvec2(256, 256), 0);
-        for (int i = 0; i < 256; i++) {
-            for (int j = 0; j < 256; j++) {
-                glm::u8vec4 color_vector_8bit(0, 0, 0, 0);
-                QColor color = eawsImage.pixelColor(QPoint(i, j));
-                color_vector_8bit.x = static_cast<uint8_t>(color.red());
-                color_vector_8bit.y = static_cast<uint8_t>(color.green());
-                eaws_raster_16bit.pixel(glm::uvec2(i, j)) = 256 * color_vector_8bit.x + color_vector_8bit.y;
-            }
-        }
-
-        // Collect raster of current tile in quad
-        quad_rasters[quad_index] = nucleus::Raster<glm::uint16>(eaws_raster_16bit);
+        jobs.push_back({ *source, tile.id, offset });
     }
 
-    // Merge 4 tiles from quad into one raster representing the quad
-    nucleus::Raster<glm::uint16> quad_as_raster
-        = nucleus::concatenate_horizontally(quad_rasters[unsigned(tile::QuadPosition::TopLeft)], quad_rasters[unsigned(tile::QuadPosition::TopRight)]);
-    quad_as_raster.append_vertically(
-        nucleus::concatenate_horizontally(quad_rasters[unsigned(tile::QuadPosition::BottomLeft)], quad_rasters[unsigned(tile::QuadPosition::BottomRight)]));
+    // Write internal region ids of every tile into its quadrant. The quadrants are disjoint, so the tiles are rasterised concurrently.
+    const auto rasterize = [&](const Job& job) { region_store.rasterize(job.source, job.tile_id, quad_as_raster, job.offset, tile_size); };
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+    std::vector<std::thread> threads;
+    threads.reserve(jobs.size());
+    for (size_t i = 1; i < jobs.size(); ++i)
+        threads.emplace_back(rasterize, std::cref(jobs[i]));
+    if (!jobs.empty())
+        rasterize(jobs.front());
+    for (auto& thread : threads)
+        thread.join();
+#else
+    std::for_each(jobs.begin(), jobs.end(), rasterize);
+#endif
 
     // return raster represntation of provided quad
     return quad_as_raster;
@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <nucleus/avalanche/RegionGeometryStore.h>
 #include <nucleus/avalanche/UIntIdManager.h>
 #include <nucleus/tile/Scheduler.h>
 #include <nucleus/tile/types.h>
@@ -28,9 +29,11 @@ class Scheduler : public nucleus::tile::Scheduler {
 public:
     Scheduler(const Scheduler::Settings& settings);
     ~Scheduler();
+    // tiles covered by geometry already in region_store are rasterised from there, all others are parsed and added to it
     static nucleus::Raster<glm::uint16> to_raster(
-        const nucleus::tile::DataQuad& quad, const nucleus::Raster<glm::uint16>& default_raster, std::shared_ptr<UIntIdManager> uint_id_manager);
+        const nucleus::tile::DataQuad& quad, const nucleus::Raster<glm::uint16>& default_raster, RegionGeometryStore& region_store);
     std::shared_ptr<UIntIdManager> get_uint_id_manager() { return m_uint_id_manager; }
+    const RegionGeometryStore& region_store() const { return *m_region_store; }
 
 signals:
     void gpu_tiles_updated(const std::vector<nucleus::tile::Id>& deleted_quads, const std::vector<nucleus::tile::GpuEawsTile>& new_tiles);
@@ -41,6 +44,7 @@ protected:
 private:
     nucleus::Raster<glm::uint16> m_default_raster;
     std::shared_ptr<UIntIdManager> m_uint_id_manager;
+    std::unique_ptr<RegionGeometryStore> m_region_store;
 };
 
 } // namespace nucleus::avalanche
@@ -26,6 +26,7 @@
 #include <QNetworkReply>
 #include <QNetworkRequest>
 #include <algorithm>
+#include <cmath>
 #include <extern/radix/src/radix/tile.h>
 #include <nucleus/tile/conversion.h>
 #include <nucleus/vector_tile/util.h>
@@ -98,13 +99,9 @@ tl::expected<RegionTile, QString> vector_tile_reader(const QByteArray& input_dat
     return tl::expected<RegionTile, QString>(RegionTile(tile_id, regions_to_be_returned));
 }
 
-// Auxillary function: Calculates new coordinates of a region boundary after zoom in / out
-std::vector<QPointF> transform_vertices(const Region& region, const radix::tile::Id& tile_id_in, const radix::tile::Id& tile_id_out, QImage* img)
+// Auxillary function: Calculates origin and scale of the output tile relative to the input tile (in local coordinates of the input tile)
+std::pair<glm::vec2, float> relative_transform(const radix::tile::Id& tile_id_in, const radix::tile::Id& tile_id_out)
 {
-    // Check if input is consistent
-    assert(img->devicePixelRatio() == 1.0);
-    assert((region.resolution.x > 0 && region.resolution.y > 0));
-    assert((img->width() > 0 && img->height() > 0));
     assert(tile_id_in.coords.x < qPow(2, tile_id_in.zoom_level));
     assert(tile_id_in.coords.y < qPow(2, tile_id_in.zoom_level));
     assert(tile_id_out.coords.x < qPow(2, tile_id_out.zoom_level));
@@ -151,6 +148,18 @@ std::vector<QPointF> transform_vertices(const Region& region, const radix::tile:
     }
     */
 
+    return { relative_origin, relative_zoom };
+}
+
+// Auxillary function: Calculates new coordinates of a region boundary after zoom in / out
+std::vector<QPointF> transform_vertices(const Region& region, const radix::tile::Id& tile_id_in, const radix::tile::Id& tile_id_out, QImage* img)
+{
+    // Check if input is consistent
+    assert(img->devicePixelRatio() == 1.0);
+    assert((region.resolution.x > 0 && region.resolution.y > 0));
+    assert((img->width() > 0 && img->height() > 0));
+    const auto [relative_origin, relative_zoom] = relative_transform(tile_id_in, tile_id_out);
+
     // Transform boundary according to input/output tile parameters
     std::vector<QPointF> transformed_vertices_as_QPointFs;
     for (const glm::vec2& vec_in : region.vertices_in_local_coordinates) {
@@ -203,6 +212,98 @@ QImage draw_regions(const RegionTile& region_tile,
     return img;
 }
 
+std::vector<uint16_t> internal_region_ids(const RegionTile& region_tile, UIntIdManager& internal_id_manager)
+{
+    const QDate reference_date = internal_id_manager.get_reference_date();
+    std::vector<uint16_t> internal_ids;
+    internal_ids.reserve(region_tile.second.size());
+    for (const auto& region : region_tile.second) {
+        if ((region.start_date.has_value() && region.start_date > reference_date) || (region.end_date.has_value() && region.end_date < reference_date)) {
+            internal_ids.push_back(0);
+            continue;
+        }
+        internal_ids.push_back(uint16_t(internal_id_manager.convert_region_id_to_internal_id(region.id)));
+    }
+    return internal_ids;
+}
+
+namespace detail {
+    void fill_polygon(const std::vector<glm::vec2>& vertices,
+        uint16_t value,
+        nucleus::Raster<uint16_t>& output,
+        const glm::uvec2& offset,
+        const glm::uvec2& size,
+        std::vector<std::vector<float>>& crossings)
+    {
+        assert(crossings.size() >= size.y);
+        assert(offset.x + size.x <= output.width() && offset.y + size.y <= output.height());
+        const glm::vec2 max_pixel = glm::vec2(size);
+
+        // Collect crossings of every edge (polygon is implicitly closed) with the horizontal lines through the pixel centres
+        int first_row = int(size.y);
+        int last_row = -1;
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            const glm::vec2& a = vertices[i];
+            const glm::vec2& b = vertices[(i + 1) % vertices.size()];
+            if (a.y == b.y)
+                continue;
+            const glm::vec2& top = (a.y < b.y) ? a : b;
+            const glm::vec2& bottom = (a.y < b.y) ? b : a;
+            // rows whose centre y + 0.5 lies in [top.y, bottom.y). clamp in float to avoid overflow for far away vertices
+            const int row_begin = int(std::clamp(std::ceil(top.y - 0.5f), 0.f, max_pixel.y));
+            const int row_end = int(std::clamp(std::ceil(bottom.y - 0.5f), 0.f, max_pixel.y));
+            if (row_begin >= row_end)
+                continue;
+            const float dx_dy = (bottom.x - top.x) / (bottom.y - top.y);
+            for (int y = row_begin; y < row_end; ++y)
+                crossings[y].push_back(top.x + (float(y) + 0.5f - top.y) * dx_dy);
+            first_row = std::min(first_row, row_begin);
+            last_row = std::max(last_row, row_end - 1);
+        }
+
+        // Fill between pairs of crossings (even-odd rule, same as QPainter::drawPolygon), sampling at pixel centres
+        for (int y = first_row; y <= last_row; ++y) {
+            auto& row = crossings[y];
+            std::sort(row.begin(), row.end());
+            uint16_t* line = &output.pixel({ offset.x, offset.y + unsigned(y) });
+            for (size_t i = 0; i + 1 < row.size(); i += 2) {
+                const int x_begin = int(std::clamp(std::ceil(row[i] - 0.5f), 0.f, max_pixel.x));
+                const int x_end = int(std::clamp(std::ceil(row[i + 1] - 0.5f), 0.f, max_pixel.x));
+                if (x_begin < x_end)
+                    std::fill(line + x_begin, line + x_end, value);
+            }
+            row.clear();
+        }
+    }
+} // namespace detail
+
+void rasterize_regions_into(const RegionTile& region_tile,
+    const std::vector<uint16_t>& internal_ids,
+    const radix::tile::Id& tile_id_out,
+    nucleus::Raster<uint16_t>& output,
+    const glm::uvec2& offset,
+    const glm::uvec2& size)
+{
+    assert(internal_ids.size() == region_tile.second.size());
+    const auto [relative_origin, relative_zoom] = relative_transform(region_tile.first, tile_id_out);
+    const glm::vec2 scale = glm::vec2(size) * relative_zoom;
+
+    // Scratch memory reused across regions to avoid allocations
+    std::vector<std::vector<float>> crossings(size.y);
+    std::vector<glm::vec2> vertices;
+    for (size_t region_index = 0; region_index < region_tile.second.size(); ++region_index) {
+        const uint16_t internal_id = internal_ids[region_index];
+        const auto& local_vertices = region_tile.second[region_index].vertices_in_local_coordinates;
+        if (internal_id == 0 || local_vertices.size() < 3)
+            continue;
+
+        vertices.clear();
+        for (const auto& v : local_vertices)
+            vertices.push_back((v - relative_origin) * scale);
+        detail::fill_polygon(vertices, internal_id, output, offset, size, crossings);
+    }
+}
+
 nucleus::Raster<uint16_t> rasterize_regions(const RegionTile& region_tile,
     std::shared_ptr<UIntIdManager> internal_id_manager,
     const uint raster_width,
@@ -82,4 +82,31 @@ nucleus::Raster<uint16_t> rasterize_regions(const RegionTile& region_tile,
 
 // Overload: Output has same resolution as EAWS regions, throws error when regions.size() == 0
 nucleus::Raster<uint16_t> rasterize_regions(const RegionTile& region_tile, std::shared_ptr<UIntIdManager> internal_id_manager);
+
+// Returns the internal id for every region of region_tile (same order). Regions that are not valid at the reference date of the manager get id 0.
+std::vector<uint16_t> internal_region_ids(const RegionTile& region_tile, UIntIdManager& internal_id_manager);
+
+// Scanline rasteriser writing internal region ids straight into the sub-rectangle [offset, offset + size) of output (no QPainter/QImage round-trip).
+// Regions with internal id 0 are skipped, pixels outside of all regions are left untouched. Only output is written, hence several tiles can be
+// rasterised concurrently into disjoint sub-rectangles of the same raster.
+// Unlike draw_regions, the outline is not stroked with a 1 pixel pen: a pixel belongs to a region iff its centre is inside. Regions are
+// therefore up to half a pixel thinner, and pixels on a shared boundary can go to the other region (or stay untouched on outer boundaries).
+// Note: tile_id_out must have greater or equal zoomlevel than tile_id_in
+void rasterize_regions_into(const RegionTile& region_tile,
+    const std::vector<uint16_t>& internal_ids,
+    const radix::tile::Id& tile_id_out,
+    nucleus::Raster<uint16_t>& output,
+    const glm::uvec2& offset,
+    const glm::uvec2& size);
+
+namespace detail {
+    // Even-odd scanline fill (sampling at pixel centres) of a polygon given in pixel coordinates of the sub-rectangle [offset, offset + size) of output.
+    // crossings is scratch memory with at least size.y empty rows, it is left empty.
+    void fill_polygon(const std::vector<glm::vec2>& vertices,
+        uint16_t value,
+        nucleus::Raster<uint16_t>& output,
+        const glm::uvec2& offset,
+        const glm::uvec2& size,
+        std::vector<std::vector<float>>& crossings);
+} // namespace detail
 } // namespace nucleus::avalanche
@@ -43,6 +43,13 @@ Controller::Controller(const Definition& camera, AbstractDepthTester* depth_test
     connect(this, &Controller::definition_changed, &m_recorder, &recording::Device::record);
 }
 
+void Controller::set_cpu_ray_casting(bool enabled)
+{
+    m_raycast_depth_tester.reset();
+    if (enabled && m_depth_tester && m_data_querier && m_data_querier->can_ray_cast())
+        m_raycast_depth_tester = std::make_unique<RaycastDepthTester>(m_definition, m_data_querier, m_depth_tester);
+}
+
 void Controller::set_near_plane(float distance)
 {
     if (m_definition.near_plane() == distance)
@@ -76,7 +83,7 @@ void Controller::fly_to_latitude_longitude(double latitude, double longitude)
 
 void Controller::rotate_north()
 {
-    m_animation_style = std::make_unique<RotateNorthAnimation>(m_definition, m_depth_tester);
+    m_animation_style = std::make_unique<RotateNorthAnimation>(m_definition, depth_tester());
     update();
 }
 
@@ -116,10 +123,10 @@ void Controller::mouse_press(const event_parameter::Mouse& e)
 
     if (m_animation_style) {
         m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
+        m_interaction_style->reset_interaction(m_definition, depth_tester());
     }
 
-    const auto new_definition = m_interaction_style->mouse_press_event(e, m_definition, m_depth_tester);
+    const auto new_definition = m_interaction_style->mouse_press_event(e, m_definition, depth_tester());
     if (!new_definition)
         return;
     m_definition = new_definition.value();
@@ -132,9 +139,9 @@ void Controller::mouse_move(const event_parameter::Mouse& e)
         if (e.button == Qt::NoButton)
             return;
         m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
+        m_interaction_style->reset_interaction(m_definition, depth_tester());
     }
-    const auto new_definition = m_interaction_style->mouse_move_event(e, m_definition, m_depth_tester);
+    const auto new_definition = m_interaction_style->mouse_move_event(e, m_definition, depth_tester());
     if (!new_definition)
         return;
 
@@ -147,10 +154,10 @@ void Controller::wheel_turn(const event_parameter::Wheel& e)
 {
     if (m_animation_style) {
         m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
+        m_interaction_style->reset_interaction(m_definition, depth_tester());
     }
 
-    const auto new_definition = m_interaction_style->wheel_event(e, m_definition, m_depth_tester);
+    const auto new_definition = m_interaction_style->wheel_event(e, m_definition, depth_tester());
     if (!new_definition)
         return;
     m_definition = new_definition.value();
@@ -161,7 +168,7 @@ void Controller::key_press(const QKeyCombination& e)
 {
     if (m_animation_style) {
         m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
+        m_interaction_style->reset_interaction(m_definition, depth_tester());
     }
 
     if (e.key() == Qt::Key_1) {
@@ -190,7 +197,7 @@ void Controller::key_press(const QKeyCombination& e)
 
     const auto new_definition = m_interaction_style->key_press_event(e,
                                                                      m_definition,
-                                                                     m_depth_tester);
+                                                                     depth_tester());
     if (!new_definition)
         return;
     m_definition = new_definition.value();
@@ -199,7 +206,7 @@ void Controller::key_press(const QKeyCombination& e)
 
 void Controller::key_release(const QKeyCombination& e)
 {
-    const auto new_definition = m_interaction_style->key_release_event(e, m_definition, m_depth_tester);
+    const auto new_definition = m_interaction_style->key_release_event(e, m_definition, depth_tester());
     if (!new_definition)
         return;
     m_definition = new_definition.value();
@@ -210,10 +217,10 @@ void Controller::touch(const event_parameter::Touch& e)
 {
     if (m_animation_style) {
         m_animation_style.reset();
-        m_interaction_style->reset_interaction(m_definition, m_depth_tester);
+        m_interaction_style->reset_interaction(m_definition, depth_tester());
     }
 
-    const auto new_definition = m_interaction_style->touch_event(e, m_definition, m_depth_tester);
+    const auto new_definition = m_interaction_style->touch_event(e, m_definition, depth_tester());
     if (!new_definition)
         return;
     m_definition = new_definition.value();
@@ -223,16 +230,16 @@ void Controller::touch(const event_parameter::Touch& e)
 void Controller::advance_camera()
 {
     if (m_animation_style) {
-        const auto new_camera_definition = m_animation_style->update(m_definition, m_depth_tester);
+        const auto new_camera_definition = m_animation_style->update(m_definition, depth_tester());
         if (!new_camera_definition) {
             m_animation_style.reset();
-            m_interaction_style->reset_interaction(m_definition, m_depth_tester);
+            m_interaction_style->reset_interaction(m_definition, depth_tester());
             return;
         }
         m_definition = new_camera_definition.value();
         update();
     } else {
-        const auto new_definition = m_interaction_style->update(m_definition, m_depth_tester);
+        const auto new_definition = m_interaction_style->update(m_definition, depth_tester());
         if (!new_definition)
             return;
         m_definition = new_definition.value();
@@ -257,7 +264,7 @@ std::optional<float> Controller::operation_centre_distance()
 }
 
 void Controller::report_global_cursor_position(const QPointF& screen_pos) {
-    auto pos = m_depth_tester->position(m_definition.to_ndc({ screen_pos.x(), screen_pos.y() }));
+    auto pos = depth_tester()->position(m_definition.to_ndc({ screen_pos.x(), screen_pos.y() }));
     auto coord = srs::world_to_lat_long_alt(pos);
     emit global_cursor_position_changed(coord);
 }
@@ -284,3 +291,9 @@ void Controller::set_model_matrix(const Definition& new_definition)
     update();
 }
 
+AbstractDepthTester* Controller::depth_tester() const
+{
+    if (m_raycast_depth_tester)
+        return m_raycast_depth_tester.get();
+    return m_depth_tester;
+}
@@ -23,6 +23,7 @@
 #include "AnimationStyle.h"
 #include "Definition.h"
 #include "InteractionStyle.h"
+#include "RaycastDepthTester.h"
 #include "recording.h"
 #include <QObject>
 #include <glm/glm.hpp>
@@ -52,6 +53,9 @@ public:
 	void report_global_cursor_position(const QPointF& screen_pos);
 
 public slots:
+    // answer depth queries by casting rays against the loaded terrain on the cpu instead of reading back the gpu depth buffer.
+    // the depth tester given in the constructor still answers rays that miss. has no effect if the data querier can't ray cast.
+    void set_cpu_ray_casting(bool enabled);
     void set_pixel_error_threshold(float threshold);
     void set_model_matrix(const Definition& new_definition);
     void set_near_plane(float distance);
@@ -78,10 +82,12 @@ signals:
 private:
     void set_interaction_style(std::unique_ptr<InteractionStyle> new_style);
     void set_animation_style(std::unique_ptr<InteractionStyle> new_style);
+    [[nodiscard]] AbstractDepthTester* depth_tester() const;
 
     recording::Device m_recorder;
     Definition m_definition;
     AbstractDepthTester* m_depth_tester;
+    std::unique_ptr<RaycastDepthTester> m_raycast_depth_tester; // set_cpu_ray_casting, falls back to m_depth_tester
     DataQuerier* m_data_querier;
     std::unique_ptr<InteractionStyle> m_interaction_style;
     std::unique_ptr<AnimationStyle> m_animation_style;
@@ -0,0 +1,56 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "RaycastDepthTester.h"
+
+#include "Definition.h"
+#include <cassert>
+#include <nucleus/DataQuerier.h>
+
+namespace nucleus::camera {
+
+RaycastDepthTester::RaycastDepthTester(const Definition& camera, const DataQuerier* data_querier, AbstractDepthTester* fallback)
+    : m_camera(camera)
+    , m_data_querier(data_querier)
+    , m_fallback(fallback)
+{
+    assert(m_fallback);
+}
+
+float RaycastDepthTester::depth(const glm::dvec2& normalised_device_coordinates)
+{
+    if (const auto hit = ray_cast(normalised_device_coordinates))
+        return float(glm::distance(m_camera.position(), *hit));
+    return m_fallback->depth(normalised_device_coordinates);
+}
+
+glm::dvec3 RaycastDepthTester::position(const glm::dvec2& normalised_device_coordinates)
+{
+    if (const auto hit = ray_cast(normalised_device_coordinates))
+        return *hit;
+    return m_fallback->position(normalised_device_coordinates);
+}
+
+std::optional<glm::dvec3> RaycastDepthTester::ray_cast(const glm::dvec2& normalised_device_coordinates) const
+{
+    if (!m_data_querier)
+        return {};
+    return m_data_querier->ray_cast(m_camera.position(), m_camera.ray_direction(normalised_device_coordinates));
+}
+
+} // namespace nucleus::camera
@@ -0,0 +1,48 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include "AbstractDepthTester.h"
+#include <optional>
+
+namespace nucleus {
+class DataQuerier;
+}
+
+namespace nucleus::camera {
+
+// Depth tester casting rays against the terrain on the cpu (DataQuerier::ray_cast), so interaction doesn't block on a gpu readback.
+// Rays that don't hit any loaded terrain are answered by the fallback (usually the renderer's depth tester), so a miss is reported
+// exactly as the fallback reports it and callers keep their handling of sky and unloaded terrain.
+class RaycastDepthTester : public AbstractDepthTester {
+public:
+    RaycastDepthTester(const Definition& camera, const DataQuerier* data_querier, AbstractDepthTester* fallback);
+
+    [[nodiscard]] float depth(const glm::dvec2& normalised_device_coordinates) override;
+    [[nodiscard]] glm::dvec3 position(const glm::dvec2& normalised_device_coordinates) override;
+
+private:
+    [[nodiscard]] std::optional<glm::dvec3> ray_cast(const glm::dvec2& normalised_device_coordinates) const;
+
+    const Definition& m_camera;
+    const DataQuerier* m_data_querier;
+    AbstractDepthTester* m_fallback;
+};
+
+} // namespace nucleus::camera
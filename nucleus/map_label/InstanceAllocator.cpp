@@ -0,0 +1,170 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "InstanceAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace nucleus::map_label {
+
+InstanceAllocator::InstanceAllocator(unsigned initial_capacity)
+    : m_capacity(std::max(initial_capacity, 1u))
+    , m_free_ranges({ InstanceRange { 0, m_capacity } })
+{
+}
+
+const InstanceAllocator::Allocation& InstanceAllocator::allocate(const tile::Id& id, unsigned n_instances, const glm::dvec3& reference_point)
+{
+    free(id);
+
+    Allocation allocation;
+    allocation.reference_point = reference_point;
+    if (m_free_slots.empty()) {
+        allocation.slot = m_slot_capacity++;
+    } else {
+        allocation.slot = m_free_slots.back();
+        m_free_slots.pop_back();
+    }
+
+    if (n_instances > 0) {
+        auto fit = std::find_if(m_free_ranges.begin(), m_free_ranges.end(), [&](const InstanceRange& r) { return r.count >= n_instances; });
+        while (fit == m_free_ranges.end()) {
+            release_range({ m_capacity, m_capacity });
+            m_capacity *= 2;
+            fit = std::find_if(m_free_ranges.begin(), m_free_ranges.end(), [&](const InstanceRange& r) { return r.count >= n_instances; });
+        }
+        allocation.range = { fit->first, n_instances };
+        fit->first += n_instances;
+        fit->count -= n_instances;
+        if (fit->count == 0)
+            m_free_ranges.erase(fit);
+        m_n_allocated_instances += n_instances;
+    }
+
+    return m_allocations[id] = allocation;
+}
+
+std::optional<InstanceAllocator::Allocation> InstanceAllocator::free(const tile::Id& id)
+{
+    const auto it = m_allocations.find(id);
+    if (it == m_allocations.end())
+        return {};
+    const auto allocation = it->second;
+    m_allocations.erase(it);
+
+    m_free_slots.push_back(allocation.slot);
+    if (allocation.range.count > 0) {
+        release_range(allocation.range);
+        m_n_allocated_instances -= allocation.range.count;
+    }
+    return allocation;
+}
+
+const InstanceAllocator::Allocation* InstanceAllocator::find(const tile::Id& id) const
+{
+    const auto it = m_allocations.find(id);
+    if (it == m_allocations.end())
+        return nullptr;
+    return &it->second;
+}
+
+void InstanceAllocator::release_range(const InstanceRange& range)
+{
+    assert(range.count > 0);
+    auto next = std::lower_bound(m_free_ranges.begin(), m_free_ranges.end(), range, [](const InstanceRange& a, const InstanceRange& b) { return a.first < b.first; });
+    assert(next == m_free_ranges.end() || next->first >= range.end());
+    if (next != m_free_ranges.begin()) {
+        auto previous = std::prev(next);
+        assert(previous->end() <= range.first);
+        if (previous->end() == range.first) {
+            previous->count += range.count;
+            if (next != m_free_ranges.end() && next->first == previous->end()) {
+                previous->count += next->count;
+                m_free_ranges.erase(next);
+            }
+            return;
+        }
+    }
+    if (next != m_free_ranges.end() && next->first == range.end()) {
+        next->first = range.first;
+        next->count += range.count;
+        return;
+    }
+    m_free_ranges.insert(next, range);
+}
+
+std::vector<InstanceRange> visible_ranges(const InstanceAllocator& allocator, const tile::DrawListGenerator::TileSet& visible_tiles, unsigned max_n_ranges)
+{
+    assert(max_n_ranges > 0);
+    std::vector<InstanceRange> ranges;
+    ranges.reserve(visible_tiles.size());
+    for (const auto& id : visible_tiles) {
+        const auto* allocation = allocator.find(id);
+        if (allocation && allocation->range.count > 0)
+            ranges.push_back(allocation->range);
+    }
+    if (ranges.empty())
+        return ranges;
+    std::sort(ranges.begin(), ranges.end(), [](const InstanceRange& a, const InstanceRange& b) { return a.first < b.first; });
+
+    // the gaps that stay open are the largest ones. gaps[i] is between ranges[i] and ranges[i + 1], adjacent ranges have a gap of 0.
+    std::vector<unsigned> split_after;
+    split_after.reserve(ranges.size() - 1);
+    for (unsigned i = 0; i + 1 < ranges.size(); ++i) {
+        if (ranges[i + 1].first > ranges[i].end())
+            split_after.push_back(i);
+    }
+    const auto gap = [&](unsigned i) { return ranges[i + 1].first - ranges[i].end(); };
+    if (split_after.size() > max_n_ranges - 1) {
+        std::nth_element(split_after.begin(), split_after.begin() + (max_n_ranges - 1), split_after.end(), [&](unsigned a, unsigned b) { return gap(a) > gap(b); });
+        split_after.resize(max_n_ranges - 1);
+        std::sort(split_after.begin(), split_after.end());
+    }
+
+    std::vector<InstanceRange> merged;
+    merged.reserve(split_after.size() + 1);
+    unsigned first = ranges.front().first;
+    for (const auto i : split_after) {
+        merged.push_back({ first, ranges[i].end() - first });
+        first = ranges[i + 1].first;
+    }
+    merged.push_back({ first, ranges.back().end() - first });
+    return merged;
+}
+
+void pack_slots(const InstanceAllocator& allocator,
+    const tile::DrawListGenerator::TileSet& visible_tiles,
+    const glm::dvec3& camera_position,
+    unsigned width,
+    Raster<glm::vec4>& slots)
+{
+    assert(width > 0);
+    const auto size = glm::uvec2(width, (allocator.slot_capacity() + width - 1) / width);
+    if (slots.size() != size)
+        slots = Raster<glm::vec4>(size, glm::vec4(0));
+    else
+        slots.fill(glm::vec4(0));
+
+    for (const auto& [id, allocation] : allocator.allocations()) {
+        const auto visible = allocation.range.count > 0 && visible_tiles.contains(id);
+        slots.pixel({ allocation.slot % width, allocation.slot / width }) = glm::vec4(glm::vec3(allocation.reference_point - camera_position), visible ? 1.0f : 0.0f);
+    }
+}
+
+} // namespace nucleus::map_label
@@ -0,0 +1,93 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <optional>
+#include <vector>
+
+#include <nucleus/Raster.h>
+#include <nucleus/tile/DrawListGenerator.h>
+#include <nucleus/tile/types.h>
+
+namespace nucleus::map_label {
+
+struct InstanceRange {
+    unsigned first = 0;
+    unsigned count = 0;
+
+    [[nodiscard]] unsigned end() const { return first + count; }
+    bool operator==(const InstanceRange&) const = default;
+};
+
+// Sub-allocates the label instances of all tiles in one shared instance buffer, so that the labels of all visible tiles can be drawn with a
+// constant number of draw calls. Every tile also gets a slot, which indexes its reference point and visibility in a small per frame texture
+// (see pack_slots). Slot 0 is never handed out, it marks instances that are not allocated.
+//
+// Free ranges are kept sorted and coalesced, allocation is first fit. If nothing fits, the capacity is doubled, and the gpu buffer has to
+// be reallocated (keeping its content).
+class InstanceAllocator {
+public:
+    struct Allocation {
+        InstanceRange range;
+        unsigned slot = 0;
+        glm::dvec3 reference_point = {};
+    };
+
+    explicit InstanceAllocator(unsigned initial_capacity = 4096);
+
+    // replaces a previous allocation of the tile
+    const Allocation& allocate(const tile::Id& id, unsigned n_instances, const glm::dvec3& reference_point);
+    // returns the freed allocation, so that its instances can be hidden on the gpu
+    std::optional<Allocation> free(const tile::Id& id);
+    [[nodiscard]] const Allocation* find(const tile::Id& id) const;
+
+    [[nodiscard]] unsigned capacity() const { return m_capacity; }
+    // one more than the largest slot that was ever handed out, i.e., the number of texels needed for pack_slots
+    [[nodiscard]] unsigned slot_capacity() const { return m_slot_capacity; }
+    [[nodiscard]] unsigned n_allocated_instances() const { return m_n_allocated_instances; }
+    [[nodiscard]] unsigned n_tiles() const { return unsigned(m_allocations.size()); }
+    [[nodiscard]] const std::vector<InstanceRange>& free_ranges() const { return m_free_ranges; }
+    [[nodiscard]] const tile::IdMap<Allocation>& allocations() const { return m_allocations; }
+
+private:
+    void release_range(const InstanceRange& range);
+
+    unsigned m_capacity = 0;
+    unsigned m_n_allocated_instances = 0;
+    unsigned m_slot_capacity = 1;
+    std::vector<InstanceRange> m_free_ranges; // sorted by first, no two are adjacent
+    std::vector<unsigned> m_free_slots;
+    tile::IdMap<Allocation> m_allocations;
+};
+
+// Instance ranges of the visible tiles, sorted and merged into at most max_n_ranges ranges. The smallest gaps are closed first. Instances
+// in the closed gaps are drawn as well, the shader hides them because their slot is not visible.
+[[nodiscard]] std::vector<InstanceRange> visible_ranges(
+    const InstanceAllocator& allocator, const tile::DrawListGenerator::TileSet& visible_tiles, unsigned max_n_ranges);
+
+// Writes per slot texels: xyz is the reference point relative to the camera, w is 1 for visible tiles and 0 otherwise. The raster is resized
+// to hold slot_capacity texels in rows of the given width (i.e., slot s is at (s % width, s / width)).
+void pack_slots(const InstanceAllocator& allocator,
+    const tile::DrawListGenerator::TileSet& visible_tiles,
+    const glm::dvec3& camera_position,
+    unsigned width,
+    Raster<glm::vec4>& slots);
+
+} // namespace nucleus::map_label
@@ -18,6 +18,7 @@
  *****************************************************************************/
 
 #include "Scheduler.h"
+#include <QDebug>
 #include <nucleus/vector_tile/parse.h>
 
 namespace nucleus::map_label {
@@ -31,26 +32,51 @@ Scheduler::~Scheduler() = default;
 
 void Scheduler::transform_and_emit(const std::vector<tile::DataQuad>& new_quads, const std::vector<tile::Id>& deleted_quads)
 {
+    std::vector<tile::Id> deleted_tiles;
+    deleted_tiles.reserve(deleted_quads.size() * 4);
+    for (const auto& quad_id : deleted_quads) {
+        for (const auto& tile_id : quad_id.children()) {
+            deleted_tiles.push_back(tile_id);
+            const auto iter = m_pick_ids_per_tile.find(tile_id);
+            if (iter == m_pick_ids_per_tile.end())
+                continue;
+            for (const auto pick_id : iter->second)
+                m_pick_ids.erase(pick_id);
+            m_pick_ids_per_tile.erase(iter);
+        }
+    }
+
     std::vector<vector_tile::PoiTile> new_gpu_tiles;
     new_gpu_tiles.reserve(new_quads.size() * 4);
+    unsigned n_unpickable = 0;
     for (const auto& data_quad : new_quads) {
         assert(data_quad.n_tiles == 4);
         for (const auto& data_tile : data_quad.tiles) {
             vector_tile::PoiTile gpu_tile;
             gpu_tile.id = data_tile.id;
             auto pois = nucleus::vector_tile::parse::points_of_interest(*data_tile.data, dataquerier().get());
+
+            // the pick id is baked into the labels, the picker looks it up in its mirror of m_pick_ids
+            auto& pick_ids = m_pick_ids_per_tile[data_tile.id];
+            for (const auto pick_id : pick_ids)
+                m_pick_ids.erase(pick_id);
+            pick_ids.clear();
+            pick_ids.reserve(pois.size());
+            for (auto& poi : pois) {
+                // all slots in use: the poi keeps invalid_id, its label is drawn but can't be picked
+                poi.id = m_pick_ids.insert(data_tile.id);
+                if (poi.id != picker::SlotTable<tile::Id>::invalid_id)
+                    pick_ids.push_back(uint32_t(poi.id));
+                else
+                    ++n_unpickable;
+            }
+
             gpu_tile.data = std::make_shared<vector_tile::PointOfInterestCollection>(std::move(pois));
             new_gpu_tiles.emplace_back(gpu_tile);
         }
     };
-
-    std::vector<tile::Id> deleted_tiles;
-    deleted_tiles.reserve(deleted_quads.size() * 4);
-    for (const auto& quad_id : deleted_quads) {
-        for (const auto& tile_id : quad_id.children()) {
-            deleted_tiles.push_back(tile_id);
-        }
-    }
+    if (n_unpickable > 0)
+        qWarning() << "map_label::Scheduler: all" << picker::SlotTable<tile::Id>::max_size << "pick ids are in use," << n_unpickable << "pois are not pickable";
 
     emit gpu_tiles_updated(new_gpu_tiles, deleted_tiles);
 }
@@ -18,8 +18,10 @@
 
 #pragma once
 
+#include <nucleus/picker/SlotTable.h>
 #include <nucleus/tile/Scheduler.h>
 #include <nucleus/vector_tile/types.h>
+#include <unordered_map>
 
 namespace nucleus::map_label {
 
@@ -40,6 +42,9 @@ protected:
 
 private:
     nucleus::tile::MemoryCache* m_geometry_ram_cache = nullptr;
+    // pick ids of the pois that were shipped, they are released when the tile is deleted
+    picker::SlotTable<tile::Id> m_pick_ids;
+    std::unordered_map<tile::Id, std::vector<uint32_t>, tile::Id::Hasher> m_pick_ids_per_tile;
 };
 
 } // namespace nucleus::map_label
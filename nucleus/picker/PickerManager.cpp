@@ -61,11 +61,12 @@ void PickerManager::eval_pick(uint32_t value)
 
     if (type == FeatureType::PointOfInterest) {
         const auto internal_id = value & 16777215; // 16777215 = 24bit mask
-        if (!m_pickid_to_poi.contains(internal_id)) {
+        const auto* const poi_ptr = m_pickid_to_poi.find(internal_id);
+        if (!poi_ptr) {
             qDebug() << "pickid does not exist: " + std::to_string(internal_id);
             return;
         }
-        const auto& poi = m_pickid_to_poi[internal_id];
+        const auto& poi = *poi_ptr;
         Feature picked;
         picked.title = poi->name;
         // picked.properties = poi->attributes;
@@ -96,19 +97,25 @@ void PickerManager::update_quads(const std::vector<vector_tile::PoiTile>& new_ti
 
 void PickerManager::add_tile(const tile::Id id, const PointOfInterestCollectionPtr& all_pois)
 {
+    // a tile can be sent again without a delete in between. its previous ids were released by the scheduler, and their slots in the mirror
+    // would otherwise keep pointing into the replaced collection
+    remove_tile(id);
     m_all_pois[id] = all_pois;
     for (const auto& poi : *all_pois) {
-        m_pickid_to_poi[poi.id] = &poi;
+        if (poi.id != SlotTable<const PointOfInterest*>::invalid_id)
+            m_pickid_to_poi.assign(uint32_t(poi.id), &poi);
     }
 }
 
 void PickerManager::remove_tile(const tile::Id id)
 {
-    if (m_all_pois.contains(id)) {
-        for (const auto& poi : *m_all_pois[id]) {
-            m_pickid_to_poi.erase(poi.id);
+    const auto iter = m_all_pois.find(id);
+    if (iter != m_all_pois.end()) {
+        // stale ids (slot already reassigned to a newer generation) are ignored by erase
+        for (const auto& poi : *iter->second) {
+            m_pickid_to_poi.erase(uint32_t(poi.id));
         }
-        m_all_pois.erase(id);
+        m_all_pois.erase(iter);
     }
 }
 
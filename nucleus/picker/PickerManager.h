@@ -19,6 +19,7 @@
 #pragma once
 
 #include <nucleus/event_parameter.h>
+#include <nucleus/picker/SlotTable.h>
 #include <nucleus/picker/types.h>
 #include <nucleus/tile/types.h>
 #include <nucleus/vector_tile/types.h>
@@ -48,7 +49,8 @@ signals:
 
 private:
     std::unordered_map<tile::Id, PointOfInterestCollectionPtr, tile::Id::Hasher> m_all_pois;
-    std::unordered_map<uint32_t, const PointOfInterest*> m_pickid_to_poi;
+    // mirror of the pick ids allocated by map_label::Scheduler
+    SlotTable<const PointOfInterest*> m_pickid_to_poi;
 
     glm::vec2 m_position;
     bool m_in_click;
@@ -0,0 +1,148 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace nucleus::picker {
+
+// Dense slot table for 24 bit pick ids (the remaining 8 bits of a pick value encode the FeatureType).
+// An id consists of a slot index (low 18 bits) and a generation (high 6 bits, never 0), so id 0 is never valid. Erasing bumps the generation
+// of the slot on the next insert, which makes stale ids (e.g., read back from the pick buffer after the tile was unloaded) fail the lookup.
+// Insert, erase and lookup are O(1) without hashing.
+//
+// A table is either an allocator (insert) or a mirror of an allocator living on another thread (assign): ids are allocated where the features
+// are created (e.g., in the scheduler), and the consumer stores its values under the same ids.
+template <typename T> class SlotTable {
+public:
+    static constexpr unsigned index_bits = 18;
+    static constexpr unsigned generation_bits = 6;
+    static constexpr uint32_t max_size = 1u << index_bits;
+    static constexpr uint32_t invalid_id = 0;
+
+    [[nodiscard]] static constexpr uint32_t index(uint32_t id) { return id & (max_size - 1); }
+    [[nodiscard]] static constexpr uint32_t generation(uint32_t id) { return (id >> index_bits) & ((1u << generation_bits) - 1); }
+    [[nodiscard]] static constexpr uint32_t make_id(uint32_t index, uint32_t generation) { return (generation << index_bits) | index; }
+
+    // Returns invalid_id if all slots are in use.
+    uint32_t insert(T value)
+    {
+        assert(!m_is_mirror);
+        uint32_t slot_index;
+        if (!m_free_slots.empty()) {
+            slot_index = m_free_slots.back();
+            m_free_slots.pop_back();
+        } else {
+            if (m_slots.size() == max_size)
+                return invalid_id;
+            slot_index = uint32_t(m_slots.size());
+            m_slots.emplace_back();
+        }
+        Slot& slot = m_slots[slot_index];
+        slot.generation = next_generation(slot.generation);
+        slot.occupied = true;
+        slot.value = std::move(value);
+        ++m_size;
+        return make_id(slot_index, slot.generation);
+    }
+
+    // Stores value under an id allocated by another table, replacing whatever was stored in the slot before.
+    void assign(uint32_t id, T value)
+    {
+        assert(generation(id) != 0);
+        assert(m_free_slots.empty() || m_is_mirror);
+        m_is_mirror = true;
+        const uint32_t slot_index = index(id);
+        if (slot_index >= m_slots.size())
+            m_slots.resize(slot_index + 1);
+        Slot& slot = m_slots[slot_index];
+        if (!slot.occupied)
+            ++m_size;
+        slot.generation = generation(id);
+        slot.occupied = true;
+        slot.value = std::move(value);
+    }
+
+    // Returns false for stale or unknown ids, the slot is left untouched in that case.
+    bool erase(uint32_t id)
+    {
+        Slot* slot = occupied_slot(id);
+        if (!slot)
+            return false;
+        slot->occupied = false;
+        slot->value = T {};
+        if (!m_is_mirror)
+            m_free_slots.push_back(index(id));
+        --m_size;
+        return true;
+    }
+
+    [[nodiscard]] T* find(uint32_t id)
+    {
+        Slot* slot = occupied_slot(id);
+        return slot ? &slot->value : nullptr;
+    }
+    [[nodiscard]] const T* find(uint32_t id) const { return const_cast<SlotTable*>(this)->find(id); }
+    [[nodiscard]] bool contains(uint32_t id) const { return find(id) != nullptr; }
+
+    [[nodiscard]] size_t size() const { return m_size; }
+    [[nodiscard]] bool empty() const { return m_size == 0; }
+
+    void clear()
+    {
+        m_slots.clear();
+        m_free_slots.clear();
+        m_size = 0;
+        m_is_mirror = false;
+    }
+
+private:
+    struct Slot {
+        T value = {};
+        uint8_t generation = 0;
+        bool occupied = false;
+    };
+
+    static constexpr uint8_t next_generation(uint8_t generation)
+    {
+        const auto next = uint32_t(generation + 1) & ((1u << generation_bits) - 1);
+        return uint8_t(next == 0 ? 1 : next);
+    }
+
+    Slot* occupied_slot(uint32_t id)
+    {
+        const uint32_t slot_index = index(id);
+        if (slot_index >= m_slots.size())
+            return nullptr;
+        Slot& slot = m_slots[slot_index];
+        if (!slot.occupied || slot.generation != generation(id) || (id >> (index_bits + generation_bits)) != 0)
+            return nullptr;
+        return &slot;
+    }
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_free_slots;
+    size_t m_size = 0;
+    bool m_is_mirror = false;
+};
+
+} // namespace nucleus::picker
@@ -18,6 +18,8 @@
 
 #include "srs.h"
 
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 
 constexpr double pi = 3.1415926535897932384626433;
@@ -47,7 +49,9 @@ tile::Id world_xy_to_tile_id(const glm::dvec2& world_xy, unsigned int zoomlevel)
     const double height_of_a_tile = cEarthCircumference / number_of_vertical_tiles_for_zoom_level(zoomlevel);
     const glm::dvec2 absolute_min = { -cOriginShift, -cOriginShift };
     const glm::dvec2 tile_size = { width_of_a_tile, height_of_a_tile };
-    const glm::dvec2 tile_coords = glm::floor((world_xy - absolute_min) / tile_size);
+    const glm::dvec2 n_tiles = { double(number_of_horizontal_tiles_for_zoom_level(zoomlevel)), double(number_of_vertical_tiles_for_zoom_level(zoomlevel)) };
+    // points outside of the world (including its east and north border) go to the border tiles, as in world_xy_to_tile_ids
+    const glm::dvec2 tile_coords = glm::clamp(glm::floor((world_xy - absolute_min) / tile_size), glm::dvec2(0.0), n_tiles - 1.0);
     return { zoomlevel, glm::uvec2(tile_coords) };
 }
 
@@ -121,6 +125,93 @@ glm::dvec3 lat_long_alt_to_world(const glm::dvec3& lat_long_alt)
     return { world_xy.x, world_xy.y, lat_long_alt.z / std::abs(std::cos(lat_rad_)) };
 }
 
+void lat_long_alt_to_world(std::span<double> latitude_to_x, std::span<double> longitude_to_y, std::span<double> altitude_to_z)
+{
+    assert(latitude_to_x.size() == longitude_to_y.size());
+    assert(latitude_to_x.size() == altitude_to_z.size());
+    const auto n = latitude_to_x.size();
+    double* __restrict a = latitude_to_x.data();
+    double* __restrict b = longitude_to_y.data();
+    double* __restrict c = altitude_to_z.data();
+    for (size_t i = 0; i < n; ++i) {
+        const double latitude = a[i];
+        const double longitude = b[i];
+        // log(tan(pi/4 + lat/2)) == atanh(sin(lat)) == 0.5 * log((1 + sin(lat)) / (1 - sin(lat))), and cos(lat) == sqrt(1 - sin(lat)^2) for |lat| < 90
+        const double sin_latitude = std::sin(latitude * (pi / 180.0));
+        a[i] = (longitude + 180) * (cOriginShift / 180) - cOriginShift;
+        b[i] = cOriginShift * 0.5 * std::log((1.0 + sin_latitude) / (1.0 - sin_latitude)) / pi;
+        c[i] = c[i] / std::sqrt(1.0 - sin_latitude * sin_latitude);
+    }
+}
+
+void lat_long_to_world(std::span<double> latitude_to_x, std::span<double> longitude_to_y)
+{
+    assert(latitude_to_x.size() == longitude_to_y.size());
+    const auto n = latitude_to_x.size();
+    double* __restrict a = latitude_to_x.data();
+    double* __restrict b = longitude_to_y.data();
+    for (size_t i = 0; i < n; ++i) {
+        const double latitude = a[i];
+        const double longitude = b[i];
+        const double sin_latitude = std::sin(latitude * (pi / 180.0));
+        a[i] = (longitude + 180) * (cOriginShift / 180) - cOriginShift;
+        b[i] = cOriginShift * 0.5 * std::log((1.0 + sin_latitude) / (1.0 - sin_latitude)) / pi;
+    }
+}
+
+void world_to_lat_long(std::span<double> x_to_latitude, std::span<double> y_to_longitude)
+{
+    assert(x_to_latitude.size() == y_to_longitude.size());
+    const auto n = x_to_latitude.size();
+    double* __restrict a = x_to_latitude.data();
+    double* __restrict b = y_to_longitude.data();
+    for (size_t i = 0; i < n; ++i) {
+        const double x = a[i];
+        const double y = b[i];
+        a[i] = (2.0 * std::atan(std::exp(y * (pi / cOriginShift))) - pi / 2.0) * (180.0 / pi);
+        b[i] = (x + cOriginShift) / (cOriginShift / 180) - 180;
+    }
+}
+
+void world_to_lat_long_alt(std::span<double> x_to_latitude, std::span<double> y_to_longitude, std::span<double> z_to_altitude)
+{
+    assert(x_to_latitude.size() == y_to_longitude.size());
+    assert(x_to_latitude.size() == z_to_altitude.size());
+    const auto n = x_to_latitude.size();
+    double* __restrict a = x_to_latitude.data();
+    double* __restrict b = y_to_longitude.data();
+    double* __restrict c = z_to_altitude.data();
+    for (size_t i = 0; i < n; ++i) {
+        const double x = a[i];
+        const double y = b[i];
+        // with e = exp(y * pi / origin_shift): latitude = 2 atan(e) - pi / 2, and cos(latitude) == 1 / cosh(y * pi / origin_shift) == 2e / (1 + e^2)
+        const double e = std::exp(y * (pi / cOriginShift));
+        a[i] = (2.0 * std::atan(e) - pi / 2.0) * (180.0 / pi);
+        b[i] = (x + cOriginShift) / (cOriginShift / 180) - 180;
+        c[i] = c[i] * (2.0 * e / (1.0 + e * e));
+    }
+}
+
+std::vector<tile::Id> world_xy_to_tile_ids(std::span<const glm::dvec2> world_xy, unsigned zoom_level)
+{
+    const auto n_tiles = double(number_of_horizontal_tiles_for_zoom_level(zoom_level));
+    const auto width_of_a_tile = cEarthCircumference / n_tiles; // same arithmetic as world_xy_to_tile_id, so that tile borders agree
+    // x in the upper and y in the lower 32 bits, so that sorting the keys sorts by x and then y
+    std::vector<uint64_t> keys(world_xy.size());
+    for (size_t i = 0; i < world_xy.size(); ++i) {
+        const auto tile = glm::clamp(glm::floor((world_xy[i] + cOriginShift) / width_of_a_tile), glm::dvec2(0.0), glm::dvec2(n_tiles - 1));
+        keys[i] = (uint64_t(tile.x) << 32) | uint64_t(tile.y);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<tile::Id> ids;
+    ids.reserve(keys.size());
+    for (const auto key : keys)
+        ids.push_back({ zoom_level, { unsigned(key >> 32), unsigned(key & 0xffffffffu) } });
+    return ids;
+}
+
 uint16_t hash_uint16(const tile::Id& id)
 {
     // https://en.wikipedia.org/wiki/Linear_congruential_generator
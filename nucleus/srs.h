@@ -20,6 +20,8 @@
 
 #include <glm/glm.hpp>
 #include <nucleus/tile/types.h>
+#include <span>
+#include <vector>
 
 namespace nucleus::srs {
 // the srs used for the alpine renderer is EPSG: 3857 (also called web mercator, spherical mercator).
@@ -39,6 +41,7 @@ inline unsigned number_of_vertical_tiles_for_zoom_level(unsigned z) { return 1 <
 double tile_width(int zoom_level);
 double tile_height(int zoom_level);
 tile::SrsBounds tile_bounds(const tile::Id& tile);
+// points outside of the world are clamped to the border tiles
 tile::Id world_xy_to_tile_id(const glm::dvec2& coords, unsigned int zoomlevel);
 glm::dvec2 tile_id_to_world_xy(const glm::uvec2& coords, unsigned int zoomlevel);
 glm::dvec2 world_xy_to_tile_uv(const glm::dvec2& world_xy, unsigned int zoomlevel);
@@ -48,6 +51,25 @@ glm::dvec2 lat_long_to_world(const glm::dvec2& lat_long);
 glm::dvec3 lat_long_alt_to_world(const glm::dvec3& lat_long_alt);
 glm::dvec2 world_to_lat_long(const glm::dvec2& world_pos);
 glm::dvec3 world_to_lat_long_alt(const glm::dvec3& world_pos);
+
+// batch version of lat_long_alt_to_world for structure of arrays data, converts in place:
+// on input the spans hold latitude, longitude and altitude, on output world x, y and z.
+// the loop is branch free and needs one sin, log and sqrt per point (instead of tan, log and cos), so the compiler can vectorise it.
+void lat_long_alt_to_world(std::span<double> latitude_to_x, std::span<double> longitude_to_y, std::span<double> altitude_to_z);
+// the other batch versions work the same way (structure of arrays, in place, branch free loops).
+void lat_long_to_world(std::span<double> latitude_to_x, std::span<double> longitude_to_y);
+void world_to_lat_long(std::span<double> x_to_latitude, std::span<double> y_to_longitude);
+// one exp and atan per point, the cosine for the altitude is computed from the same exp.
+void world_to_lat_long_alt(std::span<double> x_to_latitude, std::span<double> y_to_longitude, std::span<double> z_to_altitude);
+// largest difference between the batch and the scalar versions within the valid latitude range (±85.0511°, tested in unittests/nucleus/srs.cpp).
+// world coordinates and altitude in metres (relative for altitude), latitude and longitude in degrees (1e-11° is about 1 µm).
+constexpr double batch_max_world_error = 1e-6;
+constexpr double batch_max_relative_altitude_error = 1e-12;
+constexpr double batch_max_degree_error = 1e-11;
+
+// the tiles containing the points, sorted by x and then y, without duplicates. points outside the world are clamped to the border tiles.
+std::vector<tile::Id> world_xy_to_tile_ids(std::span<const glm::dvec2> world_xy, unsigned zoom_level);
+
 uint16_t hash_uint16(const tile::Id& id);
 glm::vec<2, uint32_t> pack(const tile::Id& id);
 tile::Id unpack(const glm::vec<2, uint32_t>& packed);
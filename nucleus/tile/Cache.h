@@ -75,6 +75,9 @@ public:
     /// functor should return true, if the given tile should be marked visited. stops descending if false is returned. don't do heavy lifting in the functort, as it blocks all other access!
     template<typename VisitorFunction>
     void visit(const VisitorFunction& functor);
+    /// same traversal as visit, but doesn't mark tiles as visited (i.e., doesn't influence purging). takes only a shared lock.
+    template <typename VisitorFunction>
+    void visit_read_only(const VisitorFunction& functor) const;
     const T& peak_at(const tile::Id& id) const;
     std::vector<T> purge(unsigned remaining_capacity);
 
@@ -86,6 +89,8 @@ private:
     void visit(const tile::Id& start_node,
                const VisitorFunction& functor,
                uint64_t visited_stamp); // must stay private or protected by mutex
+    template <typename VisitorFunction>
+    void visit_read_only(const tile::Id& start_node, const VisitorFunction& functor) const; // must stay private or protected by mutex
 
     static std::filesystem::path tile_path(const std::filesystem::path& base_path, const tile::Id& id)
     {
@@ -345,6 +350,30 @@ void Cache<T>::visit(const tile::Id& node, const VisitorFunction& functor, uint6
     }
 }
 
+template <NamedTile T>
+template <typename VisitorFunction>
+void Cache<T>::visit_read_only(const VisitorFunction& functor) const
+{
+    auto locker = std::shared_lock(m_data_mutex);
+    static_assert(
+        requires {
+            { functor(T()) } -> nucleus::utils::convertible_to<bool>;
+        }, "VisitorFunction must accept a const NamedTile and return a bool.");
+    visit_read_only(tile::Id { 0, { 0, 0 } }, functor);
+}
+
+template <NamedTile T>
+template <typename VisitorFunction>
+void Cache<T>::visit_read_only(const tile::Id& node, const VisitorFunction& functor) const
+{
+    const auto it = m_data.find(node);
+    if (it == m_data.end() || !functor(it->second.data))
+        return;
+    for (const auto& id : node.children()) {
+        visit_read_only(id, functor);
+    }
+}
+
 template<NamedTile T>
 std::vector<T> Cache<T>::purge(unsigned remaining_capacity)
 {
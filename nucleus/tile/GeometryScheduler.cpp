@@ -21,8 +21,8 @@
 #include "utils.h"
 #include <QDebug>
 #include <nucleus/tile/conversion.h>
-#include <nucleus/utils/error.h>
-#include <nucleus/utils/image_loader.h>
+#include <nucleus/utils/height_codec.h>
+#include <nucleus/utils/terrain_simplification.h>
 
 namespace nucleus::tile {
 
@@ -34,6 +34,31 @@ GeometryScheduler::GeometryScheduler(const Settings& settings, unsigned int heig
 
 GeometryScheduler::~GeometryScheduler() = default;
 
+void GeometryScheduler::set_simplification_tolerance(std::optional<float> tolerance)
+{
+    assert(!tolerance || *tolerance >= 0);
+    m_simplification_tolerance = tolerance;
+    if (tolerance && !m_rtin)
+        m_rtin = std::make_unique<nucleus::utils::terrain_simplification::Rtin>(m_default_raster.width());
+}
+
+std::optional<float> GeometryScheduler::simplification_tolerance() const { return m_simplification_tolerance; }
+
+void GeometryScheduler::set_contour_settings(std::optional<nucleus::utils::contours::Settings> settings) { m_contour_settings = settings; }
+
+std::optional<nucleus::utils::contours::Settings> GeometryScheduler::contour_settings() const { return m_contour_settings; }
+
+GeometryScheduler::Contours GeometryScheduler::contours(const tile::Data& tile, const Raster<uint16_t>& surface) const
+{
+    assert(m_contour_settings);
+    if (!tile.data || tile.data->isEmpty())
+        return std::make_shared<const std::vector<nucleus::utils::contours::Line>>();
+    if (auto cached = nucleus::utils::contours::deserialise(tile.derived_data, *m_contour_settings))
+        return std::make_shared<const std::vector<nucleus::utils::contours::Line>>(std::move(*cached));
+    // the quad was cached before contours were enabled, or with other settings
+    return std::make_shared<const std::vector<nucleus::utils::contours::Line>>(nucleus::utils::contours::generate(surface, *m_contour_settings));
+}
+
 void GeometryScheduler::transform_and_emit(const std::vector<tile::DataQuad>& new_quads, const std::vector<tile::Id>& deleted_quads)
 {
     // Tested larger geometry tiles (129x129) and switched back to smaller ones (65x65) for performance reasons (smaller ones are twice as fast).
@@ -46,13 +71,18 @@ void GeometryScheduler::transform_and_emit(const std::vector<tile::DataQuad>& ne
             gpu_tile.id = tile.id;
             if (tile.data->size()) {
                 // tile is available
-                using namespace nucleus::utils;
-                gpu_tile.surface = std::make_shared<const nucleus::Raster<uint16_t>>(
-                    image_loader::rgba8(*tile.data).and_then(error::wrap_to_expected(conversion::to_u16raster)).value_or(m_default_raster));
+                gpu_tile.surface = std::make_shared<const nucleus::Raster<uint16_t>>(conversion::height_tile_to_u16raster(*tile.data).value_or(m_default_raster));
             } else {
                 // tile is not available (use default tile)
                 gpu_tile.surface = std::make_shared<const nucleus::Raster<uint16_t>>(m_default_raster);
             }
+            if (m_simplification_tolerance) {
+                // heights are stored in 1/8 m steps
+                const auto mesh = m_rtin->simplify(*gpu_tile.surface, *m_simplification_tolerance * 8.0f);
+                gpu_tile.indices = std::make_shared<const std::vector<uint16_t>>(mesh.indices.begin(), mesh.indices.end());
+            }
+            if (m_contour_settings)
+                gpu_tile.contours = contours(tile, *gpu_tile.surface);
             new_gpu_tiles.push_back(gpu_tile);
         }
     }
@@ -68,4 +98,25 @@ void GeometryScheduler::transform_and_emit(const std::vector<tile::DataQuad>& ne
     emit gpu_tiles_updated(deleted_tiles, new_gpu_tiles);
 }
 
+tile::DataQuad GeometryScheduler::transform_for_cache(const tile::DataQuad& quad) const
+{
+    auto transformed = quad;
+    for (auto& tile : transformed.tiles) {
+        if (!tile.data || tile.data->isEmpty())
+            continue;
+        const auto is_encoded = nucleus::utils::height_codec::is_encoded(*tile.data);
+        if (is_encoded && !m_contour_settings)
+            continue;
+        // tiles that can't be decoded are kept as they are (and replaced by the default raster in transform_and_emit)
+        const auto heights = conversion::height_tile_to_u16raster(*tile.data);
+        if (!heights.has_value())
+            continue;
+        if (!is_encoded)
+            tile.data = std::make_shared<QByteArray>(nucleus::utils::height_codec::encode(heights.value()));
+        if (m_contour_settings)
+            tile.derived_data = nucleus::utils::contours::serialise(nucleus::utils::contours::generate(heights.value(), *m_contour_settings), *m_contour_settings);
+    }
+    return transformed;
+}
+
 } // namespace nucleus::tile
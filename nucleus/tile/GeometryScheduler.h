@@ -20,6 +20,12 @@
 
 #include "Scheduler.h"
 #include "types.h"
+#include <nucleus/utils/contours.h>
+#include <optional>
+
+namespace nucleus::utils::terrain_simplification {
+class Rtin;
+}
 
 namespace nucleus::tile {
 
@@ -32,14 +38,32 @@ public:
     void set_texture_compression_algorithm(nucleus::utils::ColourTexture::Format compression_algorithm);
     static Raster<uint16_t> to_raster(const tile::DataQuad& data_quad, const Raster<uint16_t>& default_raster);
 
+    // vertical error tolerance in metres. if set, every tile is simplified and gets its own index buffer (GpuGeometryTile::indices).
+    // the height map size must be 2^k + 1. off by default.
+    void set_simplification_tolerance(std::optional<float> tolerance);
+    [[nodiscard]] std::optional<float> simplification_tolerance() const;
+
+    // if set, contour lines are generated for every tile (GpuGeometryTile::contours). they are generated when the quad enters the ram cache and
+    // are cached next to the heights (tile::Data::derived_data), so tiles that are sent to the gpu again don't recompute them. off by default.
+    void set_contour_settings(std::optional<nucleus::utils::contours::Settings> settings);
+    [[nodiscard]] std::optional<nucleus::utils::contours::Settings> contour_settings() const;
+
 signals:
     void gpu_tiles_updated(const std::vector<tile::Id>& deleted_tiles, const std::vector<GpuGeometryTile>& new_tiles);
 
 protected:
     void transform_and_emit(const std::vector<tile::DataQuad>& new_quads, const std::vector<tile::Id>& deleted_quads) override;
+    // transcodes the height pngs to utils::height_codec, which is smaller and decodes several times faster. adds the contour lines if enabled.
+    tile::DataQuad transform_for_cache(const tile::DataQuad& quad) const override;
 
 private:
+    using Contours = std::shared_ptr<const std::vector<nucleus::utils::contours::Line>>;
+    Contours contours(const tile::Data& tile, const Raster<uint16_t>& surface) const;
+
     Raster<uint16_t> m_default_raster;
+    std::optional<float> m_simplification_tolerance;
+    std::unique_ptr<nucleus::utils::terrain_simplification::Rtin> m_rtin;
+    std::optional<nucleus::utils::contours::Settings> m_contour_settings;
 };
 
 } // namespace nucleus::tile
@@ -0,0 +1,261 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "HeightfieldRaycaster.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <unordered_set>
+
+#include "conversion.h"
+#include "nucleus/srs.h"
+
+namespace nucleus::tile {
+
+namespace {
+    constexpr auto infinity = std::numeric_limits<double>::infinity();
+
+    // slab test, returns the parameter range [t_enter, t_exit] of the ray inside the box, clipped to [t_min, t_max]
+    std::optional<std::pair<double, double>> clip_to_box(
+        const glm::dvec3& origin, const glm::dvec3& direction, const glm::dvec3& box_min, const glm::dvec3& box_max, unsigned n_dimensions, double t_min, double t_max)
+    {
+        for (unsigned i = 0; i < n_dimensions; ++i) {
+            if (direction[i] == 0) {
+                if (origin[i] < box_min[i] || origin[i] > box_max[i])
+                    return {};
+                continue;
+            }
+            const auto t1 = (box_min[i] - origin[i]) / direction[i];
+            const auto t2 = (box_max[i] - origin[i]) / direction[i];
+            t_min = std::max(t_min, std::min(t1, t2));
+            t_max = std::min(t_max, std::max(t1, t2));
+            if (t_min > t_max)
+                return {};
+        }
+        return std::make_pair(t_min, t_max);
+    }
+
+    // moeller trumbore, two sided. vertices are relative to the ray origin. a small tolerance on the barycentrics closes cracks along the edges.
+    std::optional<double> intersect_triangle(const glm::dvec3& direction, const glm::dvec3& v0, const glm::dvec3& v1, const glm::dvec3& v2)
+    {
+        constexpr double tolerance = 1e-9;
+        const auto e1 = v1 - v0;
+        const auto e2 = v2 - v0;
+        const auto p = glm::cross(direction, e2);
+        const auto det = glm::dot(e1, p);
+        if (det == 0)
+            return {};
+        const auto inv_det = 1.0 / det;
+        const auto s = -v0;
+        const auto u = glm::dot(s, p) * inv_det;
+        if (u < -tolerance || u > 1 + tolerance)
+            return {};
+        const auto q = glm::cross(s, e1);
+        const auto v = glm::dot(direction, q) * inv_det;
+        if (v < -tolerance || u + v > 1 + tolerance)
+            return {};
+        return glm::dot(e2, q) * inv_det;
+    }
+} // namespace
+
+HeightfieldRaycaster::HeightfieldRaycaster(MemoryCache* cache, utils::AabbDecoratorPtr aabb_decorator, unsigned decoded_tile_capacity)
+    : m_cache(cache)
+    , m_aabb_decorator(std::move(aabb_decorator))
+    , m_decoded_tile_capacity(std::max(decoded_tile_capacity, 1u))
+{
+    assert(m_cache);
+    assert(m_aabb_decorator);
+}
+
+std::optional<HeightfieldRaycaster::Hit> HeightfieldRaycaster::cast(const glm::dvec3& origin, const glm::dvec3& direction, double max_distance)
+{
+    if (glm::length(direction) == 0)
+        return {};
+    const auto d = glm::normalize(direction);
+
+    const auto clip = [&](const tile::Id& id) {
+        auto aabb = m_aabb_decorator->aabb(id);
+        // the height bounds are stored in single precision
+        aabb.min.z -= 1;
+        aabb.max.z += 1;
+        return clip_to_box(origin, d, aabb.min, aabb.max, 3, 0, max_distance);
+    };
+
+    struct Candidate {
+        Data tile;
+        double t_enter = 0;
+        double t_exit = 0;
+    };
+    std::vector<Candidate> candidates;
+    std::unordered_set<tile::Id, tile::Id::Hasher> refined;
+    // read only, a query must not keep tiles alive in the cache
+    m_cache->visit_read_only([&](const DataQuad& quad) {
+        if (!clip(quad.id))
+            return false;
+        // tiles are only replaced by their children if all of them are available, otherwise the parent stays in use
+        const auto is_good = [](const Data& t) { return t.network_info.status == NetworkInfo::Status::Good && t.data && !t.data->isEmpty(); };
+        if (quad.n_tiles != 4 || !std::all_of(quad.tiles.begin(), quad.tiles.end(), is_good))
+            return false;
+        refined.insert(quad.id);
+        for (const auto& t : quad.tiles) {
+            if (const auto range = clip(t.id))
+                candidates.push_back({ t, range->first, range->second });
+        }
+        return true;
+    });
+    std::erase_if(candidates, [&](const Candidate& c) { return refined.contains(c.tile.id); });
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.t_enter < b.t_enter; });
+
+    std::optional<Hit> hit;
+    for (const auto& candidate : candidates) {
+        if (hit && candidate.t_enter > hit->distance)
+            break;
+        const auto tile = decoded(candidate.tile);
+        if (!tile)
+            continue;
+        const auto t_max = hit ? std::min(candidate.t_exit, hit->distance) : candidate.t_exit;
+        if (const auto t = intersect(*tile, origin, d, candidate.t_enter, t_max))
+            hit = Hit { origin + d * *t, *t, candidate.tile.id };
+    }
+    return hit;
+}
+
+std::optional<HeightfieldRaycaster::DecodedTile> HeightfieldRaycaster::decode(const Data& tile)
+{
+    if (!tile.data || tile.data->isEmpty())
+        return {};
+    const auto heights = conversion::height_tile_to_u16raster(*tile.data);
+    if (!heights.has_value() || heights->width() < 2 || heights->width() != heights->height())
+        return {};
+    const auto& raw = heights.value();
+
+    DecodedTile decoded { tile.id, Raster<float>(raw.size()) };
+    const auto bounds = srs::tile_bounds(tile.id);
+    const auto n_cells = raw.width() - 1;
+    const auto cell_size = bounds.size().x / n_cells;
+    for (unsigned row = 0; row < raw.height(); ++row) {
+        const auto latitude = srs::world_to_lat_long({ 0.0, bounds.max.y - row * cell_size }).x;
+        // same as altitude_correction_factor in tile.glsl
+        const auto correction = 0.125 / std::abs(std::cos(glm::radians(latitude)));
+        for (unsigned col = 0; col < raw.width(); ++col)
+            decoded.heights.pixel({ col, row }) = float(raw.pixel({ col, row }) * correction);
+    }
+    return decoded;
+}
+
+std::optional<double> HeightfieldRaycaster::intersect(const DecodedTile& tile, const glm::dvec3& origin, const glm::dvec3& direction, double t_min, double t_max)
+{
+    const auto& heights = tile.heights;
+    assert(heights.width() >= 2 && heights.width() == heights.height());
+    const auto bounds = srs::tile_bounds(tile.id);
+    const auto range = clip_to_box(origin, direction, glm::dvec3(bounds.min, 0), glm::dvec3(bounds.max, 0), 2, t_min, t_max);
+    if (!range)
+        return {};
+    const auto [t_enter, t_exit] = *range;
+
+    // grid coordinates: x along columns, y along rows (i.e., southwards)
+    const int n_cells = int(heights.width()) - 1;
+    const auto cell_size = bounds.size().x / n_cells;
+    const auto grid_direction = glm::dvec2(direction.x, -direction.y) / cell_size;
+    const auto entry = origin + direction * t_enter;
+    const auto grid_entry = glm::dvec2(entry.x - bounds.min.x, bounds.max.y - entry.y) / cell_size;
+
+    glm::ivec2 cell = glm::clamp(glm::ivec2(glm::floor(grid_entry)), glm::ivec2(0), glm::ivec2(n_cells - 1));
+    glm::ivec2 step = {};
+    glm::dvec2 t_next = {};
+    glm::dvec2 t_delta = {};
+    for (unsigned i = 0; i < 2; ++i) {
+        if (grid_direction[i] == 0) {
+            step[i] = 0;
+            t_next[i] = infinity;
+            t_delta[i] = infinity;
+            continue;
+        }
+        step[i] = grid_direction[i] > 0 ? 1 : -1;
+        const auto boundary = double(cell[i] + (step[i] > 0 ? 1 : 0));
+        t_next[i] = t_enter + (boundary - grid_entry[i]) / grid_direction[i];
+        t_delta[i] = 1.0 / std::abs(grid_direction[i]);
+    }
+
+    const auto vertex = [&](int col, int row) {
+        return glm::dvec3(bounds.min.x + col * cell_size - origin.x, bounds.max.y - row * cell_size - origin.y, double(heights.pixel({ unsigned(col), unsigned(row) })) - origin.z);
+    };
+
+    auto t_cell_enter = t_enter;
+    while (true) {
+        const auto t_cell_exit = std::min({ t_next.x, t_next.y, t_exit });
+        const auto top_left = vertex(cell.x, cell.y);
+        const auto top_right = vertex(cell.x + 1, cell.y);
+        const auto bottom_left = vertex(cell.x, cell.y + 1);
+        const auto bottom_right = vertex(cell.x + 1, cell.y + 1);
+        const auto cell_max_z = std::max({ top_left.z, top_right.z, bottom_left.z, bottom_right.z });
+        // skip cells where the ray passes above all vertices
+        if (std::min(direction.z * t_cell_enter, direction.z * t_cell_exit) <= cell_max_z) {
+            // same diagonal as the triangle strip of terrain_mesh_index_generator::surface_quads
+            std::optional<double> t;
+            for (const auto& candidate : { intersect_triangle(direction, top_left, bottom_left, top_right), intersect_triangle(direction, bottom_left, bottom_right, top_right) }) {
+                if (candidate && *candidate >= t_min && *candidate <= t_max && (!t || *candidate < *t))
+                    t = candidate;
+            }
+            if (t)
+                return t;
+        }
+        if (t_cell_exit >= t_exit)
+            break;
+        const auto axis = t_next.x < t_next.y ? 0 : 1;
+        cell[axis] += step[axis];
+        if (cell[axis] < 0 || cell[axis] >= n_cells)
+            break;
+        t_cell_enter = t_next[axis];
+        t_next[axis] += t_delta[axis];
+    }
+    return {};
+}
+
+unsigned HeightfieldRaycaster::n_decoded_tiles() const
+{
+    std::scoped_lock lock(m_mutex);
+    return unsigned(m_decoded.size());
+}
+
+std::shared_ptr<const HeightfieldRaycaster::DecodedTile> HeightfieldRaycaster::decoded(const Data& tile)
+{
+    std::scoped_lock lock(m_mutex);
+    ++m_use_counter;
+    if (const auto it = m_decoded.find(tile.id); it != m_decoded.end()) {
+        // the cache might have received a new version of the tile in the meantime
+        if (it->second.source == tile.data) {
+            it->second.last_used = m_use_counter;
+            return it->second.tile;
+        }
+        m_decoded.erase(it);
+    }
+    auto decoded_tile = decode(tile);
+    if (!decoded_tile)
+        return {};
+    if (m_decoded.size() >= m_decoded_tile_capacity) {
+        const auto oldest = std::min_element(m_decoded.begin(), m_decoded.end(), [](const auto& a, const auto& b) { return a.second.last_used < b.second.last_used; });
+        m_decoded.erase(oldest);
+    }
+    auto shared = std::make_shared<const DecodedTile>(std::move(decoded_tile.value()));
+    m_decoded[tile.id] = { shared, tile.data, m_use_counter };
+    return shared;
+}
+
+} // namespace nucleus::tile
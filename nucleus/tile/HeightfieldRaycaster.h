@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "Cache.h"
+#include "nucleus/Raster.h"
+#include "utils.h"
+
+namespace nucleus::tile {
+
+// Intersects rays with the terrain in a geometry MemoryCache on the cpu, so that the camera controller doesn't have to read depth back from the gpu.
+// The quad tree is traversed with the TileHeights boxes of the AabbDecorator. Of the tiles hit, the finest available ones are intersected
+// (a tile is replaced by its children only if the complete quad is loaded, otherwise the coarser tile is used). Within a tile, the grid cells
+// along the ray are walked and intersected with the same two triangles per cell that the gpu draws.
+// Decoded height rasters are kept in a small lru cache. Thread safe.
+class HeightfieldRaycaster {
+public:
+    struct Hit {
+        glm::dvec3 position = {};
+        double distance = 0; // along the normalised direction
+        tile::Id tile = {}; // the tile that was hit
+    };
+    // heights in world space (i.e., altitude / cos(latitude)), first row is north
+    struct DecodedTile {
+        tile::Id id;
+        Raster<float> heights;
+    };
+
+    HeightfieldRaycaster(MemoryCache* cache, utils::AabbDecoratorPtr aabb_decorator, unsigned decoded_tile_capacity = 64);
+
+    // direction doesn't need to be normalised.
+    [[nodiscard]] std::optional<Hit> cast(const glm::dvec3& origin, const glm::dvec3& direction, double max_distance = std::numeric_limits<double>::infinity());
+
+    [[nodiscard]] static std::optional<DecodedTile> decode(const Data& tile);
+    // Intersects the ray with a single decoded tile within [t_min, t_max]. Exposed for testing.
+    [[nodiscard]] static std::optional<double> intersect(const DecodedTile& tile, const glm::dvec3& origin, const glm::dvec3& direction, double t_min, double t_max);
+
+    [[nodiscard]] unsigned n_decoded_tiles() const;
+
+private:
+    std::shared_ptr<const DecodedTile> decoded(const Data& tile);
+
+    struct CacheEntry {
+        std::shared_ptr<const DecodedTile> tile;
+        std::shared_ptr<QByteArray> source; // to detect tiles that were replaced in the cache
+        uint64_t last_used = 0;
+    };
+
+    MemoryCache* m_cache;
+    utils::AabbDecoratorPtr m_aabb_decorator;
+    unsigned m_decoded_tile_capacity;
+    mutable std::mutex m_mutex;
+    std::unordered_map<tile::Id, CacheEntry, tile::Id::Hasher> m_decoded;
+    uint64_t m_use_counter = 0;
+};
+
+} // namespace nucleus::tile
@@ -0,0 +1,220 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "HorizonMap.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <numbers>
+
+#include "HeightfieldRaycaster.h"
+#include "nucleus/srs.h"
+
+namespace nucleus::tile {
+
+namespace {
+    // below any terrain, so that regions without data never occlude
+    constexpr float no_data = -1e6f;
+
+    // height on the triangles that the gpu draws (same diagonal as terrain_mesh_index_generator::surface_quads). position in texels,
+    // x along columns, y along rows. must be inside the raster.
+    float surface_height(const Raster<float>& heights, const glm::dvec2& position)
+    {
+        const auto max_cell = glm::ivec2(heights.size()) - 2;
+        const auto cell = glm::clamp(glm::ivec2(glm::floor(position)), glm::ivec2(0), max_cell);
+        const auto f = position - glm::dvec2(cell);
+        const auto top_left = double(heights.pixel(glm::uvec2(cell)));
+        const auto top_right = double(heights.pixel(glm::uvec2(cell) + glm::uvec2(1, 0)));
+        const auto bottom_left = double(heights.pixel(glm::uvec2(cell) + glm::uvec2(0, 1)));
+        if (f.x + f.y <= 1)
+            return float(top_left + f.x * (top_right - top_left) + f.y * (bottom_left - top_left));
+        const auto bottom_right = double(heights.pixel(glm::uvec2(cell) + glm::uvec2(1, 1)));
+        return float(bottom_right + (1 - f.x) * (bottom_left - bottom_right) + (1 - f.y) * (top_right - bottom_right));
+    }
+
+    std::optional<Data> find_tile(const MemoryCache& cache, const tile::Id& id)
+    {
+        if (id.zoom_level == 0 || !cache.contains(id.parent()))
+            return {};
+        const auto quad = cache.peak_at(id.parent());
+        for (const auto& tile : quad.tiles) {
+            if (tile.id == id && tile.network_info.status == NetworkInfo::Status::Good && tile.data && !tile.data->isEmpty())
+                return tile;
+        }
+        return {};
+    }
+} // namespace
+
+float HorizonMap::horizon_sine(const glm::uvec2& texel, unsigned direction) const
+{
+    assert(direction < n_directions);
+    assert(texel.x < size && texel.y < size);
+    return float(texture.pixel({ texel.x, texel.y + (direction / 4) * size })[direction % 4]) / 255.0f;
+}
+
+float HorizonMap::horizon_sine(const glm::uvec2& texel, float azimuth) const
+{
+    auto f = azimuth / 360.0f * float(n_directions);
+    f -= std::floor(f / float(n_directions)) * float(n_directions);
+    const auto first = unsigned(f) % n_directions;
+    const auto second = (first + 1) % n_directions;
+    const auto weight = f - std::floor(f);
+    return (1 - weight) * horizon_sine(texel, first) + weight * horizon_sine(texel, second);
+}
+
+bool HorizonMap::is_sunlit(const glm::uvec2& texel, const glm::dvec3& sun_rays_direction) const
+{
+    if (glm::length(sun_rays_direction) == 0)
+        return false;
+    const auto to_sun = -glm::normalize(sun_rays_direction);
+    if (to_sun.z <= 0)
+        return false;
+    const auto azimuth = glm::degrees(std::atan2(to_sun.x, to_sun.y));
+    return to_sun.z > horizon_sine(texel, float(azimuth));
+}
+
+HorizonMapGenerator::HorizonMapGenerator(MemoryCache* cache, Settings settings)
+    : m_cache(cache)
+    , m_settings(settings)
+{
+    assert(m_cache);
+    assert(m_settings.n_directions > 0 && m_settings.n_directions % 4 == 0);
+}
+
+std::optional<HorizonMap> HorizonMapGenerator::generate(const tile::Id& id) const
+{
+    const auto neighbourhood = gather(id);
+    if (!neighbourhood)
+        return {};
+    return compute(*neighbourhood, m_settings);
+}
+
+std::optional<HorizonMapGenerator::Neighbourhood> HorizonMapGenerator::gather(const tile::Id& id) const
+{
+    const auto centre_data = find_tile(*m_cache, id);
+    if (!centre_data)
+        return {};
+    const auto centre = HeightfieldRaycaster::decode(*centre_data);
+    if (!centre)
+        return {};
+
+    Neighbourhood neighbourhood;
+    neighbourhood.centre = id;
+    neighbourhood.n_rings = m_settings.n_rings;
+    neighbourhood.size = centre->heights.width();
+    const auto n_cells = neighbourhood.size - 1;
+    const auto bounds = srs::tile_bounds(id);
+    neighbourhood.texel_size = bounds.size().x / n_cells;
+    const auto n_tiles = 2 * m_settings.n_rings + 1;
+    neighbourhood.heights = Raster<float>(glm::uvec2(n_tiles * n_cells + 1), no_data);
+
+    const auto world_bounds = srs::tile_bounds(tile::Id { 0, { 0, 0 } });
+    const auto ring = int(m_settings.n_rings);
+    for (int dy = -ring; dy <= ring; ++dy) {
+        for (int dx = -ring; dx <= ring; ++dx) {
+            // dy goes southwards, like the rows
+            const auto tile_centre = (bounds.min + bounds.max) * 0.5 + glm::dvec2(dx, -dy) * bounds.size();
+            if (!world_bounds.contains(tile_centre))
+                continue;
+            const auto offset = glm::uvec2(unsigned(dx + ring), unsigned(dy + ring)) * n_cells;
+            if (dx == 0 && dy == 0) {
+                for (unsigned row = 0; row < neighbourhood.size; ++row) {
+                    for (unsigned col = 0; col < neighbourhood.size; ++col)
+                        neighbourhood.heights.pixel(offset + glm::uvec2(col, row)) = centre->heights.pixel({ col, row });
+                }
+                continue;
+            }
+
+            // the closest cached tile covering the neighbour
+            std::optional<HeightfieldRaycaster::DecodedTile> source;
+            for (auto source_id = srs::world_xy_to_tile_id(tile_centre, id.zoom_level); !source; source_id = source_id.parent()) {
+                if (const auto data = find_tile(*m_cache, source_id))
+                    source = HeightfieldRaycaster::decode(*data);
+                if (source_id.zoom_level <= 1)
+                    break;
+            }
+            if (!source)
+                continue;
+
+            const auto source_bounds = srs::tile_bounds(source->id);
+            const auto source_texel_size = source_bounds.size().x / (source->heights.width() - 1);
+            const auto neighbour_top_left = glm::dvec2(bounds.min.x + dx * bounds.size().x, bounds.max.y - dy * bounds.size().y);
+            for (unsigned row = 0; row < neighbourhood.size; ++row) {
+                for (unsigned col = 0; col < neighbourhood.size; ++col) {
+                    // the shared border of neighbours is written twice, the centre tile must win
+                    const auto target = offset + glm::uvec2(col, row);
+                    const auto centre_min = neighbourhood.centre_offset();
+                    const auto centre_max = centre_min + glm::uvec2(n_cells);
+                    if (target.x >= centre_min.x && target.x <= centre_max.x && target.y >= centre_min.y && target.y <= centre_max.y)
+                        continue;
+                    const auto world = neighbour_top_left + glm::dvec2(col, -double(row)) * neighbourhood.texel_size;
+                    const auto source_texel = glm::dvec2(world.x - source_bounds.min.x, source_bounds.max.y - world.y) / source_texel_size;
+                    neighbourhood.heights.pixel(target) = surface_height(source->heights, source_texel);
+                }
+            }
+        }
+    }
+    return neighbourhood;
+}
+
+HorizonMap HorizonMapGenerator::compute(const Neighbourhood& neighbourhood, const Settings& settings)
+{
+    assert(settings.n_directions > 0 && settings.n_directions % 4 == 0);
+    assert(neighbourhood.size >= 2);
+    const auto size = neighbourhood.size;
+    const auto& heights = neighbourhood.heights;
+    HorizonMap map { neighbourhood.centre, settings.n_directions, size, Raster<glm::u8vec4>(glm::uvec2(size, size * settings.n_directions / 4), glm::u8vec4(0)) };
+
+    // step distances in texels, the same for all directions. the march continues until it leaves the neighbourhood.
+    const auto max_distance = std::sqrt(2.0) * (heights.width() - 1);
+    std::vector<double> distances;
+    for (double t = 1; t <= max_distance; t += std::max(1.0, t * double(settings.step_growth)))
+        distances.push_back(t);
+    const auto max_height = double(*std::max_element(heights.buffer().begin(), heights.buffer().end()));
+    const auto upper = glm::dvec2(heights.size() - glm::uvec2(1));
+
+    for (unsigned direction = 0; direction < settings.n_directions; ++direction) {
+        const auto azimuth = 2 * std::numbers::pi * direction / settings.n_directions;
+        // clockwise from north, rows go southwards
+        const auto step = glm::dvec2(std::sin(azimuth), -std::cos(azimuth));
+        const auto layer_offset = (direction / 4) * size;
+        for (unsigned row = 0; row < size; ++row) {
+            for (unsigned col = 0; col < size; ++col) {
+                const auto origin = glm::dvec2(neighbourhood.centre_offset() + glm::uvec2(col, row));
+                const auto origin_height = double(heights.pixel(glm::uvec2(origin)));
+                double max_slope = 0; // tangent of the horizon elevation
+                for (const auto t : distances) {
+                    const auto distance = t * neighbourhood.texel_size;
+                    // nothing further away can be steeper
+                    if (max_height - origin_height <= max_slope * distance)
+                        break;
+                    const auto position = origin + step * t;
+                    if (position.x < 0 || position.y < 0 || position.x > upper.x || position.y > upper.y)
+                        break;
+                    max_slope = std::max(max_slope, (double(surface_height(heights, position)) - origin_height) / distance);
+                }
+                const auto sine = max_slope / std::sqrt(1 + max_slope * max_slope);
+                map.texture.pixel({ col, row + layer_offset })[direction % 4] = uint8_t(std::lround(sine * 255));
+            }
+        }
+    }
+    return map;
+}
+
+} // namespace nucleus::tile
@@ -0,0 +1,89 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <optional>
+
+#include "Cache.h"
+#include "nucleus/Raster.h"
+
+namespace nucleus::tile {
+
+// Horizon elevation per height map texel (i.e., grid vertex) for a fixed set of azimuths. With it, whether the sun is occluded by the
+// terrain is a lookup for any time of day, instead of rendering shadow maps.
+// Only the cpu side exists so far: no renderer uploads the maps or samples them yet.
+//
+// Direction i has the azimuth i * 360° / n_directions, clockwise from north, like sun_calculations::calculate_sun_angles. Angles are
+// measured in world space (with the same altitude correction as the tile shaders), so they can be compared directly with the sun
+// direction used for shading.
+struct HorizonMap {
+    tile::Id id;
+    unsigned n_directions = 0;
+    unsigned size = 0; // texels per side, same as the height map
+    // sine of the horizon elevation, quantised to 8 bit (0: at or below the horizontal plane, 255: zenith). 4 directions per texel,
+    // n_directions / 4 layers of size x size texels stacked vertically (direction i is in channel i % 4 of layer i / 4), i.e., the
+    // memory layout of a texture array.
+    Raster<glm::u8vec4> texture;
+
+    [[nodiscard]] float horizon_sine(const glm::uvec2& texel, unsigned direction) const;
+    // linearly interpolated between the two closest directions. azimuth in degrees.
+    [[nodiscard]] float horizon_sine(const glm::uvec2& texel, float azimuth) const;
+    // sun_rays_direction points from the sun to the ground, as sun_calculations::sun_rays_direction_from_sun_angles. needn't be normalised.
+    [[nodiscard]] bool is_sunlit(const glm::uvec2& texel, const glm::dvec3& sun_rays_direction) const;
+};
+
+// Computes horizon maps on the cpu from the decoded height rasters in a geometry cache.
+// Occluders are searched in the tiles around the requested one on the same zoom level, i.e., at least n_rings tile widths away. Neighbours
+// that are not in the cache are sampled from their closest cached ancestor; regions without any data don't occlude.
+class HorizonMapGenerator {
+public:
+    struct Settings {
+        unsigned n_directions = 16; // multiple of 4. with 8, disagreement with ray marched shadows was 6% instead of 2.5% on synthetic terrain
+        unsigned n_rings = 1;
+        // the march starts with a step of one texel, every step is longer than the previous one by this fraction of the distance so far
+        float step_growth = 0.2f;
+    };
+    // heights in world space (see HeightfieldRaycaster::DecodedTile) of a tile and its neighbours, stitched into one raster (first row is north).
+    // the requested tile starts at texel (n_rings * (size - 1), n_rings * (size - 1)).
+    struct Neighbourhood {
+        tile::Id centre;
+        unsigned n_rings = 0;
+        unsigned size = 0; // texels per side of one tile
+        double texel_size = 0; // world space distance between two texels
+        Raster<float> heights;
+
+        [[nodiscard]] glm::uvec2 centre_offset() const { return glm::uvec2(n_rings * (size - 1)); }
+    };
+
+    explicit HorizonMapGenerator(MemoryCache* cache, Settings settings = {});
+
+    // fails if the tile is not in the cache
+    [[nodiscard]] std::optional<HorizonMap> generate(const tile::Id& id) const;
+    [[nodiscard]] std::optional<Neighbourhood> gather(const tile::Id& id) const;
+    [[nodiscard]] static HorizonMap compute(const Neighbourhood& neighbourhood, const Settings& settings);
+
+    [[nodiscard]] const Settings& settings() const { return m_settings; }
+
+private:
+    MemoryCache* m_cache;
+    Settings m_settings;
+};
+
+} // namespace nucleus::tile
@@ -67,7 +67,7 @@ void Scheduler::receive_quad(const DataQuad& new_quad)
     // so we'll simply treat any 404 as network error.
     // however, we need to pass tiles with zoomlevel < 10, otherwise the top of the tree won't be built.
     if (new_quad.network_info().status == Status::Good || new_quad.id.zoom_level < 10) {
-        m_ram_cache.insert(new_quad);
+        m_ram_cache.insert(transform_for_cache(new_quad));
         schedule_purge();
         schedule_update();
         schedule_persist();
@@ -77,7 +77,7 @@ void Scheduler::receive_quad(const DataQuad& new_quad)
     switch (new_quad.network_info().status) {
     case Status::Good:
     case Status::NotFound: {
-        m_ram_cache.insert(new_quad);
+        m_ram_cache.insert(transform_for_cache(new_quad));
         QVariantMap stats;
         stats["n_quads_ram"] = m_ram_cache.n_cached_objects();
         emit stats_ready(m_name, stats);
@@ -180,7 +180,7 @@ void Scheduler::purge_ram_cache()
 
     const auto should_refine = tile::utils::refineFunctor(m_current_camera, m_aabb_decorator, m.tile_resolution, m.max_zoom_level);
     m_ram_cache.visit([&should_refine](const DataQuad& quad) { return should_refine(quad.id); });
-    m_ram_cache.purge(m.ram_quad_limit);
+    on_ram_quads_purged(m_ram_cache.purge(m.ram_quad_limit));
 
     QVariantMap stats;
     stats["n_quads_ram"] = m_ram_cache.n_cached_objects();
@@ -206,6 +206,7 @@ tl::expected<void, QString> Scheduler::persist_tiles()
     if (!r.has_value()) {
         qDebug() << QString("Writing tiles to disk into %1 failed: %2. Removing all files.").arg(QString::fromStdString(disk_cache_path().string())).arg(r.error());
         std::filesystem::remove_all(disk_cache_path());
+        on_disk_cache_removed();
     }
     return r;
 }
@@ -271,6 +272,7 @@ tl::expected<void, QString> Scheduler::read_disk_cache()
     } else {
         qDebug() << QString("Reading tiles from disk cache (%1) failed: \n%2\nRemoving all files.").arg(QString::fromStdString(disk_cache_path().string())).arg(r.error());
         std::filesystem::remove_all(disk_cache_path());
+        on_disk_cache_removed();
     }
     return r;
 }
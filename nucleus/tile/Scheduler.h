@@ -121,6 +121,13 @@ protected:
     std::vector<tile::Id> quads_for_current_camera_position() const;
     virtual bool is_ready_to_ship(const DataQuad&) const { return true; }
     virtual void transform_and_emit(const std::vector<DataQuad>& new_quads, const std::vector<tile::Id>& deleted_quads) = 0;
+    // called with the quads that were removed from the ram cache, e.g., to drop data derived from them
+    virtual void on_ram_quads_purged(const std::vector<DataQuad>&) { }
+    // called with received quads before they are inserted into the ram cache (and persisted with it), e.g., to store the data in a format that
+    // is faster to load
+    virtual DataQuad transform_for_cache(const DataQuad& quad) const { return quad; }
+    // called after the files of the tile cache were removed (because reading or writing them failed), e.g., to remove data stored next to them
+    virtual void on_disk_cache_removed() { }
 
 private:
     QString m_name = "unnamed";
@@ -0,0 +1,171 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "ShadowCascadeCache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "drawing.h"
+#include "nucleus/srs.h"
+
+namespace nucleus::tile {
+
+namespace {
+    uint64_t packed(const tile::Id& id)
+    {
+        const auto p = srs::pack(id);
+        return (uint64_t(p.x) << 32) | p.y;
+    }
+} // namespace
+
+unsigned ShadowCascadeCache::Statistics::total_redraws() const
+{
+    unsigned sum = 0;
+    for (const auto n : n_redraws)
+        sum += n;
+    return sum;
+}
+
+ShadowCascadeCache::ShadowCascadeCache(Settings settings)
+    : m_settings(std::move(settings))
+{
+    assert(!m_settings.split_distances.empty());
+    assert(std::is_sorted(m_settings.split_distances.begin(), m_settings.split_distances.end()));
+    assert(m_settings.resolution > 0);
+    m_cascades.resize(m_settings.split_distances.size());
+    m_statistics.n_redraws.resize(m_settings.split_distances.size(), 0);
+}
+
+std::vector<bool> ShadowCascadeCache::update(
+    const camera::Definition& camera, const glm::dvec3& direction_to_light, const std::vector<TileBounds>& draw_list, const TileResolver& resolve)
+{
+    const auto light_direction = glm::normalize(direction_to_light);
+    const auto min_direction_cos = std::cos(m_settings.max_light_direction_change);
+    m_near_plane = camera.near_plane();
+    ++m_statistics.n_frames;
+
+    std::vector<bool> redraw(m_cascades.size());
+    double near_distance = m_near_plane;
+    for (unsigned i = 0; i < m_cascades.size(); ++i) {
+        auto& cached = m_cascades[i];
+        const auto far_distance = m_settings.split_distances[i];
+        // keeping the cached direction if it is close enough keeps the box identical
+        const auto direction = (cached.valid && glm::dot(cached.direction_to_light, light_direction) >= min_direction_cos) ? cached.direction_to_light : light_direction;
+        auto cascade = compute_cascade(camera, direction, near_distance, far_distance);
+        near_distance = far_distance;
+
+        cascade.tiles = drawing::cull_orthographic(draw_list, cascade.light_view_projection, glm::dvec3(0));
+        cascade.fingerprint.reserve(cascade.tiles.size());
+        for (const auto& t : cascade.tiles)
+            cascade.fingerprint.emplace_back(packed(t.id), packed(resolve ? resolve(t.id) : t.id));
+        std::sort(cascade.fingerprint.begin(), cascade.fingerprint.end());
+        cascade.valid = true;
+
+        redraw[i] = !cached.valid || cascade.direction_to_light != cached.direction_to_light || cascade.centre != cached.centre || cascade.radius != cached.radius
+            || cascade.depth_min != cached.depth_min || cascade.depth_max != cached.depth_max || cascade.fingerprint != cached.fingerprint;
+        if (redraw[i])
+            ++m_statistics.n_redraws[i];
+        cached = std::move(cascade);
+    }
+    return redraw;
+}
+
+void ShadowCascadeCache::invalidate()
+{
+    for (auto& cascade : m_cascades)
+        cascade.valid = false;
+}
+
+ShadowCascadeCache::Cascade ShadowCascadeCache::compute_cascade(
+    const camera::Definition& camera, const glm::dvec3& direction_to_light, double near_distance, double far_distance) const
+{
+    // bounding sphere of the frustum slice, centred on the view axis. it doesn't depend on the camera orientation.
+    const auto viewport = camera.viewport_size();
+    const auto tan_vertical = std::tan(glm::radians(double(camera.field_of_view())) * 0.5);
+    const auto tan_horizontal = tan_vertical * double(viewport.x) / double(std::max(viewport.y, 1u));
+    const auto half_depth = (far_distance - near_distance) * 0.5;
+    const auto exact_radius = std::sqrt(far_distance * tan_horizontal * far_distance * tan_horizontal + far_distance * tan_vertical * far_distance * tan_vertical + half_depth * half_depth);
+    const glm::dvec3 slice_centre = camera.position() - camera.z_axis() * (near_distance + half_depth);
+
+    Cascade cascade;
+    cascade.direction_to_light = direction_to_light;
+    // 8 steps per octave, so that changes of the near plane don't invalidate
+    cascade.radius = std::exp2(std::ceil(std::log2(exact_radius) * 8.0) / 8.0);
+
+    const auto up = std::abs(direction_to_light.z) > 0.99 ? glm::dvec3(0, 1, 0) : glm::dvec3(0, 0, 1);
+    const auto light_view = glm::lookAt(glm::dvec3(0), -direction_to_light, up);
+    const auto light_space_centre = glm::dvec3(light_view * glm::dvec4(slice_centre, 1.0));
+
+    const auto texel_size = 2.0 * cascade.radius / double(m_settings.resolution);
+    cascade.centre = glm::round(glm::dvec2(light_space_centre) / texel_size) * texel_size;
+    const auto distance = -light_space_centre.z; // along the light direction
+    cascade.depth_min = std::floor((distance - cascade.radius * (1.0 + m_settings.depth_extension)) / cascade.radius) * cascade.radius;
+    cascade.depth_max = std::ceil((distance + cascade.radius) / cascade.radius) * cascade.radius;
+
+    const auto left = cascade.centre.x - cascade.radius;
+    const auto right = cascade.centre.x + cascade.radius;
+    const auto bottom = cascade.centre.y - cascade.radius;
+    const auto top = cascade.centre.y + cascade.radius;
+    const auto projection = m_settings.zero_to_one_depth ? glm::orthoZO(left, right, bottom, top, cascade.depth_min, cascade.depth_max)
+                                                         : glm::ortho(left, right, bottom, top, cascade.depth_min, cascade.depth_max);
+    cascade.light_view_projection = projection * light_view;
+    return cascade;
+}
+
+unsigned ShadowCascadeCache::n_cascades() const { return unsigned(m_cascades.size()); }
+
+const ShadowCascadeCache::Cascade& ShadowCascadeCache::cascade(unsigned index) const
+{
+    assert(index < m_cascades.size());
+    return m_cascades[index];
+}
+
+std::vector<double> ShadowCascadeCache::cascade_planes() const
+{
+    std::vector<double> planes = { m_near_plane };
+    planes.insert(planes.end(), m_settings.split_distances.begin(), m_settings.split_distances.end());
+    return planes;
+}
+
+glm::mat4 ShadowCascadeCache::local_light_view_projection(unsigned index, const glm::dvec3& origin_offset) const
+{
+    return glm::mat4(cascade(index).light_view_projection * glm::translate(glm::dmat4(1.0), origin_offset));
+}
+
+const ShadowCascadeCache::Statistics& ShadowCascadeCache::statistics() const { return m_statistics; }
+
+const ShadowCascadeCache::Settings& ShadowCascadeCache::settings() const { return m_settings; }
+
+ShadowCascadeCache::Statistics replay(ShadowCascadeCache::Settings settings,
+    const camera::recording::Animation& path,
+    camera::Definition camera,
+    const glm::dvec3& direction_to_light,
+    const std::function<std::vector<TileBounds>(const camera::Definition&)>& draw_list)
+{
+    ShadowCascadeCache cache(std::move(settings));
+    for (const auto& frame : path) {
+        camera.set_model_matrix(frame.camera_to_world_matrix);
+        cache.update(camera, direction_to_light, draw_list(camera));
+    }
+    return cache.statistics();
+}
+
+} // namespace nucleus::tile
@@ -0,0 +1,95 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "nucleus/camera/recording.h"
+#include "types.h"
+
+namespace nucleus::tile {
+
+// Decides which shadow cascades have to be re-rendered in a frame.
+// Every cascade is a light space box around the bounding sphere of its slice of the view frustum. The sphere radius is quantised, the box centre
+// is snapped to shadow map texels and the depth range to multiples of the radius. Hence the box doesn't change with camera rotation
+// (apart from the slice centre moving) and stays identical for moves below a texel. A cascade is redrawn only if its box, the light direction or
+// the set of tiles inside it changes. Boxes and matrices are in world space (double), local_light_view_projection() converts them for the gpu.
+class ShadowCascadeCache {
+public:
+    struct Settings {
+        std::vector<double> split_distances = { 2'000, 4'000, 10'000, 100'000 }; // far end of every cascade, the first starts at the near plane
+        unsigned resolution = 4096; // shadow map texels along one side
+        double depth_extension = 10; // the box is extended towards the light by this many radii, so that mountains outside can cast into it
+        double max_light_direction_change = 1e-5; // radians, smaller changes keep the cached direction
+        bool zero_to_one_depth = false; // clip space depth convention of the projection matrices
+    };
+    struct Cascade {
+        glm::dvec3 direction_to_light = {};
+        glm::dvec2 centre = {}; // light space, snapped to texels
+        double radius = 0; // half extent of the box in light space
+        double depth_min = 0; // distance along the light direction, snapped
+        double depth_max = 0;
+        glm::dmat4 light_view_projection = glm::dmat4(1); // world space to clip space
+        std::vector<TileBounds> tiles; // draw list of the cascade, in draw list order
+        std::vector<std::pair<uint64_t, uint64_t>> fingerprint; // sorted (tile id, resolved id) pairs, packed
+        bool valid = false;
+    };
+    struct Statistics {
+        unsigned n_frames = 0;
+        std::vector<unsigned> n_redraws; // per cascade
+        [[nodiscard]] unsigned total_redraws() const;
+    };
+    // Maps a tile in the draw list to the tile whose data is actually drawn (e.g., an ancestor while the tile is still loading).
+    using TileResolver = std::function<tile::Id(const tile::Id&)>;
+
+    explicit ShadowCascadeCache(Settings settings = {});
+
+    // Computes the cascades for this frame and returns, per cascade, whether it has to be redrawn. direction_to_light doesn't need to be normalised.
+    std::vector<bool> update(const camera::Definition& camera, const glm::dvec3& direction_to_light, const std::vector<TileBounds>& draw_list, const TileResolver& resolve = {});
+    void invalidate();
+
+    [[nodiscard]] unsigned n_cascades() const;
+    [[nodiscard]] const Cascade& cascade(unsigned index) const;
+    // Distances along the view direction splitting the cascades, n_cascades() + 1 values starting with the near plane of the last update.
+    [[nodiscard]] std::vector<double> cascade_planes() const;
+    // light_view_projection for positions relative to origin_offset, in single precision
+    [[nodiscard]] glm::mat4 local_light_view_projection(unsigned index, const glm::dvec3& origin_offset) const;
+    [[nodiscard]] const Statistics& statistics() const;
+    [[nodiscard]] const Settings& settings() const;
+
+private:
+    Cascade compute_cascade(const camera::Definition& camera, const glm::dvec3& direction_to_light, double near_distance, double far_distance) const;
+
+    Settings m_settings;
+    std::vector<Cascade> m_cascades;
+    double m_near_plane = 0;
+    Statistics m_statistics;
+};
+
+// Replays a recorded camera path (projection parameters are taken from camera) and reports the redraws the cache would have triggered.
+// draw_list is called once per frame.
+ShadowCascadeCache::Statistics replay(ShadowCascadeCache::Settings settings,
+    const camera::recording::Animation& path,
+    camera::Definition camera,
+    const glm::dvec3& direction_to_light,
+    const std::function<std::vector<TileBounds>(const camera::Definition&)>& draw_list);
+
+} // namespace nucleus::tile
@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "TextureDiskCache.h"
+
+#include <QFile>
+#include <utility>
+#include <vector>
+#include <zpp_bits.h>
+
+namespace nucleus::tile {
+
+TextureDiskCache::TextureDiskCache(std::filesystem::path base_path)
+    : m_base_path(std::move(base_path))
+{
+}
+
+std::optional<nucleus::utils::MipmappedColourTexture> TextureDiskCache::read(const DataQuad& quad, Format format) const
+{
+    QFile file(texture_path(quad.id, format));
+    if (!file.open(QIODeviceBase::ReadOnly))
+        return {};
+    const auto bytes = file.readAll();
+    zpp::bits::in in(bytes);
+
+    std::remove_cvref_t<decltype(version_information)> version = {};
+    std::array<uint64_t, 4> timestamps = {};
+    uint32_t stored_format = 0;
+    uint32_t n_levels = 0;
+    if (failure(in(version, timestamps, stored_format, n_levels)))
+        return {};
+    if (version != version_information || timestamps != source_timestamps(quad) || stored_format != uint32_t(format) || n_levels == 0)
+        return {};
+
+    nucleus::utils::MipmappedColourTexture texture;
+    texture.reserve(n_levels);
+    for (uint32_t i = 0; i < n_levels; ++i) {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> data;
+        if (failure(in(width, height, data)))
+            return {};
+        texture.emplace_back(std::move(data), width, height, format);
+    }
+    return texture;
+}
+
+tl::expected<void, QString> TextureDiskCache::write(const DataQuad& quad, const nucleus::utils::MipmappedColourTexture& texture)
+{
+    const auto unexpected_error = [](const auto& e) { return tl::unexpected(QString::fromStdString(std::make_error_code(e).message())); };
+    if (texture.empty())
+        return tl::unexpected(QString("Not writing an empty texture for quad %1/%2/%3.").arg(quad.id.zoom_level).arg(quad.id.coords.x).arg(quad.id.coords.y));
+    const auto format = texture.front().format();
+
+    std::vector<char> bytes;
+    zpp::bits::out out(bytes);
+    {
+        const auto r = out(version_information, source_timestamps(quad), uint32_t(format), uint32_t(texture.size()));
+        if (failure(r))
+            return unexpected_error(r);
+    }
+    for (const auto& level : texture) {
+        const auto r = out(uint32_t(level.width()), uint32_t(level.height()), std::span<const uint8_t>(level.data(), level.n_bytes()));
+        if (failure(r))
+            return unexpected_error(r);
+    }
+
+    std::filesystem::create_directories(m_base_path);
+    const auto path = texture_path(quad.id, format);
+    // write to a temporary file and rename it, so that an interrupted or failed write never leaves a truncated texture behind
+    auto temp_path = path;
+    temp_path += ".tmp";
+    {
+        QFile file(temp_path);
+        if (!file.open(QIODeviceBase::WriteOnly))
+            return tl::unexpected(QString("Couldn't open file '%1' for writing!").arg(QString::fromStdString(temp_path.string())));
+        const auto n_written = file.write(bytes.data(), qint64(bytes.size()));
+        file.close();
+        if (n_written != qint64(bytes.size()) || file.error() != QFileDevice::NoError) {
+            std::filesystem::remove(temp_path);
+            return tl::unexpected(QString("Writing file '%1' failed: %2").arg(QString::fromStdString(temp_path.string()), file.errorString()));
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp_path, path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path);
+        return tl::unexpected(QString("Couldn't move '%1' to '%2': %3").arg(QString::fromStdString(temp_path.string()), QString::fromStdString(path.string()), QString::fromStdString(ec.message())));
+    }
+    return {};
+}
+
+void TextureDiskCache::remove(const tile::Id& id)
+{
+    for (const auto format : { Format::Uncompressed_RGBA, Format::DXT1, Format::ETC1 })
+        std::filesystem::remove(texture_path(id, format));
+}
+
+std::filesystem::path TextureDiskCache::texture_path(const tile::Id& id, Format format) const
+{
+    const auto name = std::to_string(id.zoom_level) + "_" + std::to_string(id.coords.x) + "_" + std::to_string(id.coords.y) + "_" + std::to_string(unsigned(format)) + ".alp_texture";
+    return m_base_path / name;
+}
+
+std::array<uint64_t, 4> TextureDiskCache::source_timestamps(const DataQuad& quad)
+{
+    std::array<uint64_t, 4> timestamps = {};
+    for (unsigned i = 0; i < quad.n_tiles; ++i)
+        timestamps[unsigned(quad_position(quad.tiles[i].id))] = quad.tiles[i].network_info.timestamp;
+    return timestamps;
+}
+
+} // namespace nucleus::tile
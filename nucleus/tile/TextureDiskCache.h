@@ -0,0 +1,59 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <array>
+#include <filesystem>
+#include <optional>
+#include <tl/expected.hpp>
+
+#include "types.h"
+
+namespace nucleus::tile {
+
+// Second cache tier for TextureScheduler: stores the final, compressed and mipmapped textures of quads, so that a warm start skips
+// decoding, stitching and compression. There is one file per quad and format. It also stores the timestamps of the source tiles,
+// a texture is only returned if they match the quad it was made from (i.e., refreshed tiles invalidate it).
+//
+// Not thread safe, use one instance per scheduler.
+class TextureDiskCache {
+public:
+    using Format = nucleus::utils::ColourTexture::Format;
+    static constexpr std::array<char, 25> version_information = { "ColourTexture, v0.1" };
+
+    explicit TextureDiskCache(std::filesystem::path base_path);
+
+    [[nodiscard]] const std::filesystem::path& base_path() const { return m_base_path; }
+
+    // empty on a miss, outdated source tiles, or unreadable files
+    [[nodiscard]] std::optional<nucleus::utils::MipmappedColourTexture> read(const DataQuad& quad, Format format) const;
+    [[nodiscard]] tl::expected<void, QString> write(const DataQuad& quad, const nucleus::utils::MipmappedColourTexture& texture);
+    // removes all formats of the quad
+    void remove(const tile::Id& id);
+
+private:
+    [[nodiscard]] std::filesystem::path texture_path(const tile::Id& id, Format format) const;
+    // indexed by quad position, 0 for missing tiles
+    [[nodiscard]] static std::array<uint64_t, 4> source_timestamps(const DataQuad& quad);
+
+    std::filesystem::path m_base_path;
+};
+
+} // namespace nucleus::tile
@@ -17,6 +17,7 @@
  *****************************************************************************/
 
 #include "TextureScheduler.h"
+#include "TextureDiskCache.h"
 #include "conversion.h"
 #include <QDebug>
 #include <nucleus/utils/image_loader.h>
@@ -39,8 +40,20 @@ void TextureScheduler::transform_and_emit(const std::vector<tile::DataQuad>& new
     for (const auto& quad : new_quads) {
         GpuTextureTile gpu_tile;
         gpu_tile.id = quad.id;
+        if (m_texture_disk_cache) {
+            if (auto texture = m_texture_disk_cache->read(quad, m_compression_algorithm)) {
+                gpu_tile.texture = std::make_shared<nucleus::utils::MipmappedColourTexture>(std::move(*texture));
+                new_gpu_tiles.push_back(gpu_tile);
+                continue;
+            }
+        }
         auto ortho_raster = to_raster(quad, m_default_raster);
         gpu_tile.texture = std::make_shared<nucleus::utils::MipmappedColourTexture>(generate_mipmapped_colour_texture(ortho_raster, m_compression_algorithm));
+        if (m_texture_disk_cache) {
+            const auto r = m_texture_disk_cache->write(quad, *gpu_tile.texture);
+            if (!r.has_value())
+                qDebug() << QString("Writing texture of quad %1/%2/%3 to disk failed: %4").arg(quad.id.zoom_level).arg(quad.id.coords.x).arg(quad.id.coords.y).arg(r.error());
+        }
         new_gpu_tiles.push_back(gpu_tile);
     }
 
@@ -48,8 +61,39 @@ void TextureScheduler::transform_and_emit(const std::vector<tile::DataQuad>& new
     emit gpu_tiles_updated(deleted_quads, new_gpu_tiles);
 }
 
+void TextureScheduler::on_ram_quads_purged(const std::vector<tile::DataQuad>& purged_quads)
+{
+    if (!m_texture_disk_cache)
+        return;
+    for (const auto& quad : purged_quads)
+        m_texture_disk_cache->remove(quad.id);
+}
+
+void TextureScheduler::on_disk_cache_removed()
+{
+    // nothing would remove the textures of quads that are no longer in the tile cache otherwise
+    std::filesystem::remove_all(texture_cache_path());
+}
+
 void TextureScheduler::set_texture_compression_algorithm(nucleus::utils::ColourTexture::Format compression_algorithm) { m_compression_algorithm = compression_algorithm; }
 
+void TextureScheduler::set_texture_disk_cache_enabled(bool enabled)
+{
+    if (!enabled) {
+        m_texture_disk_cache.reset();
+        return;
+    }
+    if (name() == "unnamed" || name().isEmpty()) {
+        qDebug() << "Not enabling the texture disk cache as the scheduler is not named, and this would cause name conflicts in the file system.";
+        return;
+    }
+    m_texture_disk_cache = std::make_unique<TextureDiskCache>(texture_cache_path());
+}
+
+bool TextureScheduler::texture_disk_cache_enabled() const { return bool(m_texture_disk_cache); }
+
+std::filesystem::path TextureScheduler::texture_cache_path() { return disk_cache_path().parent_path() / ("texture_cache_" + name().toStdString()); }
+
 Raster<glm::u8vec4> TextureScheduler::to_raster(const tile::DataQuad& quad, const Raster<glm::u8vec4>& default_raster)
 {
     assert(quad.n_tiles == 4);
@@ -20,8 +20,10 @@
 
 #include "Scheduler.h"
 #include "types.h"
+#include <memory>
 
 namespace nucleus::tile {
+class TextureDiskCache;
 
 class TextureScheduler : public Scheduler {
     Q_OBJECT
@@ -30,6 +32,11 @@ public:
     ~TextureScheduler() override;
 
     void set_texture_compression_algorithm(nucleus::utils::ColourTexture::Format compression_algorithm);
+    // keeps the compressed textures on disk (next to the tile cache, see texture_cache_path()), so they are not recomputed after a restart.
+    // requires a named scheduler, the name must be set before enabling.
+    void set_texture_disk_cache_enabled(bool enabled);
+    [[nodiscard]] bool texture_disk_cache_enabled() const;
+    std::filesystem::path texture_cache_path();
     static Raster<glm::u8vec4> to_raster(const tile::DataQuad& data_quad, const Raster<glm::u8vec4>& default_raster);
 
 signals:
@@ -37,10 +44,13 @@ signals:
 
 protected:
     void transform_and_emit(const std::vector<tile::DataQuad>& new_quads, const std::vector<tile::Id>& deleted_quads) override;
+    void on_ram_quads_purged(const std::vector<tile::DataQuad>& purged_quads) override;
+    void on_disk_cache_removed() override;
 
 private:
     nucleus::utils::ColourTexture::Format m_compression_algorithm = nucleus::utils::ColourTexture::Format::Uncompressed_RGBA;
     Raster<glm::u8vec4> m_default_raster;
+    std::unique_ptr<TextureDiskCache> m_texture_disk_cache;
 };
 
 } // namespace nucleus::tile
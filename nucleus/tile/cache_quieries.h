@@ -23,7 +23,7 @@
 #include "nucleus/tile/Cache.h"
 #include "radix/height_encoding.h"
 
-#include "nucleus/utils/image_loader.h"
+#include "nucleus/tile/conversion.h"
 
 namespace nucleus::tile::cache_queries {
 
@@ -48,11 +48,11 @@ inline tl::expected<float, QString> query_altitude(MemoryCache* cache, const glm
     const auto uv = (world_space - bounds.min) / bounds.size();
 
     if (selected_tile.data && selected_tile.data->size()) {
-        if (const auto height_tile_expected = nucleus::utils::image_loader::rgba8(*selected_tile.data)) {
+        if (const auto height_tile_expected = nucleus::tile::conversion::height_tile_to_u16raster(*selected_tile.data)) {
             const auto& height_tile = height_tile_expected.value();
             const auto p = glm::uvec2(uint32_t(uv.x * height_tile.width()), uint32_t((1 - uv.y) * height_tile.height()));
             const auto px = height_tile.pixel(p);
-            return radix::height_encoding::to_float(glm::u8vec3(px));
+            return radix::height_encoding::to_float(glm::u8vec3(uint8_t(px >> 8), uint8_t(px & 0xff), 0));
         }
     }
     assert(false);
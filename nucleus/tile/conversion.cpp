@@ -19,6 +19,9 @@
 
 #include "conversion.h"
 
+#include <nucleus/utils/height_codec.h>
+#include <nucleus/utils/image_loader.h>
+
 namespace nucleus::tile::conversion {
 
 Raster<uint16_t> to_u16raster(const Raster<glm::u8vec4>& raster)
@@ -30,4 +33,11 @@ Raster<uint16_t> to_u16raster(const Raster<glm::u8vec4>& raster)
     return retval;
 }
 
+tl::expected<Raster<uint16_t>, QString> height_tile_to_u16raster(const QByteArray& bytes)
+{
+    if (nucleus::utils::height_codec::is_encoded(bytes))
+        return nucleus::utils::height_codec::decode(bytes);
+    return nucleus::utils::image_loader::rgba8(bytes).map([](const Raster<glm::u8vec4>& rgba) { return to_u16raster(rgba); });
+}
+
 } // namespace nucleus::tile::conversion
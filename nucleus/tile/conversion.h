@@ -22,7 +22,9 @@
 #include <glm/glm.hpp>
 
 #include <QByteArray>
+#include <QString>
 #include <nucleus/Raster.h>
+#include <tl/expected.hpp>
 
 #ifdef QT_GUI_LIB
 #include <QImage>
@@ -35,6 +37,12 @@ namespace nucleus::tile::conversion {
  */
 Raster<uint16_t> to_u16raster(const Raster<glm::u8vec4>& raster);
 
+/**
+ * @brief Decodes a height tile as held by the tile caches, i.e., either the png as served (rg packed, see above) or transcoded with
+ * utils::height_codec (see GeometryScheduler::transform_for_cache).
+ */
+tl::expected<Raster<uint16_t>, QString> height_tile_to_u16raster(const QByteArray& bytes);
+
 #ifdef QT_GUI_LIB
 inline Raster<uint16_t> qimage_to_u16raster(const QImage& qimage)
 {
@@ -17,6 +17,7 @@
  *****************************************************************************/
 
 #include "drawing.h"
+#include <cassert>
 #include <radix/quad_tree.h>
 #include <unordered_set>
 
@@ -106,4 +107,41 @@ std::vector<TileBounds> sort(std::vector<TileBounds> list, const glm::dvec3& cam
     return list;
 }
 
+std::vector<TileBounds> cull_orthographic(
+    const std::vector<TileBounds>& list, const glm::dmat4& light_view_projection, const glm::dvec3& origin_offset, bool keep_casters_towards_light)
+{
+    // orthographic projections are affine, hence the clip space bounds of an aabb are exact: centre transformed, extent by the absolute matrix
+    assert(light_view_projection[0][3] == 0 && light_view_projection[1][3] == 0 && light_view_projection[2][3] == 0);
+    const glm::dmat3 linear = glm::dmat3(light_view_projection);
+    const glm::dmat3 abs_linear = glm::dmat3(glm::abs(linear[0]), glm::abs(linear[1]), glm::abs(linear[2]));
+    const glm::dvec3 translation = glm::dvec3(light_view_projection[3]) / light_view_projection[3][3];
+
+    std::vector<TileBounds> culled_tiles;
+    culled_tiles.reserve(list.size());
+    for (const auto& t : list) {
+        const glm::dvec3 centre = (t.bounds.min + t.bounds.max) * 0.5 - origin_offset;
+        const glm::dvec3 extent = (t.bounds.max - t.bounds.min) * 0.5;
+        const glm::dvec3 clip_centre = linear * centre + translation;
+        const glm::dvec3 clip_extent = abs_linear * extent;
+        const glm::dvec3 lower = clip_centre - clip_extent;
+        const glm::dvec3 upper = clip_centre + clip_extent;
+        if (upper.x < -1 || lower.x > 1 || upper.y < -1 || lower.y > 1 || lower.z > 1)
+            continue;
+        if (!keep_casters_towards_light && upper.z < -1)
+            continue;
+        culled_tiles.push_back(t);
+    }
+    return culled_tiles;
+}
+
+std::vector<std::vector<TileBounds>> cull_cascades(
+    const std::vector<TileBounds>& list, const std::vector<glm::dmat4>& light_view_projections, const glm::dvec3& origin_offset, bool keep_casters_towards_light)
+{
+    std::vector<std::vector<TileBounds>> cascades;
+    cascades.reserve(light_view_projections.size());
+    for (const auto& m : light_view_projections)
+        cascades.push_back(cull_orthographic(list, m, origin_offset, keep_casters_towards_light));
+    return cascades;
+}
+
 } // namespace nucleus::tile::drawing
@@ -29,4 +29,17 @@ std::vector<TileBounds> compute_bounds(const std::vector<tile::Id>& tiles, utils
 std::vector<tile::Id> limit(std::vector<tile::Id> tiles, uint max_n_tiles);
 std::vector<TileBounds> cull(std::vector<TileBounds> list, const camera::Definition& camera);
 std::vector<TileBounds> sort(std::vector<TileBounds> list, const glm::dvec3& camera_position);
+
+// Culls against the box of an orthographic (light) projection. light_view_projection maps positions relative to origin_offset to clip space
+// (x and y in [-1, 1], z increasing away from the light). The depth range is tested against [-1, 1], which is conservative for 0 to 1 clip
+// conventions. With keep_casters_towards_light, the near (light facing) side is not tested: tiles between the box and the light can cast
+// shadows into it.
+std::vector<TileBounds> cull_orthographic(
+    const std::vector<TileBounds>& list, const glm::dmat4& light_view_projection, const glm::dvec3& origin_offset, bool keep_casters_towards_light = true);
+
+// One culled list per shadow cascade, in the order of light_view_projections.
+std::vector<std::vector<TileBounds>> cull_cascades(const std::vector<TileBounds>& list,
+    const std::vector<glm::dmat4>& light_view_projections,
+    const glm::dvec3& origin_offset,
+    bool keep_casters_towards_light = true);
 }
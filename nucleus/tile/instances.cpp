@@ -0,0 +1,57 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "instances.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <nucleus/srs.h>
+
+namespace nucleus::tile {
+
+void pack_instances(const std::vector<TileBounds>& draw_list, const glm::dvec3& origin, const GpuArrayHelper& dtm_layers, std::vector<GpuTileInstance>& instances)
+{
+    const auto n = std::min(draw_list.size(), size_t(max_n_tile_instances));
+    instances.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        const auto& tile = draw_list[i];
+        auto& instance = instances[i];
+        instance.bounds = glm::vec4 { tile.bounds.min.x - origin.x, tile.bounds.min.y - origin.y, tile.bounds.max.x - origin.x, tile.bounds.max.y - origin.y };
+        instance.packed_id = srs::pack(tile.id);
+
+        const auto layer = dtm_layers.layer(tile.id);
+        const auto on_gpu = layer.id.zoom_level <= 50;
+        instance.dtm_array_index = on_gpu ? uint16_t(layer.index) : 0;
+        instance.dtm_zoom = on_gpu ? uint8_t(layer.id.zoom_level) : 0;
+    }
+}
+
+void pack_texture_layers(const std::vector<TileBounds>& draw_list, const GpuArrayHelper& layers, Raster<uint16_t>& array_index, Raster<uint8_t>& zoom)
+{
+    assert(array_index.width() == max_n_tile_instances);
+    assert(zoom.width() == max_n_tile_instances);
+    const auto n = unsigned(std::min(draw_list.size(), size_t(max_n_tile_instances)));
+    for (unsigned i = 0; i < n; ++i) {
+        const auto layer = layers.layer(draw_list[i].id);
+        zoom.pixel({ i, 0 }) = uint8_t(layer.id.zoom_level);
+        array_index.pixel({ i, 0 }) = uint16_t(layer.index);
+    }
+}
+
+} // namespace nucleus::tile
@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "GpuArrayHelper.h"
+#include "types.h"
+#include <nucleus/Raster.h>
+
+namespace nucleus::tile {
+
+// Per instance data of the tile geometry, interleaved in one vertex buffer (attributes in tile.glsl).
+struct GpuTileInstance {
+    glm::vec4 bounds = {}; // x/y min and max, relative to the origin the draw list was packed for
+    glm::u32vec2 packed_id = {};
+    uint16_t dtm_array_index = 0;
+    uint8_t dtm_zoom = 0;
+    uint8_t padding[5] = {};
+};
+static_assert(sizeof(GpuTileInstance) == 32);
+
+constexpr unsigned max_n_tile_instances = 1024; // per draw call, also the width of the instance index textures of texture layers
+
+// Packs (up to max_n_tile_instances) tiles of a draw list, reusing the capacity of instances. Tiles without geometry on the gpu (happens during
+// startup) get layer 0.
+void pack_instances(const std::vector<TileBounds>& draw_list, const glm::dvec3& origin, const GpuArrayHelper& dtm_layers, std::vector<GpuTileInstance>& instances);
+
+// Array layer and zoom level of the texture drawn for every instance. Both rasters must be max_n_tile_instances x 1.
+void pack_texture_layers(const std::vector<TileBounds>& draw_list, const GpuArrayHelper& layers, Raster<uint16_t>& array_index, Raster<uint8_t>& zoom);
+
+} // namespace nucleus::tile
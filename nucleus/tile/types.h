@@ -23,8 +23,10 @@
 
 #include <nucleus/utils/ColourTexture.h>
 #include <nucleus/utils/ColourTexture3D.h>
+#include <nucleus/utils/contours.h>
 #include <nucleus/utils/lang.h>
 #include <radix/tile.h>
+#include <vector>
 
 namespace nucleus {
 template <typename T>
@@ -70,6 +72,9 @@ struct Data {
     tile::Id id;
     NetworkInfo network_info;
     std::shared_ptr<QByteArray> data;
+    // computed from data when the quad enters the ram cache (Scheduler::transform_for_cache) and cached with it, e.g., the contour lines
+    // of height tiles. empty if there is none.
+    QByteArray derived_data = {};
 };
 static_assert(NamedTile<Data>);
 
@@ -78,7 +83,7 @@ struct DataQuad {
     unsigned n_tiles = 0;
     std::array<Data, 4> tiles = {};
     NetworkInfo network_info() const { return NetworkInfo::join(tiles[0].network_info, tiles[1].network_info, tiles[2].network_info, tiles[3].network_info); }
-    static constexpr std::array<char, 25> version_information = { "DataQuad, version 0.1" };
+    static constexpr std::array<char, 25> version_information = { "DataQuad, version 0.2" };
 };
 static_assert(NamedTile<DataQuad>);
 static_assert(SerialisableTile<DataQuad>);
@@ -124,6 +129,11 @@ struct GpuGeometryTile {
     tile::Id id;
     tile::SrsAndHeightBounds bounds = {};
     std::shared_ptr<const nucleus::Raster<uint16_t>> surface;
+    // simplified triangle list with curtains, using the vertex ids of the regular grid (see utils/terrain_simplification.h).
+    // null if simplification is off, the shared index buffer of the renderer is used then.
+    std::shared_ptr<const std::vector<uint16_t>> indices;
+    // contour lines in texel coordinates of surface (see utils/contours.h). null if contour generation is off.
+    std::shared_ptr<const std::vector<nucleus::utils::contours::Line>> contours;
 };
 static_assert(NamedTile<GpuGeometryTile>);
 
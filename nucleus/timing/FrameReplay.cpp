@@ -0,0 +1,177 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "FrameReplay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "CpuTimer.h"
+#include "TimerManager.h"
+#include "nucleus/DataQuerier.h"
+#include "nucleus/camera/Controller.h"
+#include "nucleus/tile/DrawListGenerator.h"
+#include "nucleus/tile/GeometryScheduler.h"
+#include "nucleus/tile/GpuArrayHelper.h"
+#include "nucleus/tile/ShadowCascadeCache.h"
+#include "nucleus/tile/drawing.h"
+#include "nucleus/tile/instances.h"
+
+namespace nucleus::timing {
+
+const FrameReplay::StageTimings* FrameReplay::Report::stage(const QString& name) const
+{
+    const auto it = std::find_if(stages.begin(), stages.end(), [&](const StageTimings& s) { return s.name == name; });
+    return it == stages.end() ? nullptr : &*it;
+}
+
+FrameReplay::FrameReplay(tile::utils::AabbDecoratorPtr aabb_decorator, Settings settings)
+    : m_aabb_decorator(std::move(aabb_decorator))
+    , m_settings(std::move(settings))
+{
+}
+
+FrameReplay::~FrameReplay() = default;
+
+tl::expected<void, QString> FrameReplay::load_fixture(const std::filesystem::path& path) { return m_fixture.read_from_disk(path); }
+
+tile::MemoryCache& FrameReplay::ram_cache() { return m_fixture; }
+
+const std::vector<QString>& FrameReplay::stage_names()
+{
+    static const std::vector<QString> names = { "camera", "scheduler", "gpu_slots", "draw_list", "cull", "shadow_cascades", "instances", "labels", "cpu_total" };
+    return names;
+}
+
+FrameReplay::Report FrameReplay::run(const camera::recording::Animation& path, const camera::Definition& camera)
+{
+    tile::GeometryScheduler scheduler(m_settings.scheduler, 65);
+    scheduler.set_aabb_decorator(m_aabb_decorator);
+    m_fixture.visit([&](const tile::DataQuad& quad) {
+        scheduler.ram_cache().insert(quad);
+        return true;
+    });
+
+    std::vector<tile::Id> deleted_tiles;
+    std::vector<tile::GpuGeometryTile> new_tiles;
+    QObject::connect(&scheduler, &tile::GeometryScheduler::gpu_tiles_updated, [&](const std::vector<tile::Id>& deleted, const std::vector<tile::GpuGeometryTile>& added) {
+        deleted_tiles.insert(deleted_tiles.end(), deleted.begin(), deleted.end());
+        new_tiles.insert(new_tiles.end(), added.begin(), added.end());
+    });
+
+    DataQuerier data_querier(&scheduler.ram_cache(), m_aabb_decorator);
+    auto initial_camera = camera;
+    initial_camera.set_viewport_size(m_settings.viewport_size);
+    camera::Controller controller(initial_camera, nullptr, &data_querier);
+    QObject::connect(&controller, &camera::Controller::definition_changed, &scheduler, &tile::Scheduler::update_camera);
+    scheduler.update_camera(controller.definition());
+
+    tile::GpuArrayHelper gpu_array;
+    gpu_array.set_tile_limit(m_settings.scheduler.gpu_quad_limit * 4);
+    tile::DrawListGenerator label_tiles;
+    label_tiles.set_aabb_decorator(m_aabb_decorator);
+    tile::ShadowCascadeCache shadow_cascades;
+    std::vector<tile::GpuTileInstance> instances;
+
+    TimerManager timers;
+    for (const auto& name : stage_names())
+        timers.add_timer(std::make_shared<CpuTimer>(name, "cpu", 1, 1.0f));
+    std::map<QString, std::vector<float>> samples;
+
+    Report report;
+    for (const auto& frame : path) {
+        timers.start_timer("cpu_total");
+
+        timers.start_timer("camera");
+        auto definition = controller.definition();
+        definition.set_model_matrix(frame.camera_to_world_matrix);
+        controller.set_model_matrix(definition);
+        const auto& current_camera = controller.definition();
+        timers.stop_timer("camera");
+
+        // the scheduler runs these on its update timer after a camera change
+        timers.start_timer("scheduler");
+        scheduler.send_quad_requests();
+        scheduler.update_gpu_quads();
+        timers.stop_timer("scheduler");
+
+        // gl_engine::TileGeometry::update_gpu_tiles, without the upload
+        timers.start_timer("gpu_slots");
+        for (const auto& id : deleted_tiles) {
+            gpu_array.remove_tile(id);
+            label_tiles.remove_tile(id);
+        }
+        for (const auto& tile : new_tiles) {
+            gpu_array.add_tile(tile.id);
+            label_tiles.add_tile(tile.id);
+        }
+        deleted_tiles.clear();
+        new_tiles.clear();
+        timers.stop_timer("gpu_slots");
+
+        timers.start_timer("draw_list");
+        const auto draw_list = tile::drawing::compute_bounds(
+            tile::drawing::limit(tile::drawing::generate_list(current_camera, m_aabb_decorator, m_settings.draw_list_max_zoom_level), m_settings.max_n_tiles), m_aabb_decorator);
+        timers.stop_timer("draw_list");
+
+        timers.start_timer("cull");
+        const auto culled_draw_list = tile::drawing::sort(tile::drawing::cull(draw_list, current_camera), current_camera.position());
+        timers.stop_timer("cull");
+
+        timers.start_timer("shadow_cascades");
+        shadow_cascades.update(current_camera, m_settings.direction_to_light, draw_list, [&](const tile::Id& id) { return gpu_array.layer(id).id; });
+        timers.stop_timer("shadow_cascades");
+
+        timers.start_timer("instances");
+        tile::pack_instances(culled_draw_list, current_camera.position(), gpu_array, instances);
+        timers.stop_timer("instances");
+
+        timers.start_timer("labels");
+        const auto label_tile_set
+            = label_tiles.cull(label_tiles.generate_for(current_camera, m_settings.label_tile_size, m_settings.label_max_zoom_level), current_camera.frustum());
+        timers.stop_timer("labels");
+
+        timers.stop_timer("cpu_total");
+
+        for (const auto& result : timers.fetch_results())
+            samples[result.name].push_back(result.value);
+        report.max_n_tiles_drawn = std::max(report.max_n_tiles_drawn, unsigned(culled_draw_list.size()));
+        ++report.n_frames;
+        Q_UNUSED(label_tile_set);
+    }
+    report.n_gpu_tiles = gpu_array.n_occupied();
+
+    for (const auto& name : stage_names()) {
+        const auto& values = samples[name];
+        const auto max = values.empty() ? 0.0f : *std::max_element(values.begin(), values.end());
+        report.stages.push_back({ name, unsigned(values.size()), percentile(values, 50), percentile(values, 99), max });
+    }
+    return report;
+}
+
+float percentile(std::vector<float> samples, float p)
+{
+    if (samples.empty())
+        return 0;
+    const auto rank = std::clamp(unsigned(std::ceil(double(p) / 100.0 * double(samples.size()))), 1u, unsigned(samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + (rank - 1), samples.end());
+    return samples[rank - 1];
+}
+
+} // namespace nucleus::timing
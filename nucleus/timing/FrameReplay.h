@@ -0,0 +1,86 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <QString>
+#include <filesystem>
+#include <memory>
+#include <tl/expected.hpp>
+#include <vector>
+
+#include "nucleus/camera/recording.h"
+#include "nucleus/tile/Cache.h"
+#include "nucleus/tile/Scheduler.h"
+#include "nucleus/tile/utils.h"
+
+namespace nucleus::timing {
+
+// Replays a recorded camera path through the cpu side of a frame, without gpu or network, so that cpu frame time regressions can be caught headless.
+// Every frame, camera::Controller is moved to the recorded matrix and the work of tile::Scheduler::update_camera (quad requests, gpu quad
+// selection and conversion) and of gl_engine::Window::paint (gpu slot assignment, draw list generation, culling and sorting, shadow cascades,
+// instance packing and label tile selection) is done. Label tiles follow the geometry tiles.
+// Tiles come from the ram cache, which can be loaded from a directory written by tile::Cache::write_to_disk.
+// Every stage is measured with a CpuTimer in a TimerManager, the report contains the percentiles over all frames.
+class FrameReplay {
+public:
+    struct Settings {
+        tile::Scheduler::Settings scheduler = { .tile_resolution = 256, .max_zoom_level = 18, .gpu_quad_limit = 512 }; // as in tile::setup::geometry_scheduler
+        glm::uvec2 viewport_size = { 1920, 1080 };
+        unsigned draw_list_max_zoom_level = 19; // as in gl_engine::Window::paint
+        unsigned max_n_tiles = 1024;
+        unsigned label_tile_size = 256; // as in gl_engine::MapLabels
+        unsigned label_max_zoom_level = 18;
+        glm::dvec3 direction_to_light = { -1, 1, 1 };
+    };
+    struct StageTimings {
+        QString name;
+        unsigned n_samples = 0;
+        float p50 = 0; // milliseconds
+        float p99 = 0;
+        float max = 0;
+    };
+    struct Report {
+        unsigned n_frames = 0;
+        unsigned n_gpu_tiles = 0; // at the end of the replay
+        unsigned max_n_tiles_drawn = 0;
+        std::vector<StageTimings> stages; // in pipeline order, "cpu_total" last
+        [[nodiscard]] const StageTimings* stage(const QString& name) const;
+    };
+
+    explicit FrameReplay(tile::utils::AabbDecoratorPtr aabb_decorator, Settings settings = {});
+    ~FrameReplay();
+
+    [[nodiscard]] tl::expected<void, QString> load_fixture(const std::filesystem::path& path);
+    [[nodiscard]] tile::MemoryCache& ram_cache();
+
+    // projection parameters are taken from camera, the viewport from the settings. gpu state starts empty on every run.
+    Report run(const camera::recording::Animation& path, const camera::Definition& camera);
+
+    [[nodiscard]] static const std::vector<QString>& stage_names();
+
+private:
+    tile::utils::AabbDecoratorPtr m_aabb_decorator;
+    Settings m_settings;
+    tile::MemoryCache m_fixture;
+};
+
+// nearest rank percentile, p in [0, 100]. returns 0 for no samples.
+[[nodiscard]] float percentile(std::vector<float> samples, float p);
+
+} // namespace nucleus::timing
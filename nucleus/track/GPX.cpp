@@ -116,32 +116,28 @@ std::unique_ptr<Gpx> parse(const QString& path)
 std::vector<glm::vec4> to_world_points(const Gpx& gpx)
 {
     std::vector<glm::vec4> track;
-
-    const QDateTime epoch(QDate(1970, 1, 1).startOfDay());
-
     for (const Segment& segment : gpx.track) {
-        for (size_t i = 0U; i < segment.size(); ++i) {
-
-            float time_since_epoch = 0;
-
-            if (i > 0) {
-                time_since_epoch = static_cast<float>(segment[i - 1].timestamp.msecsTo(segment[i].timestamp));
-            }
-
-            auto point = glm::dvec3(segment[i].latitude, segment[i].longitude, segment[i].elevation);
-            track.push_back(glm::vec4(srs::lat_long_alt_to_world(point), time_since_epoch));
-        }
+        const auto points = to_world_points(segment);
+        track.insert(track.end(), points.begin(), points.end());
     }
-
     return track;
 }
 
 std::vector<glm::vec4> to_world_points(const track::Segment& segment)
 {
-    std::vector<glm::vec4> track;
-
-    const QDateTime epoch(QDate(1970, 1, 1).startOfDay());
+    // structure of arrays for the batch conversion
+    std::vector<double> x(segment.size());
+    std::vector<double> y(segment.size());
+    std::vector<double> z(segment.size());
+    for (size_t i = 0U; i < segment.size(); ++i) {
+        x[i] = segment[i].latitude;
+        y[i] = segment[i].longitude;
+        z[i] = segment[i].elevation;
+    }
+    srs::lat_long_alt_to_world(x, y, z);
 
+    std::vector<glm::vec4> track;
+    track.reserve(segment.size());
     for (size_t i = 0U; i < segment.size(); ++i) {
 
         float time_since_epoch = 0;
@@ -150,8 +146,7 @@ std::vector<glm::vec4> to_world_points(const track::Segment& segment)
             time_since_epoch = static_cast<float>(segment[i - 1].timestamp.msecsTo(segment[i].timestamp));
         }
 
-        auto point = glm::dvec3(segment[i].latitude, segment[i].longitude, segment[i].elevation);
-        track.push_back(glm::vec4(srs::lat_long_alt_to_world(point), time_since_epoch));
+        track.push_back(glm::vec4(float(x[i]), float(y[i]), float(z[i]), time_since_epoch));
     }
 
     return track;
@@ -274,40 +269,61 @@ void apply_gaussian_filter(std::vector<glm::vec4>& points, float sigma)
     for (int i = 0; i < kernel_size; i++)
         kernel[i] /= kernel_sum;
 
+    if (static_cast<int>(points.size()) < kernel_size)
+        return;
+
+    // the filter runs in place, keep the original values of the window in a ring buffer (otherwise already smoothed neighbours feed back)
+    glm::vec3 window[kernel_size];
+    for (int j = 0; j < kernel_size; j++)
+        window[j] = glm::vec3(points[j]);
+
     for (int i = radius; i < static_cast<int>(points.size()) - radius; i++) {
         glm::vec3 value(0.0f);
 
         for (int j = -radius; j <= radius; j++)
-            value += glm::vec3(points[i + j]) * kernel[j + radius];
+            value += window[(i + j) % kernel_size] * kernel[j + radius];
 
         points[i] = glm::vec4(value, points[i].w);
+
+        if (i + radius + 1 < static_cast<int>(points.size()))
+            window[(i + radius + 1) % kernel_size] = glm::vec3(points[i + radius + 1]);
     }
 }
 
 void reduce_point_count(std::vector<glm::vec4>& points, float threshold)
 {
-    std::vector<glm::vec4> old_points = points;
+    if (points.empty())
+        return;
 
-    points.clear();
+    // compacts in place, point i is kept and following points closer than threshold to it are skipped
+    size_t n_kept = 0;
+    for (size_t i = 0; i < points.size() - 1; ++i) {
+        const auto current_point = points[i];
 
-    for (size_t i = 0; i < old_points.size() - 1; ++i) {
-        auto current_point = old_points[i];
+        points[n_kept++] = current_point;
 
-        points.push_back(current_point);
-
-        while (glm::distance(glm::vec3(current_point), glm::vec3(old_points[i + 1])) < threshold && i < old_points.size() - 1) {
+        while (i < points.size() - 1 && glm::distance(glm::vec3(current_point), glm::vec3(points[i + 1])) < threshold) {
             ++i;
         }
     }
+    points.resize(n_kept);
 }
 
 BoundingBox compute_world_aabb(const Gpx& gpx)
 {
     BoundingBox aabb { glm::dvec3(std::numeric_limits<double>::max()), glm::dvec3(std::numeric_limits<double>::min()) };
     for (const auto& segment : gpx.track) {
-        for (const auto& point : segment) {
-            aabb.expand_by(srs::lat_long_alt_to_world({ point.latitude, point.longitude, point.elevation }));
+        std::vector<double> x(segment.size());
+        std::vector<double> y(segment.size());
+        std::vector<double> z(segment.size());
+        for (size_t i = 0U; i < segment.size(); ++i) {
+            x[i] = segment[i].latitude;
+            y[i] = segment[i].longitude;
+            z[i] = segment[i].elevation;
         }
+        srs::lat_long_alt_to_world(x, y, z);
+        for (size_t i = 0U; i < segment.size(); ++i)
+            aabb.expand_by(glm::dvec3(x[i], y[i], z[i]));
     }
     return aabb;
 }
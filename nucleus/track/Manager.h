@@ -18,7 +18,7 @@
 
 #pragma once
 
-#include "nucleus/track/GPX.h"
+#include "nucleus/track/streaming.h"
 #include <QObject>
 
 namespace nucleus::track {
@@ -29,7 +29,7 @@ public:
     Manager(QObject* parent);
 
 public slots:
-    virtual void change_tracks(const QVector<nucleus::track::Gpx>& tracks) = 0;
+    virtual void change_tracks(const QVector<nucleus::track::WorldTrack>& tracks) = 0;
     virtual void change_display_width(float new_width) = 0;
     virtual void change_shading_style(unsigned new_style) = 0;
 };
@@ -0,0 +1,178 @@
+/*****************************************************************************
+ * AlpineMaps.org Renderer
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "polyline_lod.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+#include "nucleus/camera/Definition.h"
+#include "nucleus/tile/utils.h"
+
+namespace nucleus::track {
+
+namespace detail {
+    namespace {
+        float distance_to_segment(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b)
+        {
+            const glm::vec3 ab = b - a;
+            const float length_sq = glm::dot(ab, ab);
+            if (length_sq == 0.0f)
+                return glm::distance(p, a);
+            const float t = std::clamp(glm::dot(p - a, ab) / length_sq, 0.0f, 1.0f);
+            return glm::distance(p, a + t * ab);
+        }
+    } // namespace
+
+    void douglas_peucker_errors(const std::vector<glm::vec4>& points, size_t first, size_t last, std::vector<float>& errors)
+    {
+        assert(first <= last);
+        assert(last < points.size());
+        assert(errors.size() >= points.size());
+        constexpr float infinity = std::numeric_limits<float>::infinity();
+        errors[first] = infinity;
+        errors[last] = infinity;
+
+        struct Task {
+            size_t first;
+            size_t last;
+            float parent_error;
+        };
+        std::vector<Task> stack = { { first, last, infinity } };
+        while (!stack.empty()) {
+            const Task task = stack.back();
+            stack.pop_back();
+            if (task.last - task.first < 2)
+                continue;
+            const glm::vec3 a = points[task.first];
+            const glm::vec3 b = points[task.last];
+            float max_distance = -1;
+            size_t index = task.first + 1;
+            for (size_t i = task.first + 1; i < task.last; ++i) {
+                const float d = distance_to_segment(glm::vec3(points[i]), a, b);
+                if (d > max_distance) {
+                    max_distance = d;
+                    index = i;
+                }
+            }
+            // clamping makes errors monotonic along the hierarchy, a vertex is only kept if the vertex splitting its range is kept as well
+            const float error = std::min(max_distance, task.parent_error);
+            errors[index] = error;
+            stack.push_back({ task.first, index, error });
+            stack.push_back({ index, task.last, error });
+        }
+    }
+} // namespace detail
+
+PolylineLod build_polyline_lod(const std::vector<glm::vec4>& points, unsigned chunk_size, float finest_error, unsigned max_n_levels)
+{
+    assert(chunk_size >= 1);
+    assert(max_n_levels >= 1);
+    PolylineLod lod;
+    const size_t n = points.size();
+    if (n < 2)
+        return lod;
+
+    const size_t n_chunks = (n - 1 + chunk_size - 1) / chunk_size;
+    const auto chunk_first = [&](size_t c) { return c * chunk_size; };
+    const auto chunk_last = [&](size_t c) { return std::min((c + 1) * chunk_size, n - 1); };
+
+    std::vector<float> errors(n);
+    lod.chunks.resize(n_chunks);
+    for (size_t c = 0; c < n_chunks; ++c) {
+        detail::douglas_peucker_errors(points, chunk_first(c), chunk_last(c), errors);
+        auto& bounds = lod.chunks[c].bounds;
+        bounds.min = glm::dvec3(points[chunk_first(c)]);
+        bounds.max = bounds.min;
+        for (size_t i = chunk_first(c); i <= chunk_last(c); ++i)
+            bounds.expand_by(glm::dvec3(points[i]));
+    }
+
+    std::vector<unsigned> boundary_index(n_chunks + 1); // index of chunk boundary points within the current level
+    float threshold = finest_error;
+    for (unsigned l = 0; l < max_n_levels; ++l) {
+        if (l > 1)
+            threshold *= 4.0f;
+        std::vector<glm::vec4> level;
+        float level_error = 0;
+        float w = 0;
+        for (size_t i = 0; i < n; ++i) {
+            w += points[i].w;
+            if (l > 0 && errors[i] <= threshold) {
+                level_error = std::max(level_error, errors[i]);
+                continue;
+            }
+            if (i % chunk_size == 0 || i == n - 1)
+                boundary_index[(i + chunk_size - 1) / chunk_size] = unsigned(level.size());
+            level.emplace_back(glm::vec3(points[i]), w);
+            w = 0;
+        }
+
+        // nothing was removed compared to the previous level
+        if (!lod.levels.empty() && level.size() == lod.levels.back().size())
+            continue;
+
+        for (size_t c = 0; c < n_chunks; ++c)
+            lod.chunks[c].ranges.push_back({ boundary_index[c], boundary_index[c + 1] - boundary_index[c] + 1 });
+        lod.level_errors.push_back(level_error);
+        lod.levels.push_back(std::move(level));
+        if (lod.levels.back().size() == n_chunks + 1)
+            break;
+    }
+    return lod;
+}
+
+std::vector<PolylineLod::DrawRange> select_polyline_lod(const PolylineLod& lod, const camera::Definition& camera, float max_pixel_error)
+{
+    std::vector<PolylineLod::DrawRange> draw_ranges;
+    if (lod.levels.empty())
+        return draw_ranges;
+
+    const auto frustum = camera.frustum();
+    const glm::dvec3 camera_position = camera.position();
+    const auto n_levels = unsigned(lod.levels.size());
+    for (const auto& chunk : lod.chunks) {
+        if (!tile::utils::camera_frustum_contains_tile(frustum, chunk.bounds))
+            continue;
+        const glm::dvec3 closest = glm::clamp(camera_position, chunk.bounds.min, chunk.bounds.max);
+        const auto distance = float(std::max(glm::distance(camera_position, closest), double(camera.near_plane())));
+
+        unsigned level = 0;
+        for (unsigned l = n_levels - 1; l > 0; --l) {
+            if (camera.to_screen_space(lod.level_errors[l], distance) <= max_pixel_error) {
+                level = l;
+                break;
+            }
+        }
+
+        const PolylineLod::Range& range = chunk.ranges[level];
+        if (!draw_ranges.empty()) {
+            auto& previous = draw_ranges.back();
+            if (previous.level == level && previous.range.first + previous.range.n_points - 1 == range.first) {
+                previous.range.n_points += range.n_points - 1;
+                continue;
+            }
+        }
+        draw_ranges.push_back({ level, range });
+    }
+    std::stable_sort(draw_ranges.begin(), draw_ranges.end(), [](const auto& a, const auto& b) { return a.level < b.level; });
+    return draw_ranges;
+}
+
+} // namespace nucleus::track
@@ -0,0 +1,68 @@
+/*****************************************************************************
+ * AlpineMaps.org Renderer
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <glm/glm.hpp>
+#include <radix/geometry.h>
+#include <vector>
+
+namespace nucleus::camera {
+class Definition;
+}
+
+namespace nucleus::track {
+
+// Level of detail representation of a polyline (world points, w = milliseconds since the previous point).
+// The polyline is cut into chunks of a fixed number of input points. Every vertex gets a Douglas-Peucker error (computed per chunk, clamped
+// such that it never exceeds the error of the vertex that split its parent range). Thresholding these errors yields exactly the
+// Douglas-Peucker simplification for that tolerance, level l keeps vertices with error > level_errors[l] (level 0 keeps all).
+// Chunk end points are kept on every level, so chunks can be drawn at different levels without cracks.
+struct PolylineLod {
+    struct Range {
+        unsigned first = 0; // index into the points of the level
+        unsigned n_points = 0; // >= 2
+    };
+    struct Chunk {
+        radix::geometry::Aabb<3, double> bounds;
+        std::vector<Range> ranges; // one per level
+    };
+    struct DrawRange {
+        unsigned level = 0;
+        Range range;
+    };
+
+    std::vector<float> level_errors; // world space distance, level_errors[0] == 0
+    std::vector<std::vector<glm::vec4>> levels; // w = milliseconds since the previous point of the same level
+    std::vector<Chunk> chunks;
+};
+
+// finest_error is the tolerance of level 1, it grows by a factor of 4 per level. Levels are added until all chunks are reduced to
+// their end points or max_n_levels is reached.
+PolylineLod build_polyline_lod(const std::vector<glm::vec4>& points, unsigned chunk_size = 256, float finest_error = 0.5f, unsigned max_n_levels = 12);
+
+// Per chunk frustum culling and selection of the coarsest level whose error, projected at the distance of the chunk's bounds, stays
+// below max_pixel_error. Ranges of neighbouring chunks on the same level are merged. The result is sorted by level.
+std::vector<PolylineLod::DrawRange> select_polyline_lod(const PolylineLod& lod, const camera::Definition& camera, float max_pixel_error);
+
+namespace detail {
+    // Douglas-Peucker error of every vertex of points[first, last], end points get infinity.
+    void douglas_peucker_errors(const std::vector<glm::vec4>& points, size_t first, size_t last, std::vector<float>& errors);
+} // namespace detail
+
+} // namespace nucleus::track
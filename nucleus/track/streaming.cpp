@@ -0,0 +1,343 @@
+/*****************************************************************************
+ * AlpineMaps.org Renderer
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "streaming.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <cassert>
+#include <cmath>
+
+#include "../srs.h"
+
+namespace nucleus::track {
+
+namespace {
+    // http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+    int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+    {
+        y -= m <= 2;
+        const int64_t era = (y >= 0 ? y : y - 399) / 400;
+        const auto yoe = unsigned(y - era * 400);
+        const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+        const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + int64_t(doe) - 719468;
+    }
+
+    // reads exactly n digits starting at pos
+    bool read_digits(QStringView text, qsizetype& pos, int n, int& value)
+    {
+        if (pos + n > text.size())
+            return false;
+        value = 0;
+        for (int i = 0; i < n; ++i) {
+            const char16_t c = text[pos + i].unicode();
+            if (c < u'0' || c > u'9')
+                return false;
+            value = value * 10 + (c - u'0');
+        }
+        pos += n;
+        return true;
+    }
+
+    bool expect(QStringView text, qsizetype& pos, char16_t c)
+    {
+        if (pos >= text.size() || text[pos].unicode() != c)
+            return false;
+        ++pos;
+        return true;
+    }
+
+    std::optional<int64_t> parse_iso8601_ms_fast(QStringView text)
+    {
+        qsizetype pos = 0;
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0, second = 0;
+        if (!read_digits(text, pos, 4, year) || !expect(text, pos, u'-') || !read_digits(text, pos, 2, month) || !expect(text, pos, u'-')
+            || !read_digits(text, pos, 2, day) || !(expect(text, pos, u'T') || expect(text, pos, u't')) || !read_digits(text, pos, 2, hour)
+            || !expect(text, pos, u':') || !read_digits(text, pos, 2, minute) || !expect(text, pos, u':') || !read_digits(text, pos, 2, second))
+            return {};
+        if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60)
+            return {};
+
+        int64_t milliseconds = 0;
+        if (pos < text.size() && (text[pos] == u'.' || text[pos] == u',')) {
+            ++pos;
+            int scale = 100;
+            const qsizetype fraction_begin = pos;
+            while (pos < text.size() && text[pos] >= u'0' && text[pos] <= u'9') {
+                milliseconds += (text[pos].unicode() - u'0') * scale;
+                scale /= 10;
+                ++pos;
+            }
+            if (pos == fraction_begin)
+                return {};
+        }
+
+        int64_t offset_minutes = 0;
+        if (pos < text.size()) {
+            const char16_t c = text[pos].unicode();
+            if (c == u'Z' || c == u'z') {
+                ++pos;
+            } else if (c == u'+' || c == u'-') {
+                ++pos;
+                int offset_hours = 0, offset_mins = 0;
+                if (!read_digits(text, pos, 2, offset_hours))
+                    return {};
+                expect(text, pos, u':');
+                if (!read_digits(text, pos, 2, offset_mins))
+                    return {};
+                offset_minutes = (c == u'+' ? 1 : -1) * (offset_hours * 60 + offset_mins);
+            }
+        }
+        if (pos != text.size())
+            return {};
+
+        const int64_t days = days_from_civil(year, unsigned(month), unsigned(day));
+        const int64_t seconds = ((days * 24 + hour) * 60 + minute) * 60 + second - offset_minutes * 60;
+        return seconds * 1000 + milliseconds;
+    }
+} // namespace
+
+void PointChunk::clear()
+{
+    latitude.clear();
+    longitude.clear();
+    elevation.clear();
+    timestamp.clear();
+}
+
+void PointChunk::reserve(size_t n)
+{
+    latitude.reserve(n);
+    longitude.reserve(n);
+    elevation.reserve(n);
+    timestamp.reserve(n);
+}
+
+std::optional<int64_t> parse_iso8601_ms(QStringView text)
+{
+    text = text.trimmed();
+    if (const auto ms = parse_iso8601_ms_fast(text))
+        return ms;
+    // exotic formats (e.g., without seconds)
+    const QDateTime date_time = QDateTime::fromString(text.toString(), Qt::ISODate);
+    if (!date_time.isValid())
+        return {};
+    return date_time.toMSecsSinceEpoch();
+}
+
+bool parse_chunked(QXmlStreamReader& reader, const std::function<void(PointChunk&)>& on_chunk, size_t chunk_size)
+{
+    assert(chunk_size > 0);
+    enum class Field { None, Elevation, Time };
+
+    PointChunk chunk;
+    chunk.reserve(chunk_size);
+    unsigned segment_index = 0;
+    bool in_segment = false;
+    bool in_point = false;
+    Field field = Field::None;
+
+    const auto begin_segment = [&]() {
+        in_segment = true;
+        chunk.segment_index = segment_index;
+        chunk.segment_begin = true;
+        chunk.segment_end = false;
+    };
+    const auto flush = [&](bool segment_end) {
+        chunk.segment_end = segment_end;
+        on_chunk(chunk);
+        chunk.clear();
+        chunk.segment_begin = false;
+    };
+    const auto end_segment = [&]() {
+        flush(true);
+        in_segment = false;
+        ++segment_index;
+    };
+
+    while (!reader.atEnd() && !reader.hasError()) {
+        const QXmlStreamReader::TokenType token = reader.readNext();
+        if (token == QXmlStreamReader::StartElement) {
+            const QStringView name = reader.name();
+            if (name == u"trkpt") {
+                // trkpt without trkseg is put into its own segment (like parse() does)
+                if (!in_segment)
+                    begin_segment();
+                const QXmlStreamAttributes attributes = reader.attributes();
+                chunk.latitude.push_back(attributes.value(u"lat").toDouble());
+                chunk.longitude.push_back(attributes.value(u"lon").toDouble());
+                chunk.elevation.push_back(0.0);
+                chunk.timestamp.push_back(no_timestamp);
+                in_point = true;
+            } else if (in_point && name == u"ele") {
+                field = Field::Elevation;
+            } else if (in_point && name == u"time") {
+                field = Field::Time;
+            } else if (name == u"trkseg") {
+                if (in_segment)
+                    end_segment();
+                begin_segment();
+            } else if (name == u"wpt") {
+                qDebug() << "'wpt' NOT IMPLEMENTED!\n";
+                return false;
+            } else if (name == u"rte") {
+                qDebug() << "'rte' NOT IMPLEMENTED!\n";
+                return false;
+            }
+        } else if (token == QXmlStreamReader::Characters && field != Field::None) {
+            const QStringView text = reader.text();
+            if (field == Field::Elevation) {
+                chunk.elevation.back() = text.trimmed().toDouble();
+            } else {
+                const auto ms = parse_iso8601_ms(text);
+                if (ms)
+                    chunk.timestamp.back() = *ms;
+                else
+                    qDebug() << "Failed to parse date " << text;
+            }
+        } else if (token == QXmlStreamReader::EndElement) {
+            const QStringView name = reader.name();
+            field = Field::None;
+            if (name == u"trkpt") {
+                in_point = false;
+                if (chunk.size() >= chunk_size)
+                    flush(false);
+            } else if (name == u"trkseg" && in_segment) {
+                end_segment();
+            }
+        }
+    }
+
+    if (reader.hasError()) {
+        qDebug() << "XML Parsing Error: " << reader.errorString();
+        return false;
+    }
+    if (in_segment)
+        end_segment();
+    return true;
+}
+
+void to_world(PointChunk& chunk) { srs::lat_long_alt_to_world(chunk.latitude, chunk.longitude, chunk.elevation); }
+
+SegmentProcessor::SegmentProcessor(const Settings& settings)
+    : m_settings(settings)
+{
+    double kernel_sum = 0;
+    for (int x = -2; x <= 2; ++x) {
+        m_kernel[size_t(x + 2)] = std::exp(-double(x * x) / (2.0 * double(settings.sigma) * double(settings.sigma)));
+        kernel_sum += m_kernel[size_t(x + 2)];
+    }
+    for (auto& k : m_kernel)
+        k /= kernel_sum;
+}
+
+void SegmentProcessor::process(const PointChunk& world_chunk)
+{
+    if (world_chunk.segment_begin) {
+        m_segments.emplace_back();
+        m_n_points = 0;
+        m_last_emitted_timestamp = no_timestamp;
+        m_milliseconds_since_kept = 0;
+        m_dropped_last.reset();
+    }
+    assert(!m_segments.empty());
+    for (size_t i = 0; i < world_chunk.size(); ++i)
+        push({ world_chunk.latitude[i], world_chunk.longitude[i], world_chunk.elevation[i] }, world_chunk.timestamp[i]);
+    if (world_chunk.segment_end)
+        finish_segment();
+}
+
+void SegmentProcessor::push(const glm::dvec3& position, int64_t timestamp)
+{
+    const size_t k = m_n_points++;
+    m_window_position[k % 5] = position;
+    m_window_timestamp[k % 5] = timestamp;
+
+    if (k < 2) {
+        decimate(position, timestamp);
+        return;
+    }
+    if (k < 4)
+        return;
+
+    // all 5 neighbours of point k - 2 are known now
+    glm::dvec3 smoothed(0.0);
+    for (size_t j = 0; j < 5; ++j)
+        smoothed += m_window_position[(k - 4 + j) % 5] * m_kernel[j];
+    decimate(smoothed, m_window_timestamp[(k - 2) % 5]);
+}
+
+void SegmentProcessor::decimate(const glm::dvec3& position, int64_t timestamp)
+{
+    if (timestamp != no_timestamp && m_last_emitted_timestamp != no_timestamp)
+        m_milliseconds_since_kept += double(timestamp - m_last_emitted_timestamp);
+    m_last_emitted_timestamp = timestamp;
+
+    auto& segment = m_segments.back();
+    if (segment.empty() || glm::distance(position, m_last_kept) >= double(m_settings.min_distance)) {
+        segment.emplace_back(glm::vec3(position), float(m_milliseconds_since_kept));
+        m_last_kept = position;
+        m_milliseconds_since_kept = 0;
+        m_dropped_last.reset();
+    } else {
+        m_dropped_last = position;
+    }
+}
+
+void SegmentProcessor::finish_segment()
+{
+    // points that were not smoothed (the last two, or all if the segment is shorter than the kernel) and are still waiting in the window
+    const size_t n = m_n_points;
+    for (size_t i = (n > 4 ? n - 2 : 2); i < n; ++i)
+        decimate(m_window_position[i % 5], m_window_timestamp[i % 5]);
+    if (m_dropped_last)
+        m_segments.back().emplace_back(glm::vec3(*m_dropped_last), float(m_milliseconds_since_kept));
+    m_dropped_last.reset();
+    // empty segments carry no geometry
+    if (m_segments.back().empty())
+        m_segments.pop_back();
+}
+
+std::optional<std::vector<std::vector<glm::vec4>>> load_world_segments(QXmlStreamReader& reader, const SegmentProcessor::Settings& settings, size_t chunk_size)
+{
+    auto track = load_track(reader, settings, chunk_size);
+    if (!track)
+        return {};
+    return std::move(track->segments);
+}
+
+std::optional<WorldTrack> load_track(QXmlStreamReader& reader, const SegmentProcessor::Settings& settings, size_t chunk_size)
+{
+    SegmentProcessor processor(settings);
+    std::optional<glm::dvec2> start_lat_long;
+    const bool ok = parse_chunked(
+        reader,
+        [&](PointChunk& chunk) {
+            if (!start_lat_long && chunk.size() > 0)
+                start_lat_long = glm::dvec2(chunk.latitude.front(), chunk.longitude.front());
+            to_world(chunk);
+            processor.process(chunk);
+        },
+        chunk_size);
+    if (!ok)
+        return {};
+    return WorldTrack { processor.take_segments(), start_lat_long.value_or(glm::dvec2(0)) };
+}
+
+} // namespace nucleus::track
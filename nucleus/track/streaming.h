@@ -0,0 +1,114 @@
+/*****************************************************************************
+ * AlpineMaps.org Renderer
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <QStringView>
+#include <QXmlStreamReader>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <glm/glm.hpp>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Streaming GPX loading for large tracks (10^6 points and more).
+// Points are parsed into chunks of structure of arrays, which are transformed to world coordinates in batch and then smoothed
+// and decimated in a single pass. Memory is bounded by one chunk plus the (decimated) output, no intermediate Gpx is built.
+
+namespace nucleus::track {
+
+constexpr int64_t no_timestamp = std::numeric_limits<int64_t>::min();
+
+// a chunk contains points of a single segment
+struct PointChunk {
+    unsigned segment_index = 0;
+    bool segment_begin = false; // first chunk of the segment
+    bool segment_end = false; // last chunk of the segment (can be empty)
+    std::vector<double> latitude;
+    std::vector<double> longitude;
+    std::vector<double> elevation;
+    std::vector<int64_t> timestamp; // milliseconds since epoch (UTC) or no_timestamp
+
+    [[nodiscard]] size_t size() const { return latitude.size(); }
+    void clear();
+    void reserve(size_t n);
+};
+
+// parses ISO 8601 date times as used in GPX (e.g. 2009-10-17T18:37:26Z, 2009-10-17T18:37:26.250+02:00) without going through QDateTime.
+std::optional<int64_t> parse_iso8601_ms(QStringView text);
+
+// Parses trkpt elements and calls on_chunk whenever chunk_size points were read or a segment ended.
+// The chunk can be modified in place by the callback (e.g., converted to world coordinates), it is cleared afterwards.
+// Returns false on xml errors and for waypoints and routes (same as parse()).
+bool parse_chunked(QXmlStreamReader& reader, const std::function<void(PointChunk&)>& on_chunk, size_t chunk_size = 4096);
+
+// Converts a chunk in place to world coordinates: latitude -> x, longitude -> y, elevation -> z.
+void to_world(PointChunk& chunk);
+
+// Single pass gaussian smoothing (radius 2, first and last 2 points of a segment are kept as is, like apply_gaussian_filter) and decimation of
+// chunks in world coordinates. Points closer than min_distance to the previously kept point are dropped (like reduce_point_count), but the
+// last point of a segment is always kept and w holds the milliseconds since the previously kept point.
+class SegmentProcessor {
+public:
+    struct Settings {
+        float sigma = 1.0f;
+        float min_distance = 0.0f;
+    };
+    explicit SegmentProcessor(const Settings& settings = {});
+
+    void process(const PointChunk& world_chunk);
+    [[nodiscard]] const std::vector<std::vector<glm::vec4>>& segments() const { return m_segments; }
+    [[nodiscard]] std::vector<std::vector<glm::vec4>> take_segments() { return std::move(m_segments); }
+
+private:
+    void push(const glm::dvec3& position, int64_t timestamp);
+    void decimate(const glm::dvec3& position, int64_t timestamp);
+    void finish_segment();
+
+    Settings m_settings;
+    std::array<double, 5> m_kernel = {};
+    std::vector<std::vector<glm::vec4>> m_segments;
+
+    // last 5 input points of the current segment (ring buffer), smoothing is delayed by 2 points
+    std::array<glm::dvec3, 5> m_window_position = {};
+    std::array<int64_t, 5> m_window_timestamp = {};
+    size_t m_n_points = 0;
+
+    // decimation state
+    int64_t m_last_emitted_timestamp = no_timestamp;
+    double m_milliseconds_since_kept = 0;
+    glm::dvec3 m_last_kept = {};
+    std::optional<glm::dvec3> m_dropped_last; // the last point of a segment is kept even if it is close to the previously kept one
+};
+
+// parse_chunked + to_world + SegmentProcessor. Returns world points per segment (xyz, w = milliseconds since previous point).
+std::optional<std::vector<std::vector<glm::vec4>>> load_world_segments(
+    QXmlStreamReader& reader, const SegmentProcessor::Settings& settings = {}, size_t chunk_size = 4096);
+
+// A track as loaded by load_track, this is what track::Manager renders.
+struct WorldTrack {
+    std::vector<std::vector<glm::vec4>> segments; // see load_world_segments
+    glm::dvec2 start_lat_long = {}; // latitude and longitude of the first point, (0, 0) if there are no points
+};
+
+// load_world_segments, additionally keeping the position of the first point.
+std::optional<WorldTrack> load_track(QXmlStreamReader& reader, const SegmentProcessor::Settings& settings = {}, size_t chunk_size = 4096);
+
+} // namespace nucleus::track
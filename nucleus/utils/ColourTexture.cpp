@@ -23,6 +23,7 @@
 #include <array>
 #include <cstdint>
 #include <stdexcept>
+#include <utility>
 
 #define GOOFYTC_IMPLEMENTATION
 #include <GoofyTC/goofy_tc.h>
@@ -156,6 +157,14 @@ nucleus::utils::ColourTexture::ColourTexture(const nucleus::Raster<glm::u8vec4>&
 {
 }
 
+nucleus::utils::ColourTexture::ColourTexture(std::vector<uint8_t> data, unsigned width, unsigned height, Format format)
+    : m_data(std::move(data))
+    , m_width(width)
+    , m_height(height)
+    , m_format(format)
+{
+}
+
 nucleus::utils::MipmappedColourTexture nucleus::utils::generate_mipmapped_colour_texture(
     const nucleus::Raster<glm::u8vec4>& texture, ColourTexture::Format format)
 {
@@ -0,0 +1,419 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "contours.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <optional>
+#include <unordered_map>
+#include <zpp_bits.h>
+
+namespace nucleus::utils::contours {
+
+namespace {
+    constexpr float height_scale = 8.0f; // raster units per metre
+
+    std::vector<float> levels(float min_height, float max_height, const Settings& settings)
+    {
+        std::vector<float> levels;
+        for (const auto interval : { settings.primary_interval, settings.secondary_interval }) {
+            for (auto k = std::ceil(min_height / interval); k * interval <= max_height; ++k)
+                levels.push_back(k * interval);
+        }
+        std::sort(levels.begin(), levels.end());
+        levels.erase(std::unique(levels.begin(), levels.end()), levels.end());
+        return levels;
+    }
+
+    bool is_primary(float level, float primary_interval) { return std::abs(std::remainder(level, primary_interval)) < primary_interval * 1e-4f; }
+
+    float distance_to_segment(const glm::vec2& p, const glm::vec2& a, const glm::vec2& b)
+    {
+        const auto ab = b - a;
+        const auto length2 = glm::dot(ab, ab);
+        if (length2 == 0)
+            return glm::distance(p, a);
+        const auto t = std::clamp(glm::dot(p - a, ab) / length2, 0.0f, 1.0f);
+        return glm::distance(p, a + t * ab);
+    }
+
+    // Marching squares for one level at a time. Crossings are identified by their grid edge: the horizontal edge from vertex (x, y) to
+    // (x + 1, y) has id 2 * (y * width + x), the vertical one from (x, y) to (x, y + 1) has that id + 1.
+    class Tracer {
+    public:
+        explicit Tracer(const Raster<uint16_t>& heights)
+            : m_heights(heights)
+            , m_edge_segments(size_t(heights.width()) * heights.height() * 4, -1)
+        {
+        }
+
+        void trace(float level, std::vector<std::vector<glm::vec2>>& lines)
+        {
+            m_level = level;
+            collect_segments();
+
+            m_visited.assign(m_segments.size(), false);
+            // open lines start and end at edges with one segment, i.e., on the tile border
+            for (const auto edge : m_touched_edges) {
+                const auto segment = m_edge_segments[edge * 2];
+                if (m_edge_segments[edge * 2 + 1] == -1 && !m_visited[unsigned(segment)])
+                    lines.push_back(follow(unsigned(segment), edge));
+            }
+            for (unsigned segment = 0; segment < m_segments.size(); ++segment) {
+                if (!m_visited[segment])
+                    lines.push_back(follow(segment, m_segments[segment][0]));
+            }
+
+            for (const auto edge : m_touched_edges) {
+                m_edge_segments[edge * 2] = -1;
+                m_edge_segments[edge * 2 + 1] = -1;
+            }
+            m_touched_edges.clear();
+            m_segments.clear();
+        }
+
+    private:
+        [[nodiscard]] float height(unsigned x, unsigned y) const { return float(m_heights.pixel({ x, y })); }
+        [[nodiscard]] bool above(float h) const { return h >= m_level; }
+        [[nodiscard]] uint32_t horizontal_edge(unsigned x, unsigned y) const { return 2 * (y * m_heights.width() + x); }
+        [[nodiscard]] uint32_t vertical_edge(unsigned x, unsigned y) const { return 2 * (y * m_heights.width() + x) + 1; }
+
+        // always interpolated from the vertex with the lower index, so that neighbouring tiles compute bit identical border crossings
+        [[nodiscard]] glm::vec2 crossing(uint32_t edge) const
+        {
+            const auto vertex = edge / 2;
+            const auto x = vertex % m_heights.width();
+            const auto y = vertex / m_heights.width();
+            const auto is_vertical = (edge & 1) == 1;
+            const auto a = height(x, y);
+            const auto b = is_vertical ? height(x, y + 1) : height(x + 1, y);
+            const auto t = (m_level - a) / (b - a);
+            return is_vertical ? glm::vec2(float(x), float(y) + t) : glm::vec2(float(x) + t, float(y));
+        }
+
+        void add_segment(uint32_t a, uint32_t b)
+        {
+            const auto segment = int32_t(m_segments.size());
+            m_segments.push_back({ a, b });
+            for (const auto edge : { a, b }) {
+                if (m_edge_segments[edge * 2] == -1) {
+                    m_edge_segments[edge * 2] = segment;
+                    m_touched_edges.push_back(edge);
+                } else {
+                    assert(m_edge_segments[edge * 2 + 1] == -1);
+                    m_edge_segments[edge * 2 + 1] = segment;
+                }
+            }
+        }
+
+        void collect_segments()
+        {
+            const auto width = m_heights.width();
+            const auto n_rows = m_heights.height();
+            for (unsigned y = 0; y + 1 < n_rows; ++y) {
+                for (unsigned x = 0; x + 1 < width; ++x) {
+                    const auto tl = height(x, y);
+                    const auto tr = height(x + 1, y);
+                    const auto br = height(x + 1, y + 1);
+                    const auto bl = height(x, y + 1);
+                    const auto cell_case = (above(tl) ? 8u : 0u) | (above(tr) ? 4u : 0u) | (above(br) ? 2u : 0u) | (above(bl) ? 1u : 0u);
+                    if (cell_case == 0 || cell_case == 15)
+                        continue;
+
+                    const auto top = horizontal_edge(x, y);
+                    const auto bottom = horizontal_edge(x, y + 1);
+                    const auto left = vertical_edge(x, y);
+                    const auto right = vertical_edge(x + 1, y);
+                    const auto centre_above = above((tl + tr + br + bl) * 0.25f);
+                    switch (cell_case) {
+                    case 1:
+                    case 14:
+                        add_segment(left, bottom);
+                        break;
+                    case 2:
+                    case 13:
+                        add_segment(bottom, right);
+                        break;
+                    case 3:
+                    case 12:
+                        add_segment(left, right);
+                        break;
+                    case 4:
+                    case 11:
+                        add_segment(top, right);
+                        break;
+                    case 6:
+                    case 9:
+                        add_segment(top, bottom);
+                        break;
+                    case 7:
+                    case 8:
+                        add_segment(top, left);
+                        break;
+                    case 5: // top right and bottom left above
+                        if (centre_above) {
+                            add_segment(top, left);
+                            add_segment(bottom, right);
+                        } else {
+                            add_segment(top, right);
+                            add_segment(left, bottom);
+                        }
+                        break;
+                    case 10: // top left and bottom right above
+                        if (centre_above) {
+                            add_segment(top, right);
+                            add_segment(left, bottom);
+                        } else {
+                            add_segment(top, left);
+                            add_segment(bottom, right);
+                        }
+                        break;
+                    default:
+                        assert(false);
+                    }
+                }
+            }
+        }
+
+        std::vector<glm::vec2> follow(unsigned segment, uint32_t edge)
+        {
+            std::vector<glm::vec2> points = { crossing(edge) };
+            while (true) {
+                m_visited[segment] = true;
+                edge = (m_segments[segment][0] == edge) ? m_segments[segment][1] : m_segments[segment][0];
+                const auto point = crossing(edge);
+                // crossings on grid vertices (height exactly at the level) can repeat
+                if (point != points.back())
+                    points.push_back(point);
+                const auto first = m_edge_segments[edge * 2];
+                const auto next = (first == int32_t(segment)) ? m_edge_segments[edge * 2 + 1] : first;
+                if (next == -1 || m_visited[unsigned(next)])
+                    break;
+                segment = unsigned(next);
+            }
+            return points;
+        }
+
+        const Raster<uint16_t>& m_heights;
+        float m_level = 0;
+        std::vector<std::array<uint32_t, 2>> m_segments;
+        std::vector<int32_t> m_edge_segments; // 2 per edge, -1 if unused
+        std::vector<uint32_t> m_touched_edges;
+        std::vector<bool> m_visited;
+    };
+
+    uint64_t cell_key(const glm::dvec2& position, double cell_size)
+    {
+        const auto cell = glm::floor(position / cell_size);
+        return (uint64_t(int64_t(cell.x)) * 73856093u) ^ (uint64_t(int64_t(cell.y)) * 19349663u);
+    }
+} // namespace
+
+std::vector<Line> generate(const Raster<uint16_t>& heights, const Settings& settings)
+{
+    assert(settings.primary_interval > 0 && settings.secondary_interval > 0);
+    if (heights.width() < 2 || heights.height() < 2)
+        return {};
+
+    const auto [min, max] = std::minmax_element(heights.begin(), heights.end());
+    Tracer tracer(heights);
+    std::vector<Line> lines;
+    std::vector<std::vector<glm::vec2>> traced;
+    for (const auto level : levels(float(*min) / height_scale, float(*max) / height_scale, settings)) {
+        tracer.trace(level * height_scale, traced);
+        for (auto& points : traced) {
+            if (points.size() < 2)
+                continue;
+            Line line;
+            line.elevation = level;
+            line.primary = is_primary(level, settings.primary_interval);
+            line.points = settings.simplification_tolerance > 0 ? simplify(points, settings.simplification_tolerance) : std::move(points);
+            lines.push_back(std::move(line));
+        }
+        traced.clear();
+    }
+    return lines;
+}
+
+std::vector<glm::vec2> simplify(std::span<const glm::vec2> points, float tolerance)
+{
+    if (points.size() < 3)
+        return { points.begin(), points.end() };
+
+    std::vector<bool> keep(points.size(), false);
+    keep.front() = true;
+    keep.back() = true;
+    std::vector<std::pair<size_t, size_t>> stack = { { 0, points.size() - 1 } };
+    while (!stack.empty()) {
+        const auto [first, last] = stack.back();
+        stack.pop_back();
+        float max_distance = 0;
+        size_t farthest = first;
+        for (auto i = first + 1; i < last; ++i) {
+            const auto distance = distance_to_segment(points[i], points[first], points[last]);
+            if (distance > max_distance) {
+                max_distance = distance;
+                farthest = i;
+            }
+        }
+        if (max_distance > tolerance) {
+            keep[farthest] = true;
+            stack.emplace_back(first, farthest);
+            stack.emplace_back(farthest, last);
+        }
+    }
+
+    std::vector<glm::vec2> simplified;
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (keep[i])
+            simplified.push_back(points[i]);
+    }
+    return simplified;
+}
+
+std::vector<WorldLine> to_world(const std::vector<Line>& lines, const glm::dvec2& north_west, double texel_size)
+{
+    std::vector<WorldLine> world_lines;
+    world_lines.reserve(lines.size());
+    for (const auto& line : lines) {
+        WorldLine world_line { line.elevation, line.primary, {} };
+        world_line.points.reserve(line.points.size());
+        for (const auto& p : line.points)
+            world_line.points.push_back(north_west + glm::dvec2(p.x, -double(p.y)) * texel_size);
+        world_lines.push_back(std::move(world_line));
+    }
+    return world_lines;
+}
+
+QByteArray serialise(const std::vector<Line>& lines, const Settings& settings)
+{
+    std::vector<char> bytes;
+    zpp::bits::out out(bytes);
+    if (failure(out(settings.primary_interval, settings.secondary_interval, settings.simplification_tolerance, uint32_t(lines.size()))))
+        return {};
+    std::vector<float> coordinates;
+    for (const auto& line : lines) {
+        coordinates.clear();
+        for (const auto& p : line.points) {
+            coordinates.push_back(p.x);
+            coordinates.push_back(p.y);
+        }
+        if (failure(out(line.elevation, uint8_t(line.primary), coordinates)))
+            return {};
+    }
+    return QByteArray(bytes.data(), qsizetype(bytes.size()));
+}
+
+std::optional<std::vector<Line>> deserialise(const QByteArray& bytes, const Settings& settings)
+{
+    if (bytes.isEmpty())
+        return {};
+    zpp::bits::in in(bytes);
+    Settings stored;
+    uint32_t n_lines = 0;
+    if (failure(in(stored.primary_interval, stored.secondary_interval, stored.simplification_tolerance, n_lines)) || stored != settings)
+        return {};
+
+    std::vector<Line> lines;
+    std::vector<float> coordinates;
+    for (uint32_t i = 0; i < n_lines; ++i) {
+        Line line;
+        uint8_t primary = 0;
+        if (failure(in(line.elevation, primary, coordinates)) || coordinates.size() % 2 != 0)
+            return {};
+        line.primary = primary != 0;
+        line.points.reserve(coordinates.size() / 2);
+        for (size_t j = 0; j < coordinates.size(); j += 2)
+            line.points.emplace_back(coordinates[j], coordinates[j + 1]);
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+std::vector<WorldLine> stitch(std::vector<WorldLine> lines, double tolerance)
+{
+    assert(tolerance > 0);
+    struct End {
+        unsigned line;
+        bool is_back;
+    };
+    std::unordered_map<uint64_t, std::vector<End>> ends;
+    for (unsigned i = 0; i < lines.size(); ++i) {
+        if (lines[i].is_closed() || lines[i].points.empty())
+            continue;
+        ends[cell_key(lines[i].points.front(), tolerance)].push_back({ i, false });
+        ends[cell_key(lines[i].points.back(), tolerance)].push_back({ i, true });
+    }
+
+    std::vector<bool> used(lines.size(), false);
+    const auto find_match = [&](const glm::dvec2& position, float elevation) -> std::optional<End> {
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const auto it = ends.find(cell_key(position + glm::dvec2(dx, dy) * tolerance, tolerance));
+                if (it == ends.end())
+                    continue;
+                for (const auto& end : it->second) {
+                    const auto& line = lines[end.line];
+                    if (used[end.line] || line.elevation != elevation)
+                        continue;
+                    if (glm::distance(end.is_back ? line.points.back() : line.points.front(), position) <= tolerance)
+                        return end;
+                }
+            }
+        }
+        return {};
+    };
+
+    std::vector<WorldLine> stitched;
+    for (unsigned i = 0; i < lines.size(); ++i) {
+        if (used[i])
+            continue;
+        used[i] = true;
+        auto line = std::move(lines[i]);
+        if (line.is_closed() || line.points.empty()) {
+            stitched.push_back(std::move(line));
+            continue;
+        }
+        // the match itself is not appended, it is the same point
+        while (const auto match = find_match(line.points.back(), line.elevation)) {
+            used[match->line] = true;
+            const auto& other = lines[match->line].points;
+            if (match->is_back)
+                line.points.insert(line.points.end(), std::next(other.rbegin()), other.rend());
+            else
+                line.points.insert(line.points.end(), std::next(other.begin()), other.end());
+        }
+        while (const auto match = find_match(line.points.front(), line.elevation)) {
+            used[match->line] = true;
+            const auto& other = lines[match->line].points;
+            if (match->is_back)
+                line.points.insert(line.points.begin(), other.begin(), std::prev(other.end()));
+            else
+                line.points.insert(line.points.begin(), other.rbegin(), std::prev(other.rend()));
+        }
+        if (line.points.size() > 2 && glm::distance(line.points.front(), line.points.back()) <= tolerance)
+            line.points.back() = line.points.front();
+        stitched.push_back(std::move(line));
+    }
+    return stitched;
+}
+
+} // namespace nucleus::utils::contours
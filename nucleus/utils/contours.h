@@ -0,0 +1,76 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <nucleus/Raster.h>
+#include <optional>
+#include <span>
+#include <vector>
+
+// contour lines (isolines of the altitude) of height tiles as polylines, so that they can be cached, drawn as geometry, labelled or exported.
+namespace nucleus::utils::contours {
+
+struct Settings {
+    float primary_interval = 250.0f; // metres, same defaults as the height lines overlay
+    float secondary_interval = 50.0f;
+    float simplification_tolerance = 0.1f; // in texels, 0 keeps all marching squares vertices
+
+    bool operator==(const Settings&) const = default;
+};
+
+// vertex positions in texel coordinates of the height raster, x along columns, y along rows (first row is north)
+template <typename Vec> struct BasicLine {
+    float elevation = 0; // metres
+    bool primary = false; // on a multiple of the primary interval
+    std::vector<Vec> points; // closed lines repeat the first point at the end
+
+    [[nodiscard]] bool is_closed() const { return points.size() > 2 && points.front() == points.back(); }
+};
+using Line = BasicLine<glm::vec2>;
+using WorldLine = BasicLine<glm::dvec2>; // in world space (web mercator metres)
+
+// Marching squares over the grid cells of heights (in 1/8 m, as decoded by tile::conversion::to_u16raster), at every multiple of the primary
+// and secondary interval between the lowest and the highest sample. Saddles are resolved with the average of the cell's corners.
+//
+// Crossings on an edge only depend on the two samples of that edge, and are interpolated in the same direction for all edges. Tiles share their
+// border samples with their neighbours, so lines that leave a tile end at exactly the position where the neighbour's lines start (see stitch).
+// Simplification (Douglas-Peucker) keeps the end points.
+[[nodiscard]] std::vector<Line> generate(const Raster<uint16_t>& heights, const Settings& settings);
+
+// Douglas-Peucker, the first and last point are always kept.
+[[nodiscard]] std::vector<glm::vec2> simplify(std::span<const glm::vec2> points, float tolerance);
+
+// texel (0, 0) is at the north west corner of the tile, i.e., (bounds.min.x, bounds.max.y). texel_size = tile width / (raster width - 1).
+[[nodiscard]] std::vector<WorldLine> to_world(const std::vector<Line>& lines, const glm::dvec2& north_west, double texel_size);
+
+// Binary form of generated lines, together with the settings they were generated with, so that they can be cached next to the heights
+// (see tile::GeometryScheduler).
+[[nodiscard]] QByteArray serialise(const std::vector<Line>& lines, const Settings& settings);
+
+// Empty if the bytes are empty or corrupted, or if the lines were generated with other settings.
+[[nodiscard]] std::optional<std::vector<Line>> deserialise(const QByteArray& bytes, const Settings& settings);
+
+// Joins open lines of the same elevation whose end points are within tolerance (e.g., lines of neighbouring tiles). Lines whose ends meet
+// are closed.
+[[nodiscard]] std::vector<WorldLine> stitch(std::vector<WorldLine> lines, double tolerance);
+
+} // namespace nucleus::utils::contours
@@ -0,0 +1,255 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "geotiff_writer.h"
+
+#include <QtEndian>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace nucleus::utils::geotiff {
+
+namespace {
+    enum class Type : uint16_t {
+        Short = 3,
+        Long = 4,
+        Double = 12,
+    };
+
+    struct Entry {
+        uint16_t tag;
+        Type type;
+        uint32_t count;
+        QByteArray value; // little endian
+    };
+
+    template <typename T> void append(QByteArray* bytes, T value)
+    {
+        const auto le = qToLittleEndian(value);
+        bytes->append(reinterpret_cast<const char*>(&le), sizeof(T));
+    }
+
+    void append(QByteArray* bytes, double value)
+    {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(double));
+        append(bytes, bits);
+    }
+
+    template <typename T> Entry entry(uint16_t tag, Type type, const std::vector<T>& values)
+    {
+        Entry e { tag, type, uint32_t(values.size()), {} };
+        for (const auto& v : values)
+            append(&e.value, v);
+        return e;
+    }
+} // namespace
+
+StreamingWriter::StreamingWriter(const QString& file_path, const Format& format, const std::optional<radix::geometry::Aabb<2, double>>& bounds, unsigned tile_size, int compression_level)
+    : m_file(file_path)
+    , m_format(format)
+    , m_bounds(bounds)
+    , m_tile_size(tile_size)
+    , m_compression_level(compression_level)
+{
+    assert(tile_size > 0 && tile_size % 16 == 0); // required by the tiff spec
+    assert(compression_level >= 0 && compression_level <= 9);
+    if (format.size.x == 0 || format.size.y == 0 || format.n_channels == 0) {
+        fail("empty image");
+        return;
+    }
+    if (format.bytes_per_sample != 1 && format.bytes_per_sample != 2 && format.bytes_per_sample != 4) {
+        fail("unsupported sample size");
+        return;
+    }
+    if (!m_file.open(QIODevice::WriteOnly)) {
+        fail("could not open " + file_path.toStdString() + " for writing");
+        return;
+    }
+    QByteArray header("II");
+    append<uint16_t>(&header, 42);
+    append<uint32_t>(&header, 0); // offset of the image file directory, written by finish()
+    if (!write(header))
+        return;
+
+    m_strip.resize(m_format.bytes_per_row() * m_tile_size);
+    m_tile.resize(size_t(m_tile_size) * m_tile_size * m_format.bytes_per_pixel());
+}
+
+void StreamingWriter::write_rows(std::span<const uint8_t> rows)
+{
+    if (!m_error.empty())
+        return;
+    const auto row_size = m_format.bytes_per_row();
+    assert(rows.size() % row_size == 0);
+    const auto n_rows = unsigned(rows.size() / row_size);
+    if (m_n_written_rows + n_rows > m_format.size.y) {
+        fail("more rows than the image height");
+        return;
+    }
+    for (unsigned i = 0; i < n_rows; ++i) {
+        std::memcpy(m_strip.data() + m_n_strip_rows * row_size, rows.data() + i * row_size, row_size);
+        ++m_n_strip_rows;
+        ++m_n_written_rows;
+        if (m_n_strip_rows == m_tile_size)
+            flush_strip();
+    }
+}
+
+void StreamingWriter::flush_strip()
+{
+    const auto bpp = m_format.bytes_per_pixel();
+    const auto row_size = m_format.bytes_per_row();
+    const auto tile_row_size = m_tile_size * bpp;
+    for (unsigned x = 0; x < m_format.size.x && m_error.empty(); x += m_tile_size) {
+        // tiles at the right and bottom border are padded
+        std::fill(m_tile.begin(), m_tile.end(), uint8_t(0));
+        const auto n_columns = std::min(m_tile_size, m_format.size.x - x);
+        for (unsigned row = 0; row < m_n_strip_rows; ++row)
+            std::memcpy(m_tile.data() + row * tile_row_size, m_strip.data() + row * row_size + x * bpp, n_columns * bpp);
+
+        const auto offset = m_file.pos();
+        qint64 n_bytes = 0;
+        if (m_compression_level == 0) {
+            n_bytes = qint64(m_tile.size());
+            if (!write(reinterpret_cast<const char*>(m_tile.data()), n_bytes))
+                return;
+        } else {
+            // qCompress prepends the uncompressed size (4 bytes), the rest is a zlib stream as tiff's deflate compression expects
+            const auto compressed = qCompress(m_tile.data(), qsizetype(m_tile.size()), m_compression_level);
+            n_bytes = compressed.size() - 4;
+            if (!write(compressed.constData() + 4, n_bytes))
+                return;
+        }
+        if (offset + n_bytes > std::numeric_limits<uint32_t>::max()) {
+            fail("tiff is larger than 4 GiB");
+            return;
+        }
+        m_tile_offsets.push_back(uint32_t(offset));
+        m_tile_byte_counts.push_back(uint32_t(n_bytes));
+    }
+    m_n_strip_rows = 0;
+}
+
+tl::expected<void, std::string> StreamingWriter::finish()
+{
+    if (m_error.empty() && m_n_written_rows != m_format.size.y)
+        fail("only " + std::to_string(m_n_written_rows) + " of " + std::to_string(m_format.size.y) + " rows were written");
+    if (m_error.empty() && m_n_strip_rows > 0)
+        flush_strip();
+    if (!m_error.empty())
+        return tl::unexpected(m_error);
+
+    const auto n = uint16_t(m_format.n_channels);
+    const auto bits = uint16_t(m_format.bytes_per_sample * 8);
+    std::vector<Entry> entries;
+    entries.push_back(entry<uint32_t>(256, Type::Long, { m_format.size.x }));
+    entries.push_back(entry<uint32_t>(257, Type::Long, { m_format.size.y }));
+    entries.push_back(entry<uint16_t>(258, Type::Short, std::vector<uint16_t>(n, bits)));
+    entries.push_back(entry<uint16_t>(259, Type::Short, { uint16_t(m_compression_level == 0 ? 1 : 8) })); // none or deflate
+    entries.push_back(entry<uint16_t>(262, Type::Short, { uint16_t(n >= 3 ? 2 : 1) })); // rgb or grey scale
+    entries.push_back(entry<uint16_t>(277, Type::Short, { n }));
+    entries.push_back(entry<uint16_t>(284, Type::Short, { 1 })); // interleaved
+    entries.push_back(entry<uint32_t>(322, Type::Long, { m_tile_size }));
+    entries.push_back(entry<uint32_t>(323, Type::Long, { m_tile_size }));
+    entries.push_back(entry<uint32_t>(324, Type::Long, m_tile_offsets));
+    entries.push_back(entry<uint32_t>(325, Type::Long, m_tile_byte_counts));
+    const auto n_colour_channels = n >= 3 ? 3 : 1;
+    if (n > n_colour_channels) {
+        // the first extra channel of grey + alpha or rgba is alpha (unassociated), others are unspecified
+        std::vector<uint16_t> extra(n - n_colour_channels, 0);
+        if (n == 2 || n == 4)
+            extra.front() = 2;
+        entries.push_back(entry<uint16_t>(338, Type::Short, extra));
+    }
+    entries.push_back(entry<uint16_t>(339, Type::Short, std::vector<uint16_t>(n, uint16_t(m_format.sample_format))));
+    if (m_bounds) {
+        const auto size = m_bounds->size();
+        entries.push_back(entry<double>(33550, Type::Double, { size.x / m_format.size.x, size.y / m_format.size.y, 0.0 })); // ModelPixelScale
+        entries.push_back(entry<double>(33922, Type::Double, { 0.0, 0.0, 0.0, m_bounds->min.x, m_bounds->max.y, 0.0 })); // ModelTiepoint
+        // GeoKeyDirectory: version 1.1.0 with 3 keys: projected model, pixel is area, EPSG:3857
+        entries.push_back(entry<uint16_t>(34735, Type::Short, { 1, 1, 0, 3, 1024, 0, 1, 1, 1025, 0, 1, 1, 3072, 0, 1, 3857 }));
+    }
+
+    // image file directory at the (word aligned) end of the file, followed by the values that don't fit into the entries
+    if (m_file.pos() % 2)
+        write(QByteArray(1, 0));
+    const auto ifd_offset = m_file.pos();
+    auto data_offset = ifd_offset + 2 + 12 * qint64(entries.size()) + 4;
+    QByteArray ifd;
+    QByteArray data;
+    append<uint16_t>(&ifd, uint16_t(entries.size()));
+    for (const auto& e : entries) {
+        append<uint16_t>(&ifd, e.tag);
+        append<uint16_t>(&ifd, uint16_t(e.type));
+        append<uint32_t>(&ifd, e.count);
+        if (e.value.size() <= 4) {
+            ifd.append(e.value);
+            ifd.append(QByteArray(4 - e.value.size(), 0));
+            continue;
+        }
+        append<uint32_t>(&ifd, uint32_t(data_offset + data.size()));
+        data.append(e.value);
+        if (data.size() % 2)
+            data.append(char(0));
+    }
+    append<uint32_t>(&ifd, 0); // no further directories
+    if (data_offset + data.size() > std::numeric_limits<uint32_t>::max())
+        return tl::unexpected(std::string("tiff is larger than 4 GiB"));
+    write(ifd);
+    write(data);
+
+    QByteArray header_offset;
+    append<uint32_t>(&header_offset, uint32_t(ifd_offset));
+    if (m_error.empty() && !m_file.seek(4))
+        fail("seek error: " + m_file.errorString().toStdString());
+    write(header_offset);
+    // flushes the buffered bytes, which can fail as well
+    m_file.close();
+    if (m_error.empty() && m_file.error() != QFileDevice::NoError)
+        fail(m_file.errorString().toStdString());
+    if (!m_error.empty())
+        return tl::unexpected(m_error);
+    return {};
+}
+
+bool StreamingWriter::write(const char* data, qint64 size)
+{
+    if (!m_error.empty())
+        return false;
+    const auto n_written = m_file.write(data, size);
+    if (n_written < 0) {
+        fail("write error: " + m_file.errorString().toStdString());
+        return false;
+    }
+    if (n_written != size) {
+        fail("short write (" + std::to_string(n_written) + " of " + std::to_string(size) + " bytes): " + m_file.errorString().toStdString());
+        return false;
+    }
+    return true;
+}
+
+void StreamingWriter::fail(const std::string& message)
+{
+    if (m_error.empty())
+        m_error = message;
+}
+
+} // namespace nucleus::utils::geotiff
@@ -0,0 +1,90 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <QFile>
+#include <glm/glm.hpp>
+#include <optional>
+#include <radix/geometry.h>
+#include <span>
+#include <string>
+#include <tl/expected.hpp>
+#include <vector>
+
+namespace nucleus::utils::geotiff {
+
+enum class SampleFormat : uint16_t {
+    UnsignedInteger = 1,
+    Float = 3,
+};
+
+struct Format {
+    glm::uvec2 size = {};
+    unsigned n_channels = 4;
+    unsigned bytes_per_sample = 1; // 1, 2 or 4
+    SampleFormat sample_format = SampleFormat::UnsignedInteger;
+
+    [[nodiscard]] size_t bytes_per_pixel() const { return size_t(n_channels) * bytes_per_sample; }
+    [[nodiscard]] size_t bytes_per_row() const { return size.x * bytes_per_pixel(); }
+};
+
+// Writes a tiled, deflate compressed (Geo)TIFF while the rows are produced, north to south. Only one strip of tiles is held in
+// memory, and each tile is compressed and written as soon as its strip is complete. The image file directory goes to the end of
+// the file, so no size needs to be known beforehand. Classic TIFF, i.e., files are limited to 4 GiB.
+//
+// If bounds are given, they are embedded as GeoTIFF tags (EPSG:3857, pixel is area, bounds are the outer edges of the pixels),
+// replacing the aabb side car files of the geo pngs.
+class StreamingWriter {
+public:
+    // compression_level 0 writes uncompressed tiles, 1 - 9 are zlib levels. tile_size must be a multiple of 16.
+    StreamingWriter(const QString& file_path, const Format& format, const std::optional<radix::geometry::Aabb<2, double>>& bounds = {}, unsigned tile_size = 256,
+        int compression_level = 6);
+
+    // appends whole rows, tightly packed. may be called with any number of rows.
+    void write_rows(std::span<const uint8_t> rows);
+    // all rows must have been written. closes the file.
+    [[nodiscard]] tl::expected<void, std::string> finish();
+
+    [[nodiscard]] bool has_failed() const { return !m_error.empty(); }
+    [[nodiscard]] unsigned n_written_rows() const { return m_n_written_rows; }
+    // memory held for buffering, independent of the image height
+    [[nodiscard]] size_t buffer_size_in_bytes() const { return m_strip.capacity() + m_tile.capacity(); }
+
+private:
+    void flush_strip();
+    // writes all bytes or fails the export. short writes (e.g., on a full disk) fail as well.
+    bool write(const char* data, qint64 size);
+    bool write(const QByteArray& bytes) { return write(bytes.constData(), bytes.size()); }
+    void fail(const std::string& message);
+
+    QFile m_file;
+    Format m_format;
+    std::optional<radix::geometry::Aabb<2, double>> m_bounds;
+    unsigned m_tile_size;
+    int m_compression_level;
+    std::vector<uint8_t> m_strip; // tile_size rows
+    std::vector<uint8_t> m_tile;
+    unsigned m_n_strip_rows = 0;
+    unsigned m_n_written_rows = 0;
+    std::vector<uint32_t> m_tile_offsets;
+    std::vector<uint32_t> m_tile_byte_counts;
+    std::string m_error;
+};
+
+} // namespace nucleus::utils::geotiff
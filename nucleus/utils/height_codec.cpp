@@ -0,0 +1,263 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "height_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <vector>
+
+namespace nucleus::utils::height_codec {
+
+namespace {
+constexpr std::array<char, 4> magic = { 'A', 'H', 'C', '1' };
+constexpr qsizetype header_size = 8;
+constexpr unsigned block_size = 16; // samples per rice parameter
+constexpr unsigned rice_parameter_bits = 4;
+constexpr unsigned max_rice_parameter = (1u << rice_parameter_bits) - 1;
+constexpr unsigned escape_length = 24; // longer unary prefixes are replaced by this many zeros, a one and the 16 bit residual
+
+// Converts between samples and residuals in place, in row major order. The prediction always uses samples (not residuals): the encoder goes
+// backwards, so that the neighbours are not yet converted, the decoder forwards, so that they are already reconstructed.
+template <bool forward> void convert(unsigned width, unsigned height, uint16_t* data)
+{
+    const auto predict = [&](unsigned row, unsigned col) -> uint16_t {
+        const uint16_t* current = data + size_t(row) * width;
+        if (row == 0)
+            return col > 0 ? current[col - 1] : uint16_t(0);
+        const uint16_t* north = current - width;
+        if (col == 0)
+            return north[0];
+        return uint16_t(current[col - 1] + north[col] - north[col - 1]);
+    };
+    if constexpr (forward) {
+        for (unsigned row = 0; row < height; ++row) {
+            for (unsigned col = 0; col < width; ++col)
+                data[size_t(row) * width + col] += predict(row, col);
+        }
+    } else {
+        for (unsigned row = height; row-- > 0;) {
+            for (unsigned col = width; col-- > 0;)
+                data[size_t(row) * width + col] -= predict(row, col);
+        }
+    }
+}
+
+// zigzag: 0, -1, 1, -2, 2, .. <-> 0, 1, 2, 3, 4, ..
+uint32_t to_unsigned(uint16_t residual)
+{
+    const auto r = int16_t(residual);
+    return r >= 0 ? uint32_t(r) * 2 : uint32_t(-(r + 1)) * 2 + 1;
+}
+uint16_t to_residual(uint32_t mapped) { return uint16_t((mapped >> 1) ^ (0u - (mapped & 1))); }
+
+unsigned code_length(uint32_t mapped, unsigned rice_parameter)
+{
+    const auto quotient = mapped >> rice_parameter;
+    return quotient < escape_length ? quotient + 1 + rice_parameter : escape_length + 1 + 16;
+}
+
+class BitWriter {
+public:
+    explicit BitWriter(QByteArray* out)
+        : m_out(out)
+    {
+    }
+    void write(uint64_t bits, unsigned n_bits)
+    {
+        assert(m_n_bits + n_bits <= 64);
+        m_bits |= bits << m_n_bits;
+        m_n_bits += n_bits;
+        while (m_n_bits >= 8) {
+            m_out->append(char(m_bits & 0xff));
+            m_bits >>= 8;
+            m_n_bits -= 8;
+        }
+    }
+    void write_code(uint32_t mapped, unsigned rice_parameter)
+    {
+        const auto quotient = mapped >> rice_parameter;
+        if (quotient < escape_length)
+            write((uint64_t(mapped & ((1u << rice_parameter) - 1)) << (quotient + 1)) | (uint64_t(1) << quotient), quotient + 1 + rice_parameter);
+        else
+            write((uint64_t(mapped) << (escape_length + 1)) | (uint64_t(1) << escape_length), escape_length + 1 + 16);
+    }
+    void flush()
+    {
+        if (m_n_bits > 0)
+            write(0, 8 - m_n_bits);
+    }
+
+private:
+    QByteArray* m_out;
+    uint64_t m_bits = 0;
+    unsigned m_n_bits = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* begin, const uint8_t* end)
+        : m_position(begin)
+        , m_end(end)
+    {
+    }
+    // at least 57 bits are available afterwards. reading past the end gives zeros (see overrun).
+    void refill()
+    {
+        if constexpr (std::endian::native == std::endian::little) {
+            if (m_end - m_position >= 8) {
+                uint64_t word = 0;
+                std::memcpy(&word, m_position, 8);
+                m_bits |= word << m_n_bits;
+                m_position += (63 - m_n_bits) >> 3;
+                m_n_bits |= 56;
+                return;
+            }
+        }
+        while (m_n_bits <= 56) {
+            uint64_t byte = 0;
+            if (m_position < m_end)
+                byte = *m_position++;
+            else
+                ++m_n_padding_bytes;
+            m_bits |= byte << m_n_bits;
+            m_n_bits += 8;
+        }
+    }
+    void consume(unsigned n_bits)
+    {
+        assert(n_bits <= m_n_bits);
+        m_bits >>= n_bits;
+        m_n_bits -= n_bits;
+    }
+    uint32_t take(unsigned n_bits)
+    {
+        const auto value = uint32_t(m_bits & ((uint64_t(1) << n_bits) - 1));
+        consume(n_bits);
+        return value;
+    }
+    // returns false on invalid codes (too many leading zeros). needs refill before.
+    bool read_code(unsigned rice_parameter, uint32_t* mapped)
+    {
+        const auto quotient = unsigned(std::countr_zero(m_bits));
+        if (quotient < escape_length) {
+            consume(quotient + 1);
+            *mapped = (quotient << rice_parameter) | take(rice_parameter);
+            return true;
+        }
+        if (quotient == escape_length) {
+            consume(escape_length + 1);
+            *mapped = take(16);
+            return true;
+        }
+        return false;
+    }
+    [[nodiscard]] bool overrun() const { return m_n_padding_bytes * 8 > m_n_bits; }
+
+private:
+    const uint8_t* m_position;
+    const uint8_t* m_end;
+    uint64_t m_bits = 0;
+    unsigned m_n_bits = 0;
+    unsigned m_n_padding_bytes = 0;
+};
+
+} // namespace
+
+bool is_encoded(const QByteArray& bytes) { return bytes.size() >= header_size && std::memcmp(bytes.constData(), magic.data(), magic.size()) == 0; }
+
+QByteArray encode(const Raster<uint16_t>& heights)
+{
+    assert(heights.width() < (1u << 16) && heights.height() < (1u << 16));
+    QByteArray bytes;
+    bytes.reserve(header_size + qsizetype(heights.width() * heights.height()));
+    bytes.append(magic.data(), magic.size());
+    for (const auto size : { heights.width(), heights.height() }) {
+        bytes.append(char(size & 0xff));
+        bytes.append(char((size >> 8) & 0xff));
+    }
+
+    std::vector<uint16_t> residuals = heights.buffer();
+    convert<false>(heights.width(), heights.height(), residuals.data());
+    std::vector<uint32_t> mapped(residuals.size());
+    std::transform(residuals.begin(), residuals.end(), mapped.begin(), to_unsigned);
+
+    BitWriter writer(&bytes);
+    for (size_t block_start = 0; block_start < mapped.size(); block_start += block_size) {
+        const auto block = std::span(mapped).subspan(block_start, std::min<size_t>(block_size, mapped.size() - block_start));
+        // the parameter giving the shortest block
+        unsigned rice_parameter = 0;
+        unsigned shortest = std::numeric_limits<unsigned>::max();
+        for (unsigned k = 0; k <= max_rice_parameter; ++k) {
+            unsigned length = 0;
+            for (const auto m : block)
+                length += code_length(m, k);
+            if (length < shortest) {
+                shortest = length;
+                rice_parameter = k;
+            }
+        }
+        writer.write(rice_parameter, rice_parameter_bits);
+        for (const auto m : block)
+            writer.write_code(m, rice_parameter);
+    }
+    writer.flush();
+    return bytes;
+}
+
+tl::expected<Raster<uint16_t>, QString> decode(const QByteArray& bytes)
+{
+    if (!is_encoded(bytes))
+        return tl::unexpected(QString("height_codec::decode: not an encoded height raster."));
+    const auto* begin = reinterpret_cast<const uint8_t*>(bytes.constData());
+    const auto width = unsigned(begin[4]) | (unsigned(begin[5]) << 8);
+    const auto height = unsigned(begin[6]) | (unsigned(begin[7]) << 8);
+    // every sample takes at least one bit. protects against allocating gigabytes for a corrupted header.
+    if (uint64_t(width) * height > uint64_t(bytes.size() - header_size) * 8)
+        return tl::unexpected(QString("height_codec::decode: data is truncated."));
+
+    // the residuals don't depend on the samples, so they are decoded first (the loop only waits for the bit reader), and then converted in place.
+    Raster<uint16_t> heights({ width, height });
+    uint16_t* data = heights.data();
+    const auto n_samples = size_t(width) * height;
+    BitReader reader(begin + header_size, begin + bytes.size());
+    bool valid = true;
+    for (size_t block_start = 0; block_start < n_samples; block_start += block_size) {
+        reader.refill();
+        const auto rice_parameter = reader.take(rice_parameter_bits);
+        const auto block_end = std::min(n_samples, block_start + block_size);
+        for (size_t i = block_start; i < block_end; ++i) {
+            reader.refill();
+            uint32_t mapped = 0;
+            valid &= reader.read_code(rice_parameter, &mapped);
+            data[i] = to_residual(mapped);
+        }
+    }
+    if (!valid || reader.overrun())
+        return tl::unexpected(QString("height_codec::decode: data is corrupted."));
+    convert<true>(width, height, data);
+    return heights;
+}
+
+} // namespace nucleus::utils::height_codec
@@ -16,13 +16,16 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
+#include <algorithm>
 #include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <type_traits>
 #include <vector>
 
 #include <glm/glm.hpp>
 
-#include <iostream>
-
 namespace nucleus::utils::rasterizer {
 /*
  * Possible future improvements:
@@ -44,6 +47,24 @@ concept PixelWriterFunctionConcept = requires(Func f) {
     { f(glm::ivec2(11, 22), 123456u) };
 };
 
+/* SpanWriterFunctionConcept
+ * The *_spans functions use a SpanWriterFunction instead. It receives a horizontal run of pixels at once, so that the writer can fill it
+ * with a single std::fill / memset instead of one call per pixel. Parameters:
+ *      int y
+ *          the row
+ *      int x_begin, int x_end
+ *          the pixels [x_begin, x_end) of the row, x_begin < x_end. spans are not clipped, i.e., they may reach outside the raster
+ *      unsigned int data (optional)
+ *          the triangle/line-segment index
+ * Spans of the same primitive may overlap (e.g., end caps and the enlarged triangle), so the writer should not accumulate.
+ */
+template <typename Func>
+concept SpanWriterFunctionConcept = requires(Func f) {
+    { f(11, 22, 33) };
+} || requires(Func f) {
+    { f(11, 22, 33, 123456u) };
+};
+
 namespace details {
 
     /*
@@ -58,6 +79,154 @@ namespace details {
         }
     }
 
+    /*
+     * This function calls either the 3 parameter or the 4 parameter spanwriter (determined at compile time)
+     */
+    template <SpanWriterFunctionConcept SpanWriterFunction> inline void invokeSpanWriter(const SpanWriterFunction& span_writer, int y, int x_begin, int x_end, unsigned int data_index)
+    {
+        if constexpr (std::is_invocable_v<SpanWriterFunction, int, int, int, unsigned int>) {
+            span_writer(y, x_begin, x_end, data_index);
+        } else if constexpr (std::is_invocable_v<SpanWriterFunction, int, int, int>) {
+            span_writer(y, x_begin, x_end);
+        }
+    }
+
+    /*
+     * Lets the span based rasterizer drive a per pixel writer.
+     * Pixels of a span are visited from left to right.
+     */
+    template <PixelWriterFunctionConcept PixelWriterFunction> struct PixelWriterSpanAdapter {
+        const PixelWriterFunction& pixel_writer;
+
+        inline void operator()(int y, int x_begin, int x_end, unsigned int data_index) const
+        {
+            for (int x = x_begin; x < x_end; ++x)
+                invokePixelWriter(pixel_writer, glm::ivec2(x, y), data_index);
+        }
+    };
+
+    /*
+     * Pixel extent of every row touched by a convex polygon, built edge by edge.
+     * Within a row, the extent of a convex polygon is the extent of its boundary in that row, so every edge only widens the rows it crosses.
+     * The row intersections of an edge are stepped incrementally (one division per edge), in double precision so that long edges don't drift.
+     */
+    class RowExtents {
+    public:
+        // prepares the rows [floor(y_min), floor(y_max)], all of them empty
+        void reset(float y_min, float y_max)
+        {
+            m_first_row = int(std::floor(y_min));
+            m_extents.assign(size_t(int(std::floor(y_max)) - m_first_row + 1), glm::ivec2(std::numeric_limits<int>::max(), std::numeric_limits<int>::min()));
+        }
+
+        void add_edge(glm::vec2 a, glm::vec2 b)
+        {
+            // if an edge would go directly through integer points, we would falsely draw a whole pixel -> intersect slightly inside the row
+            constexpr double epsilon = 0.00001;
+
+            if (a.y > b.y)
+                std::swap(a, b);
+            const int first_row = int(std::floor(a.y));
+            const int last_row = int(std::floor(b.y));
+            if (first_row == last_row) {
+                widen(first_row, a.x, b.x);
+                return;
+            }
+
+            const double slope = (double(b.x) - a.x) / (double(b.y) - a.y);
+            const double row_height = (1 - 2 * epsilon) * slope; // x difference between the top and the bottom intersection of a row
+            // start of the edge to the bottom of its first row
+            widen(first_row, a.x, a.x + std::max(first_row + 1 - epsilon - a.y, 0.0) * slope);
+            // full rows in between, x is the intersection with the top of the row
+            double x = a.x + (first_row + 1 + epsilon - a.y) * slope;
+            for (int row = first_row + 1; row < last_row; ++row) {
+                widen(row, x, x + row_height);
+                x += slope;
+            }
+            // top of the last row to the end of the edge
+            widen(last_row, b.y - last_row < epsilon ? b.x : x, b.x);
+        }
+
+        template <SpanWriterFunctionConcept SpanWriterFunction> void write(const SpanWriterFunction& span_writer, unsigned int data_index) const
+        {
+            for (size_t i = 0; i < m_extents.size(); ++i) {
+                if (m_extents[i].x <= m_extents[i].y)
+                    invokeSpanWriter(span_writer, m_first_row + int(i), m_extents[i].x, m_extents[i].y + 1, data_index);
+            }
+        }
+
+    private:
+        void widen(int row, double x1, double x2)
+        {
+            assert(row >= m_first_row && row - m_first_row < int(m_extents.size()));
+            auto& extent = m_extents[size_t(row - m_first_row)];
+            extent.x = std::min(extent.x, int(std::floor(std::min(x1, x2))));
+            extent.y = std::max(extent.y, int(std::floor(std::max(x1, x2))));
+        }
+
+        int m_first_row = 0;
+        std::vector<glm::ivec2> m_extents;
+    };
+
+    /*
+     * renders the convex polygon given by its points (in order, either orientation), one span per row.
+     * a polygon with 2 points is a line segment.
+     */
+    template <SpanWriterFunctionConcept SpanWriterFunction, size_t n_points>
+    void render_convex_polygon(const SpanWriterFunction& span_writer, RowExtents& rows, unsigned int data_index, const std::array<glm::vec2, n_points>& points)
+    {
+        const auto [y_min, y_max] = std::minmax_element(points.begin(), points.end(), [](const glm::vec2& a, const glm::vec2& b) { return a.y < b.y; });
+        rows.reset(y_min->y, y_max->y);
+        for (size_t i = 0; i < (n_points == 2 ? 1 : n_points); ++i)
+            rows.add_edge(points[i], points[(i + 1) % n_points]);
+        rows.write(span_writer, data_index);
+    }
+
+    /*
+     * Lets the per pixel rasterizer (used for enlarged shapes) drive a span writer.
+     * Consecutive pixels of the same row and primitive are merged into one span, which is written once the next pixel doesn't extend it
+     * (or on flush). Pixels are passed on unchanged, so the spans cover exactly the pixels of the per pixel rasterizer.
+     */
+    template <SpanWriterFunctionConcept SpanWriterFunction> class SpanWriterPixelAdapter {
+    public:
+        explicit SpanWriterPixelAdapter(const SpanWriterFunction& span_writer)
+            : m_span_writer(span_writer)
+        {
+        }
+
+        inline void operator()(glm::ivec2 position, unsigned int data_index) const
+        {
+            if (m_has_span && position.y == m_y && data_index == m_data_index) {
+                if (position.x >= m_x_begin - 1 && position.x <= m_x_end) {
+                    m_x_begin = std::min(m_x_begin, position.x);
+                    m_x_end = std::max(m_x_end, position.x + 1);
+                    return;
+                }
+            }
+            flush();
+            m_has_span = true;
+            m_y = position.y;
+            m_x_begin = position.x;
+            m_x_end = position.x + 1;
+            m_data_index = data_index;
+        }
+
+        void flush() const
+        {
+            if (m_has_span)
+                invokeSpanWriter(m_span_writer, m_y, m_x_begin, m_x_end, m_data_index);
+            m_has_span = false;
+        }
+
+    private:
+        const SpanWriterFunction& m_span_writer;
+        mutable bool m_has_span = false;
+        mutable int m_y = 0;
+        mutable int m_x_begin = 0;
+        mutable int m_x_end = 0;
+        mutable unsigned int m_data_index = 0;
+    };
+
     /*
      * Calculates the x value for a given y.
      * The resulting x value will be on the line.
@@ -229,21 +398,43 @@ namespace details {
 
     /*
      * renders a circle at the given position
+     * covers all integer offsets o from position with length(o) < distance + sqrt(0.5), one span per row.
+     * the extent of a row is computed from the circle equation and then corrected with the exact test, so that we get the same pixels as testing every offset.
      */
-    template <PixelWriterFunctionConcept PixelWriterFunction> void add_circle_end_cap(const PixelWriterFunction& pixel_writer, const glm::vec2& position, unsigned int data_index, float distance)
+    template <SpanWriterFunctionConcept SpanWriterFunction> void add_circle_end_cap(const SpanWriterFunction& span_writer, const glm::vec2& position, unsigned int data_index, float distance)
     {
         distance += sqrt(0.5);
-        float distance_test = ceil(distance);
-
-        for (int i = -distance_test; i < distance_test; i++) {
-            for (int j = -distance_test; j < distance_test; j++) {
-                const auto offset = glm::vec2(i + 0.0, j + 0.0);
-                if (glm::length(offset) < distance)
-                    invokePixelWriter(pixel_writer, position + offset, data_index);
-            }
+        const float distance_test = ceil(distance);
+        const int i_min = -distance_test;
+        const int i_max = int(distance_test) - 1;
+
+        const auto is_inside = [distance](int i, int j) { return glm::length(glm::vec2(i + 0.0, j + 0.0)) < distance; };
+
+        for (int j = -distance_test; j < distance_test; j++) {
+            // largest i >= 0 that is still inside (the test is symmetric in i and monotonic in |i|)
+            int i_extent = int(std::sqrt(std::max(0.0, double(distance) * distance - double(j) * j)));
+            while (is_inside(i_extent + 1, j))
+                i_extent++;
+            while (i_extent >= 0 && !is_inside(i_extent, j))
+                i_extent--;
+            if (i_extent < 0)
+                continue;
+
+            // offsets are added in float and truncated like a glm::vec2 -> glm::ivec2 conversion. that is monotonic, so the row stays a single span.
+            const int i_begin = std::max(-i_extent, i_min);
+            const int i_end = std::min(i_extent, i_max);
+            const int y = position.y + float(j);
+            const int x_begin = position.x + float(i_begin);
+            const int x_last = position.x + float(i_end);
+            invokeSpanWriter(span_writer, y, x_begin, x_last + 1, data_index);
         }
     }
 
+    template <PixelWriterFunctionConcept PixelWriterFunction> void add_circle_end_cap(const PixelWriterFunction& pixel_writer, const glm::vec2& position, unsigned int data_index, float distance)
+    {
+        add_circle_end_cap(PixelWriterSpanAdapter<PixelWriterFunction> { pixel_writer }, position, data_index, distance);
+    }
+
     /*
      * In order to process enlarged triangles, the triangle is separated into 3 parts: top, middle and bottom
      * we first generate the normals for each edge and offset the triangle origins by the normal multiplied by the supplied distance to get 6 "enlarged" points that define the bigger triangle
@@ -274,16 +465,9 @@ namespace details {
         float x_middle_of_top_bottom_line = get_x_for_y_on_line(triangle[0], edge_top_bottom, triangle[1].y);
         int fill_direction = (triangle[1].x < x_middle_of_top_bottom_line) ? 1 : -1;
 
-        if (distance == 0.0) {
-            // top middle
-            render_line(pixel_writer, triangle_index, triangle[0], edge_top_middle, fill_direction, triangle[0], edge_top_bottom);
-            // middle bottom
-            render_line(pixel_writer, triangle_index, triangle[1], edge_middle_bottom, fill_direction, triangle[0], edge_top_bottom);
+        // without distance, triangles are rendered by render_convex_polygon
+        assert(distance > 0);
 
-            return; // finished
-        }
-
-        // we need to render an enlarged triangle
         auto normal_top_bottom = glm::normalize(glm::vec2(-edge_top_bottom.y, edge_top_bottom.x));
         auto normal_top_middle = glm::normalize(glm::vec2(-edge_top_middle.y, edge_top_middle.x));
         auto normal_middle_bottom = glm::normalize(glm::vec2(-edge_middle_bottom.y, edge_middle_bottom.x));
@@ -397,16 +581,8 @@ namespace details {
             origin = line_points[0];
         }
 
-        // only draw lines with 1 pixel width
-        if (distance == 0.0) {
-            render_line(pixel_writer, line_index, origin, edge);
-
-            // debug output for points
-            // invokePixelWriter(pixel_writer, line_points[0], 50);
-            // invokePixelWriter(pixel_writer, line_points[1], 50);
-
-            return; // finished
-        }
+        // lines with 1 pixel width are rendered by render_convex_polygon
+        assert(distance > 0);
 
         // we want to draw lines with a thickness
 
@@ -497,7 +673,9 @@ std::vector<glm::vec2> triangulize(std::vector<glm::vec2> polygon_points, std::v
 /*
  * Rasterize a triangle
  * in this method every triangle is traversed only once, and it only accesses pixels it needs for itself.
- * this function determines the position where pixels should be set and calls the given pixel_writer lambda to actually draw the pixels
+ * this function determines the position where pixels should be set and calls the given span_writer lambda once per horizontal run of pixels
+ * without distance, the row extents of a triangle are computed directly. enlarged triangles go through the per pixel rasterizer,
+ * whose pixels are merged into spans, so both entry points produce the same pixels.
  *
  * NOTE: the triangle points have to be ordered correctly by y position
  * -> input triangles: ordered by y position within each triangle (top_ypos_triangle_1, middle_ypos_triangle_1, bottom_ypos_triangle_1, top_ypos_triangle_2, middle_ypos_triangle_2, ...)
@@ -505,23 +683,76 @@ std::vector<glm::vec2> triangulize(std::vector<glm::vec2> polygon_points, std::v
  * example usage:
  *      const std::vector<glm::vec2> triangle_points = { glm::vec2(30.5, 10.5), glm::vec2(10.5, 30.5), glm::vec2(50.5, 50.5) };
  *      nucleus::Raster<uint8_t> output({ 64, 64 }, 0u);
+ *      const auto span_writer = [&output](int y, int x_begin, int x_end) { std::fill(&output.pixel({ x_begin, y }), &output.pixel({ x_begin, y }) + (x_end - x_begin), 255); };
+ *      nucleus::utils::rasterizer::rasterize_triangle_spans(span_writer, triangle_points);
+ */
+template <SpanWriterFunctionConcept SpanWriterFunction> void rasterize_triangle_spans(const SpanWriterFunction& span_writer, const std::vector<glm::vec2>& triangles, float distance = 0.0)
+{
+    if (distance != 0.0) {
+        const details::SpanWriterPixelAdapter<SpanWriterFunction> pixel_writer(span_writer);
+        for (size_t i = 0; i < triangles.size() / 3; ++i) {
+            details::render_triangle(pixel_writer, { triangles[i * 3 + 0], triangles[i * 3 + 1], triangles[i * 3 + 2] }, i, distance);
+        }
+        pixel_writer.flush();
+        return;
+    }
+
+    details::RowExtents rows;
+    for (size_t i = 0; i < triangles.size() / 3; ++i) {
+        details::render_convex_polygon(span_writer, rows, i, std::array<glm::vec2, 3> { triangles[i * 3 + 0], triangles[i * 3 + 1], triangles[i * 3 + 2] });
+    }
+}
+
+/*
+ * Rasterize a triangle
+ * same as rasterize_triangle_spans, but calls the given pixel_writer lambda for every pixel
+ *
+ * example usage:
+ *      const std::vector<glm::vec2> triangle_points = { glm::vec2(30.5, 10.5), glm::vec2(10.5, 30.5), glm::vec2(50.5, 50.5) };
+ *      nucleus::Raster<uint8_t> output({ 64, 64 }, 0u);
  *      const auto pixel_writer = [&output](glm::ivec2 pos) { output.pixel(pos) = 255; };
  *      nucleus::utils::rasterizer::rasterize_triangle(pixel_writer, triangle_points);
  */
 template <PixelWriterFunctionConcept PixelWriterFunction> void rasterize_triangle(const PixelWriterFunction& pixel_writer, const std::vector<glm::vec2>& triangles, float distance = 0.0)
 {
-    for (size_t i = 0; i < triangles.size() / 3; ++i) {
-        details::render_triangle(pixel_writer, { triangles[i * 3 + 0], triangles[i * 3 + 1], triangles[i * 3 + 2] }, i, distance);
+    if (distance != 0.0) {
+        for (size_t i = 0; i < triangles.size() / 3; ++i) {
+            details::render_triangle(pixel_writer, { triangles[i * 3 + 0], triangles[i * 3 + 1], triangles[i * 3 + 2] }, i, distance);
+        }
+        return;
     }
+    rasterize_triangle_spans(details::PixelWriterSpanAdapter<PixelWriterFunction> { pixel_writer }, triangles);
 }
 
 /*
  * Rasterize a line
  *
- * this function determines the position where pixels should be set and calls the given pixel_writer lambda to actually draw the pixels
+ * this function determines the position where pixels should be set and calls the given span_writer lambda once per horizontal run of pixels
+ * like rasterize_triangle_spans, lines with distance go through the per pixel rasterizer.
  *
  * input line_points: a list of points that should form a line (line_start, line_point1, line_point2, ..., line_end)
  * -> generates line segments between line_start-line_point1, line_point1 to line_point2, ...
+ */
+template <SpanWriterFunctionConcept SpanWriterFunction> void rasterize_line_spans(const SpanWriterFunction& span_writer, const std::vector<glm::vec2>& line_points, float distance = 0.0)
+{
+    if (distance != 0.0) {
+        const details::SpanWriterPixelAdapter<SpanWriterFunction> pixel_writer(span_writer);
+        for (size_t i = 0; i < line_points.size() - 1; ++i) {
+            details::render_line_preprocess(pixel_writer, { line_points[i + 0], line_points[i + 1] }, i, distance);
+        }
+        pixel_writer.flush();
+        return;
+    }
+
+    details::RowExtents rows;
+    for (size_t i = 0; i < line_points.size() - 1; ++i) {
+        details::render_convex_polygon(span_writer, rows, i, std::array<glm::vec2, 2> { line_points[i + 0], line_points[i + 1] });
+    }
+}
+
+/*
+ * Rasterize a line
+ * same as rasterize_line_spans, but calls the given pixel_writer lambda for every pixel
  *
  * example usage:
  *      const std::vector<glm::vec2> line = { glm::vec2(30.5, 10.5), glm::vec2(50.5, 30.5), glm::vec2(30.5, 50.5), glm::vec2(10.5, 30.5), glm::vec2(30.5, 10.5) };
@@ -531,15 +762,31 @@ template <PixelWriterFunctionConcept PixelWriterFunction> void rasterize_triangl
  */
 template <PixelWriterFunctionConcept PixelWriterFunction> void rasterize_line(const PixelWriterFunction& pixel_writer, const std::vector<glm::vec2>& line_points, float distance = 0.0)
 {
-    for (size_t i = 0; i < line_points.size() - 1; ++i) {
-        details::render_line_preprocess(pixel_writer, { line_points[i + 0], line_points[i + 1] }, i, distance);
+    if (distance != 0.0) {
+        for (size_t i = 0; i < line_points.size() - 1; ++i) {
+            details::render_line_preprocess(pixel_writer, { line_points[i + 0], line_points[i + 1] }, i, distance);
+        }
+        return;
     }
+    rasterize_line_spans(details::PixelWriterSpanAdapter<PixelWriterFunction> { pixel_writer }, line_points);
 }
 
 /*
  * Rasterize a polygon
- * convenience function that really just calls rasterize_triangle after triangulizing the polygon
- * this function determines the position where pixels should be set and calls the given pixel_writer lambda to actually draw the pixels
+ * convenience function that really just calls rasterize_triangle_spans after triangulizing the polygon
+ * this function determines the position where pixels should be set and calls the given span_writer lambda once per horizontal run of pixels
+ */
+template <SpanWriterFunctionConcept SpanWriterFunction> void rasterize_polygon_spans(const SpanWriterFunction& span_writer, const std::vector<glm::vec2>& polygon_points, float distance = 0.0)
+{
+    const auto edges = generate_neighbour_edges(polygon_points);
+    const auto triangles = triangulize(polygon_points, edges);
+
+    rasterize_triangle_spans(span_writer, triangles, distance);
+}
+
+/*
+ * Rasterize a polygon
+ * same as rasterize_polygon_spans, but calls the given pixel_writer lambda for every pixel
  *
  * example usage:
  *      const std::vector<glm::vec2> polygon_points = { glm::vec2(30.5, 10.5), glm::vec2(10.5, 30.5), glm::vec2(50.5, 50.5) };
@@ -549,10 +796,7 @@ template <PixelWriterFunctionConcept PixelWriterFunction> void rasterize_line(co
  */
 template <PixelWriterFunctionConcept PixelWriterFunction> void rasterize_polygon(const PixelWriterFunction& pixel_writer, const std::vector<glm::vec2>& polygon_points, float distance = 0.0)
 {
-    const auto edges = generate_neighbour_edges(polygon_points);
-    const auto triangles = triangulize(polygon_points, edges);
-
-    rasterize_triangle(pixel_writer, triangles, distance);
+    rasterize_polygon_spans(details::PixelWriterSpanAdapter<PixelWriterFunction> { pixel_writer }, polygon_points, distance);
 }
 
 } // namespace nucleus::utils::rasterizer
@@ -0,0 +1,97 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "terrain_mesh_index_generator.h"
+
+namespace nucleus::utils::terrain_mesh_index_generator {
+
+glm::uvec2 grid_position(uint32_t vertex, unsigned vertex_side_length)
+{
+    const auto n = vertex_side_length;
+    if (vertex < n * n)
+        return { vertex % n, vertex / n };
+    // curtains run around the tile: east side (south to north), north side (east to west), west side (north to south), south side (west to east)
+    const auto curtain = vertex - n * n;
+    assert(curtain < 4 * (n - 1));
+    if (curtain < n)
+        return { n - 1, n - 1 - curtain };
+    if (curtain < 2 * n - 1)
+        return { 2 * n - 2 - curtain, 0 };
+    if (curtain < 3 * n - 2)
+        return { 0, curtain - 2 * n + 2 };
+    return { curtain - 3 * n + 3, n - 1 };
+}
+
+TileMesh tile_mesh(unsigned vertex_side_length, Layout layout, unsigned meshlet_quads)
+{
+    assert(meshlet_quads > 0);
+    const auto n = vertex_side_length;
+    TileMesh mesh;
+    mesh.indices = surface_quads_with_curtains<uint32_t>(n);
+    if (layout == Layout::Strip)
+        return mesh;
+
+    mesh.topology = vertex_cache::Topology::TriangleList;
+    const auto triangles = vertex_cache::strip_to_list(mesh.indices);
+    const auto n_vertices = n * n + 4 * (n - 1);
+    if (layout == Layout::CacheOptimisedList) {
+        mesh.indices = vertex_cache::forsyth_order(triangles, n_vertices);
+        return mesh;
+    }
+
+    // a triangle belongs to the block of its upper left vertex, i.e., of its quad. curtain triangles go with the quads they hang from.
+    const auto n_blocks = (n - 1 + meshlet_quads - 1) / meshlet_quads;
+    std::vector<std::vector<uint32_t>> blocks(n_blocks * n_blocks);
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+        auto min = grid_position(triangles[i], n);
+        for (unsigned j = 1; j < 3; ++j)
+            min = glm::min(min, grid_position(triangles[i + j], n));
+        const auto block = glm::min(min / meshlet_quads, glm::uvec2(n_blocks - 1));
+        auto& block_triangles = blocks[block.y * n_blocks + block.x];
+        block_triangles.insert(block_triangles.end(), &triangles[i], &triangles[i] + 3);
+    }
+
+    mesh.indices.clear();
+    mesh.indices.reserve(triangles.size());
+    for (const auto& block_triangles : blocks) {
+        if (block_triangles.empty())
+            continue;
+        Meshlet meshlet;
+        meshlet.first_index = uint32_t(mesh.indices.size());
+        meshlet.n_indices = uint32_t(block_triangles.size());
+        meshlet.grid_min = glm::uvec2(n);
+        std::vector<uint32_t> vertices(block_triangles.begin(), block_triangles.end());
+        std::sort(vertices.begin(), vertices.end());
+        vertices.erase(std::unique(vertices.begin(), vertices.end()), vertices.end());
+        meshlet.n_vertices = uint32_t(vertices.size());
+        for (const auto v : vertices) {
+            meshlet.grid_min = glm::min(meshlet.grid_min, grid_position(v, n));
+            meshlet.grid_max = glm::max(meshlet.grid_max, grid_position(v, n));
+        }
+        // optimise on local indices, so that the cost depends on the size of the meshlet only
+        std::vector<uint32_t> local(block_triangles.size());
+        for (size_t i = 0; i < local.size(); ++i)
+            local[i] = uint32_t(std::lower_bound(vertices.begin(), vertices.end(), block_triangles[i]) - vertices.begin());
+        for (const auto v : vertex_cache::forsyth_order(local, meshlet.n_vertices))
+            mesh.indices.push_back(vertices[v]);
+        mesh.meshlets.push_back(meshlet);
+    }
+    return mesh;
+}
+
+} // namespace nucleus::utils::terrain_mesh_index_generator
@@ -18,10 +18,15 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <glm/glm.hpp>
 #include <limits>
 #include <vector>
 
+#include "vertex_cache.h"
+
 // functions in this file generate the indices for our terrain meshes.
 // we use a regular grid. vertex positions are computed in the vertex shader on the fly,
 // but we still need the indices of the triangles.
@@ -102,4 +107,41 @@ std::vector<Index> surface_quads_with_curtains(unsigned vertex_side_length)
 
     return indices;
 }
+
+// alternatives to the strip above. all layouts contain the same triangles with the same winding order and vertex indices, so the
+// shaders don't need to know which one is used; only the primitive topology differs.
+enum class Layout {
+    Strip, // surface_quads_with_curtains
+    CacheOptimisedList, // triangle list in vertex cache order (Forsyth), the default of the tile renderers
+    Meshlets, // triangle list partitioned into square blocks of quads (plus their curtains), each in vertex cache order
+};
+
+struct Meshlet {
+    uint32_t first_index = 0;
+    uint32_t n_indices = 0;
+    uint32_t n_vertices = 0; // unique vertices
+    // (column, row) bounds of the referenced vertices, inclusive. together with the tile bounds and the height range of the block this
+    // gives a bounding box for culling.
+    glm::uvec2 grid_min = {};
+    glm::uvec2 grid_max = {};
+};
+
+struct TileMesh {
+    vertex_cache::Topology topology = vertex_cache::Topology::TriangleStrip;
+    std::vector<uint32_t> indices;
+    std::vector<Meshlet> meshlets; // Layout::Meshlets only, covering the index buffer in order
+
+    template <typename Index> std::vector<Index> indices_as() const
+    {
+        assert(indices.empty() || *std::max_element(indices.begin(), indices.end()) <= std::numeric_limits<Index>::max());
+        return std::vector<Index>(indices.begin(), indices.end());
+    }
+};
+
+// (column, row) of a vertex on the grid. curtain vertices are mapped to the border vertex they hang from (as in the tile shaders).
+glm::uvec2 grid_position(uint32_t vertex, unsigned vertex_side_length);
+
+// index buffer for the surface with curtains in the given layout. meshlets cover at most meshlet_quads x meshlet_quads quads, that is
+// (meshlet_quads + 1)^2 surface vertices (64 for the default) and 2 * meshlet_quads^2 triangles, plus curtains at the tile border.
+TileMesh tile_mesh(unsigned vertex_side_length, Layout layout, unsigned meshlet_quads = 7);
 }
@@ -0,0 +1,245 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "terrain_simplification.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "terrain_mesh_index_generator.h"
+#include "vertex_cache.h"
+
+namespace nucleus::utils::terrain_simplification {
+
+namespace {
+    struct Extraction {
+        const std::vector<float>& errors;
+        float max_error;
+        unsigned size;
+        std::vector<uint32_t>& indices;
+        std::vector<uint8_t>& is_used;
+        unsigned n_vertices = 0;
+
+        void add_vertex(glm::ivec2 v)
+        {
+            const auto index = uint32_t(v.y) * size + uint32_t(v.x);
+            if (!is_used[index]) {
+                is_used[index] = 1;
+                ++n_vertices;
+            }
+            indices.push_back(index);
+        }
+
+        // a and b span the hypotenuse, c is the right angle
+        void process(glm::ivec2 a, glm::ivec2 b, glm::ivec2 c)
+        {
+            const auto m = (a + b) / 2;
+            if (std::abs(a.x - c.x) + std::abs(a.y - c.y) > 1 && errors[uint32_t(m.y) * size + uint32_t(m.x)] > max_error) {
+                process(c, a, m);
+                process(b, c, m);
+                return;
+            }
+            // (column, row) with rows going south. the strips of terrain_mesh_index_generator have a negative signed area in that space.
+            const auto ab = b - a;
+            const auto ac = c - a;
+            if (ab.x * ac.y - ab.y * ac.x > 0)
+                std::swap(b, c);
+            add_vertex(a);
+            add_vertex(b);
+            add_vertex(c);
+        }
+    };
+
+    // largest vertical distance between the grid heights inside the triangle and the plane through its corners
+    float triangle_error(const Raster<uint16_t>& heights, glm::ivec2 a, glm::ivec2 b, glm::ivec2 c)
+    {
+        const auto height = [&](glm::ivec2 p) { return float(heights.pixel(glm::uvec2(p))); };
+        const auto ab = b - a;
+        const auto ac = c - a;
+        const auto det = float(ab.x * ac.y - ab.y * ac.x);
+        assert(det != 0);
+        const auto dhb = height(b) - height(a);
+        const auto dhc = height(c) - height(a);
+        const auto gradient_x = (dhb * float(ac.y) - dhc * float(ab.y)) / det;
+        const auto gradient_y = (dhc * float(ab.x) - dhb * float(ac.x)) / det;
+
+        // scan line order: the long edge goes from top to bottom, the two short ones meet at the middle vertex
+        std::array<glm::ivec2, 3> v = { a, b, c };
+        std::sort(v.begin(), v.end(), [](const glm::ivec2& p, const glm::ivec2& q) { return p.y < q.y; });
+        const auto x_on_edge = [](glm::ivec2 p, glm::ivec2 q, int y) {
+            // exact whenever the intersection is on the grid
+            return p.y == q.y ? double(p.x) : p.x + double((q.x - p.x) * (y - p.y)) / double(q.y - p.y);
+        };
+        const auto& row_buffer = heights.buffer();
+        const auto h_a = height(a);
+        float error = 0;
+        for (int y = v[0].y; y <= v[2].y; ++y) {
+            const auto x_long = x_on_edge(v[0], v[2], y);
+            const auto x_short = y < v[1].y ? x_on_edge(v[0], v[1], y) : x_on_edge(v[1], v[2], y);
+            const auto x_begin = int(std::ceil(std::min(x_long, x_short)));
+            const auto x_end = int(std::floor(std::max(x_long, x_short)));
+            const auto* row = &row_buffer[size_t(y) * heights.width()];
+            const auto row_offset = gradient_y * float(y - a.y) + h_a;
+            for (auto x = x_begin; x <= x_end; ++x)
+                error = std::max(error, std::abs(row_offset + gradient_x * float(x - a.x) - float(row[x])));
+        }
+        return error;
+    }
+} // namespace
+
+Rtin::Rtin(unsigned vertex_side_length)
+    : m_size(vertex_side_length)
+{
+    const auto tile_size = vertex_side_length - 1;
+    assert(vertex_side_length >= 3);
+    assert((tile_size & (tile_size - 1)) == 0); // 2^k + 1
+    const auto n_triangles = tile_size * tile_size * 2 - 2;
+    m_n_parent_triangles = n_triangles - tile_size * tile_size;
+    m_triangles.resize(n_triangles);
+
+    for (unsigned i = 0; i < n_triangles; ++i) {
+        // walk down from the root, the bits of the id say which half is taken on each level
+        auto id = i + 2;
+        glm::uvec2 a = {}, b = {}, c = {};
+        if (id & 1) {
+            b = glm::uvec2(tile_size); // north east root
+            c = { tile_size, 0 };
+        } else {
+            a = glm::uvec2(tile_size); // south west root
+            c = { 0, tile_size };
+        }
+        while ((id >>= 1) > 1) {
+            const auto m = glm::uvec2((a.x + b.x) / 2, (a.y + b.y) / 2);
+            if (id & 1) {
+                b = a;
+                a = c;
+            } else {
+                a = b;
+                b = c;
+            }
+            c = m;
+        }
+        m_triangles[i] = { uint16_t(a.x), uint16_t(a.y), uint16_t(b.x), uint16_t(b.y) };
+    }
+
+    const auto strip = terrain_mesh_index_generator::surface_quads_with_curtains<uint32_t>(vertex_side_length);
+    const auto list = vertex_cache::strip_to_list(strip);
+    const auto n_surface_vertices = vertex_side_length * vertex_side_length;
+    for (size_t i = 0; i < list.size(); i += 3) {
+        if (list[i] >= n_surface_vertices || list[i + 1] >= n_surface_vertices || list[i + 2] >= n_surface_vertices)
+            m_curtains.insert(m_curtains.end(), &list[i], &list[i] + 3);
+    }
+}
+
+std::vector<float> Rtin::errors(const Raster<uint16_t>& heights) const
+{
+    assert(heights.width() == m_size && heights.height() == m_size);
+    const auto size = m_size;
+    std::vector<float> errors(heights.buffer().size(), 0.0f);
+
+    // the infinite error of the border vertices is propagated like any other, so all triangles touching the border are split down to
+    // the finest level.
+    constexpr auto infinity = std::numeric_limits<float>::infinity();
+    for (unsigned i = 0; i < size; ++i) {
+        errors[i] = infinity;
+        errors[(size - 1) * size + i] = infinity;
+        errors[i * size] = infinity;
+        errors[i * size + size - 1] = infinity;
+    }
+
+    // smallest triangles first, so that the errors of the children are final when their parent is processed
+    const auto& h = heights.buffer();
+    std::vector<float> triangle_errors(m_triangles.size(), 0.0f);
+    for (auto i = unsigned(m_triangles.size()); i-- > 0;) {
+        const auto& t = m_triangles[i];
+        const unsigned ax = t.ax, ay = t.ay, bx = t.bx, by = t.by;
+        const auto mx = (ax + bx) / 2;
+        const auto my = (ay + by) / 2;
+        const auto middle = my * size + mx;
+        const auto interpolated = (float(h[ay * size + ax]) + float(h[by * size + bx])) * 0.5f;
+        // the error of the smallest triangles is just that of the midpoint, they don't contain other vertices
+        auto error = std::abs(interpolated - float(h[middle]));
+
+        if (i < m_n_parent_triangles) {
+            // the children deviate from the plane of this triangle by at most the error at the midpoint, which gives an upper bound.
+            // the exact error is only computed if it can be smaller and the triangle can be merged at all.
+            // ids are the path from the root, least significant bit first, behind a leading 1. children add a bit in front of the path.
+            const auto id = i + 2;
+            const auto top = std::bit_floor(id);
+            const auto children_error = std::max(triangle_errors[id + top - 2], triangle_errors[id + 2 * top - 2]);
+            const auto cx = mx + my - ay;
+            const auto cy = my + ax - mx;
+            if (children_error > 0 && errors[middle] != infinity)
+                error = std::min(error + children_error, triangle_error(heights, glm::ivec2(ax, ay), glm::ivec2(bx, by), glm::ivec2(cx, cy)));
+            else
+                error += children_error;
+
+            // the parent must be split whenever one of the children is
+            const auto left = ((ay + cy) / 2) * size + (ax + cx) / 2;
+            const auto right = ((by + cy) / 2) * size + (bx + cx) / 2;
+            errors[middle] = std::max({ errors[middle], errors[left], errors[right] });
+        }
+        triangle_errors[i] = error;
+        // the neighbour across the hypotenuse shares the midpoint, so both are split together
+        errors[middle] = std::max(errors[middle], error);
+    }
+    return errors;
+}
+
+Mesh Rtin::mesh(const std::vector<float>& errors, float max_error) const
+{
+    assert(errors.size() == size_t(m_size) * m_size);
+    Mesh mesh;
+    std::vector<uint8_t> is_used(errors.size(), 0);
+    Extraction extraction { errors, max_error, m_size, mesh.indices, is_used };
+
+    const auto max = int(m_size) - 1;
+    extraction.process({ 0, 0 }, { max, max }, { max, 0 });
+    extraction.process({ max, max }, { 0, 0 }, { 0, max });
+
+    mesh.n_surface_triangles = unsigned(mesh.indices.size() / 3);
+    mesh.n_surface_vertices = extraction.n_vertices;
+    mesh.indices.insert(mesh.indices.end(), m_curtains.begin(), m_curtains.end());
+    return mesh;
+}
+
+float max_error(const Raster<uint16_t>& heights, std::span<const uint32_t> triangle_list)
+{
+    assert(triangle_list.size() % 3 == 0);
+    assert(heights.width() == heights.height());
+    const auto size = heights.width();
+    const auto n_surface_vertices = size * size;
+    const auto position = [&](uint32_t v) { return glm::ivec2(v % size, v / size); };
+
+    float error = 0;
+    for (size_t i = 0; i < triangle_list.size(); i += 3) {
+        const auto a = triangle_list[i];
+        const auto b = triangle_list[i + 1];
+        const auto c = triangle_list[i + 2];
+        if (a >= n_surface_vertices || b >= n_surface_vertices || c >= n_surface_vertices)
+            continue;
+        error = std::max(error, triangle_error(heights, position(a), position(b), position(c)));
+    }
+    return error;
+}
+
+} // namespace nucleus::utils::terrain_simplification
@@ -0,0 +1,76 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <nucleus/Raster.h>
+#include <span>
+#include <vector>
+
+// adaptive simplification of the regular tile grid (see terrain_mesh_index_generator.h).
+// the output uses the vertex ids of the full grid, so the tile shaders and vertex layout stay the same; only the index buffer changes.
+namespace nucleus::utils::terrain_simplification {
+
+struct Mesh {
+    std::vector<uint32_t> indices; // triangle list, the simplified surface followed by the curtains. same winding order as the strip.
+    unsigned n_surface_triangles = 0;
+    unsigned n_surface_vertices = 0; // grid vertices that are referenced by the surface
+};
+
+// Right-triangulated irregular network (RTIN, Evans et al., Right-triangulated irregular networks, 2001; the formulation follows
+// mapbox/martini). The grid is covered by a binary tree of right isosceles triangles, which are split at the midpoint of their
+// hypotenuse. Errors are propagated up the tree, so that any error threshold gives a triangulation without t-junctions.
+//
+// All border vertices are kept, i.e., the tile border is identical to the full grid. Neighbouring tiles and the curtains therefore
+// stay watertight, independently of how much the neighbours are simplified.
+//
+// The triangle hierarchy only depends on the grid size, so one instance can be shared by all tiles (and threads).
+class Rtin {
+public:
+    // vertex_side_length must be 2^k + 1, e.g., 65
+    explicit Rtin(unsigned vertex_side_length);
+
+    [[nodiscard]] unsigned vertex_side_length() const { return m_size; }
+
+    // per vertex error in raster units. triangles are split at the midpoint of their hypotenuse if the error there is above the threshold.
+    // it is the largest vertical distance between the heights and the unsplit triangles on both sides of the hypotenuse, or any error
+    // further down the tree. border vertices have an infinite error.
+    [[nodiscard]] std::vector<float> errors(const Raster<uint16_t>& heights) const;
+
+    // triangulation, where no triangle deviates from the heights by more than max_error (in raster units).
+    [[nodiscard]] Mesh mesh(const std::vector<float>& errors, float max_error) const;
+
+    [[nodiscard]] Mesh simplify(const Raster<uint16_t>& heights, float max_error) const { return mesh(errors(heights), max_error); }
+
+private:
+    struct Hypotenuse {
+        uint16_t ax, ay, bx, by;
+    };
+    unsigned m_size;
+    std::vector<Hypotenuse> m_triangles; // the tree is stored breadth first, without the 2 roots
+    unsigned m_n_parent_triangles;
+    std::vector<uint32_t> m_curtains; // triangle list
+};
+
+// largest vertical distance between the heights at the grid vertices and the surface triangles of the given list (in raster units).
+// curtain triangles are ignored.
+[[nodiscard]] float max_error(const Raster<uint16_t>& heights, std::span<const uint32_t> triangle_list);
+
+} // namespace nucleus::utils::terrain_simplification
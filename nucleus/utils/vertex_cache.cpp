@@ -0,0 +1,226 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "vertex_cache.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace nucleus::utils::vertex_cache {
+
+namespace {
+    bool is_degenerate(uint32_t a, uint32_t b, uint32_t c) { return a == b || b == c || a == c; }
+
+    // constants from the paper
+    constexpr float cache_decay_power = 1.5f;
+    constexpr float last_triangle_score = 0.75f;
+    constexpr float valence_boost_scale = 2.0f;
+    constexpr float valence_boost_power = 0.5f;
+
+    float vertex_score(int cache_position, unsigned n_remaining_triangles, unsigned cache_size)
+    {
+        if (n_remaining_triangles == 0)
+            return -1.0f; // not used by any triangle any more
+        float score = 0.0f;
+        if (cache_position >= 0) {
+            // the vertices of the last triangle get a fixed score, so that the next triangle doesn't just reuse 2 of its vertices
+            if (cache_position < 3)
+                score = last_triangle_score;
+            else
+                score = std::pow(1.0f - float(cache_position - 3) / float(cache_size - 3), cache_decay_power);
+        }
+        // vertices with few remaining triangles are preferred, so that they can leave the cache for good
+        return score + valence_boost_scale * std::pow(float(n_remaining_triangles), -valence_boost_power);
+    }
+} // namespace
+
+Statistics simulate_fifo(std::span<const uint32_t> indices, Topology topology, unsigned cache_size)
+{
+    assert(cache_size > 0);
+    Statistics stats;
+    if (indices.empty())
+        return stats;
+
+    constexpr auto empty = std::numeric_limits<uint32_t>::max();
+    const auto n_vertices = size_t(*std::max_element(indices.begin(), indices.end())) + 1;
+    std::vector<uint8_t> in_cache(n_vertices, 0);
+    std::vector<uint8_t> seen(n_vertices, 0);
+    std::vector<uint32_t> fifo(cache_size, empty);
+    size_t fifo_head = 0;
+
+    for (const auto v : indices) {
+        if (!seen[v]) {
+            seen[v] = 1;
+            ++stats.n_unique_vertices;
+        }
+        if (in_cache[v])
+            continue;
+        ++stats.n_transformed_vertices;
+        if (fifo[fifo_head] != empty)
+            in_cache[fifo[fifo_head]] = 0;
+        fifo[fifo_head] = v;
+        in_cache[v] = 1;
+        fifo_head = (fifo_head + 1) % cache_size;
+    }
+
+    if (topology == Topology::TriangleList) {
+        assert(indices.size() % 3 == 0);
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            stats.n_triangles += is_degenerate(indices[i], indices[i + 1], indices[i + 2]) ? 0 : 1;
+    } else {
+        for (size_t i = 0; i + 2 < indices.size(); ++i)
+            stats.n_triangles += is_degenerate(indices[i], indices[i + 1], indices[i + 2]) ? 0 : 1;
+    }
+    if (stats.n_triangles > 0)
+        stats.acmr = double(stats.n_transformed_vertices) / stats.n_triangles;
+    stats.atvr = double(stats.n_transformed_vertices) / stats.n_unique_vertices;
+    return stats;
+}
+
+std::vector<uint32_t> strip_to_list(std::span<const uint32_t> strip)
+{
+    std::vector<uint32_t> list;
+    if (strip.size() < 3)
+        return list;
+    list.reserve((strip.size() - 2) * 3);
+    for (size_t i = 0; i + 2 < strip.size(); ++i) {
+        const auto a = strip[i];
+        const auto b = strip[i + 1];
+        const auto c = strip[i + 2];
+        if (is_degenerate(a, b, c))
+            continue;
+        // every second triangle of a strip has its first two vertices swapped, otherwise the winding order would alternate
+        if (i % 2 == 0)
+            list.insert(list.end(), { a, b, c });
+        else
+            list.insert(list.end(), { b, a, c });
+    }
+    return list;
+}
+
+std::vector<uint32_t> forsyth_order(std::span<const uint32_t> triangle_list, unsigned n_vertices, unsigned cache_size)
+{
+    assert(triangle_list.size() % 3 == 0);
+    assert(cache_size > 3);
+    const auto n_triangles = triangle_list.size() / 3;
+
+    // vertex -> triangle adjacency. the first n_remaining[v] entries of a vertex are the triangles that aren't in the output yet.
+    std::vector<uint32_t> n_remaining(n_vertices, 0);
+    for (const auto v : triangle_list) {
+        assert(v < n_vertices);
+        ++n_remaining[v];
+    }
+    std::vector<uint32_t> adjacency_offset(size_t(n_vertices) + 1, 0);
+    for (unsigned v = 0; v < n_vertices; ++v)
+        adjacency_offset[v + 1] = adjacency_offset[v] + n_remaining[v];
+    std::vector<uint32_t> adjacency(triangle_list.size());
+    {
+        std::vector<uint32_t> cursor(adjacency_offset.begin(), adjacency_offset.end() - 1);
+        for (size_t i = 0; i < triangle_list.size(); ++i)
+            adjacency[cursor[triangle_list[i]]++] = uint32_t(i / 3);
+    }
+
+    std::vector<int> cache_position(n_vertices, -1);
+    std::vector<float> vertex_scores(n_vertices);
+    for (unsigned v = 0; v < n_vertices; ++v)
+        vertex_scores[v] = vertex_score(-1, n_remaining[v], cache_size);
+    const auto triangle_score = [&](size_t t) {
+        return vertex_scores[triangle_list[t * 3]] + vertex_scores[triangle_list[t * 3 + 1]] + vertex_scores[triangle_list[t * 3 + 2]];
+    };
+    std::vector<uint8_t> is_added(n_triangles, 0);
+
+    std::vector<uint32_t> cache; // most recent first
+    std::vector<uint32_t> new_cache;
+    cache.reserve(cache_size + 3);
+    new_cache.reserve(cache_size + 3);
+    std::vector<uint32_t> ordered;
+    ordered.reserve(triangle_list.size());
+
+    int64_t best = -1;
+    float best_score = -1.0f;
+    for (size_t t = 0; t < n_triangles; ++t) {
+        if (triangle_score(t) > best_score) {
+            best_score = triangle_score(t);
+            best = int64_t(t);
+        }
+    }
+    size_t dead_end_cursor = 0;
+
+    for (size_t i = 0; i < n_triangles; ++i) {
+        if (best < 0) {
+            // nothing in the cache has triangles left, continue with the next triangle in input order
+            while (is_added[dead_end_cursor])
+                ++dead_end_cursor;
+            best = int64_t(dead_end_cursor);
+        }
+        const auto triangle = size_t(best);
+        is_added[triangle] = 1;
+        const auto* vertices = &triangle_list[triangle * 3];
+        ordered.insert(ordered.end(), vertices, vertices + 3);
+
+        for (unsigned j = 0; j < 3; ++j) {
+            const auto v = vertices[j];
+            auto* begin = &adjacency[adjacency_offset[v]];
+            auto* end = begin + n_remaining[v];
+            auto* it = std::find(begin, end, uint32_t(triangle)); // vertices that appear twice have two entries
+            assert(it != end);
+            std::swap(*it, *(end - 1));
+            --n_remaining[v];
+        }
+
+        // the vertices of the triangle go to the front of the cache
+        new_cache.clear();
+        for (unsigned j = 0; j < 3; ++j) {
+            if (std::find(new_cache.begin(), new_cache.end(), vertices[j]) == new_cache.end())
+                new_cache.push_back(vertices[j]);
+        }
+        for (const auto v : cache) {
+            if (v != vertices[0] && v != vertices[1] && v != vertices[2])
+                new_cache.push_back(v);
+        }
+        for (size_t j = 0; j < new_cache.size(); ++j) {
+            const auto v = new_cache[j];
+            cache_position[v] = j < cache_size ? int(j) : -1;
+            vertex_scores[v] = vertex_score(cache_position[v], n_remaining[v], cache_size);
+        }
+
+        // only triangles of vertices whose score changed need a new score, and the best one of them is next
+        best = -1;
+        best_score = -1.0f;
+        for (const auto v : new_cache) {
+            const auto* begin = &adjacency[adjacency_offset[v]];
+            for (const auto* it = begin; it != begin + n_remaining[v]; ++it) {
+                const auto t = *it;
+                const auto score = triangle_score(t);
+                if (score > best_score) {
+                    best_score = score;
+                    best = t;
+                }
+            }
+        }
+
+        if (new_cache.size() > cache_size)
+            new_cache.resize(cache_size);
+        std::swap(cache, new_cache);
+    }
+    return ordered;
+}
+
+} // namespace nucleus::utils::vertex_cache
@@ -0,0 +1,49 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// tools for ordering index buffers for the post-transform vertex cache of the gpu, and for measuring how well an order does.
+namespace nucleus::utils::vertex_cache {
+
+enum class Topology { TriangleList, TriangleStrip };
+
+struct Statistics {
+    unsigned n_triangles = 0; // without degenerate triangles
+    unsigned n_unique_vertices = 0;
+    unsigned n_transformed_vertices = 0; // cache misses
+    double acmr = 0; // average cache miss ratio: transformed vertices per triangle. 0.5 is optimal for large regular grids, 3 is the worst case
+    double atvr = 0; // average transform to vertex ratio: transformed vertices per unique vertex. 1 is optimal
+};
+
+// simulates a fifo post-transform cache of the given size (a reasonable model for most desktop and mobile gpus).
+// strips are fed to the cache index by index, just like the input assembler does it.
+Statistics simulate_fifo(std::span<const uint32_t> indices, Topology topology, unsigned cache_size = 32);
+
+// converts a triangle strip into a list, preserving the winding order. degenerate triangles are dropped.
+std::vector<uint32_t> strip_to_list(std::span<const uint32_t> strip);
+
+// reorders the triangles of a triangle list for the vertex cache (Tom Forsyth, Linear-Speed Vertex Cache Optimisation, 2006).
+// the vertices of each triangle stay in place, i.e., the winding order is preserved. runs in linear time.
+std::vector<uint32_t> forsyth_order(std::span<const uint32_t> triangle_list, unsigned n_vertices, unsigned cache_size = 32);
+
+} // namespace nucleus::utils::vertex_cache
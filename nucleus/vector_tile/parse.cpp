@@ -36,8 +36,6 @@ nucleus::vector_tile::PointOfInterest::Type type_from_layer_name(const std::stri
     assert(false);
     return nucleus::vector_tile::PointOfInterest::Type::Unknown;
 }
-
-static std::atomic_int32_t s_number_of_pois = {};
 } // namespace
 
 nucleus::vector_tile::PointOfInterestCollection nucleus::vector_tile::parse::points_of_interest(
@@ -62,7 +60,6 @@ nucleus::vector_tile::PointOfInterestCollection nucleus::vector_tile::parse::poi
             auto props = feature.getProperties();
 
             PointOfInterest poi;
-            poi.id = s_number_of_pois.fetch_add(1);
             poi.type = type;
             poi.name = QString::fromStdString(get<std::string>(props["name"]));
             const auto lat_long = glm::dvec2(get<double>(props["lat"]), get<double>(props["long"]));
@@ -75,12 +72,11 @@ nucleus::vector_tile::PointOfInterestCollection nucleus::vector_tile::parse::poi
                 if (r) {
                     altitude = r.value();
                 } else {
-                    qWarning() << r.error() << QString(" (name: %1, id: %2, type: %3).").arg(poi.name).arg(poi.id).arg(unsigned(poi.type));
+                    qWarning() << r.error() << QString(" (name: %1, type: %2).").arg(poi.name).arg(unsigned(poi.type));
                 }
             }
 
             poi.lat_long_alt = glm::dvec3(lat_long.x, lat_long.y, altitude);
-            poi.world_space_pos = nucleus::srs::lat_long_alt_to_world(poi.lat_long_alt);
 
             for (const auto& property : props) {
                 const auto name = property.first;
@@ -95,5 +91,18 @@ nucleus::vector_tile::PointOfInterestCollection nucleus::vector_tile::parse::poi
         }
     }
 
+    // world space positions in one batch (structure of arrays)
+    std::vector<double> x(pois.size());
+    std::vector<double> y(pois.size());
+    std::vector<double> z(pois.size());
+    for (size_t i = 0; i < pois.size(); ++i) {
+        x[i] = pois[i].lat_long_alt.x;
+        y[i] = pois[i].lat_long_alt.y;
+        z[i] = pois[i].lat_long_alt.z;
+    }
+    nucleus::srs::lat_long_alt_to_world(x, y, z);
+    for (size_t i = 0; i < pois.size(); ++i)
+        pois[i].world_space_pos = glm::dvec3(x[i], y[i], z[i]);
+
     return pois;
 }
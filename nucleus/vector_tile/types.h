@@ -35,7 +35,8 @@ struct PointOfInterest {
 public:
     enum class Type { Unknown = 0, Peak, Settlement, AlpineHut, Webcam, NumberOfElements };
     Q_ENUM(Type)
-    uint64_t id = UINT64_MAX;
+    // pick id, assigned by map_label::Scheduler (see picker::SlotTable). 0 (SlotTable::invalid_id) if the poi has none, it is not pickable then.
+    uint64_t id = 0;
     Type type = Type::Unknown;
     QString name;
     glm::dvec3 lat_long_alt = glm::dvec3(0);
@@ -131,7 +131,7 @@ int main(int argc, char** argv)
 
     auto geometry_scheduler = nucleus::tile::setup::geometry_scheduler(std::move(terrain_service), decorator, &scheduler_thread);
     director.check_in("geometry", geometry_scheduler.scheduler);
-    auto data_querier = std::make_shared<DataQuerier>(&geometry_scheduler.scheduler->ram_cache());
+    auto data_querier = std::make_shared<DataQuerier>(&geometry_scheduler.scheduler->ram_cache(), decorator);
 
     auto ortho_scheduler = nucleus::tile::setup::texture_scheduler(std::move(ortho_service), decorator, &scheduler_thread);
     director.check_in("ortho", ortho_scheduler.scheduler);
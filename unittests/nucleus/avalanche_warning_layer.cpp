@@ -19,9 +19,11 @@
 
 #include "test_helpers.h"
 #include <QFile>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <QSignalSpy>
 #include <catch2/catch_test_macros.hpp>
 #include <extern/radix/src/radix/tile.h>
+#include <nucleus/avalanche/RegionGeometryStore.h>
 #include <nucleus/avalanche/ReportLoadService.h>
 #include <nucleus/avalanche/Scheduler.h>
 #include <nucleus/avalanche/UIntIdManager.h>
@@ -31,6 +33,7 @@
 #include <nucleus/tile/types.h>
 #include <nucleus/tile/utils.h>
 #include <nucleus/utils/image_loader.h>
+#include <thread>
 
 TEST_CASE("nucleus/EAWS Vector Tiles")
 {
@@ -296,7 +299,8 @@ TEST_CASE("nucleus/avalanche/Scheduler")
 
         // use "to_raster" on quad and compare result to previously loaded tile rasters
         nucleus::Raster<glm::uint16> default_raster(glm::uvec2(256, 256), glm::uint16 { 255 });
-        const auto joined = nucleus::avalanche::Scheduler::to_raster(quad, default_raster, id_manager);
+        nucleus::avalanche::RegionGeometryStore region_store(id_manager, 256);
+        const auto joined = nucleus::avalanche::Scheduler::to_raster(quad, default_raster, region_store);
         REQUIRE(joined.width() == 512);
         REQUIRE(joined.height() == 512);
         for (int i = 0; i < 4; i++) {
@@ -312,4 +316,201 @@ TEST_CASE("nucleus/avalanche/Scheduler")
         CHECK(joined.pixel(glm::uvec2(256, 255)) == rasters[3].pixel(glm::uvec2(0, 0)));
         CHECK(joined.pixel(glm::uvec2(511, 511)) == rasters[3].pixel(glm::uvec2(255, 255)));
     }
+
+    SECTION("rasterize_regions_into agrees with QPainter path")
+    {
+        QDate refDate(2025, 7, 1);
+        std::shared_ptr<nucleus::avalanche::UIntIdManager> id_manager = std::make_shared<nucleus::avalanche::UIntIdManager>(refDate);
+        const radix::tile::Id tile_id = { 6, { 33, 22 }, radix::tile::Scheme::SlippyMap };
+        const auto region_tile = load_tile_from_file("eaws_6-33-22.mvt", tile_id).second;
+        const auto reference = rasterize_regions(region_tile, id_manager, 256, 256, tile_id);
+
+        nucleus::Raster<uint16_t> raster({ 512, 256 }, uint16_t(0));
+        const auto internal_ids = nucleus::avalanche::internal_region_ids(region_tile, *id_manager);
+        REQUIRE(internal_ids.size() == region_tile.second.size());
+        nucleus::avalanche::rasterize_regions_into(region_tile, internal_ids, tile_id, raster, { 256, 0 }, { 256, 256 });
+
+        // QPainter additionally strokes the outline with a 1 pixel pen, the scanline rasteriser doesn't (see eaws.h). Hence pixels may only
+        // differ where the reference has a region boundary in their 3x3 neighbourhood.
+        const auto is_near_boundary = [&](unsigned x, unsigned y) {
+            for (unsigned ny = std::max(y, 1u) - 1; ny <= std::min(y + 1, 255u); ++ny) {
+                for (unsigned nx = std::max(x, 1u) - 1; nx <= std::min(x + 1, 255u); ++nx) {
+                    if (reference.pixel({ nx, ny }) != reference.pixel({ x, y }))
+                        return true;
+                }
+            }
+            return false;
+        };
+        unsigned n_different = 0;
+        for (unsigned y = 0; y < 256; ++y) {
+            for (unsigned x = 0; x < 256; ++x) {
+                CHECK(raster.pixel({ x, y }) == 0);
+                if (raster.pixel({ x + 256, y }) == reference.pixel({ x, y }))
+                    continue;
+                ++n_different;
+                CHECK(is_near_boundary(x, y));
+            }
+        }
+        CHECK(n_different < 256 * 256 / 20);
+    }
+}
+
+TEST_CASE("nucleus/avalanche/RegionGeometryStore")
+{
+    using nucleus::avalanche::RegionGeometryStore;
+    std::shared_ptr<nucleus::avalanche::UIntIdManager> id_manager = std::make_shared<nucleus::avalanche::UIntIdManager>(QDate(2025, 7, 1));
+
+    SECTION("simplify_polygon")
+    {
+        // square with collinear points on its edges
+        const std::vector<glm::dvec2> polygon = { { 0, 0 }, { 0.5, 0 }, { 1, 0 }, { 1, 0.5 }, { 1, 1 }, { 0.5, 1.001 }, { 0, 1 }, { 0, 0.5 } };
+        const auto simplified = nucleus::avalanche::detail::simplify_polygon(polygon, 0.01);
+        REQUIRE(simplified.size() == 4);
+        CHECK(simplified[0] == glm::dvec2(0, 0));
+        CHECK(simplified[1] == glm::dvec2(1, 0));
+        CHECK(simplified[2] == glm::dvec2(1, 1));
+        CHECK(simplified[3] == glm::dvec2(0, 1));
+
+        CHECK(nucleus::avalanche::detail::simplify_polygon(polygon, 0.0001).size() == 5);
+    }
+
+    SECTION("ingest and look up")
+    {
+        RegionGeometryStore store(id_manager, 256);
+        const radix::tile::Id tile_id = { 6, { 33, 22 }, radix::tile::Scheme::SlippyMap };
+        CHECK(!store.covering_source(tile_id).has_value());
+        REQUIRE(store.ingest(load_raw_data_from_file("eaws_6-33-22.mvt"), tile_id));
+        CHECK(store.n_source_tiles() == 1);
+        CHECK(store.n_regions() > 0);
+        CHECK(!store.ingest(QByteArray("garbage"), { 7, { 66, 44 }, radix::tile::Scheme::SlippyMap }));
+        CHECK(store.n_source_tiles() == 1);
+
+        // extent 4096, 256 pixels per tile -> source is good for 4 zoom levels (at least 2 mvt units per pixel)
+        REQUIRE(store.source(tile_id));
+        CHECK(store.source(tile_id)->max_zoom_level == 9);
+        CHECK(store.covering_source(tile_id) == tile_id);
+        CHECK(store.covering_source({ 7, { 66, 44 }, radix::tile::Scheme::SlippyMap }) == tile_id);
+        CHECK(store.covering_source({ 9, { 33 * 8 + 7, 22 * 8 + 7 }, radix::tile::Scheme::SlippyMap }) == tile_id);
+        CHECK(!store.covering_source({ 10, { 33 * 16, 22 * 16 }, radix::tile::Scheme::SlippyMap }).has_value());
+        CHECK(!store.covering_source({ 7, { 0, 0 }, radix::tile::Scheme::SlippyMap }).has_value());
+
+        // region ids are the key, bounds are in normalised slippy map coordinates
+        for (const auto& piece : store.source(tile_id)->pieces) {
+            const auto* region = store.region(piece.region->id);
+            REQUIRE(region);
+            CHECK(region == piece.region);
+            CHECK(region->internal_id == id_manager->convert_region_id_to_internal_id(region->id));
+            CHECK(region->bounds.min.x <= piece.bounds.min.x);
+            CHECK(region->bounds.max.y >= piece.bounds.max.y);
+            CHECK(piece.simplified_polygons.size() == 4);
+            // coarser levels have fewer vertices
+            CHECK(piece.simplified_polygons.front().size() <= piece.simplified_polygons.back().size());
+        }
+    }
+
+    SECTION("rasterising from a coarser source agrees with parsing the tile itself")
+    {
+        RegionGeometryStore store(id_manager, 256);
+        const radix::tile::Id parent_id = { 6, { 33, 22 }, radix::tile::Scheme::SlippyMap };
+        REQUIRE(store.ingest(load_raw_data_from_file("eaws_6-33-22.mvt"), parent_id));
+
+        const radix::tile::Id tile_id = { 7, { 66, 45 }, radix::tile::Scheme::SlippyMap };
+        const auto region_tile = load_tile_from_file("eaws_7-66-45.mvt", tile_id).second;
+        nucleus::Raster<uint16_t> reference({ 256, 256 }, uint16_t(0));
+        nucleus::avalanche::rasterize_regions_into(
+            region_tile, nucleus::avalanche::internal_region_ids(region_tile, *id_manager), tile_id, reference, { 0, 0 }, { 256, 256 });
+
+        nucleus::Raster<uint16_t> raster({ 256, 256 }, uint16_t(0));
+        store.rasterize(parent_id, tile_id, raster, { 0, 0 }, { 256, 256 });
+
+        unsigned n_equal = 0;
+        for (unsigned i = 0; i < raster.buffer_length(); ++i)
+            n_equal += raster.buffer()[i] == reference.buffer()[i];
+        CHECK(n_equal > 256 * 256 * 95 / 100);
+    }
+
+    SECTION("eviction")
+    {
+        RegionGeometryStore store(id_manager, 256, 2);
+        REQUIRE(store.ingest(load_raw_data_from_file("eaws_7-66-44.mvt"), { 7, { 66, 44 }, radix::tile::Scheme::SlippyMap }));
+        REQUIRE(store.ingest(load_raw_data_from_file("eaws_7-66-45.mvt"), { 7, { 66, 45 }, radix::tile::Scheme::SlippyMap }));
+        REQUIRE(store.ingest(load_raw_data_from_file("eaws_7-67-44.mvt"), { 7, { 67, 44 }, radix::tile::Scheme::SlippyMap }));
+        CHECK(store.n_source_tiles() == 2);
+        CHECK(!store.source({ 7, { 66, 44 }, radix::tile::Scheme::SlippyMap }));
+        for (const auto& source_id : { radix::tile::Id { 7, { 66, 45 }, radix::tile::Scheme::SlippyMap }, radix::tile::Id { 7, { 67, 44 }, radix::tile::Scheme::SlippyMap } }) {
+            REQUIRE(store.source(source_id));
+            for (const auto& piece : store.source(source_id)->pieces) {
+                REQUIRE(store.region(piece.region->id));
+                CHECK(std::find(piece.region->sources.begin(), piece.region->sources.end(), radix::tile::Id { 7, { 66, 44 }, radix::tile::Scheme::SlippyMap })
+                    == piece.region->sources.end());
+            }
+        }
+    }
+}
+
+TEST_CASE("nucleus/avalanche/Scheduler benchmarks")
+{
+    QDate refDate(2025, 7, 1);
+    std::shared_ptr<nucleus::avalanche::UIntIdManager> id_manager = std::make_shared<nucleus::avalanche::UIntIdManager>(refDate);
+    nucleus::tile::DataQuad quad;
+    quad.id = radix::tile::Id { 6, { 33, 22 }, radix::tile::Scheme::SlippyMap };
+    std::array<nucleus::avalanche::RegionTile, 4> region_tiles;
+    unsigned int idx = 0;
+    for (radix::tile::Id tile_id : quad.id.children()) {
+        QString file_name = QString("eaws_%1-%2-%3.mvt").arg(tile_id.zoom_level).arg(tile_id.coords.x).arg(tile_id.coords.y);
+        auto data_and_tile = load_tile_from_file(file_name.toStdString(), tile_id);
+        region_tiles[idx] = data_and_tile.second;
+        quad.tiles[idx].id = tile_id;
+        quad.tiles[idx].data = std::make_shared<QByteArray>(std::move(data_and_tile.first));
+        quad.tiles[idx].network_info = { nucleus::tile::NetworkInfo::Status::Good, 12345 };
+        ++idx;
+    }
+    quad.n_tiles = 4;
+    const nucleus::Raster<glm::uint16> default_raster(glm::uvec2(256, 256), glm::uint16 { 0 });
+
+    BENCHMARK("rasterise 4 tiles with QPainter")
+    {
+        std::array<nucleus::Raster<uint16_t>, 4> rasters;
+        for (unsigned i = 0; i < 4; ++i)
+            rasters[i] = rasterize_regions(region_tiles[i], id_manager, 256, 256, region_tiles[i].first);
+        return rasters;
+    };
+
+    BENCHMARK("rasterise 4 tiles with scanline rasteriser")
+    {
+        nucleus::Raster<uint16_t> raster({ 512, 512 }, uint16_t(0));
+        for (unsigned i = 0; i < 4; ++i) {
+            const auto internal_ids = nucleus::avalanche::internal_region_ids(region_tiles[i], *id_manager);
+            nucleus::avalanche::rasterize_regions_into(region_tiles[i], internal_ids, region_tiles[i].first, raster, { (i % 2) * 256, (i / 2) * 256 }, { 256, 256 });
+        }
+        return raster;
+    };
+
+    BENCHMARK("rasterise 4 tiles concurrently with scanline rasteriser")
+    {
+        nucleus::Raster<uint16_t> raster({ 512, 512 }, uint16_t(0));
+        // the id manager is not thread safe, ids are resolved upfront
+        std::array<std::vector<uint16_t>, 4> internal_ids;
+        for (unsigned i = 0; i < 4; ++i)
+            internal_ids[i] = nucleus::avalanche::internal_region_ids(region_tiles[i], *id_manager);
+        std::vector<std::thread> threads;
+        for (unsigned i = 0; i < 4; ++i) {
+            threads.emplace_back([&, i]() {
+                nucleus::avalanche::rasterize_regions_into(region_tiles[i], internal_ids[i], region_tiles[i].first, raster, { (i % 2) * 256, (i / 2) * 256 }, { 256, 256 });
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+        return raster;
+    };
+
+    BENCHMARK("to_raster into an empty region geometry store (parsing + scanline rasteriser)")
+    {
+        nucleus::avalanche::RegionGeometryStore cold_store(id_manager, 256);
+        return nucleus::avalanche::Scheduler::to_raster(quad, default_raster, cold_store);
+    };
+
+    nucleus::avalanche::RegionGeometryStore warm_store(id_manager, 256);
+    nucleus::avalanche::Scheduler::to_raster(quad, default_raster, warm_store);
+    BENCHMARK("to_raster from region geometry store") { return nucleus::avalanche::Scheduler::to_raster(quad, default_raster, warm_store); };
 }
@@ -0,0 +1,274 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <algorithm>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <set>
+
+#include <nucleus/map_label/InstanceAllocator.h>
+
+using namespace nucleus::map_label;
+using nucleus::tile::Id;
+using TileSet = nucleus::tile::DrawListGenerator::TileSet;
+
+namespace {
+Id tile(unsigned i) { return { 18, { 140000 + i % 64, 90000 + i / 64 } }; }
+
+// allocations don't overlap, and together with the free ranges they cover the whole capacity
+void check_consistency(const InstanceAllocator& allocator)
+{
+    std::vector<InstanceRange> ranges = allocator.free_ranges();
+    std::set<unsigned> slots;
+    unsigned n_allocated = 0;
+    for (const auto& [id, allocation] : allocator.allocations()) {
+        CHECK(allocation.slot > 0);
+        CHECK(allocation.slot < allocator.slot_capacity());
+        CHECK(slots.insert(allocation.slot).second);
+        n_allocated += allocation.range.count;
+        if (allocation.range.count > 0)
+            ranges.push_back(allocation.range);
+    }
+    CHECK(n_allocated == allocator.n_allocated_instances());
+    std::sort(ranges.begin(), ranges.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    unsigned next = 0;
+    for (const auto& r : ranges) {
+        CHECK(r.first == next);
+        next = r.end();
+    }
+    CHECK(next == allocator.capacity());
+
+    const auto& free_ranges = allocator.free_ranges();
+    for (size_t i = 1; i < free_ranges.size(); ++i)
+        CHECK(free_ranges[i - 1].end() < free_ranges[i].first); // coalesced
+}
+
+} // namespace
+
+TEST_CASE("nucleus/map_label/InstanceAllocator")
+{
+    SECTION("allocate and free")
+    {
+        InstanceAllocator allocator(100);
+        CHECK(allocator.capacity() == 100);
+        CHECK(allocator.n_tiles() == 0);
+        CHECK(allocator.free_ranges() == std::vector<InstanceRange> { { 0, 100 } });
+
+        const auto a = allocator.allocate(tile(0), 10, { 1, 2, 3 });
+        const auto b = allocator.allocate(tile(1), 20, {});
+        const auto c = allocator.allocate(tile(2), 30, {});
+        CHECK(a.range == InstanceRange { 0, 10 });
+        CHECK(b.range == InstanceRange { 10, 20 });
+        CHECK(c.range == InstanceRange { 30, 30 });
+        CHECK(a.reference_point == glm::dvec3(1, 2, 3));
+        CHECK(allocator.n_tiles() == 3);
+        CHECK(allocator.n_allocated_instances() == 60);
+        check_consistency(allocator);
+
+        REQUIRE(allocator.find(tile(1)));
+        CHECK(allocator.find(tile(1))->range == b.range);
+        CHECK(!allocator.find(tile(3)));
+
+        const auto freed = allocator.free(tile(1));
+        REQUIRE(freed);
+        CHECK(freed->range == b.range);
+        CHECK(!allocator.free(tile(1)));
+        CHECK(allocator.free_ranges() == std::vector<InstanceRange> { { 10, 20 }, { 60, 40 } });
+
+        // first fit
+        CHECK(allocator.allocate(tile(3), 15, {}).range == InstanceRange { 10, 15 });
+        CHECK(allocator.allocate(tile(4), 6, {}).range == InstanceRange { 60, 6 });
+        check_consistency(allocator);
+
+        allocator.free(tile(0));
+        allocator.free(tile(3));
+        allocator.free(tile(2));
+        allocator.free(tile(4));
+        CHECK(allocator.free_ranges() == std::vector<InstanceRange> { { 0, 100 } });
+        CHECK(allocator.n_allocated_instances() == 0);
+        CHECK(allocator.n_tiles() == 0);
+    }
+
+    SECTION("reallocating a tile replaces it")
+    {
+        InstanceAllocator allocator(100);
+        allocator.allocate(tile(0), 10, {});
+        allocator.allocate(tile(1), 10, {});
+        const auto a = allocator.allocate(tile(0), 5, {});
+        CHECK(a.range == InstanceRange { 0, 5 });
+        CHECK(allocator.n_tiles() == 2);
+        CHECK(allocator.n_allocated_instances() == 15);
+        check_consistency(allocator);
+    }
+
+    SECTION("tiles without labels get a slot, but no instances")
+    {
+        InstanceAllocator allocator(100);
+        const auto a = allocator.allocate(tile(0), 0, {});
+        CHECK(a.range.count == 0);
+        CHECK(a.slot > 0);
+        CHECK(allocator.free_ranges() == std::vector<InstanceRange> { { 0, 100 } });
+        CHECK(allocator.free(tile(0)));
+    }
+
+    SECTION("grows by doubling and keeps existing allocations")
+    {
+        InstanceAllocator allocator(16);
+        const auto a = allocator.allocate(tile(0), 10, {});
+        const auto b = allocator.allocate(tile(1), 10, {});
+        CHECK(allocator.capacity() == 32);
+        CHECK(b.range == InstanceRange { 10, 10 });
+        CHECK(allocator.find(tile(0))->range == a.range);
+        const auto c = allocator.allocate(tile(2), 100, {});
+        CHECK(allocator.capacity() == 128);
+        CHECK(c.range == InstanceRange { 20, 100 });
+        check_consistency(allocator);
+    }
+
+    SECTION("slots start at 1 and are reused")
+    {
+        InstanceAllocator allocator(100);
+        CHECK(allocator.slot_capacity() == 1);
+        CHECK(allocator.allocate(tile(0), 1, {}).slot == 1);
+        CHECK(allocator.allocate(tile(1), 1, {}).slot == 2);
+        CHECK(allocator.allocate(tile(2), 1, {}).slot == 3);
+        CHECK(allocator.slot_capacity() == 4);
+        allocator.free(tile(1));
+        CHECK(allocator.allocate(tile(3), 1, {}).slot == 2);
+        CHECK(allocator.slot_capacity() == 4);
+    }
+
+    SECTION("random allocations and frees")
+    {
+        InstanceAllocator allocator(64);
+        std::mt19937 rng(42);
+        for (unsigned i = 0; i < 2000; ++i) {
+            const auto id = tile(rng() % 200);
+            if (rng() % 3 == 0)
+                allocator.free(id);
+            else
+                allocator.allocate(id, rng() % 50, {});
+        }
+        check_consistency(allocator);
+        CHECK(allocator.slot_capacity() <= 201);
+    }
+}
+
+TEST_CASE("nucleus/map_label/InstanceAllocator visible ranges")
+{
+    InstanceAllocator allocator(1000);
+    // ranges: 0: [0, 10), 1: [10, 30), 2: [30, 60), 3: [60, 100), ...
+    for (unsigned i = 0; i < 8; ++i)
+        allocator.allocate(tile(i), 10 * (i + 1), {});
+    const auto range = [&](unsigned i) { return allocator.find(tile(i))->range; };
+
+    SECTION("nothing visible")
+    {
+        CHECK(visible_ranges(allocator, {}, 4).empty());
+        CHECK(visible_ranges(allocator, { tile(100) }, 4).empty());
+    }
+
+    SECTION("adjacent ranges are merged")
+    {
+        const auto ranges = visible_ranges(allocator, { tile(2), tile(0), tile(1) }, 4);
+        CHECK(ranges == std::vector<InstanceRange> { { 0, 60 } });
+    }
+
+    SECTION("separated ranges stay separate if the limit allows it")
+    {
+        const auto ranges = visible_ranges(allocator, { tile(5), tile(0), tile(3) }, 4);
+        CHECK(ranges == std::vector<InstanceRange> { range(0), range(3), range(5) });
+    }
+
+    SECTION("the smallest gaps are closed first")
+    {
+        // gaps: 0..3 is 50 instances (tiles 1 and 2), 3..5 is 50 (tile 4), 5..7 is 70 (tile 6)
+        const auto ranges = visible_ranges(allocator, { tile(0), tile(3), tile(5), tile(7) }, 2);
+        REQUIRE(ranges.size() == 2);
+        CHECK(ranges[0].first == range(0).first);
+        CHECK(ranges[0].end() == range(5).end());
+        CHECK(ranges[1] == range(7));
+
+        CHECK(visible_ranges(allocator, { tile(0), tile(3), tile(5), tile(7) }, 1) == std::vector<InstanceRange> { { 0, range(7).end() } });
+    }
+
+    SECTION("pack slots")
+    {
+        nucleus::Raster<glm::vec4> slots;
+        allocator.allocate(tile(3), 40, { 1000, 2000, 300 });
+        allocator.allocate(tile(20), 0, { 5, 5, 5 });
+        pack_slots(allocator, { tile(3), tile(20), tile(100) }, { 1000, 1000, 100 }, 4, slots);
+        CHECK(slots.width() == 4);
+        CHECK(slots.height() == (allocator.slot_capacity() + 3) / 4);
+        CHECK(slots.pixel({ 0, 0 }) == glm::vec4(0)); // slot 0 is never visible
+
+        for (const auto& [id, allocation] : allocator.allocations()) {
+            const auto texel = slots.pixel({ allocation.slot % 4, allocation.slot / 4 });
+            CHECK(glm::vec3(texel) == glm::vec3(allocation.reference_point - glm::dvec3(1000, 1000, 100)));
+            // tiles without labels are not visible either
+            CHECK(texel.w == ((id == tile(3)) ? 1.0f : 0.0f));
+        }
+    }
+}
+
+TEST_CASE("nucleus/map_label/InstanceAllocator benchmarks")
+{
+    // the label scheduler keeps up to 2048 tiles on the gpu, a typical view draws a few hundred of them
+    InstanceAllocator allocator;
+    std::mt19937 rng(42);
+    std::vector<unsigned> n_labels;
+    for (unsigned i = 0; i < 2048; ++i) {
+        n_labels.push_back(rng() % 60);
+        allocator.allocate(tile(i), n_labels.back(), { i * 100.0, i * 50.0, 1000.0 });
+    }
+    TileSet visible;
+    for (unsigned i = 0; i < 2048; ++i) {
+        if (rng() % 6 == 0)
+            visible.insert(tile(i));
+    }
+    const auto camera_position = glm::dvec3(50000, 20000, 2000);
+
+    BENCHMARK("per tile draw list (previous path)")
+    {
+        // what the per tile path did on the cpu: walk all tiles, test visibility, one (or two) draw calls with their own uniform per tile
+        std::vector<std::pair<InstanceRange, glm::vec3>> draws;
+        for (const auto& [id, allocation] : allocator.allocations()) {
+            if (!visible.contains(id) || allocation.range.count == 0)
+                continue;
+            draws.emplace_back(allocation.range, glm::vec3(allocation.reference_point - camera_position));
+        }
+        return draws.size();
+    };
+
+    nucleus::Raster<glm::vec4> slots;
+    BENCHMARK("visible ranges and slots (batched path)")
+    {
+        pack_slots(allocator, visible, camera_position, 256, slots);
+        return visible_ranges(allocator, visible, 4).size();
+    };
+
+    BENCHMARK("reallocate 64 tiles")
+    {
+        for (unsigned i = 0; i < 64; ++i) {
+            const auto index = unsigned(rng() % 2048);
+            allocator.allocate(tile(index), n_labels[index], {});
+        }
+        return allocator.capacity();
+    };
+}
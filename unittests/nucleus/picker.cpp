@@ -0,0 +1,241 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <unordered_map>
+
+#include <nucleus/picker/PickerManager.h>
+#include <nucleus/picker/SlotTable.h>
+
+using namespace nucleus;
+using picker::SlotTable;
+
+TEST_CASE("nucleus/picker/SlotTable")
+{
+    SECTION("insert, find, erase")
+    {
+        SlotTable<int> table;
+        CHECK(table.empty());
+        const auto a = table.insert(1);
+        const auto b = table.insert(2);
+        CHECK(a != SlotTable<int>::invalid_id);
+        CHECK(b != SlotTable<int>::invalid_id);
+        CHECK(a != b);
+        CHECK(a < (1u << 24));
+        CHECK(table.size() == 2);
+        REQUIRE(table.find(a));
+        CHECK(*table.find(a) == 1);
+        CHECK(*table.find(b) == 2);
+        CHECK(!table.contains(SlotTable<int>::invalid_id));
+
+        CHECK(table.erase(a));
+        CHECK(!table.erase(a));
+        CHECK(!table.contains(a));
+        CHECK(table.size() == 1);
+    }
+
+    SECTION("reused slots get a new generation")
+    {
+        SlotTable<int> table;
+        const auto a = table.insert(1);
+        table.erase(a);
+        const auto c = table.insert(3);
+        CHECK(SlotTable<int>::index(c) == SlotTable<int>::index(a));
+        CHECK(c != a);
+        CHECK(!table.contains(a)); // stale id
+        CHECK(!table.erase(a));
+        REQUIRE(table.find(c));
+        CHECK(*table.find(c) == 3);
+
+        // generation wraps around but skips 0, so the id never becomes invalid_id
+        auto id = c;
+        for (unsigned i = 0; i < 200; ++i) {
+            table.erase(id);
+            id = table.insert(int(i));
+            CHECK(id != SlotTable<int>::invalid_id);
+            CHECK(SlotTable<int>::generation(id) != 0);
+        }
+    }
+
+    SECTION("ids with bits beyond 24 are invalid")
+    {
+        SlotTable<int> table;
+        const auto a = table.insert(1);
+        CHECK(!table.contains(a | (1u << 24)));
+    }
+
+    SECTION("mirror")
+    {
+        SlotTable<int> allocator;
+        SlotTable<const char*> mirror;
+        const auto a = allocator.insert(0);
+        const auto b = allocator.insert(0);
+        mirror.assign(a, "a");
+        mirror.assign(b, "b");
+        CHECK(mirror.size() == 2);
+        CHECK(std::string(*mirror.find(a)) == "a");
+
+        // allocator reuses the slot of a before the mirror processed the removal
+        allocator.erase(a);
+        const auto c = allocator.insert(0);
+        mirror.assign(c, "c");
+        CHECK(!mirror.erase(a)); // stale removal doesn't touch c
+        CHECK(std::string(*mirror.find(c)) == "c");
+        CHECK(mirror.size() == 2);
+    }
+
+    SECTION("capacity")
+    {
+        SlotTable<uint8_t> table;
+        for (uint32_t i = 0; i < SlotTable<uint8_t>::max_size; ++i)
+            table.insert(1);
+        CHECK(table.size() == SlotTable<uint8_t>::max_size);
+        CHECK(table.insert(1) == SlotTable<uint8_t>::invalid_id);
+    }
+}
+
+TEST_CASE("nucleus/picker/PickerManager")
+{
+    SlotTable<tile::Id> allocator;
+    const auto make_tile = [&](const tile::Id& id, unsigned n_pois) {
+        vector_tile::PointOfInterestCollection pois(n_pois);
+        for (unsigned i = 0; i < n_pois; ++i) {
+            pois[i].id = allocator.insert(id);
+            pois[i].name = QString("poi %1").arg(i);
+            pois[i].type = vector_tile::PointOfInterest::Type::Peak;
+        }
+        return vector_tile::PoiTile { id, std::make_shared<const vector_tile::PointOfInterestCollection>(std::move(pois)) };
+    };
+    const auto pick_value = [](uint64_t id) { return (uint32_t(picker::FeatureType::PointOfInterest) << 24) | uint32_t(id); };
+
+    picker::PickerManager manager;
+    std::vector<picker::Feature> picked;
+    QObject::connect(&manager, &picker::PickerManager::pick_evaluated, [&](const picker::Feature& f) { picked.push_back(f); });
+
+    const auto tile_a = make_tile({ 10, { 1, 2 } }, 5);
+    const auto tile_b = make_tile({ 10, { 1, 3 } }, 3);
+    manager.update_quads({ tile_a, tile_b }, {});
+
+    manager.eval_pick(pick_value(tile_a.data->at(3).id));
+    REQUIRE(picked.size() == 1);
+    CHECK(picked.back().title == "poi 3");
+    CHECK(picked.back().properties["type"].toString() == "PoiPeak");
+
+    manager.eval_pick(pick_value(tile_b.data->at(0).id));
+    REQUIRE(picked.size() == 2);
+    CHECK(picked.back().title == "poi 0");
+
+    // removing tile a, its slots are reused by tile c
+    const auto stale_id = tile_a.data->at(3).id;
+    for (const auto& poi : *tile_a.data)
+        allocator.erase(uint32_t(poi.id));
+    const auto tile_c = make_tile({ 11, { 2, 4 } }, 5);
+    manager.update_quads({ tile_c }, { tile_a.id });
+    manager.eval_pick(pick_value(stale_id));
+    CHECK(picked.size() == 2); // stale, not found
+
+    manager.eval_pick(pick_value(tile_c.data->at(4).id));
+    REQUIRE(picked.size() == 3);
+    CHECK(picked.back().title == "poi 4");
+
+    // tile b is sent again without a delete in between (like map_label::Scheduler does when it ships a tile again), its previous ids are stale
+    for (const auto& poi : *tile_b.data)
+        allocator.erase(uint32_t(poi.id));
+    const auto tile_b_again = make_tile(tile_b.id, 1);
+    manager.update_quads({ tile_b_again }, {});
+    for (const auto& poi : *tile_b.data)
+        manager.eval_pick(pick_value(poi.id));
+    CHECK(picked.size() == 3);
+    manager.eval_pick(pick_value(tile_b_again.data->at(0).id));
+    REQUIRE(picked.size() == 4);
+    CHECK(picked.back().title == "poi 0");
+
+    manager.eval_pick(0); // nothing
+    REQUIRE(picked.size() == 5);
+    CHECK(picked.back() == picker::Feature {});
+
+    // pois that didn't go through map_label::Scheduler have no pick id and must not end up in any slot
+    CHECK(vector_tile::PointOfInterest {}.id == SlotTable<tile::Id>::invalid_id);
+    const tile::Id unpicked_tile_id = { 12, { 5, 6 } };
+    manager.update_quads({ vector_tile::PoiTile { unpicked_tile_id, std::make_shared<const vector_tile::PointOfInterestCollection>(3) } }, {});
+    for (uint32_t generation = 1; generation < (1u << SlotTable<tile::Id>::generation_bits); ++generation)
+        manager.eval_pick(pick_value(SlotTable<tile::Id>::make_id(SlotTable<tile::Id>::max_size - 1, generation)));
+    CHECK(picked.size() == 5); // not found
+    manager.update_quads({}, { unpicked_tile_id });
+
+    // the pois that do have ids are unaffected
+    manager.eval_pick(pick_value(tile_b_again.data->at(0).id));
+    CHECK(picked.back().title == "poi 0");
+}
+
+TEST_CASE("nucleus/picker/SlotTable benchmark")
+{
+    // 400 tiles with 50 pois each, replace 100 tiles (like update_quads does) and look up 1000 ids
+    constexpr unsigned n_tiles = 400;
+    constexpr unsigned n_pois = 50;
+    std::vector<std::vector<uint32_t>> tiles(n_tiles);
+    SlotTable<const void*> allocator;
+    for (auto& tile : tiles) {
+        for (unsigned i = 0; i < n_pois; ++i)
+            tile.push_back(allocator.insert(nullptr));
+    }
+
+    BENCHMARK("unordered_map: remove and add 100 tiles, 1000 lookups")
+    {
+        std::unordered_map<uint32_t, const void*> map;
+        for (const auto& tile : tiles) {
+            for (const auto id : tile)
+                map[id] = &tile;
+        }
+        for (unsigned t = 0; t < 100; ++t) {
+            for (const auto id : tiles[t])
+                map.erase(id);
+        }
+        for (unsigned t = 0; t < 100; ++t) {
+            for (const auto id : tiles[t])
+                map[id] = &tiles[t];
+        }
+        size_t found = 0;
+        for (unsigned i = 0; i < 1000; ++i)
+            found += map.contains(tiles[(i * 7) % n_tiles][i % n_pois]);
+        return found;
+    };
+
+    BENCHMARK("SlotTable: remove and add 100 tiles, 1000 lookups")
+    {
+        SlotTable<const void*> table;
+        for (const auto& tile : tiles) {
+            for (const auto id : tile)
+                table.assign(id, &tile);
+        }
+        for (unsigned t = 0; t < 100; ++t) {
+            for (const auto id : tiles[t])
+                table.erase(id);
+        }
+        for (unsigned t = 0; t < 100; ++t) {
+            for (const auto id : tiles[t])
+                table.assign(id, &tiles[t]);
+        }
+        size_t found = 0;
+        for (unsigned i = 0; i < 1000; ++i)
+            found += table.contains(tiles[(i * 7) % n_tiles][i % n_pois]);
+        return found;
+    };
+}
@@ -20,8 +20,11 @@
 // #define WRITE_RASTERIZER_DEBUG_IMAGE
 
 #include <QSignalSpy>
+#include <algorithm>
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <set>
 
 #include <CDT.h>
 
@@ -159,6 +162,27 @@ std::pair<CDT::TriangleVec, std::vector<CDT::V2d<double>>> triangulate(std::vect
     return std::make_pair(cdt.triangles, cdt.vertices);
 }
 
+// writes data_index + 1 into the covered pixels of the raster, spans are clipped to the raster
+auto raster_span_writer(nucleus::Raster<uint8_t>& raster)
+{
+    return [&raster](int y, int x_begin, int x_end, unsigned data_index) {
+        if (y < 0 || y >= int(raster.height()))
+            return;
+        x_begin = std::max(x_begin, 0);
+        x_end = std::min(x_end, int(raster.width()));
+        if (x_begin < x_end)
+            std::fill(&raster.pixel({ x_begin, y }), &raster.pixel({ x_begin, y }) + (x_end - x_begin), uint8_t(data_index + 1));
+    };
+}
+
+auto raster_pixel_writer(nucleus::Raster<uint8_t>& raster)
+{
+    return [&raster](glm::ivec2 pos, unsigned data_index) {
+        if (pos.x >= 0 && pos.y >= 0 && pos.x < int(raster.width()) && pos.y < int(raster.height()))
+            raster.pixel(pos) = uint8_t(data_index + 1);
+    };
+}
+
 QImage example_rasterizer_image(const QString& filename)
 {
     auto image_file = QFile(QString("%1%2").arg(ALP_TEST_DATA_DIR, filename));
@@ -981,6 +1005,114 @@ TEST_CASE("nucleus/rasterizer")
 #endif
     }
 }
+TEST_CASE("nucleus/rasterizer span writer")
+{
+    SECTION("fixture")
+    {
+        const std::vector<glm::vec2> polygon_points = { glm::vec2(5, 1), glm::vec2(5, 5), glm::vec2(1, 5) };
+
+        nucleus::Raster<uint8_t> output({ 7, 7 }, 0u);
+        const auto span_writer = [&output](int y, int x_begin, int x_end) { std::fill(&output.pixel({ x_begin, y }), &output.pixel({ x_begin, y }) + (x_end - x_begin), uint8_t(255)); };
+        nucleus::utils::rasterizer::rasterize_polygon_spans(span_writer, polygon_points);
+
+        CHECK(nucleus::tile::conversion::u8raster_to_qimage(output) == example_rasterizer_image("rasterizer_simple_triangle.png"));
+    }
+
+    SECTION("pixel and span writers give the fixture pixels for every distance")
+    {
+        // the first row of the random triangles, rasterised into one band of 80 pixels per distance.
+        // the fixtures were rendered with the per pixel rasterizer, pixel values are (triangle/line segment index + 1) * 15.
+        const std::vector<std::vector<glm::vec2>> polygon_points = { { { 11.5, 16 }, { 12.9, 3.9 }, { 4.8, 5.5 } },
+            { { 59.3, 11.9 }, { 58.9, 6.9 }, { 38.5, 24.7 } },
+            { { 79.1, 14.3 }, { 82, 2.4 }, { 72.7, 31.9 } },
+            { { 125.2, 24.7 }, { 105.2, 30.8 }, { 125.5, 12.1 } },
+            { { 145.9, 17.1 }, { 128, 15.5 }, { 141.6, 29.5 } },
+            { { 160.7, 23.1 }, { 174.3, 12.4 }, { 165.1, 0.8 } },
+            { { 223.9, 19.1 }, { 205.2, 0.4 }, { 217.1, 26.8 } },
+            { { 252.4, 6.9 }, { 233.3, 27.4 }, { 251.3, 14.4 } },
+            { { 7.1, 37.2 }, { 4, 43.7 }, { 11.1, 35.5 } },
+            { { 39.9, 52.7 }, { 55.5, 48.2 }, { 45.7, 39.9 } },
+            { { 82.3, 37.1 }, { 68.7, 46.5 }, { 66.5, 32.6 } },
+            { { 102.9, 41.8 }, { 125.5, 34.5 }, { 112.5, 52.2 } },
+            { { 155.1, 41.8 }, { 133.3, 44.9 }, { 155.3, 55.7 } },
+            { { 188.9, 51.8 }, { 178.8, 53.6 }, { 172.4, 52.2 } },
+            { { 220.1, 61.9 }, { 206.1, 39.5 }, { 194.6, 51.6 } },
+            { { 236, 59.8 }, { 253.5, 52.9 }, { 232.7, 35.9 } } };
+        const std::array<float, 4> distances = { 0.0f, 0.7f, 3.0f, 6.5f };
+
+        nucleus::Raster<uint8_t> triangle_pixels({ 256, 320 }, 0u);
+        nucleus::Raster<uint8_t> triangle_spans({ 256, 320 }, 0u);
+        nucleus::Raster<uint8_t> line_pixels({ 256, 320 }, 0u);
+        nucleus::Raster<uint8_t> line_spans({ 256, 320 }, 0u);
+        for (unsigned i = 0; i < distances.size(); ++i) {
+            const auto offset = glm::vec2(0, 8 + 80 * i);
+            std::vector<glm::vec2> triangles;
+            std::vector<glm::vec2> line;
+            for (auto triangle : polygon_points) {
+                for (auto& point : triangle)
+                    point = point + offset;
+                std::sort(triangle.begin(), triangle.end(), [](const glm::vec2& a, const glm::vec2& b) { return a.y < b.y; });
+                triangles.insert(triangles.end(), triangle.begin(), triangle.end());
+                line.push_back(triangle[0]);
+            }
+            nucleus::utils::rasterizer::rasterize_triangle(raster_pixel_writer(triangle_pixels), triangles, distances[i]);
+            nucleus::utils::rasterizer::rasterize_triangle_spans(raster_span_writer(triangle_spans), triangles, distances[i]);
+            nucleus::utils::rasterizer::rasterize_line(raster_pixel_writer(line_pixels), line, distances[i]);
+            nucleus::utils::rasterizer::rasterize_line_spans(raster_span_writer(line_spans), line, distances[i]);
+        }
+
+        const auto to_image = [](nucleus::Raster<uint8_t> raster) {
+            for (auto& pixel : raster)
+                pixel *= 15;
+            return nucleus::tile::conversion::u8raster_to_qimage(raster);
+        };
+        const auto triangle_fixture = example_rasterizer_image("rasterizer_output_enlarged_triangles.png");
+        const auto line_fixture = example_rasterizer_image("rasterizer_output_enlarged_lines.png");
+        CHECK(to_image(triangle_pixels) == triangle_fixture);
+        CHECK(to_image(triangle_spans) == triangle_fixture);
+        CHECK(to_image(line_pixels) == line_fixture);
+        CHECK(to_image(line_spans) == line_fixture);
+
+#ifdef WRITE_RASTERIZER_DEBUG_IMAGE
+        to_image(triangle_pixels).save(QString("rasterizer_output_enlarged_triangles.png"));
+        to_image(line_pixels).save(QString("rasterizer_output_enlarged_lines.png"));
+#endif
+    }
+
+    SECTION("end caps cover the same pixels as testing every offset")
+    {
+        std::mt19937 rng(42);
+        std::uniform_real_distribution<float> coordinate(-3.0f, 20.0f);
+        std::uniform_real_distribution<float> radius(0.0f, 12.0f);
+        for (unsigned i = 0; i < 500; ++i) {
+            const auto position = glm::vec2(coordinate(rng), coordinate(rng));
+            const auto distance = radius(rng);
+            CAPTURE(position.x, position.y, distance);
+
+            std::set<std::pair<int, int>> reference;
+            const float enlarged = distance + sqrt(0.5);
+            const float distance_test = ceil(enlarged);
+            for (int x = -distance_test; x < distance_test; x++) {
+                for (int y = -distance_test; y < distance_test; y++) {
+                    if (glm::length(glm::vec2(x, y)) < enlarged) {
+                        const auto pos = glm::ivec2(position + glm::vec2(x, y));
+                        reference.emplace(pos.x, pos.y);
+                    }
+                }
+            }
+
+            std::set<std::pair<int, int>> covered;
+            const auto span_writer = [&covered](int y, int x_begin, int x_end) {
+                CHECK(x_begin < x_end);
+                for (int x = x_begin; x < x_end; ++x)
+                    covered.emplace(x, y);
+            };
+            nucleus::utils::rasterizer::details::add_circle_end_cap(span_writer, position, 0, distance);
+            CHECK(covered == reference);
+        }
+    }
+}
+
 TEST_CASE("nucleus/utils/rasterizer benchmarks")
 {
 
@@ -1032,6 +1164,40 @@ TEST_CASE("nucleus/utils/rasterizer benchmarks")
         nucleus::utils::rasterizer::rasterize_triangle(pixel_writer, triangles, 5.0);
     };
 
+    BENCHMARK("Rasterize triangle (span writer)")
+    {
+        const std::vector<glm::vec2> triangles = { glm::vec2(30.5, 10.5), glm::vec2(10.5, 30.5), glm::vec2(50.5, 50.5), glm::vec2(5.5, 5.5), glm::vec2(15.5, 10.5), glm::vec2(5.5, 15.5) };
+
+        const auto span_writer = [](int, int, int) { /*do nothing*/ };
+        nucleus::utils::rasterizer::rasterize_triangle_spans(span_writer, triangles);
+    };
+
+    BENCHMARK("Rasterize triangle distance (span writer)")
+    {
+        const std::vector<glm::vec2> triangles = { glm::vec2(30.5, 10.5), glm::vec2(10.5, 30.5), glm::vec2(50.5, 50.5), glm::vec2(5.5, 5.5), glm::vec2(15.5, 10.5), glm::vec2(5.5, 15.5) };
+
+        const auto span_writer = [](int, int, int) { /*do nothing*/ };
+        nucleus::utils::rasterizer::rasterize_triangle_spans(span_writer, triangles, 5.0);
+    };
+
+    {
+        // large triangle written into a 4096x4096 raster, this is where the per pixel calls hurt
+        const std::vector<glm::vec2> triangles = { glm::vec2(1930.5, 10.5), glm::vec2(10.5, 2030.5), glm::vec2(4050.5, 4050.5) };
+        nucleus::Raster<uint8_t> output({ 4096, 4096 }, 0u);
+
+        BENCHMARK("Rasterize triangle into 4096x4096 raster (pixel writer)")
+        {
+            nucleus::utils::rasterizer::rasterize_triangle(raster_pixel_writer(output), triangles, 5.0);
+            return output.pixel({ 2048, 2048 });
+        };
+
+        BENCHMARK("Rasterize triangle into 4096x4096 raster (span writer)")
+        {
+            nucleus::utils::rasterizer::rasterize_triangle_spans(raster_span_writer(output), triangles, 5.0);
+            return output.pixel({ 2048, 2048 });
+        };
+    }
+
     BENCHMARK("Rasterize triangle SDF")
     {
         const std::vector<glm::vec2> triangles = { glm::vec2(30.5, 10.5), glm::vec2(10.5, 30.5), glm::vec2(50.5, 50.5), glm::vec2(5.5, 5.5), glm::vec2(15.5, 10.5), glm::vec2(5.5, 15.5) };
@@ -16,9 +16,13 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
+#include <array>
+#include <random>
+#include <set>
 #include <unordered_set>
 
 #include <QImage>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
 
@@ -233,6 +237,132 @@ TEST_CASE("nucleus/srs")
         }
     }
 
+    SECTION("srs conversion with height, batch version")
+    {
+        std::vector<double> lat = { 0, 48.2086939, 38.2086939, -70.2086939, -60.2086939, 85.0, -85.0, 47.0744 };
+        std::vector<double> lon = { 0, 16.3726561, -116.3726561, 26.3726561, -96.3726561, 180.0, -180.0, 12.6939 };
+        std::vector<double> alt = { 10, 100, 200, 1000, 4000, 0, 50, 3798 };
+        const auto lat_in = lat;
+        const auto lon_in = lon;
+        const auto alt_in = alt;
+        lat_long_alt_to_world(lat, lon, alt);
+        for (size_t i = 0; i < lat.size(); ++i) {
+            const auto reference = lat_long_alt_to_world({ lat_in[i], lon_in[i], alt_in[i] });
+            CHECK(lat[i] == Approx(reference.x).scale(1000));
+            CHECK(lon[i] == Approx(reference.y).scale(1000));
+            CHECK(alt[i] == Approx(reference.z).scale(1000));
+        }
+    }
+
+    SECTION("batch versions stay within their error bounds")
+    {
+        constexpr double max_latitude = 85.0511287798;
+        constexpr double world_extent = 20037508.342789244;
+        std::mt19937_64 rng(42);
+        std::uniform_real_distribution<double> latitude_distribution(-max_latitude, max_latitude);
+        std::uniform_real_distribution<double> longitude_distribution(-180, 180);
+        std::uniform_real_distribution<double> world_distribution(-world_extent, world_extent);
+        std::uniform_real_distribution<double> altitude_distribution(-500, 9000);
+
+        // every 10th point close to the equator, where the log of the batch version is least accurate
+        std::vector<glm::dvec3> lat_long_alt(100'000);
+        std::vector<glm::dvec3> world(lat_long_alt.size());
+        for (size_t i = 0; i < lat_long_alt.size(); ++i) {
+            const auto scale = (i % 10 == 0) ? 1e-6 : 1.0;
+            lat_long_alt[i] = { latitude_distribution(rng) * scale, longitude_distribution(rng), altitude_distribution(rng) };
+            world[i] = { world_distribution(rng), world_distribution(rng) * scale, altitude_distribution(rng) };
+        }
+        lat_long_alt.push_back({ max_latitude, 180, 100 });
+        lat_long_alt.push_back({ -max_latitude, -180, 100 });
+        world.push_back({ world_extent, world_extent, 100 });
+        world.push_back({ -world_extent, -world_extent, 100 });
+
+        const auto split = [](const std::vector<glm::dvec3>& points) {
+            std::array<std::vector<double>, 3> soa;
+            for (const auto& p : points) {
+                for (unsigned j = 0; j < 3; ++j)
+                    soa[j].push_back(p[j]);
+            }
+            return soa;
+        };
+        const auto relative_error = [](double value, double reference) { return std::abs(value - reference) / std::max(1.0, std::abs(reference)); };
+
+        {
+            auto [x, y, z] = split(lat_long_alt);
+            auto [x2, y2, unused] = split(lat_long_alt);
+            lat_long_alt_to_world(x, y, z);
+            lat_long_to_world(x2, y2);
+            double max_xy_error = 0;
+            double max_z_error = 0;
+            for (size_t i = 0; i < lat_long_alt.size(); ++i) {
+                const auto reference = lat_long_alt_to_world(lat_long_alt[i]);
+                max_xy_error = std::max({ max_xy_error, std::abs(x[i] - reference.x), std::abs(y[i] - reference.y) });
+                max_xy_error = std::max({ max_xy_error, std::abs(x2[i] - reference.x), std::abs(y2[i] - reference.y) });
+                max_z_error = std::max(max_z_error, relative_error(z[i], reference.z));
+            }
+            CHECK(max_xy_error <= batch_max_world_error);
+            CHECK(max_z_error <= batch_max_relative_altitude_error);
+        }
+        {
+            auto [latitude, longitude, altitude] = split(world);
+            auto [latitude2, longitude2, unused] = split(world);
+            world_to_lat_long_alt(latitude, longitude, altitude);
+            world_to_lat_long(latitude2, longitude2);
+            double max_degree_error = 0;
+            double max_altitude_error = 0;
+            for (size_t i = 0; i < world.size(); ++i) {
+                const auto reference = world_to_lat_long_alt(world[i]);
+                max_degree_error = std::max({ max_degree_error, std::abs(latitude[i] - reference.x), std::abs(longitude[i] - reference.y) });
+                max_degree_error = std::max({ max_degree_error, std::abs(latitude2[i] - reference.x), std::abs(longitude2[i] - reference.y) });
+                max_altitude_error = std::max(max_altitude_error, relative_error(altitude[i], reference.z));
+            }
+            CHECK(max_degree_error <= batch_max_degree_error);
+            CHECK(max_altitude_error <= batch_max_relative_altitude_error);
+        }
+    }
+
+    SECTION("batch tile id lookup")
+    {
+        CHECK(world_xy_to_tile_ids({}, 10).empty());
+
+        std::mt19937_64 rng(42);
+        const auto bounds = tile_bounds({ 12, { 2200, 2670 } });
+        std::uniform_real_distribution<double> x_distribution(bounds.min.x, bounds.max.x);
+        std::uniform_real_distribution<double> y_distribution(bounds.min.y, bounds.max.y);
+        std::vector<glm::dvec2> points(10'000);
+        for (auto& p : points)
+            p = { x_distribution(rng), y_distribution(rng) };
+
+        for (const auto zoom_level : { 0u, 12u, 14u, 16u }) {
+            std::set<std::pair<unsigned, unsigned>> reference;
+            for (const auto& p : points) {
+                const auto id = world_xy_to_tile_id(p, zoom_level);
+                reference.insert({ id.coords.x, id.coords.y });
+            }
+            const auto ids = world_xy_to_tile_ids(points, zoom_level);
+            REQUIRE(ids.size() == reference.size());
+            auto reference_it = reference.begin();
+            for (const auto& id : ids) {
+                CHECK(id.zoom_level == zoom_level);
+                CHECK(std::make_pair(id.coords.x, id.coords.y) == *reference_it++);
+            }
+        }
+        CHECK(world_xy_to_tile_ids(points, 12) == std::vector<tile::Id> { { 12, { 2200, 2670 } } });
+
+        // outside of the world
+        const std::vector<glm::dvec2> outside = { { -3e7, -3e7 }, { 3e7, 3e7 }, { -3e7, 3e7 } };
+        CHECK(world_xy_to_tile_ids(outside, 1) == std::vector<tile::Id> { { 1, { 0, 0 } }, { 1, { 0, 1 } }, { 1, { 1, 1 } } });
+        // the scalar version clamps the same way, also on the east and north border of the world
+        const auto edge = tile_bounds({ 0, { 0, 0 } }).max.x;
+        for (const auto& p : { outside[0], outside[1], outside[2], glm::dvec2(edge, edge), glm::dvec2(-edge, edge), glm::dvec2(edge, 0) }) {
+            for (const auto zoom_level : { 0u, 1u, 12u }) {
+                const std::array<glm::dvec2, 1> point = { p };
+                CHECK(world_xy_to_tile_ids(point, zoom_level) == std::vector<tile::Id> { world_xy_to_tile_id(p, zoom_level) });
+            }
+        }
+        CHECK(world_xy_to_tile_id({ edge, edge }, 3) == tile::Id { 3, { 7, 7 } });
+    }
+
     SECTION("check conflict potential")
     {
         QImage data(256, 256, QImage::Format_Grayscale8);
@@ -279,3 +409,76 @@ TEST_CASE("nucleus/srs")
         }
     }
 }
+
+TEST_CASE("nucleus/srs benchmarks")
+{
+    // 1M points, the throughput in points per second is 1e6 / the mean time in seconds
+    constexpr size_t n = 1'000'000;
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> latitude_distribution(45, 49);
+    std::uniform_real_distribution<double> longitude_distribution(9, 17);
+    std::uniform_real_distribution<double> altitude_distribution(100, 4000);
+    std::vector<glm::dvec3> points(n);
+    for (auto& p : points)
+        p = { latitude_distribution(rng), longitude_distribution(rng), altitude_distribution(rng) };
+    std::vector<double> x(n), y(n), z(n);
+    const auto fill_soa = [&]() {
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = points[i].x;
+            y[i] = points[i].y;
+            z[i] = points[i].z;
+        }
+    };
+
+    BENCHMARK("copy 1M points into soa (for reference)")
+    {
+        fill_soa();
+        return x.back();
+    };
+    BENCHMARK("lat_long_alt_to_world, scalar, 1M points")
+    {
+        double sum = 0;
+        for (const auto& p : points)
+            sum += lat_long_alt_to_world(p).y;
+        return sum;
+    };
+    BENCHMARK("lat_long_alt_to_world, batch, 1M points")
+    {
+        fill_soa();
+        lat_long_alt_to_world(x, y, z);
+        return y.back();
+    };
+
+    std::vector<glm::dvec3> world_points(n);
+    for (size_t i = 0; i < n; ++i)
+        world_points[i] = lat_long_alt_to_world(points[i]);
+    BENCHMARK("world_to_lat_long_alt, scalar, 1M points")
+    {
+        double sum = 0;
+        for (const auto& p : world_points)
+            sum += world_to_lat_long_alt(p).x;
+        return sum;
+    };
+    BENCHMARK("world_to_lat_long_alt, batch, 1M points")
+    {
+        for (size_t i = 0; i < n; ++i) {
+            x[i] = world_points[i].x;
+            y[i] = world_points[i].y;
+            z[i] = world_points[i].z;
+        }
+        world_to_lat_long_alt(x, y, z);
+        return x.back();
+    };
+
+    std::vector<glm::dvec2> world_xy(n);
+    for (size_t i = 0; i < n; ++i)
+        world_xy[i] = world_points[i];
+    BENCHMARK("world_xy_to_tile_id, scalar into a set, 1M points")
+    {
+        std::unordered_set<tile::Id, tile::Id::Hasher> ids;
+        for (const auto& p : world_xy)
+            ids.insert(world_xy_to_tile_id(p, 14));
+        return ids.size();
+    };
+    BENCHMARK("world_xy_to_tile_ids, batch, 1M points") { return world_xy_to_tile_ids(world_xy, 14).size(); };
+}
@@ -16,9 +16,30 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
+#include <algorithm>
+#include <array>
+#include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <map>
 
 #include "nucleus/utils/terrain_mesh_index_generator.h"
+#include "nucleus/utils/vertex_cache.h"
+
+using namespace nucleus::utils;
+
+namespace {
+// triangle -> count, with the vertices rotated so that the smallest comes first. rotating keeps the winding order.
+std::map<std::array<uint32_t, 3>, unsigned> triangle_set(const std::vector<uint32_t>& triangle_list)
+{
+    std::map<std::array<uint32_t, 3>, unsigned> triangles;
+    for (size_t i = 0; i < triangle_list.size(); i += 3) {
+        std::array<uint32_t, 3> t = { triangle_list[i], triangle_list[i + 1], triangle_list[i + 2] };
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        ++triangles[t];
+    }
+    return triangles;
+}
+} // namespace
 
 TEST_CASE("nucleus/utils/terrain_mesh_index_generator")
 {
@@ -53,3 +74,124 @@ TEST_CASE("nucleus/utils/terrain_mesh_index_generator")
                                       5, 10, 2, 11, 1, 12, 0, 13, 3, 14, 6, 15, 7, 16, 8, 9}));
     }
 }
+
+TEST_CASE("nucleus/utils/vertex_cache")
+{
+    using namespace vertex_cache;
+    SECTION("strip to list")
+    {
+        // winding of every second triangle is swapped back, degenerate triangles are dropped
+        CHECK(strip_to_list(std::vector<uint32_t> { 0, 3, 1, 4, 2, 5, 5, 3, 3, 6 }) == std::vector<uint32_t> { 0, 3, 1, 1, 3, 4, 1, 4, 2, 2, 4, 5 });
+    }
+    SECTION("fifo simulation")
+    {
+        // two triangles sharing an edge: 4 vertices for 2 triangles
+        auto stats = simulate_fifo(std::vector<uint32_t> { 0, 1, 2, 2, 1, 3 }, Topology::TriangleList, 4);
+        CHECK(stats.n_triangles == 2);
+        CHECK(stats.n_unique_vertices == 4);
+        CHECK(stats.n_transformed_vertices == 4);
+        CHECK(stats.acmr == 2.0);
+        CHECK(stats.atvr == 1.0);
+
+        // with a cache of 3, vertex 3 evicts 0, which then evicts 1 and so on
+        stats = simulate_fifo(std::vector<uint32_t> { 0, 1, 2, 1, 2, 3, 0, 1, 2 }, Topology::TriangleList, 3);
+        CHECK(stats.n_transformed_vertices == 7);
+        CHECK(stats.atvr == 1.75);
+
+        // strips: every index is fed once, degenerate triangles don't count
+        stats = simulate_fifo(surface_quads<uint32_t>(3), Topology::TriangleStrip, 16);
+        CHECK(stats.n_triangles == 8);
+        CHECK(stats.n_transformed_vertices == 9);
+    }
+    SECTION("forsyth keeps the triangles")
+    {
+        const auto list = strip_to_list(terrain_mesh_index_generator::surface_quads_with_curtains<uint32_t>(17));
+        const auto ordered = forsyth_order(list, 17 * 17 + 4 * 16);
+        REQUIRE(ordered.size() == list.size());
+        CHECK(triangle_set(ordered) == triangle_set(list));
+    }
+}
+
+TEST_CASE("nucleus/utils/terrain_mesh_index_generator layouts")
+{
+    using namespace terrain_mesh_index_generator;
+    constexpr unsigned n = 65;
+    const auto strip = tile_mesh(n, Layout::Strip);
+    const auto list = tile_mesh(n, Layout::CacheOptimisedList);
+    const auto meshlets = tile_mesh(n, Layout::Meshlets);
+
+    SECTION("all layouts have the same triangles")
+    {
+        CHECK(strip.topology == vertex_cache::Topology::TriangleStrip);
+        CHECK(strip.indices == surface_quads_with_curtains<uint32_t>(n));
+        const auto reference = triangle_set(vertex_cache::strip_to_list(strip.indices));
+        CHECK(list.topology == vertex_cache::Topology::TriangleList);
+        CHECK(triangle_set(list.indices) == reference);
+        CHECK(meshlets.topology == vertex_cache::Topology::TriangleList);
+        CHECK(triangle_set(meshlets.indices) == reference);
+        CHECK(list.indices_as<uint16_t>().size() == list.indices.size());
+    }
+
+    SECTION("grid position of curtain vertices")
+    {
+        CHECK(grid_position(4, 3) == glm::uvec2(1, 1));
+        CHECK(grid_position(9, 3) == glm::uvec2(2, 2)); // first curtain vertex hangs from the south east corner
+        CHECK(grid_position(11, 3) == glm::uvec2(2, 0));
+        CHECK(grid_position(13, 3) == glm::uvec2(0, 0));
+        CHECK(grid_position(15, 3) == glm::uvec2(0, 2));
+        CHECK(grid_position(16, 3) == glm::uvec2(1, 2));
+        // each curtain vertex is paired with its border vertex in the strip
+        const auto indices = surface_quads_with_curtains<uint32_t>(5);
+        for (size_t i = surface_quads<uint32_t>(5).size(); i + 1 < indices.size(); i += 2)
+            CHECK(grid_position(indices[i + 1], 5) == grid_position(indices[i], 5));
+    }
+
+    SECTION("meshlets partition the index buffer")
+    {
+        REQUIRE(meshlets.meshlets.size() == 10 * 10);
+        uint32_t next_index = 0;
+        for (const auto& meshlet : meshlets.meshlets) {
+            CHECK(meshlet.first_index == next_index);
+            CHECK(meshlet.n_indices % 3 == 0);
+            next_index += meshlet.n_indices;
+            const auto extent = meshlet.grid_max - meshlet.grid_min;
+            CHECK(extent.x <= 7);
+            CHECK(extent.y <= 7);
+            // border meshlets have additional curtain vertices
+            CHECK(meshlet.n_vertices <= 64 + 2 * 8);
+            for (uint32_t i = meshlet.first_index; i < meshlet.first_index + meshlet.n_indices; ++i) {
+                const auto p = grid_position(meshlets.indices[i], n);
+                CHECK(glm::all(glm::greaterThanEqual(p, meshlet.grid_min)));
+                CHECK(glm::all(glm::lessThanEqual(p, meshlet.grid_max)));
+            }
+        }
+        CHECK(next_index == meshlets.indices.size());
+    }
+
+    SECTION("cache optimised layouts transform fewer vertices")
+    {
+        for (const auto cache_size : { 16u, 32u }) {
+            CAPTURE(cache_size);
+            const auto strip_stats = vertex_cache::simulate_fifo(strip.indices, strip.topology, cache_size);
+            const auto list_stats = vertex_cache::simulate_fifo(list.indices, list.topology, cache_size);
+            const auto meshlet_stats = vertex_cache::simulate_fifo(meshlets.indices, meshlets.topology, cache_size);
+            CHECK(list_stats.n_triangles == strip_stats.n_triangles);
+            CHECK(meshlet_stats.n_triangles == strip_stats.n_triangles);
+            // the row by row strip transforms almost every vertex twice
+            CHECK(strip_stats.acmr > 0.95);
+            CHECK(strip_stats.atvr > 1.9);
+            CHECK(list_stats.acmr < 0.72);
+            CHECK(list_stats.atvr < 1.4);
+            CHECK(meshlet_stats.acmr < 0.72);
+            CHECK(meshlet_stats.atvr < 1.4);
+        }
+    }
+}
+
+TEST_CASE("nucleus/utils/terrain_mesh_index_generator benchmarks")
+{
+    using namespace terrain_mesh_index_generator;
+    BENCHMARK("strip 65x65") { return tile_mesh(65, Layout::Strip).indices.size(); };
+    BENCHMARK("cache optimised list 65x65") { return tile_mesh(65, Layout::CacheOptimisedList).indices.size(); };
+    BENCHMARK("meshlets 65x65") { return tile_mesh(65, Layout::Meshlets).indices.size(); };
+}
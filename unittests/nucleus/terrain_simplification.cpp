@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QString>
+#include <algorithm>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+#include <set>
+
+#include <nucleus/tile/conversion.h>
+#include <nucleus/utils/image_loader.h>
+#include <nucleus/utils/terrain_mesh_index_generator.h>
+#include <nucleus/utils/terrain_simplification.h>
+#include <nucleus/utils/vertex_cache.h>
+
+using namespace nucleus::utils;
+using terrain_simplification::Rtin;
+
+namespace {
+nucleus::Raster<uint16_t> test_tile()
+{
+    const auto image = image_loader::rgba8(QString("%1%2").arg(ALP_TEST_DATA_DIR, "test-tile.png"));
+    REQUIRE(image.has_value());
+    return nucleus::tile::conversion::to_u16raster(image.value());
+}
+
+// directed edges without their reverse, i.e., the boundary of the mesh
+std::set<std::pair<uint32_t, uint32_t>> open_edges(const std::vector<uint32_t>& triangle_list)
+{
+    std::set<std::pair<uint32_t, uint32_t>> edges;
+    for (size_t i = 0; i < triangle_list.size(); i += 3) {
+        for (unsigned j = 0; j < 3; ++j)
+            edges.emplace(triangle_list[i + j], triangle_list[i + (j + 1) % 3]);
+    }
+    std::set<std::pair<uint32_t, uint32_t>> open;
+    for (const auto& [a, b] : edges) {
+        if (!edges.contains({ b, a }))
+            open.emplace(a, b);
+    }
+    return open;
+}
+
+void check_mesh(const terrain_simplification::Mesh& mesh, unsigned n)
+{
+    const auto full = vertex_cache::strip_to_list(terrain_mesh_index_generator::surface_quads_with_curtains<uint32_t>(n));
+    REQUIRE(mesh.indices.size() % 3 == 0);
+    REQUIRE(mesh.n_surface_triangles * 3 <= mesh.indices.size());
+
+    // same boundary as the full grid, i.e., no holes, no t-junctions, and the curtains close the border
+    CHECK(open_edges(mesh.indices) == open_edges(full));
+
+    // all border vertices are kept
+    std::vector<bool> is_used(n * n, false);
+    for (unsigned i = 0; i < mesh.n_surface_triangles * 3; ++i) {
+        REQUIRE(mesh.indices[i] < n * n);
+        is_used[mesh.indices[i]] = true;
+    }
+    for (unsigned i = 0; i < n; ++i) {
+        CHECK(is_used[i]);
+        CHECK(is_used[(n - 1) * n + i]);
+        CHECK(is_used[i * n]);
+        CHECK(is_used[i * n + n - 1]);
+    }
+    CHECK(unsigned(std::count(is_used.begin(), is_used.end(), true)) == mesh.n_surface_vertices);
+
+    // same winding order as the strip
+    for (unsigned i = 0; i < mesh.n_surface_triangles * 3; i += 3) {
+        const auto a = glm::ivec2(mesh.indices[i] % n, mesh.indices[i] / n);
+        const auto b = glm::ivec2(mesh.indices[i + 1] % n, mesh.indices[i + 1] / n);
+        const auto c = glm::ivec2(mesh.indices[i + 2] % n, mesh.indices[i + 2] / n);
+        CHECK((b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x) < 0);
+    }
+}
+} // namespace
+
+TEST_CASE("nucleus/utils/terrain_simplification")
+{
+    SECTION("flat and planar tiles collapse to the border")
+    {
+        const Rtin rtin(65);
+        nucleus::Raster<uint16_t> flat({ 65, 65 }, uint16_t(4000));
+        nucleus::Raster<uint16_t> ramp(65);
+        for (unsigned y = 0; y < 65; ++y) {
+            for (unsigned x = 0; x < 65; ++x)
+                ramp.pixel({ x, y }) = uint16_t(1000 + 300 * x + 200 * y);
+        }
+        for (const auto* raster : { &flat, &ramp }) {
+            const auto mesh = rtin.simplify(*raster, 0.0f);
+            check_mesh(mesh, 65);
+            CHECK(terrain_simplification::max_error(*raster, mesh.indices) == 0);
+            // only the triangles along the border remain
+            CHECK(mesh.n_surface_vertices < 10 * 64);
+            CHECK(mesh.n_surface_triangles < 2 * 64 * 64 / 8);
+        }
+    }
+
+    SECTION("test tile")
+    {
+        const auto heights = test_tile();
+        REQUIRE(heights.width() == 65);
+        const Rtin rtin(65);
+        const auto errors = rtin.errors(heights);
+        unsigned previous_n_triangles = 2 * 64 * 64 + 1;
+        for (const auto tolerance : { 0.0f, 1.0f, 4.0f, 16.0f, 64.0f, 256.0f }) {
+            const auto mesh = rtin.mesh(errors, tolerance);
+            check_mesh(mesh, 65);
+            CHECK(terrain_simplification::max_error(heights, mesh.indices) <= tolerance);
+            CHECK(mesh.n_surface_triangles <= previous_n_triangles);
+            previous_n_triangles = mesh.n_surface_triangles;
+        }
+        // at 32 m, less than a quarter of the triangles remain
+        CHECK(previous_n_triangles < 2 * 64 * 64 / 4);
+    }
+
+    SECTION("tolerance holds for noise")
+    {
+        std::mt19937 rng(42);
+        for (const auto n : { 3u, 5u, 9u, 17u, 65u }) {
+            const Rtin rtin(n);
+            for (unsigned i = 0; i < 20; ++i) {
+                nucleus::Raster<uint16_t> heights(n);
+                std::uniform_int_distribution<int> noise(0, int(i) * 200);
+                for (unsigned y = 0; y < n; ++y) {
+                    for (unsigned x = 0; x < n; ++x)
+                        heights.pixel({ x, y }) = uint16_t(20000 + 100 * int(x) + noise(rng));
+                }
+                const auto errors = rtin.errors(heights);
+                for (const auto tolerance : { 0.0f, 50.0f, 500.0f, 2000.0f }) {
+                    const auto mesh = rtin.mesh(errors, tolerance);
+                    CHECK(terrain_simplification::max_error(heights, mesh.indices) <= tolerance);
+                    if (n == 17)
+                        check_mesh(mesh, n);
+                }
+            }
+        }
+    }
+
+    SECTION("max_error")
+    {
+        nucleus::Raster<uint16_t> heights({ 3, 3 }, uint16_t(0));
+        heights.pixel({ 1, 1 }) = 8;
+        // two triangles covering the grid, without the centre vertex
+        const std::vector<uint32_t> triangles = { 0, 8, 2, 8, 0, 6 };
+        CHECK(terrain_simplification::max_error(heights, triangles) == 8);
+        // curtain triangles are ignored
+        const std::vector<uint32_t> curtain = { 0, 9, 1 };
+        CHECK(terrain_simplification::max_error(heights, curtain) == 0);
+    }
+}
+
+TEST_CASE("nucleus/utils/terrain_simplification benchmarks")
+{
+    const auto heights = test_tile();
+    const Rtin rtin(65);
+    BENCHMARK("rtin 65x65 precomputation") { return Rtin(65).vertex_side_length(); };
+    BENCHMARK("rtin 65x65 errors") { return rtin.errors(heights).size(); };
+
+    // tolerances in metres, heights are stored in 1/8 m steps
+    for (const auto tolerance : { 0.5f, 2.0f, 8.0f }) {
+        const auto mesh = rtin.simplify(heights, tolerance * 8);
+        const auto name = QString("rtin 65x65 test tile, tolerance %1 m: %2 of %3 triangles, max error %4 m")
+                              .arg(tolerance)
+                              .arg(mesh.n_surface_triangles)
+                              .arg(2 * 64 * 64)
+                              .arg(terrain_simplification::max_error(heights, mesh.indices) / 8);
+        BENCHMARK(name.toStdString()) { return rtin.simplify(heights, tolerance * 8).indices.size(); };
+    }
+}
@@ -213,6 +213,27 @@ TEST_CASE("nucleus/tile/cache")
         CHECK(cache.contains({ 0, { 0, 0 } }));
     }
 
+    SECTION("purge: visit_read_only doesn't update the time")
+    {
+        Cache<TestTile> cache;
+        cache.insert(TestTile { { 0, { 0, 0 } }, "older" });
+
+        QThread::msleep(2);
+        cache.insert(TestTile { { 1, { 0, 0 } }, "newer" });
+        cache.insert(TestTile { { 1, { 0, 1 } }, "newer" });
+
+        QThread::msleep(2);
+        std::unordered_set<Id, Id::Hasher> visited;
+        cache.visit_read_only([&visited](const TestTile& t) {
+            visited.insert(t.id);
+            return true;
+        });
+        CHECK(visited.size() == 3);
+        const auto purged = cache.purge(2);
+        REQUIRE(purged.size() == 1);
+        CHECK(purged[0].id == Id { 0, { 0, 0 } });
+    }
+
     SECTION("purge: visited elements are purged later than others")
     {
         Cache<TestTile> cache;
@@ -336,6 +357,37 @@ TEST_CASE("nucleus/tile/cache")
         std::filesystem::remove_all(path);
     }
 
+    SECTION("data quads keep their derived data on disk") {
+        const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
+        std::filesystem::remove_all(path);
+        const Id id = { 3, { 2, 5 } };
+        {
+            DataQuad quad;
+            quad.id = id;
+            quad.n_tiles = 4;
+            for (unsigned i = 0; i < 4; ++i) {
+                quad.tiles[i] = { id.children()[i], { NetworkInfo::Status::Good, 12345 }, std::make_shared<QByteArray>("heights") };
+                if (i != 2)
+                    quad.tiles[i].derived_data = QByteArray("derived ") + QByteArray::number(i);
+            }
+            Cache<DataQuad> cache;
+            cache.insert(quad);
+            CHECK(cache.write_to_disk(path).has_value());
+        }
+        {
+            Cache<DataQuad> cache;
+            CHECK(cache.read_from_disk(path).has_value());
+            REQUIRE(cache.contains(id));
+            const auto& quad = cache.peak_at(id);
+            for (unsigned i = 0; i < 4; ++i) {
+                REQUIRE(quad.tiles[i].data);
+                CHECK(*quad.tiles[i].data == "heights");
+                CHECK(quad.tiles[i].derived_data == (i != 2 ? QByteArray("derived ") + QByteArray::number(i) : QByteArray()));
+            }
+        }
+        std::filesystem::remove_all(path);
+    }
+
     SECTION("reading disk cache back fails on bad version") {
         const auto path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_tile_cache";
         std::filesystem::remove_all(path);
@@ -18,6 +18,7 @@
 
 #include <catch2/benchmark/catch_benchmark.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <glm/gtc/matrix_transform.hpp>
 #include <nucleus/camera/PositionStorage.h>
 #include <nucleus/tile/drawing.h>
 #include <nucleus/tile/utils.h>
@@ -105,4 +106,66 @@ TEST_CASE("tile/drawing")
         }
         return tmp;
     };
+
+    BENCHMARK("cull cascades")
+    {
+        std::vector<std::vector<std::vector<TileBounds>>> tmp;
+        tmp.reserve(lists.size());
+        for (const auto& [camera, list] : tile_bound_lists) {
+            // 4 boxes growing along the view direction, roughly what the shadow mapping does
+            std::vector<glm::dmat4> matrices;
+            for (double size = 500; size < 500'000; size *= 10) {
+                const auto centre = camera.z_axis() * -size; // relative to the camera position
+                const auto view = glm::lookAt(centre + glm::dvec3(0.3, 0.4, 0.8), centre, glm::dvec3(0, 0, 1));
+                matrices.push_back(glm::ortho(-size, size, -size, size, -10 * size, 10 * size) * view);
+            }
+            tmp.push_back(drawing::cull_cascades(list, matrices, camera.position()));
+        }
+        return tmp;
+    };
+}
+
+TEST_CASE("tile/drawing/cull_orthographic")
+{
+    // light straight from above, box of 200x200m around origin, depth from 100m above to 100m below origin
+    const auto origin = glm::dvec3(1000, 2000, 0);
+    const auto view = glm::lookAt(glm::dvec3(0, 0, 100), glm::dvec3(0, 0, 0), glm::dvec3(0, 1, 0));
+    const auto light_view_projection = glm::ortho(-100.0, 100.0, -100.0, 100.0, 0.0, 200.0) * view;
+
+    const auto make_tile = [&](const tile::Id& id, const glm::dvec3& min, const glm::dvec3& max) { return TileBounds { id, { origin + min, origin + max } }; };
+    const auto inside = make_tile({ 0, { 0, 0 } }, { -10, -10, -10 }, { 10, 10, 10 });
+    const auto overlapping = make_tile({ 1, { 0, 0 } }, { 90, 90, -500 }, { 150, 150, 500 });
+    const auto outside_x = make_tile({ 2, { 0, 0 } }, { 300, -10, -10 }, { 400, 10, 10 });
+    const auto outside_y = make_tile({ 3, { 0, 0 } }, { -10, -400, -10 }, { 10, -300, 10 });
+    const auto towards_light = make_tile({ 4, { 0, 0 } }, { -10, -10, 500 }, { 10, 10, 600 });
+    const auto behind = make_tile({ 5, { 0, 0 } }, { -10, -10, -600 }, { 10, 10, -500 });
+    const std::vector<TileBounds> list = { inside, overlapping, outside_x, outside_y, towards_light, behind };
+
+    const auto ids = [](const std::vector<TileBounds>& list) {
+        std::vector<tile::Id> ids;
+        for (const auto& t : list)
+            ids.push_back(t.id);
+        return ids;
+    };
+
+    SECTION("keeps casters between box and light")
+    {
+        const auto culled = drawing::cull_orthographic(list, light_view_projection, origin);
+        CHECK(ids(culled) == std::vector<tile::Id> { inside.id, overlapping.id, towards_light.id });
+    }
+
+    SECTION("box only")
+    {
+        const auto culled = drawing::cull_orthographic(list, light_view_projection, origin, false);
+        CHECK(ids(culled) == std::vector<tile::Id> { inside.id, overlapping.id });
+    }
+
+    SECTION("cascades are subsets of the input, in input order")
+    {
+        const auto larger = glm::ortho(-1000.0, 1000.0, -1000.0, 1000.0, 0.0, 200.0) * view;
+        const auto cascades = drawing::cull_cascades(list, { light_view_projection, larger }, origin);
+        REQUIRE(cascades.size() == 2);
+        CHECK(ids(cascades[0]) == std::vector<tile::Id> { inside.id, overlapping.id, towards_light.id });
+        CHECK(ids(cascades[1]) == std::vector<tile::Id> { inside.id, overlapping.id, outside_x.id, outside_y.id, towards_light.id });
+    }
 }
@@ -0,0 +1,318 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QBuffer>
+#include <QFile>
+#include <QImage>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+
+#include <nucleus/DataQuerier.h>
+#include <nucleus/camera/RaycastDepthTester.h>
+#include <nucleus/srs.h>
+#include <nucleus/tile/HeightfieldRaycaster.h>
+#include <nucleus/tile/conversion.h>
+#include <nucleus/utils/image_loader.h>
+#include <radix/TileHeights.h>
+
+using namespace nucleus::tile;
+using nucleus::tile::utils::AabbDecorator;
+
+namespace {
+
+std::shared_ptr<QByteArray> flat_png(float altitude)
+{
+    QImage tile(QSize { 65, 65 }, QImage::Format_ARGB32);
+    const auto rgba = conversion::float2alpineRGBA(altitude);
+    tile.fill(QColor(rgba.x, rgba.y, rgba.z, rgba.w));
+    auto bytes = std::make_shared<QByteArray>();
+    QBuffer buffer(bytes.get());
+    REQUIRE(buffer.open(QIODevice::WriteOnly));
+    tile.save(&buffer, "PNG");
+    return bytes;
+}
+
+std::shared_ptr<QByteArray> test_tile_png()
+{
+    QFile file(QString("%1%2").arg(ALP_TEST_DATA_DIR, "test-tile.png"));
+    REQUIRE(file.open(QIODevice::ReadOnly));
+    return std::make_shared<QByteArray>(file.readAll());
+}
+
+// complete quads from the root down to the given tile, which carries the test tile. everything else is flat at 0m.
+void fill_cache(MemoryCache* cache, const Id& tile, const std::shared_ptr<QByteArray>& tile_data)
+{
+    const auto flat = flat_png(0);
+    for (auto id = tile.parent(); true; id = id.parent()) {
+        DataQuad quad;
+        quad.id = id;
+        quad.n_tiles = 4;
+        const auto children = id.children();
+        for (unsigned i = 0; i < 4; ++i) {
+            quad.tiles[i].id = children[i];
+            quad.tiles[i].data = children[i] == tile ? tile_data : flat;
+            quad.tiles[i].network_info.status = NetworkInfo::Status::Good;
+            quad.tiles[i].network_info.timestamp = nucleus::utils::time_since_epoch();
+        }
+        cache->insert(quad);
+        if (id.zoom_level == 0)
+            break;
+    }
+}
+
+glm::dvec3 vertex_position(const HeightfieldRaycaster::DecodedTile& tile, unsigned col, unsigned row)
+{
+    const auto bounds = nucleus::srs::tile_bounds(tile.id);
+    const auto cell_size = bounds.size().x / (tile.heights.width() - 1);
+    return { bounds.min.x + col * cell_size, bounds.max.y - row * cell_size, tile.heights.pixel({ col, row }) };
+}
+
+std::optional<double> intersect_triangle(const glm::dvec3& origin, const glm::dvec3& direction, const glm::dvec3& v0, const glm::dvec3& v1, const glm::dvec3& v2)
+{
+    const auto e1 = v1 - v0;
+    const auto e2 = v2 - v0;
+    const auto p = glm::cross(direction, e2);
+    const auto det = glm::dot(e1, p);
+    if (det == 0)
+        return {};
+    const auto s = origin - v0;
+    const auto u = glm::dot(s, p) / det;
+    const auto q = glm::cross(s, e1);
+    const auto v = glm::dot(direction, q) / det;
+    if (u < 0 || v < 0 || u + v > 1)
+        return {};
+    const auto t = glm::dot(e2, q) / det;
+    return t >= 0 ? std::optional<double>(t) : std::nullopt;
+}
+
+glm::dvec2 tile_centre(const Id& id)
+{
+    const auto bounds = nucleus::srs::tile_bounds(id);
+    return (bounds.min + bounds.max) * 0.5;
+}
+
+// stands in for the renderer's depth tester, counting the queries it answers
+class FixedDepthTester : public nucleus::camera::AbstractDepthTester {
+public:
+    explicit FixedDepthTester(const glm::dvec3& position)
+        : fixed_position(position)
+    {
+    }
+    float depth(const glm::dvec2&) override
+    {
+        ++n_queries;
+        return fixed_depth;
+    }
+    glm::dvec3 position(const glm::dvec2&) override
+    {
+        ++n_queries;
+        return fixed_position;
+    }
+
+    glm::dvec3 fixed_position;
+    float fixed_depth = 1;
+    unsigned n_queries = 0;
+};
+
+// tests every triangle of the tile
+std::optional<double> brute_force(const HeightfieldRaycaster::DecodedTile& tile, const glm::dvec3& origin, const glm::dvec3& direction)
+{
+    std::optional<double> best;
+    const auto n_cells = tile.heights.width() - 1;
+    for (unsigned row = 0; row < n_cells; ++row) {
+        for (unsigned col = 0; col < n_cells; ++col) {
+            const auto tl = vertex_position(tile, col, row);
+            const auto tr = vertex_position(tile, col + 1, row);
+            const auto bl = vertex_position(tile, col, row + 1);
+            const auto br = vertex_position(tile, col + 1, row + 1);
+            for (const auto& t : { intersect_triangle(origin, direction, tl, bl, tr), intersect_triangle(origin, direction, bl, br, tr) }) {
+                if (t && (!best || *t < *best))
+                    best = t;
+            }
+        }
+    }
+    return best;
+}
+} // namespace
+
+TEST_CASE("nucleus/tile/HeightfieldRaycaster")
+{
+    radix::TileHeights h;
+    h.emplace({ 0, { 0, 0 } }, { 0, 5000 });
+    const auto aabb_decorator = AabbDecorator::make(std::move(h));
+
+    const auto grossglockner = nucleus::srs::lat_long_to_world({ 47.07386676653372, 12.694470292406267 });
+    const auto tile_id = nucleus::srs::world_xy_to_tile_id(grossglockner, 12);
+    const auto tile_data = test_tile_png();
+    const auto decoded = HeightfieldRaycaster::decode({ tile_id, { NetworkInfo::Status::Good, 0 }, tile_data });
+    REQUIRE(decoded);
+    REQUIRE(decoded->heights.width() == 65);
+    const auto max_height = *std::max_element(decoded->heights.buffer().begin(), decoded->heights.buffer().end());
+    REQUIRE(max_height > 10);
+
+    MemoryCache cache;
+    fill_cache(&cache, tile_id, tile_data);
+    HeightfieldRaycaster raycaster(&cache, aabb_decorator);
+
+    SECTION("decoding")
+    {
+        const auto raw = conversion::to_u16raster(nucleus::utils::image_loader::rgba8(*tile_data).value());
+        const auto bounds = nucleus::srs::tile_bounds(tile_id);
+        for (const auto& p : { glm::uvec2 { 0, 0 }, glm::uvec2 { 32, 10 }, glm::uvec2 { 64, 64 } }) {
+            const auto cell_size = bounds.size().x / 64;
+            const auto expected = nucleus::srs::lat_long_alt_to_world(
+                { nucleus::srs::world_to_lat_long({ 0, bounds.max.y - p.y * cell_size }).x, 0, raw.pixel(p) * 0.125 });
+            CHECK(std::abs(decoded->heights.pixel(p) - expected.z) < 0.01);
+        }
+    }
+
+    SECTION("vertical rays hit the vertices")
+    {
+        for (unsigned row = 1; row < 64; row += 7) {
+            for (unsigned col = 1; col < 64; col += 5) {
+                CAPTURE(row, col);
+                const auto vertex = vertex_position(*decoded, col, row);
+                const auto hit = raycaster.cast({ vertex.x, vertex.y, 10'000 }, { 0, 0, -1 });
+                REQUIRE(hit);
+                CHECK(hit->tile == tile_id);
+                CHECK(std::abs(hit->position.z - vertex.z) < 0.001);
+                CHECK(std::abs(hit->distance - (10'000 - vertex.z)) < 0.001);
+            }
+        }
+    }
+
+    SECTION("oblique rays match a brute force intersection")
+    {
+        std::mt19937 rng(42);
+        const auto bounds = nucleus::srs::tile_bounds(tile_id);
+        std::uniform_real_distribution<double> x(bounds.min.x, bounds.max.x);
+        std::uniform_real_distribution<double> y(bounds.min.y, bounds.max.y);
+        std::uniform_real_distribution<double> angle(0, 6.28318530718);
+        std::uniform_real_distribution<double> slope(0, 3);
+        unsigned n_hits = 0;
+        for (unsigned i = 0; i < 200; ++i) {
+            const auto a = angle(rng);
+            const auto s = slope(rng);
+            const auto origin = glm::dvec3(x(rng), y(rng), max_height + 500);
+            const auto direction = glm::normalize(glm::dvec3(std::cos(a) * s, std::sin(a) * s, -1));
+            CAPTURE(i, origin.x, origin.y, direction.x, direction.y, direction.z);
+            const auto expected = brute_force(*decoded, origin, direction);
+            const auto hit = raycaster.cast(origin, direction);
+            // the rest of the world is flat at 0m, so nothing in front of the tile can occlude it
+            if (expected) {
+                REQUIRE(hit);
+                CHECK(hit->tile == tile_id);
+                CHECK(std::abs(hit->distance - *expected) < 0.001);
+                ++n_hits;
+            } else if (hit) {
+                CHECK(hit->tile != tile_id);
+            }
+        }
+        CHECK(n_hits > 100);
+    }
+
+    SECTION("falls back to the parent if the quad is incomplete")
+    {
+        auto quad = cache.peak_at(tile_id.parent());
+        for (auto& t : quad.tiles) {
+            if (t.id != tile_id)
+                t.network_info.status = NetworkInfo::Status::NetworkError;
+        }
+        cache.insert(quad);
+        const auto centre = tile_centre(tile_id);
+        const auto hit = raycaster.cast({ centre.x, centre.y, 10'000 }, { 0, 0, -1 });
+        REQUIRE(hit);
+        CHECK(hit->tile == tile_id.parent());
+        CHECK(std::abs(hit->position.z) < 0.001);
+    }
+
+    SECTION("misses")
+    {
+        const auto centre = tile_centre(tile_id);
+        CHECK(!raycaster.cast({ centre.x, centre.y, 10'000 }, { 0, 0, 1 }));
+        CHECK(!raycaster.cast({ centre.x, centre.y, 10'000 }, { 1, 0, 0 }));
+        CHECK(!raycaster.cast({ centre.x, centre.y, 10'000 }, { 0, 0, -1 }, 1000));
+        CHECK(!raycaster.cast({ centre.x, centre.y, 10'000 }, { 0, 0, 0 }));
+        MemoryCache empty_cache;
+        CHECK(!HeightfieldRaycaster(&empty_cache, aabb_decorator).cast({ centre.x, centre.y, 10'000 }, { 0, 0, -1 }));
+    }
+
+    SECTION("decoded tiles are cached")
+    {
+        HeightfieldRaycaster small(&cache, aabb_decorator, 2);
+        const auto centre = tile_centre(tile_id);
+        CHECK(small.cast({ centre.x, centre.y, 10'000 }, { 0, 0, -1 }));
+        CHECK(small.n_decoded_tiles() == 1);
+        CHECK(small.cast({ centre.x, centre.y, 10'000 }, { 1, 1, -0.1 }));
+        CHECK(small.n_decoded_tiles() <= 2);
+    }
+
+    SECTION("depth tester")
+    {
+        nucleus::DataQuerier querier(&cache, aabb_decorator);
+        REQUIRE(querier.can_ray_cast());
+        const auto target = vertex_position(*decoded, 30, 30);
+        nucleus::camera::Definition camera(target + glm::dvec3(-300, -400, 3000), target);
+        camera.set_viewport_size({ 1920, 1080 });
+        FixedDepthTester fallback(camera.position() + glm::dvec3(0, 0, 1));
+        nucleus::camera::RaycastDepthTester tester(camera, &querier, &fallback);
+        const auto position = tester.position({ 0, 0 });
+        CHECK(glm::distance(position, target) < 0.1);
+        CHECK(std::abs(double(tester.depth({ 0, 0 })) - glm::distance(camera.position(), target)) < 0.1);
+        CHECK(fallback.n_queries == 0);
+
+        // without ray casting, and for rays into the sky, the fallback reports the miss
+        nucleus::DataQuerier without_decorator(&cache);
+        CHECK(!without_decorator.can_ray_cast());
+        nucleus::camera::RaycastDepthTester missing(camera, &without_decorator, &fallback);
+        CHECK(missing.position({ 0, 0 }) == fallback.fixed_position);
+        CHECK(missing.depth({ 0, 0 }) == fallback.fixed_depth);
+        CHECK(fallback.n_queries == 2);
+
+        nucleus::camera::Definition sky_camera(target + glm::dvec3(0, 0, 3000), target + glm::dvec3(100, 100, 6000));
+        sky_camera.set_viewport_size({ 1920, 1080 });
+        nucleus::camera::RaycastDepthTester sky(sky_camera, &querier, &fallback);
+        CHECK(sky.position({ 0, 0 }) == fallback.fixed_position);
+        CHECK(sky.depth({ 0, 0 }) == fallback.fixed_depth);
+        CHECK(fallback.n_queries == 4);
+    }
+
+    std::vector<std::pair<glm::dvec3, glm::dvec3>> rays;
+    {
+        std::mt19937 rng(7);
+        const auto bounds = nucleus::srs::tile_bounds(tile_id);
+        std::uniform_real_distribution<double> x(bounds.min.x, bounds.max.x);
+        std::uniform_real_distribution<double> y(bounds.min.y, bounds.max.y);
+        std::uniform_real_distribution<double> direction(-1, 1);
+        for (unsigned i = 0; i < 100; ++i)
+            rays.emplace_back(glm::dvec3(x(rng), y(rng), max_height + 500), glm::dvec3(direction(rng), direction(rng), -0.5));
+    }
+    BENCHMARK("100 rays")
+    {
+        unsigned n_hits = 0;
+        for (const auto& ray : rays)
+            n_hits += raycaster.cast(ray.first, ray.second).has_value();
+        return n_hits;
+    };
+
+    BENCHMARK("decode")
+    {
+        return HeightfieldRaycaster::decode({ tile_id, { NetworkInfo::Status::Good, 0 }, tile_data });
+    };
+}
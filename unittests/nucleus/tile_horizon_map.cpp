@@ -0,0 +1,246 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QBuffer>
+#include <QImage>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <limits>
+#include <random>
+#include <unordered_set>
+
+#include <nucleus/srs.h>
+#include <nucleus/tile/HeightfieldRaycaster.h>
+#include <nucleus/tile/HorizonMap.h>
+#include <nucleus/tile/conversion.h>
+#include <nucleus/utils/sun_calculations.h>
+
+using namespace nucleus::tile;
+
+namespace {
+// smooth ridges and valleys with a few hundred metres of relief per kilometre, continuous across tiles
+float altitude(const glm::dvec2& world)
+{
+    return float(1800 + 700 * std::sin(world.x / 900.0) * std::cos(world.y / 700.0) + 250 * std::sin((world.x + world.y) / 310.0));
+}
+
+std::shared_ptr<QByteArray> terrain_png(const Id& id)
+{
+    const auto bounds = nucleus::srs::tile_bounds(id);
+    const auto cell_size = bounds.size().x / 64;
+    QImage tile(QSize { 65, 65 }, QImage::Format_ARGB32);
+    for (int row = 0; row < 65; ++row) {
+        for (int col = 0; col < 65; ++col) {
+            const auto rgba = conversion::float2alpineRGBA(altitude({ bounds.min.x + col * cell_size, bounds.max.y - row * cell_size }));
+            tile.setPixelColor(col, row, QColor(rgba.x, rgba.y, rgba.z, rgba.w));
+        }
+    }
+    auto bytes = std::make_shared<QByteArray>();
+    QBuffer buffer(bytes.get());
+    REQUIRE(buffer.open(QIODevice::WriteOnly));
+    tile.save(&buffer, "PNG");
+    return bytes;
+}
+
+Data terrain_tile(const Id& id) { return { id, { NetworkInfo::Status::Good, 0 }, terrain_png(id) }; }
+
+Id neighbour(const Id& id, int dx, int dy_south)
+{
+    const auto bounds = nucleus::srs::tile_bounds(id);
+    return nucleus::srs::world_xy_to_tile_id((bounds.min + bounds.max) * 0.5 + glm::dvec2(dx, -dy_south) * bounds.size(), id.zoom_level);
+}
+
+// inserts the complete quads containing the given tiles
+void fill_cache(MemoryCache* cache, const std::vector<Id>& tiles)
+{
+    std::unordered_set<Id, Id::Hasher> quads;
+    for (const auto& tile : tiles)
+        quads.insert(tile.parent());
+    for (const auto& id : quads) {
+        DataQuad quad;
+        quad.id = id;
+        quad.n_tiles = 4;
+        const auto children = id.children();
+        for (unsigned i = 0; i < 4; ++i)
+            quad.tiles[i] = terrain_tile(children[i]);
+        cache->insert(quad);
+    }
+}
+
+std::vector<Id> block(const Id& centre, int n_rings)
+{
+    std::vector<Id> tiles;
+    for (int dy = -n_rings; dy <= n_rings; ++dy) {
+        for (int dx = -n_rings; dx <= n_rings; ++dx)
+            tiles.push_back(neighbour(centre, dx, dy));
+    }
+    return tiles;
+}
+
+// shoots a ray from the vertex towards the sun through the triangles of all given tiles
+bool is_sunlit_reference(const std::vector<HeightfieldRaycaster::DecodedTile>& tiles, const HeightfieldRaycaster::DecodedTile& tile, const glm::uvec2& texel, const glm::dvec3& to_sun)
+{
+    const auto bounds = nucleus::srs::tile_bounds(tile.id);
+    const auto cell_size = bounds.size().x / (tile.heights.width() - 1);
+    const auto origin = glm::dvec3(bounds.min.x + texel.x * cell_size, bounds.max.y - texel.y * cell_size, tile.heights.pixel(texel) + 0.01);
+    for (const auto& t : tiles) {
+        if (HeightfieldRaycaster::intersect(t, origin, to_sun, cell_size * 1e-3, std::numeric_limits<double>::infinity()))
+            return false;
+    }
+    return true;
+}
+} // namespace
+
+TEST_CASE("nucleus/tile/HorizonMap")
+{
+    const auto grossglockner = nucleus::srs::lat_long_to_world({ 47.07386676653372, 12.694470292406267 });
+    const auto tile_id = nucleus::srs::world_xy_to_tile_id(grossglockner, 14);
+
+    SECTION("lookup")
+    {
+        HorizonMap map { tile_id, 8, 2, nucleus::Raster<glm::u8vec4>(glm::uvec2(2, 4), glm::u8vec4(0)) };
+        // direction 2 (east) has a horizon at 30°, direction 3 (south east) at 0°
+        map.texture.pixel({ 1, 0 }) = { 0, 0, 128, 0 };
+        CHECK(std::abs(map.horizon_sine({ 1, 0 }, 2u) - 0.5f) < 0.01f);
+        CHECK(std::abs(map.horizon_sine({ 1, 0 }, 90.0f) - 0.5f) < 0.01f);
+        CHECK(std::abs(map.horizon_sine({ 1, 0 }, 112.5f) - 0.25f) < 0.01f);
+        CHECK(std::abs(map.horizon_sine({ 1, 0 }, 90.0f + 360.0f) - 0.5f) < 0.01f);
+        CHECK(map.horizon_sine({ 0, 0 }, 90.0f) == 0);
+
+        using nucleus::utils::sun_calculations::sun_rays_direction_from_sun_angles;
+        CHECK(!map.is_sunlit({ 1, 0 }, glm::dvec3(sun_rays_direction_from_sun_angles({ 90, 70 }))));
+        CHECK(map.is_sunlit({ 1, 0 }, glm::dvec3(sun_rays_direction_from_sun_angles({ 90, 50 }))));
+        CHECK(map.is_sunlit({ 1, 0 }, glm::dvec3(sun_rays_direction_from_sun_angles({ 270, 85 }))));
+        CHECK(map.is_sunlit({ 0, 0 }, glm::dvec3(sun_rays_direction_from_sun_angles({ 90, 85 }))));
+        // sun below the horizontal plane
+        CHECK(!map.is_sunlit({ 0, 0 }, glm::dvec3(sun_rays_direction_from_sun_angles({ 90, 95 }))));
+    }
+
+    SECTION("gather stitches neighbours")
+    {
+        MemoryCache cache;
+        fill_cache(&cache, block(tile_id, 1));
+        const HorizonMapGenerator generator(&cache);
+        const auto neighbourhood = generator.gather(tile_id);
+        REQUIRE(neighbourhood);
+        CHECK(neighbourhood->size == 65);
+        CHECK(neighbourhood->heights.size() == glm::uvec2(3 * 64 + 1));
+        CHECK(neighbourhood->centre_offset() == glm::uvec2(64));
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const auto decoded = HeightfieldRaycaster::decode(terrain_tile(neighbour(tile_id, dx, dy)));
+                REQUIRE(decoded);
+                const auto offset = glm::uvec2(unsigned(dx + 1) * 64, unsigned(dy + 1) * 64);
+                for (const auto& texel : { glm::uvec2(1, 1), glm::uvec2(32, 17), glm::uvec2(63, 40) })
+                    CHECK(std::abs(neighbourhood->heights.pixel(offset + texel) - decoded->heights.pixel(texel)) < 0.01f);
+            }
+        }
+    }
+
+    SECTION("missing neighbours are sampled from ancestors")
+    {
+        // only the siblings of the tile and the parents of the neighbours, which cover them at half the resolution
+        MemoryCache cache;
+        std::vector<Id> tiles = { tile_id };
+        for (const auto& id : block(tile_id, 1))
+            tiles.push_back(id.parent());
+        fill_cache(&cache, tiles);
+        const HorizonMapGenerator generator(&cache);
+        const auto neighbourhood = generator.gather(tile_id);
+        REQUIRE(neighbourhood);
+        unsigned n_sampled = 0;
+        unsigned n_empty = 0;
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                const auto decoded = HeightfieldRaycaster::decode(terrain_tile(neighbour(tile_id, dx, dy)));
+                const auto texel = glm::uvec2(unsigned(dx + 1) * 64 + 31, unsigned(dy + 1) * 64 + 31);
+                const auto height = neighbourhood->heights.pixel(texel);
+                if (height < -1000) {
+                    ++n_empty;
+                    continue;
+                }
+                ++n_sampled;
+                CHECK(std::abs(height - decoded->heights.pixel({ 31, 31 })) < 10.0f);
+            }
+        }
+        CHECK(n_sampled == 9);
+        CHECK(n_empty == 0);
+    }
+
+    SECTION("nothing is occluded without neighbours on flat ground")
+    {
+        HorizonMapGenerator::Neighbourhood flat { tile_id, 1, 65, 10.0, nucleus::Raster<float>(glm::uvec2(193), 1000.0f) };
+        const auto map = HorizonMapGenerator::compute(flat, {});
+        CHECK(map.texture.size() == glm::uvec2(65, 130));
+        CHECK(std::all_of(map.texture.buffer().begin(), map.texture.buffer().end(), [](const glm::u8vec4& v) { return v == glm::u8vec4(0); }));
+    }
+
+    SECTION("agrees with ray marching")
+    {
+        MemoryCache cache;
+        const auto tiles = block(tile_id, 1);
+        fill_cache(&cache, tiles);
+        std::vector<HeightfieldRaycaster::DecodedTile> decoded;
+        for (const auto& id : tiles)
+            decoded.push_back(HeightfieldRaycaster::decode(terrain_tile(id)).value());
+        const auto& centre = decoded[4];
+        REQUIRE(centre.id == tile_id);
+
+        const HorizonMapGenerator generator(&cache);
+        const auto map = generator.generate(tile_id);
+        REQUIRE(map);
+        CHECK(map->id == tile_id);
+        CHECK(map->texture.size() == glm::uvec2(65, 65 * 4));
+
+        std::mt19937 rng(7);
+        std::uniform_int_distribution<unsigned> texel(0, 64);
+        std::uniform_real_distribution<float> azimuth(0, 360);
+        std::uniform_real_distribution<float> zenith(30, 85);
+        unsigned n_agreeing = 0;
+        unsigned n_lit = 0;
+        const unsigned n_samples = 1000;
+        for (unsigned i = 0; i < n_samples; ++i) {
+            const auto t = glm::uvec2(texel(rng), texel(rng));
+            const auto sun_rays = glm::dvec3(nucleus::utils::sun_calculations::sun_rays_direction_from_sun_angles({ azimuth(rng), zenith(rng) }));
+            const auto reference = is_sunlit_reference(decoded, centre, t, -sun_rays);
+            n_agreeing += map->is_sunlit(t, sun_rays) == reference ? 1 : 0;
+            n_lit += reference ? 1 : 0;
+        }
+        // the fixture must have both
+        CHECK(n_lit > n_samples / 10);
+        CHECK(n_lit < n_samples * 9 / 10);
+        CHECK(n_agreeing > n_samples * 95 / 100);
+    }
+}
+
+TEST_CASE("nucleus/tile/HorizonMap benchmarks")
+{
+    const auto tile_id = nucleus::srs::world_xy_to_tile_id(nucleus::srs::lat_long_to_world({ 47.07386676653372, 12.694470292406267 }), 14);
+    MemoryCache cache;
+    fill_cache(&cache, block(tile_id, 2));
+    const HorizonMapGenerator generator(&cache);
+    const auto neighbourhood = generator.gather(tile_id).value();
+
+    BENCHMARK("gather 3x3 tiles (png decoding)") { return generator.gather(tile_id)->heights.width(); };
+    BENCHMARK("horizon map 65x65, 8 directions, 1 ring") { return HorizonMapGenerator::compute(neighbourhood, { .n_directions = 8 }).texture.width(); };
+    BENCHMARK("horizon map 65x65, 16 directions, 1 ring") { return HorizonMapGenerator::compute(neighbourhood, {}).texture.width(); };
+
+    const HorizonMapGenerator wide_generator(&cache, { .n_rings = 2 });
+    const auto wide_neighbourhood = wide_generator.gather(tile_id).value();
+    BENCHMARK("horizon map 65x65, 16 directions, 2 rings") { return HorizonMapGenerator::compute(wide_neighbourhood, wide_generator.settings()).texture.width(); };
+}
@@ -0,0 +1,147 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <nucleus/camera/PositionStorage.h>
+#include <nucleus/srs.h>
+#include <nucleus/tile/drawing.h>
+#include <nucleus/tile/instances.h>
+#include <nucleus/tile/utils.h>
+#include <radix/TileHeights.h>
+
+using namespace radix;
+using namespace nucleus::tile;
+using nucleus::tile::utils::AabbDecorator;
+
+TEST_CASE("nucleus/tile/instances")
+{
+    TileHeights h;
+    h.emplace({ 0, { 0, 0 } }, { 100, 4000 });
+    const auto aabb_decorator = AabbDecorator::make(std::move(h));
+    auto camera = nucleus::camera::stored_positions::grossglockner();
+    camera.set_viewport_size({ 1920, 1080 });
+    const auto draw_list = drawing::compute_bounds(drawing::limit(drawing::generate_list(camera, aabb_decorator, 19), 1024u), aabb_decorator);
+    REQUIRE(draw_list.size() > 10);
+
+    // every other tile is on the gpu, the rest falls back to the parent
+    GpuArrayHelper layers;
+    layers.set_tile_limit(2048);
+    for (unsigned i = 0; i < draw_list.size(); ++i) {
+        const auto id = (i % 2 == 0) ? draw_list[i].id : draw_list[i].id.parent();
+        if (!layers.contains(id))
+            layers.add_tile(id);
+    }
+
+    SECTION("pack instances")
+    {
+        std::vector<GpuTileInstance> instances;
+        pack_instances(draw_list, camera.position(), layers, instances);
+        REQUIRE(instances.size() == draw_list.size());
+        for (unsigned i = 0; i < draw_list.size(); ++i) {
+            const auto& tile = draw_list[i];
+            const auto& instance = instances[i];
+            CHECK(instance.bounds.x == float(tile.bounds.min.x - camera.position().x));
+            CHECK(instance.bounds.w == float(tile.bounds.max.y - camera.position().y));
+            CHECK(nucleus::srs::unpack(instance.packed_id) == tile.id);
+            const auto layer = layers.layer(tile.id);
+            CHECK(unsigned(instance.dtm_array_index) == layer.index);
+            CHECK(unsigned(instance.dtm_zoom) == layer.id.zoom_level);
+            CHECK(unsigned(instance.dtm_zoom) <= tile.id.zoom_level);
+        }
+
+        // capacity is reused
+        const auto* data = instances.data();
+        pack_instances(std::vector<TileBounds>(draw_list.begin(), draw_list.begin() + 10), camera.position(), layers, instances);
+        CHECK(instances.size() == 10);
+        CHECK(instances.data() == data);
+    }
+
+    SECTION("tiles that are not on the gpu get layer 0")
+    {
+        std::vector<GpuTileInstance> instances;
+        pack_instances(draw_list, camera.position(), GpuArrayHelper(), instances);
+        REQUIRE(instances.size() == draw_list.size());
+        CHECK(unsigned(instances.front().dtm_array_index) == 0u);
+        CHECK(unsigned(instances.front().dtm_zoom) == 0u);
+    }
+
+    SECTION("no more than max_n_tile_instances")
+    {
+        std::vector<TileBounds> long_list;
+        while (long_list.size() <= max_n_tile_instances)
+            long_list.insert(long_list.end(), draw_list.begin(), draw_list.end());
+        std::vector<GpuTileInstance> instances;
+        pack_instances(long_list, camera.position(), layers, instances);
+        CHECK(instances.size() == max_n_tile_instances);
+    }
+
+    SECTION("pack texture layers")
+    {
+        nucleus::Raster<uint16_t> array_index({ max_n_tile_instances, 1 });
+        nucleus::Raster<uint8_t> zoom({ max_n_tile_instances, 1 });
+        pack_texture_layers(draw_list, layers, array_index, zoom);
+        for (unsigned i = 0; i < draw_list.size(); ++i) {
+            const auto layer = layers.layer(draw_list[i].id);
+            CHECK(unsigned(array_index.pixel({ i, 0 })) == layer.index);
+            CHECK(unsigned(zoom.pixel({ i, 0 })) == layer.id.zoom_level);
+        }
+    }
+
+    // what gl_engine::TileGeometry::draw did for every pass (gbuffer layers and 4 shadow cascades) before the instance block was shared
+    BENCHMARK("per pass rebuild, 6 passes")
+    {
+        size_t checksum = 0;
+        for (unsigned pass = 0; pass < 6; ++pass) {
+            std::vector<glm::vec4> bounds;
+            bounds.reserve(draw_list.size());
+            std::vector<glm::u32vec2> packed_id;
+            packed_id.reserve(draw_list.size());
+            nucleus::Raster<uint8_t> zoom_level_raster = { glm::uvec2 { 1024, 1 } };
+            nucleus::Raster<uint16_t> array_index_raster = { glm::uvec2 { 1024, 1 } };
+            nucleus::Raster<glm::vec4> bounds_raster = { glm::uvec2 { 1024, 1 } };
+            for (unsigned i = 0; i < std::min(unsigned(draw_list.size()), 1024u); ++i) {
+                const auto& tile = draw_list[i];
+                bounds.push_back(glm::vec4 { tile.bounds.min.x - camera.position().x,
+                    tile.bounds.min.y - camera.position().y,
+                    tile.bounds.max.x - camera.position().x,
+                    tile.bounds.max.y - camera.position().y });
+                packed_id.push_back(nucleus::srs::pack(tile.id));
+                const auto layer = layers.layer(draw_list[i].id);
+                if (layer.id.zoom_level > 50)
+                    continue;
+                zoom_level_raster.pixel({ i, 0 }) = uint8_t(layer.id.zoom_level);
+                array_index_raster.pixel({ i, 0 }) = uint16_t(layer.index);
+                const auto geom_aabb = aabb_decorator->aabb(layer.id);
+                bounds_raster.pixel({ i, 0 }) = glm::vec4 { geom_aabb.min.x - camera.position().x,
+                    geom_aabb.min.y - camera.position().y,
+                    geom_aabb.max.x - camera.position().x,
+                    geom_aabb.max.y - camera.position().y };
+            }
+            checksum += bounds.size() + packed_id.size() + zoom_level_raster.pixel({ 0, 0 }) + array_index_raster.pixel({ 0, 0 });
+        }
+        return checksum;
+    };
+
+    std::vector<GpuTileInstance> instances;
+    BENCHMARK("pack once")
+    {
+        pack_instances(draw_list, camera.position(), layers, instances);
+        return instances.size();
+    };
+}
@@ -17,6 +17,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  *****************************************************************************/
 
+#include <algorithm>
 #include <unordered_set>
 
 #include "nucleus/utils/Stopwatch.h"
@@ -28,6 +29,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include <nucleus/camera/PositionStorage.h>
 #include <nucleus/tile/SchedulerDirector.h>
+#include <nucleus/tile/TextureDiskCache.h>
 #include <nucleus/tile/TextureScheduler.h>
 #include <nucleus/tile/conversion.h>
 #include <nucleus/tile/types.h>
@@ -423,6 +425,70 @@ TEST_CASE("nucleus/tile/Scheduler")
         CHECK(gpu_tiles[0].texture->at(0).height() == 512);
     }
 
+    SECTION("compressed textures are served from the texture disk cache")
+    {
+        const auto quad = example_tile_quad_for(Id { 0, { 0, 0 } });
+        const auto gpu_texture = [&quad](bool disk_cache_enabled) {
+            auto scheduler = default_scheduler();
+            scheduler->set_texture_compression_algorithm(nucleus::utils::ColourTexture::Format::DXT1);
+            scheduler->set_texture_disk_cache_enabled(disk_cache_enabled);
+            QSignalSpy spy(scheduler.get(), &TextureScheduler::gpu_tiles_updated);
+            scheduler->receive_quad(quad);
+            scheduler->update_camera(nucleus::camera::stored_positions::stephansdom());
+            scheduler->update_gpu_quads();
+            REQUIRE(spy.size() == 1);
+            const auto gpu_tiles = spy[0][1].value<std::vector<nucleus::tile::GpuTextureTile>>();
+            REQUIRE(gpu_tiles.size() == 1);
+            REQUIRE(gpu_tiles[0].texture);
+            return gpu_tiles[0].texture;
+        };
+        const auto cache_path = default_scheduler()->texture_cache_path();
+        std::filesystem::remove_all(cache_path);
+
+        const auto computed = gpu_texture(true);
+        REQUIRE(std::filesystem::exists(cache_path));
+        CHECK(!std::filesystem::is_empty(cache_path));
+        {
+            const auto cached = TextureDiskCache(cache_path).read(quad, nucleus::utils::ColourTexture::Format::DXT1);
+            REQUIRE(cached);
+            REQUIRE(cached->size() == computed->size());
+            CHECK(std::equal(computed->front().data(), computed->front().data() + computed->front().n_bytes(), cached->front().data()));
+        }
+
+        // replace the cached texture to see, that it is used instead of compressing the tiles again
+        const auto replacement = nucleus::utils::generate_mipmapped_colour_texture(
+            nucleus::Raster<glm::u8vec4>({ 512, 512 }, glm::u8vec4 { 255, 0, 0, 255 }), nucleus::utils::ColourTexture::Format::DXT1);
+        REQUIRE(TextureDiskCache(cache_path).write(quad, replacement));
+        const auto served = gpu_texture(true);
+        REQUIRE(served->size() == replacement.size());
+        CHECK(std::equal(replacement.front().data(), replacement.front().data() + replacement.front().n_bytes(), served->front().data()));
+        CHECK(!std::equal(computed->front().data(), computed->front().data() + computed->front().n_bytes(), served->front().data()));
+
+        // not used when disabled
+        const auto recomputed = gpu_texture(false);
+        CHECK(std::equal(computed->front().data(), computed->front().data() + computed->front().n_bytes(), recomputed->front().data()));
+
+        // purged quads are removed from disk
+        {
+            auto scheduler = default_scheduler();
+            scheduler->set_texture_disk_cache_enabled(true);
+            scheduler->receive_quad(quad);
+            scheduler->set_ram_quad_limit(0);
+            scheduler->purge_ram_cache();
+            CHECK(!TextureDiskCache(cache_path).read(quad, nucleus::utils::ColourTexture::Format::DXT1));
+        }
+
+        // textures are removed together with a tile cache that can't be read
+        {
+            REQUIRE(TextureDiskCache(cache_path).write(quad, replacement));
+            auto scheduler = default_scheduler();
+            std::filesystem::remove_all(scheduler->disk_cache_path());
+            CHECK(!scheduler->read_disk_cache());
+            CHECK(!std::filesystem::exists(cache_path));
+        }
+        std::filesystem::remove_all(cache_path);
+    }
+
     SECTION("gpu quads are updated when serving from cache")
     {
         auto scheduler = default_scheduler();
@@ -813,6 +879,25 @@ TEST_CASE("nucleus/tile/Scheduler benchmarks")
         scheduler->purge_ram_cache();
     };
 
+    {
+        // gpu textures of a warm start, computed from the tiles vs. read from a pre-filled texture disk cache
+        const auto update_gpu_quads = [&camera](bool disk_cache_enabled) {
+            auto scheduler = default_scheduler();
+            scheduler->set_texture_compression_algorithm(nucleus::utils::ColourTexture::Format::DXT1);
+            scheduler->set_texture_disk_cache_enabled(disk_cache_enabled);
+            scheduler->update_camera(camera);
+            for (const auto& q : example_quads_for_steffl_and_gg())
+                scheduler->receive_quad(q);
+            scheduler->update_gpu_quads();
+            return scheduler->texture_cache_path();
+        };
+        const auto cache_path = update_gpu_quads(true);
+        const auto n_quads = std::to_string(example_quads_for_steffl_and_gg().size());
+        BENCHMARK("receive " + n_quads + " quads + update_gpu_quads (DXT1, without texture disk cache)") { return update_gpu_quads(false); };
+        BENCHMARK("receive " + n_quads + " quads + update_gpu_quads (DXT1, warm texture disk cache)") { return update_gpu_quads(true); };
+        std::filesystem::remove_all(cache_path);
+    }
+
     {
         auto scheduler = default_scheduler();
         scheduler->receive_quad({example_tile_quad_for({0, {0, 0}}),});
@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <algorithm>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <nucleus/camera/PositionStorage.h>
+#include <nucleus/tile/ShadowCascadeCache.h>
+#include <nucleus/tile/drawing.h>
+#include <nucleus/tile/utils.h>
+#include <radix/TileHeights.h>
+
+using namespace radix;
+using namespace nucleus::tile;
+using nucleus::tile::utils::AabbDecorator;
+
+namespace {
+// straight line, one frame per step
+nucleus::camera::recording::Animation make_path(nucleus::camera::Definition camera, const glm::dvec3& step, unsigned n_frames)
+{
+    nucleus::camera::recording::Animation path;
+    for (unsigned i = 0; i < n_frames; ++i) {
+        path.push_back({ i * 16, camera.model_matrix() });
+        camera.move(step);
+    }
+    return path;
+}
+} // namespace
+
+TEST_CASE("nucleus/tile/ShadowCascadeCache")
+{
+    TileHeights h;
+    h.emplace({ 0, { 0, 0 } }, { 100, 4000 });
+    const auto aabb_decorator = AabbDecorator::make(std::move(h));
+    const auto generate_draw_list = [&](const nucleus::camera::Definition& camera) {
+        return drawing::compute_bounds(drawing::limit(drawing::generate_list(camera, aabb_decorator, 19), 1024u), aabb_decorator);
+    };
+
+    auto camera = nucleus::camera::stored_positions::grossglockner();
+    camera.set_viewport_size({ 1920, 1080 });
+    const auto draw_list = generate_draw_list(camera);
+    const auto light = glm::normalize(glm::dvec3(-1, 1, 1));
+
+    SECTION("static camera draws every cascade once")
+    {
+        ShadowCascadeCache cache;
+        CHECK(cache.update(camera, light, draw_list) == std::vector<bool>(4, true));
+        for (unsigned i = 0; i < 10; ++i)
+            CHECK(cache.update(camera, light, draw_list) == std::vector<bool>(4, false));
+        CHECK(cache.statistics().n_frames == 11);
+        CHECK(cache.statistics().n_redraws == std::vector<unsigned>(4, 1));
+        CHECK(cache.statistics().total_redraws() == 4);
+    }
+
+    SECTION("cascade boxes contain their frustum slice")
+    {
+        ShadowCascadeCache cache;
+        cache.update(camera, light, draw_list);
+        const auto planes = cache.cascade_planes();
+        REQUIRE(planes.size() == 5);
+        CHECK(planes[0] == double(camera.near_plane()));
+        for (unsigned i = 0; i < cache.n_cascades(); ++i) {
+            CAPTURE(i);
+            for (const auto distance : { planes[i], (planes[i] + planes[i + 1]) / 2, planes[i + 1] }) {
+                const auto world_position = camera.position() - camera.z_axis() * distance;
+                const auto local = glm::vec4(cache.local_light_view_projection(i, camera.position()) * glm::vec4(world_position - camera.position(), 1));
+                CHECK(std::abs(local.x) <= 1.0f);
+                CHECK(std::abs(local.y) <= 1.0f);
+                CHECK(std::abs(local.z) <= 1.0f);
+            }
+            CHECK(cache.cascade(i).depth_min < cache.cascade(i).depth_max);
+        }
+    }
+
+    SECTION("sub texel moves keep the far cascade")
+    {
+        ShadowCascadeCache cache;
+        cache.update(camera, light, draw_list);
+        const auto matrix = cache.cascade(3).light_view_projection;
+        auto moved = camera;
+        moved.move({ 0.01, 0.01, 0 });
+        const auto redraw = cache.update(moved, light, draw_list);
+        CHECK(!redraw[3]);
+        CHECK(cache.cascade(3).light_view_projection == matrix);
+    }
+
+    SECTION("walking 200 metres mostly redraws the near cascades")
+    {
+        // fixed draw list, so only the snapped boxes cause redraws
+        const auto path = make_path(camera, { 1, 0, 0 }, 200);
+        const auto stats = replay({}, path, camera, light, [&](const nucleus::camera::Definition&) { return draw_list; });
+        CHECK(stats.n_frames == 200);
+        REQUIRE(stats.n_redraws.size() == 4);
+        // far cascade texels are ~80m
+        CHECK(stats.n_redraws[3] <= 10);
+        CHECK(stats.n_redraws[0] > 5 * stats.n_redraws[3]);
+        CHECK(stats.n_redraws[0] >= stats.n_redraws[1]);
+        CHECK(stats.total_redraws() < 4 * 200);
+    }
+
+    SECTION("replaying with streamed draw lists")
+    {
+        const auto path = make_path(camera, { 0.5, 0.5, 0 }, 100);
+        const auto stats = replay({}, path, camera, light, generate_draw_list);
+        CHECK(stats.n_frames == 100);
+        CHECK(stats.total_redraws() >= 4);
+    }
+
+    SECTION("light direction")
+    {
+        ShadowCascadeCache cache;
+        cache.update(camera, light, draw_list);
+        // below the tolerance, the cached direction is kept
+        const auto slightly_rotated = glm::normalize(light + glm::dvec3(1e-7, 0, 0));
+        CHECK(cache.update(camera, slightly_rotated, draw_list) == std::vector<bool>(4, false));
+        CHECK(cache.cascade(0).direction_to_light == light);
+
+        const auto rotated = glm::normalize(light + glm::dvec3(1e-3, 0, 0));
+        CHECK(cache.update(camera, rotated, draw_list) == std::vector<bool>(4, true));
+        CHECK(cache.cascade(0).direction_to_light == rotated);
+    }
+
+    SECTION("a tile change only invalidates the cascades containing the tile")
+    {
+        ShadowCascadeCache cache;
+        cache.update(camera, light, draw_list);
+        REQUIRE(!cache.cascade(0).tiles.empty());
+        const auto changed = cache.cascade(0).tiles.front().id;
+        const auto redraw = cache.update(camera, light, draw_list, [&](const tile::Id& id) { return id == changed ? id.parent() : id; });
+        for (unsigned i = 0; i < cache.n_cascades(); ++i) {
+            const auto& tiles = cache.cascade(i).tiles;
+            const auto contains = std::find_if(tiles.begin(), tiles.end(), [&](const TileBounds& t) { return t.id == changed; }) != tiles.end();
+            CHECK(redraw[i] == contains);
+        }
+        CHECK(redraw[0]);
+    }
+
+    SECTION("invalidate")
+    {
+        ShadowCascadeCache cache;
+        cache.update(camera, light, draw_list);
+        cache.invalidate();
+        CHECK(cache.update(camera, light, draw_list) == std::vector<bool>(4, true));
+    }
+
+    BENCHMARK("update")
+    {
+        ShadowCascadeCache cache;
+        return cache.update(camera, light, draw_list);
+    };
+}
@@ -0,0 +1,151 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QTemporaryDir>
+#include <algorithm>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+
+#include <nucleus/tile/TextureDiskCache.h>
+
+using namespace nucleus::tile;
+using Format = nucleus::utils::ColourTexture::Format;
+
+namespace {
+DataQuad quad_for(const Id& id, uint64_t timestamp)
+{
+    DataQuad quad;
+    quad.id = id;
+    quad.n_tiles = 4;
+    const auto children = id.children();
+    for (unsigned i = 0; i < 4; ++i) {
+        quad.tiles[i].id = children[i];
+        quad.tiles[i].network_info = { NetworkInfo::Status::Good, timestamp + i };
+        quad.tiles[i].data = std::make_shared<QByteArray>();
+    }
+    return quad;
+}
+
+nucleus::utils::MipmappedColourTexture texture_for(Format format)
+{
+    nucleus::Raster<glm::u8vec4> raster({ 64, 64 }, glm::u8vec4(0));
+    for (unsigned y = 0; y < 64; ++y) {
+        for (unsigned x = 0; x < 64; ++x)
+            raster.pixel({ x, y }) = glm::u8vec4(x * 4, y * 4, (x + y) * 2, 255);
+    }
+    return nucleus::utils::generate_mipmapped_colour_texture(raster, format);
+}
+
+void check_equal(const nucleus::utils::MipmappedColourTexture& a, const nucleus::utils::MipmappedColourTexture& b)
+{
+    REQUIRE(a.size() == b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        CHECK(a[i].width() == b[i].width());
+        CHECK(a[i].height() == b[i].height());
+        CHECK(a[i].format() == b[i].format());
+        REQUIRE(a[i].n_bytes() == b[i].n_bytes());
+        CHECK(std::equal(a[i].data(), a[i].data() + a[i].n_bytes(), b[i].data()));
+    }
+}
+} // namespace
+
+TEST_CASE("nucleus/tile/TextureDiskCache")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    TextureDiskCache cache(std::filesystem::path(dir.path().toStdString()) / "textures");
+    const auto quad = quad_for({ 10, { 558, 668 } }, 1000);
+
+    SECTION("round trip")
+    {
+        CHECK(!cache.read(quad, Format::DXT1));
+        for (const auto format : { Format::Uncompressed_RGBA, Format::DXT1, Format::ETC1 }) {
+            const auto texture = texture_for(format);
+            REQUIRE(cache.write(quad, texture));
+            const auto read = cache.read(quad, format);
+            REQUIRE(read);
+            check_equal(*read, texture);
+        }
+    }
+
+    SECTION("formats are stored separately")
+    {
+        REQUIRE(cache.write(quad, texture_for(Format::DXT1)));
+        CHECK(!cache.read(quad, Format::ETC1));
+        CHECK(!cache.read(quad, Format::Uncompressed_RGBA));
+        CHECK(!cache.read(quad_for({ 10, { 558, 669 } }, 1000), Format::DXT1));
+    }
+
+    SECTION("refreshed source tiles invalidate the texture")
+    {
+        REQUIRE(cache.write(quad, texture_for(Format::DXT1)));
+        auto refreshed = quad;
+        refreshed.tiles[2].network_info.timestamp += 10;
+        CHECK(!cache.read(refreshed, Format::DXT1));
+        // the order of tiles in the quad doesn't matter
+        auto shuffled = quad;
+        std::swap(shuffled.tiles[0], shuffled.tiles[3]);
+        CHECK(cache.read(shuffled, Format::DXT1));
+    }
+
+    SECTION("remove")
+    {
+        REQUIRE(cache.write(quad, texture_for(Format::DXT1)));
+        REQUIRE(cache.write(quad, texture_for(Format::ETC1)));
+        cache.remove(quad.id);
+        CHECK(!cache.read(quad, Format::DXT1));
+        CHECK(!cache.read(quad, Format::ETC1));
+        cache.remove(quad.id); // doesn't throw if there is nothing
+    }
+
+    SECTION("truncated files are a miss")
+    {
+        REQUIRE(cache.write(quad, texture_for(Format::DXT1)));
+        for (const auto& entry : std::filesystem::directory_iterator(cache.base_path()))
+            std::filesystem::resize_file(entry.path(), std::filesystem::file_size(entry.path()) / 2);
+        CHECK(!cache.read(quad, Format::DXT1));
+    }
+
+    SECTION("overwriting leaves a single complete file")
+    {
+        REQUIRE(cache.write(quad, texture_for(Format::DXT1)));
+        const auto texture = texture_for(Format::DXT1);
+        REQUIRE(cache.write(quad, texture));
+        const auto n_files = std::distance(std::filesystem::directory_iterator(cache.base_path()), std::filesystem::directory_iterator());
+        CHECK(n_files == 1);
+        const auto read = cache.read(quad, Format::DXT1);
+        REQUIRE(read);
+        check_equal(*read, texture);
+    }
+}
+
+TEST_CASE("nucleus/tile/TextureDiskCache benchmarks")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    TextureDiskCache cache(std::filesystem::path(dir.path().toStdString()));
+    const auto quad = quad_for({ 10, { 558, 668 } }, 1000);
+    nucleus::Raster<glm::u8vec4> raster({ 512, 512 }, glm::u8vec4(120, 140, 90, 255));
+    const auto texture = nucleus::utils::generate_mipmapped_colour_texture(raster, Format::DXT1);
+    REQUIRE(cache.write(quad, texture));
+
+    BENCHMARK("compress 512x512 DXT1 with mipmaps") { return nucleus::utils::generate_mipmapped_colour_texture(raster, Format::DXT1).size(); };
+    BENCHMARK("write 512x512 DXT1 with mipmaps") { return cache.write(quad, texture).has_value(); };
+    BENCHMARK("read 512x512 DXT1 with mipmaps") { return cache.read(quad, Format::DXT1)->size(); };
+}
@@ -0,0 +1,141 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QFile>
+#include <QStandardPaths>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <nucleus/camera/PositionStorage.h>
+#include <nucleus/tile/drawing.h>
+#include <nucleus/timing/FrameReplay.h>
+#include <radix/TileHeights.h>
+
+using namespace nucleus::timing;
+using nucleus::tile::utils::AabbDecorator;
+
+namespace {
+// complete quads for every tile the camera would draw, all carrying the test tile
+void fill_fixture(nucleus::tile::MemoryCache* cache, const nucleus::camera::Definition& camera, const nucleus::tile::utils::AabbDecoratorPtr& aabb_decorator)
+{
+    QFile file(QString("%1%2").arg(ALP_TEST_DATA_DIR, "test-tile.png"));
+    REQUIRE(file.open(QIODevice::ReadOnly));
+    const auto data = std::make_shared<QByteArray>(file.readAll());
+
+    for (const auto& id : nucleus::tile::drawing::generate_list(camera, aabb_decorator, 16)) {
+        for (auto quad_id = id; quad_id.zoom_level > 0;) {
+            quad_id = quad_id.parent();
+            if (cache->contains(quad_id))
+                break;
+            nucleus::tile::DataQuad quad;
+            quad.id = quad_id;
+            quad.n_tiles = 4;
+            const auto children = quad_id.children();
+            for (unsigned i = 0; i < 4; ++i)
+                quad.tiles[i] = { children[i], { nucleus::tile::NetworkInfo::Status::Good, nucleus::utils::time_since_epoch() }, data };
+            cache->insert(quad);
+        }
+    }
+}
+
+nucleus::camera::recording::Animation make_path(nucleus::camera::Definition camera, unsigned n_frames)
+{
+    nucleus::camera::recording::Animation path;
+    for (unsigned i = 0; i < n_frames; ++i) {
+        path.push_back({ i * 16, camera.model_matrix() });
+        camera.move({ 20, 10, 0 });
+        camera.orbit(camera.position() - camera.z_axis() * 1000.0, { 1, 0 });
+    }
+    return path;
+}
+} // namespace
+
+TEST_CASE("nucleus/timing/FrameReplay")
+{
+    radix::TileHeights h;
+    h.emplace({ 0, { 0, 0 } }, { 100, 4000 });
+    const auto aabb_decorator = AabbDecorator::make(std::move(h));
+    const auto camera = nucleus::camera::stored_positions::grossglockner();
+    const auto path = make_path(camera, 60);
+
+    const auto fixture_path = std::filesystem::path(QStandardPaths::writableLocation(QStandardPaths::CacheLocation).toStdString()) / "test_frame_replay";
+    std::filesystem::remove_all(fixture_path);
+    {
+        nucleus::tile::MemoryCache cache;
+        auto fixture_camera = camera;
+        fixture_camera.set_viewport_size({ 1920, 1080 });
+        fill_fixture(&cache, fixture_camera, aabb_decorator);
+        REQUIRE(cache.write_to_disk(fixture_path).has_value());
+    }
+
+    FrameReplay replay(aabb_decorator);
+    REQUIRE(replay.load_fixture(fixture_path).has_value());
+    REQUIRE(replay.ram_cache().n_cached_objects() > 10);
+
+    SECTION("report")
+    {
+        const auto report = replay.run(path, camera);
+        CHECK(report.n_frames == 60);
+        CHECK(report.n_gpu_tiles > 0);
+        CHECK(report.max_n_tiles_drawn > 10);
+        REQUIRE(report.stages.size() == FrameReplay::stage_names().size());
+        for (const auto& stage : report.stages) {
+            CAPTURE(stage.name.toStdString());
+            CHECK(stage.n_samples == 60);
+            CHECK(stage.p50 >= 0);
+            CHECK(stage.p50 <= stage.p99);
+            CHECK(stage.p99 <= stage.max);
+        }
+        REQUIRE(report.stage("cpu_total"));
+        REQUIRE(report.stage("draw_list"));
+        CHECK(report.stage("cpu_total")->max >= report.stage("draw_list")->max);
+        CHECK(!report.stage("unknown"));
+    }
+
+    SECTION("runs start from an empty gpu state")
+    {
+        const auto a = replay.run(path, camera);
+        const auto b = replay.run(path, camera);
+        CHECK(a.n_gpu_tiles == b.n_gpu_tiles);
+        CHECK(a.max_n_tiles_drawn == b.max_n_tiles_drawn);
+    }
+
+    SECTION("missing fixture")
+    {
+        FrameReplay other(aabb_decorator);
+        CHECK(!other.load_fixture(fixture_path / "does_not_exist").has_value());
+    }
+
+    BENCHMARK("replay 60 frames")
+    {
+        return replay.run(path, camera).n_frames;
+    };
+}
+
+TEST_CASE("nucleus/timing/percentile")
+{
+    CHECK(percentile({}, 50) == 0);
+    CHECK(percentile({ 3 }, 99) == 3);
+    std::vector<float> samples;
+    for (unsigned i = 100; i > 0; --i)
+        samples.push_back(float(i));
+    CHECK(percentile(samples, 50) == 50);
+    CHECK(percentile(samples, 99) == 99);
+    CHECK(percentile(samples, 100) == 100);
+    CHECK(percentile(samples, 0) == 1);
+}
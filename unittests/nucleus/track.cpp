@@ -1,9 +1,19 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
 
+#include "nucleus/camera/Definition.h"
 #include "nucleus/track/GPX.h"
+#include "nucleus/track/polyline_lod.h"
+#include "nucleus/track/streaming.h"
+#include <QDateTime>
+#include <QFile>
 #include <QString>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
+using Catch::Approx;
 using namespace nucleus::track;
 
 TEST_CASE("GPX")
@@ -20,4 +30,365 @@ TEST_CASE("GPX")
         CHECK(gpx->track[0].size() == 3); // there are three trackpoints in segment 1
         CHECK(gpx->track[1].size() == 2); // there are two trackpoints in segment 2
     }
+
+    SECTION("apply_gaussian_filter smooths with the original neighbours")
+    {
+        // a single spike. if already smoothed points were fed back into the kernel, the result would not be symmetric
+        std::vector<glm::vec4> points(9, glm::vec4(0, 0, 0, 1000));
+        points[4] = glm::vec4(10, 20, 30, 1000);
+        apply_gaussian_filter(points, 1.0f);
+        CHECK(points[3] == points[5]);
+        CHECK(points[2] == points[6]);
+        CHECK(points[4].x < 10);
+        // the first and last 2 points are kept as they are
+        for (const auto i : { 0, 1, 7, 8 })
+            CHECK(points[i] == glm::vec4(0, 0, 0, 1000));
+    }
+
+    SECTION("reduce_point_count")
+    {
+        std::vector<glm::vec4> empty;
+        reduce_point_count(empty, 1.0f);
+        CHECK(empty.empty());
+
+        // the loop used to read one past the end when the last points were close to the kept one
+        std::vector<glm::vec4> points = { { 0, 0, 0, 0 }, { 0.5f, 0, 0, 0 }, { 2, 0, 0, 0 }, { 2.2f, 0, 0, 0 }, { 2.4f, 0, 0, 0 } };
+        reduce_point_count(points, 1.0f);
+        REQUIRE(points.size() == 2);
+        CHECK(points[0].x == 0);
+        CHECK(points[1].x == 2);
+    }
+}
+
+namespace {
+QByteArray synthetic_gpx(size_t n_points, size_t n_segments = 1)
+{
+    QByteArray data;
+    data.reserve(qsizetype(n_points * 110 + 200));
+    data.append("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<gpx version=\"1.1\" creator=\"unittests\">\n<trk>\n");
+    const size_t points_per_segment = n_points / n_segments;
+    for (size_t s = 0; s < n_segments; ++s) {
+        data.append("<trkseg>\n");
+        for (size_t i = 0; i < points_per_segment; ++i) {
+            const size_t k = s * points_per_segment + i;
+            // wiggly line in the alps, one point per second
+            const double lat = 47.0 + double(k) * 1e-5 + 2e-5 * std::sin(double(k) * 0.7);
+            const double lon = 12.0 + double(k) * 1.5e-5 + 2e-5 * std::cos(double(k) * 0.3);
+            const double ele = 1500.0 + 100.0 * std::sin(double(k) * 1e-3);
+            const auto time = QString("2020-01-%1T%2:%3:%4Z")
+                                  .arg(k / 86400 + 1, 2, 10, QChar('0'))
+                                  .arg(k / 3600 % 24, 2, 10, QChar('0'))
+                                  .arg(k / 60 % 60, 2, 10, QChar('0'))
+                                  .arg(k % 60, 2, 10, QChar('0'));
+            data.append(QString("<trkpt lat=\"%1\" lon=\"%2\"><ele>%3</ele><time>%4</time></trkpt>\n")
+                            .arg(lat, 0, 'f', 7)
+                            .arg(lon, 0, 'f', 7)
+                            .arg(ele, 0, 'f', 2)
+                            .arg(time)
+                            .toUtf8());
+        }
+        data.append("</trkseg>\n");
+    }
+    data.append("</trk>\n</gpx>\n");
+    return data;
+}
+} // namespace
+
+TEST_CASE("nucleus/track/streaming")
+{
+    SECTION("parse_iso8601_ms")
+    {
+        CHECK(parse_iso8601_ms(u"1970-01-01T00:00:00Z") == 0);
+        CHECK(parse_iso8601_ms(u"1970-01-01T00:00:01.5Z") == 1500);
+        CHECK(parse_iso8601_ms(u"2009-10-17T18:37:26Z") == QDateTime::fromString("2009-10-17T18:37:26Z", Qt::ISODate).toMSecsSinceEpoch());
+        CHECK(parse_iso8601_ms(u"2024-02-29T23:59:59.123Z") == QDateTime::fromString("2024-02-29T23:59:59.123Z", Qt::ISODate).toMSecsSinceEpoch());
+        CHECK(parse_iso8601_ms(u"2009-10-17T20:37:26+02:00") == parse_iso8601_ms(u"2009-10-17T18:37:26Z"));
+        CHECK(parse_iso8601_ms(u"2009-10-17T16:07:26-0230") == parse_iso8601_ms(u"2009-10-17T18:37:26Z"));
+        CHECK(parse_iso8601_ms(u" 2009-10-17T18:37:26Z\n") == parse_iso8601_ms(u"2009-10-17T18:37:26Z"));
+        CHECK(!parse_iso8601_ms(u"yesterday").has_value());
+        CHECK(!parse_iso8601_ms(u"2009-13-17T18:37:26Z").has_value());
+    }
+
+    SECTION("parse_chunked example.gpx")
+    {
+        QFile file(QString("%1%2").arg(ALP_TEST_DATA_DIR, "example.gpx"));
+        REQUIRE(file.open(QIODevice::ReadOnly | QIODevice::Text));
+        const QByteArray data = file.readAll();
+
+        for (const size_t chunk_size : { size_t(1), size_t(2), size_t(4096) }) {
+            QXmlStreamReader reader(data);
+            std::vector<std::vector<double>> elevations;
+            std::vector<std::vector<int64_t>> timestamps;
+            unsigned n_chunks = 0;
+            const bool ok = parse_chunked(
+                reader,
+                [&](PointChunk& chunk) {
+                    ++n_chunks;
+                    CHECK(chunk.size() <= chunk_size);
+                    if (chunk.segment_begin) {
+                        CHECK(chunk.segment_index == elevations.size());
+                        elevations.emplace_back();
+                        timestamps.emplace_back();
+                    }
+                    for (size_t i = 0; i < chunk.size(); ++i) {
+                        CHECK(chunk.latitude[i] == Approx(47.644548));
+                        CHECK(chunk.longitude[i] == Approx(-122.326897));
+                        elevations.back().push_back(chunk.elevation[i]);
+                        timestamps.back().push_back(chunk.timestamp[i]);
+                    }
+                },
+                chunk_size);
+            CHECK(ok);
+            REQUIRE(elevations.size() == 2);
+            REQUIRE(elevations[0].size() == 3);
+            REQUIRE(elevations[1].size() == 2);
+            CHECK(elevations[0][0] == Approx(4.46));
+            CHECK(elevations[0][2] == Approx(6.87));
+            CHECK(elevations[1][1] == Approx(4.94));
+            CHECK(timestamps[0][1] - timestamps[0][0] == 5000);
+            CHECK(timestamps[0][2] - timestamps[0][1] == 3000);
+            // metadata time must not end up in a point
+            CHECK(timestamps[0][0] == parse_iso8601_ms(u"2009-10-17T18:37:26Z"));
+            if (chunk_size == 1)
+                CHECK(n_chunks == 7); // one chunk per point plus an empty closing chunk per segment
+            if (chunk_size == 4096)
+                CHECK(n_chunks == 2);
+        }
+    }
+
+    SECTION("load_world_segments agrees with parse + to_world_points + apply_gaussian_filter")
+    {
+        const QByteArray data = synthetic_gpx(2000, 2);
+        QXmlStreamReader legacy_reader(data);
+        const auto gpx = parse(legacy_reader);
+        REQUIRE(gpx);
+
+        for (const size_t chunk_size : { size_t(3), size_t(64), size_t(4096) }) {
+            QXmlStreamReader reader(data);
+            const auto segments = load_world_segments(reader, {}, chunk_size);
+            REQUIRE(segments.has_value());
+            REQUIRE(segments->size() == gpx->track.size());
+            for (size_t s = 0; s < segments->size(); ++s) {
+                auto reference = to_world_points(gpx->track[s]);
+                apply_gaussian_filter(reference);
+                const auto& segment = segments->at(s);
+                REQUIRE(segment.size() == reference.size());
+                for (size_t i = 0; i < segment.size(); ++i) {
+                    // reference is smoothed in float, world coordinates are in the millions
+                    CHECK(segment[i].x == Approx(reference[i].x).margin(2.0));
+                    CHECK(segment[i].y == Approx(reference[i].y).margin(2.0));
+                    CHECK(segment[i].z == Approx(reference[i].z).margin(2.0));
+                    CHECK(segment[i].w == reference[i].w);
+                }
+            }
+        }
+    }
+
+    SECTION("decimation keeps the last point and accumulates time")
+    {
+        const QByteArray data = synthetic_gpx(1000);
+        QXmlStreamReader reader(data);
+        const auto segments = load_world_segments(reader, { .sigma = 1.0f, .min_distance = 10.0f }, 100);
+        REQUIRE(segments.has_value());
+        REQUIRE(segments->size() == 1);
+        const auto& segment = segments->front();
+        CHECK(segment.size() < 500);
+        CHECK(segment.front().w == 0);
+        float total_ms = 0;
+        for (size_t i = 1; i < segment.size(); ++i) {
+            total_ms += segment[i].w;
+            if (i + 1 < segment.size())
+                CHECK(glm::distance(glm::vec3(segment[i]), glm::vec3(segment[i - 1])) >= 9.0f);
+        }
+        CHECK(total_ms == Approx(999 * 1000.0));
+
+        QXmlStreamReader legacy_reader(data);
+        const auto gpx = parse(legacy_reader);
+        const auto last = to_world_points(gpx->track.front()).back();
+        CHECK(glm::distance(glm::vec3(segment.back()), glm::vec3(last)) < 1.0f);
+    }
+
+    SECTION("load_track keeps the start position")
+    {
+        QFile file(QString("%1%2").arg(ALP_TEST_DATA_DIR, "example.gpx"));
+        REQUIRE(file.open(QIODevice::ReadOnly | QIODevice::Text));
+        QXmlStreamReader reader(file.readAll());
+        const auto track = load_track(reader);
+        REQUIRE(track.has_value());
+        CHECK(track->segments.size() == 2);
+        CHECK(track->start_lat_long.x == Approx(47.644548));
+        CHECK(track->start_lat_long.y == Approx(-122.326897));
+    }
+
+    SECTION("waypoints are rejected")
+    {
+        QXmlStreamReader reader(QByteArray("<gpx><wpt lat=\"1\" lon=\"2\"/></gpx>"));
+        CHECK(!load_world_segments(reader).has_value());
+        QXmlStreamReader track_reader(QByteArray("<gpx><wpt lat=\"1\" lon=\"2\"/></gpx>"));
+        CHECK(!load_track(track_reader).has_value());
+    }
+}
+
+TEST_CASE("nucleus/track/streaming benchmark")
+{
+    const QByteArray data = synthetic_gpx(1'000'000);
+
+    BENCHMARK("1M points: parse + to_world_points + apply_gaussian_filter + reduce_point_count")
+    {
+        QXmlStreamReader reader(data);
+        const auto gpx = parse(reader);
+        auto points = to_world_points(*gpx);
+        apply_gaussian_filter(points);
+        reduce_point_count(points, 1.0f);
+        return points.size();
+    };
+
+    BENCHMARK("1M points: load_world_segments")
+    {
+        QXmlStreamReader reader(data);
+        const auto segments = load_world_segments(reader, { .sigma = 1.0f, .min_distance = 1.0f });
+        return segments->front().size();
+    };
+}
+
+namespace {
+std::vector<glm::vec4> wiggly_world_track(size_t n_points)
+{
+    std::vector<glm::vec4> points;
+    for (size_t i = 0; i < n_points; ++i) {
+        const auto t = float(i);
+        points.emplace_back(1'400'000.0f + t * 2.0f, 5'900'000.0f + 30.0f * std::sin(t * 0.05f), 1000.0f + 0.1f * t, i == 0 ? 0.0f : 1000.0f);
+    }
+    return points;
+}
+} // namespace
+
+TEST_CASE("nucleus/track/polyline_lod")
+{
+    SECTION("douglas_peucker_errors")
+    {
+        std::vector<glm::vec4> line = { { 0, 0, 0, 0 }, { 1, 0, 0, 0 }, { 2, 0, 0, 0 }, { 3, 0, 0, 0 } };
+        std::vector<float> errors(line.size(), -1.0f);
+        nucleus::track::detail::douglas_peucker_errors(line, 0, 3, errors);
+        CHECK(std::isinf(errors[0]));
+        CHECK(std::isinf(errors[3]));
+        CHECK(errors[1] == 0);
+        CHECK(errors[2] == 0);
+
+        // the peak splits first, the small bump is clamped to its own distance
+        std::vector<glm::vec4> peak = { { 0, 0, 0, 0 }, { 1, 0.5, 0, 0 }, { 2, 0, 0, 0 }, { 3, 10, 0, 0 }, { 4, 0, 0, 0 } };
+        errors.assign(peak.size(), -1.0f);
+        nucleus::track::detail::douglas_peucker_errors(peak, 0, 4, errors);
+        CHECK(errors[3] == Approx(10.0f));
+        CHECK(errors[1] <= errors[3]);
+        CHECK(errors[2] <= errors[3]);
+        CHECK(errors[1] > 0);
+    }
+
+    const auto points = wiggly_world_track(10'000);
+    const auto lod = build_polyline_lod(points, 256);
+
+    SECTION("levels")
+    {
+        REQUIRE(lod.levels.size() >= 3);
+        REQUIRE(lod.levels.size() == lod.level_errors.size());
+        CHECK(lod.levels[0].size() == points.size());
+        CHECK(lod.level_errors[0] == 0);
+        CHECK(lod.chunks.size() == (points.size() - 1 + 255) / 256);
+        CHECK(lod.levels.back().size() == lod.chunks.size() + 1);
+        for (size_t l = 1; l < lod.levels.size(); ++l) {
+            CHECK(lod.levels[l].size() < lod.levels[l - 1].size());
+            CHECK(lod.level_errors[l] >= lod.level_errors[l - 1]);
+        }
+
+        for (size_t l = 0; l < lod.levels.size(); ++l) {
+            const auto& level = lod.levels[l];
+            // time is accumulated over dropped points
+            double total_time = 0;
+            for (const auto& p : level)
+                total_time += p.w;
+            CHECK(total_time == Approx(double(points.size() - 1) * 1000.0));
+
+            // chunks are contiguous and share their end points
+            for (size_t c = 0; c < lod.chunks.size(); ++c) {
+                const auto& range = lod.chunks[c].ranges[l];
+                CHECK(range.n_points >= 2);
+                CHECK(glm::vec3(level[range.first]) == glm::vec3(points[c * 256]));
+                if (c + 1 < lod.chunks.size())
+                    CHECK(lod.chunks[c + 1].ranges[l].first == range.first + range.n_points - 1);
+                else
+                    CHECK(range.first + range.n_points == level.size());
+            }
+        }
+    }
+
+    SECTION("simplification error is bounded by the level error")
+    {
+        for (size_t l = 1; l < lod.levels.size(); ++l) {
+            const auto& level = lod.levels[l];
+            // walk the original points along the simplified polyline
+            size_t k = 0;
+            float max_error = 0;
+            for (const auto& p : points) {
+                if (k + 1 < level.size() && glm::vec3(p) == glm::vec3(level[k + 1]))
+                    ++k;
+                if (k + 1 >= level.size())
+                    break;
+                const glm::vec3 a = level[k];
+                const glm::vec3 b = level[k + 1];
+                const float t = std::clamp(glm::dot(glm::vec3(p) - a, b - a) / glm::dot(b - a, b - a), 0.0f, 1.0f);
+                max_error = std::max(max_error, glm::distance(glm::vec3(p), a + t * (b - a)));
+            }
+            CHECK(max_error <= lod.level_errors[l] + 0.01f);
+        }
+    }
+
+    SECTION("selection")
+    {
+        const glm::dvec3 first(points.front());
+        const glm::dvec3 centre(points[points.size() / 2]);
+
+        // close to the start of the track: full detail there, coarser further away
+        {
+            nucleus::camera::Definition camera(first + glm::dvec3(-20, -60, 40), first + glm::dvec3(200, 0, 0));
+            camera.set_viewport_size({ 1920, 1080 });
+            const auto ranges = select_polyline_lod(lod, camera, 0.5f);
+            REQUIRE(!ranges.empty());
+            CHECK(ranges.front().level == 0);
+            CHECK(ranges.front().range.first == 0);
+            CHECK(ranges.back().level > 0);
+            for (size_t i = 1; i < ranges.size(); ++i)
+                CHECK(ranges[i - 1].level <= ranges[i].level);
+        }
+
+        // far away: everything on the coarsest level, merged into one range
+        {
+            nucleus::camera::Definition camera(centre + glm::dvec3(0, 0, 200'000), centre);
+            camera.set_viewport_size({ 1920, 1080 });
+            const auto ranges = select_polyline_lod(lod, camera, 0.5f);
+            REQUIRE(ranges.size() == 1);
+            CHECK(ranges.front().level == lod.levels.size() - 1);
+            CHECK(ranges.front().range.first == 0);
+            CHECK(ranges.front().range.n_points == lod.levels.back().size());
+        }
+
+        // looking away from the track
+        {
+            nucleus::camera::Definition camera(first + glm::dvec3(-100, 0, 100), first + glm::dvec3(-1000, 0, 100));
+            camera.set_viewport_size({ 1920, 1080 });
+            CHECK(select_polyline_lod(lod, camera, 0.5f).empty());
+        }
+    }
+}
+
+TEST_CASE("nucleus/track/polyline_lod benchmark")
+{
+    const auto points = wiggly_world_track(100'000);
+    const auto lod = build_polyline_lod(points);
+    const glm::dvec3 centre(points[points.size() / 2]);
+    nucleus::camera::Definition camera(centre + glm::dvec3(-500, -2000, 1000), centre);
+    camera.set_viewport_size({ 1920, 1080 });
+
+    BENCHMARK("build_polyline_lod (100k points)") { return build_polyline_lod(points); };
+    BENCHMARK("select_polyline_lod (100k points)") { return select_polyline_lod(lod, camera, 0.5f); };
 }
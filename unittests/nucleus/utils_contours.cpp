@@ -0,0 +1,257 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QFile>
+#include <QString>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+#include <nucleus/srs.h>
+#include <nucleus/tile/conversion.h>
+#include <nucleus/utils/contours.h>
+#include <nucleus/utils/image_loader.h>
+
+using namespace nucleus::utils;
+using nucleus::tile::Id;
+
+namespace {
+nucleus::Raster<uint16_t> test_tile()
+{
+    const auto image = image_loader::rgba8(QString("%1%2").arg(ALP_TEST_DATA_DIR, "test-tile.png"));
+    REQUIRE(image.has_value());
+    return nucleus::tile::conversion::to_u16raster(image.value());
+}
+
+// smooth ridges and valleys with a few hundred metres of relief per kilometre, continuous across tiles
+double altitude(const glm::dvec2& world) { return 1800 + 700 * std::sin(world.x / 900.0) * std::cos(world.y / 700.0) + 250 * std::sin((world.x + world.y) / 310.0); }
+
+nucleus::Raster<uint16_t> synthetic_tile(const Id& id)
+{
+    const auto bounds = nucleus::srs::tile_bounds(id);
+    const auto texel_size = bounds.size().x / 64;
+    nucleus::Raster<uint16_t> heights({ 65, 65 }, 0);
+    for (unsigned row = 0; row < 65; ++row) {
+        for (unsigned col = 0; col < 65; ++col)
+            heights.pixel({ col, row }) = uint16_t(std::lround(altitude({ bounds.min.x + col * texel_size, bounds.max.y - row * texel_size }) * 8));
+    }
+    return heights;
+}
+
+std::vector<contours::WorldLine> world_lines(const Id& id, const contours::Settings& settings)
+{
+    const auto bounds = nucleus::srs::tile_bounds(id);
+    return contours::to_world(contours::generate(synthetic_tile(id), settings), { bounds.min.x, bounds.max.y }, bounds.size().x / 64);
+}
+
+bool is_inside(const glm::dvec2& p, const nucleus::tile::SrsBounds& bounds, double margin)
+{
+    return p.x > bounds.min.x + margin && p.x < bounds.max.x - margin && p.y > bounds.min.y + margin && p.y < bounds.max.y - margin;
+}
+
+// height of the raster linearly interpolated on the grid edge through p (one coordinate is integral)
+float height_on_edge(const nucleus::Raster<uint16_t>& heights, const glm::vec2& p)
+{
+    const auto x = unsigned(std::floor(p.x));
+    const auto y = unsigned(std::floor(p.y));
+    const auto a = float(heights.pixel({ x, y }));
+    if (p.x == float(x)) {
+        const auto t = p.y - float(y);
+        return t == 0 ? a : a + t * (float(heights.pixel({ x, y + 1 })) - a);
+    }
+    const auto t = p.x - float(x);
+    return a + t * (float(heights.pixel({ x + 1, y })) - a);
+}
+} // namespace
+
+TEST_CASE("nucleus/utils/contours")
+{
+    SECTION("flat tiles have no contours")
+    {
+        CHECK(contours::generate(nucleus::Raster<uint16_t>({ 65, 65 }, uint16_t(0)), {}).empty());
+        CHECK(contours::generate(nucleus::Raster<uint16_t>({ 65, 65 }, uint16_t(1000 * 8)), {}).empty());
+    }
+
+    SECTION("a cone gives closed rings at every level")
+    {
+        nucleus::Raster<uint16_t> heights({ 65, 65 }, 0);
+        for (unsigned row = 0; row < 65; ++row) {
+            for (unsigned col = 0; col < 65; ++col) {
+                const auto distance = std::hypot(double(col) - 32, double(row) - 32);
+                heights.pixel({ col, row }) = uint16_t(std::lround(std::max(0.0, 1000 - distance * 40) * 8));
+            }
+        }
+        const auto lines = contours::generate(heights, { 250, 50, 0 });
+        // 50, 100, .., 1000. the ring at 0 touches the border, the one at 1000 is a single point
+        REQUIRE(lines.size() == 19);
+        for (unsigned i = 0; i < lines.size(); ++i) {
+            const auto& line = lines[i];
+            CHECK(line.elevation == float(50 * (i + 1)));
+            CHECK(line.primary == (int(line.elevation) % 250 == 0));
+            CHECK(line.is_closed());
+            const auto radius = (1000 - line.elevation) / 40;
+            for (const auto& p : line.points) {
+                CHECK(std::abs(glm::distance(p, glm::vec2(32, 32)) - radius) < 0.5f);
+                CHECK(std::abs(height_on_edge(heights, p) - line.elevation * 8) < 0.01f);
+            }
+        }
+    }
+
+    SECTION("points are on the levels and on the grid edges")
+    {
+        const auto heights = test_tile();
+        const auto lines = contours::generate(heights, { 100, 20, 0 });
+        REQUIRE(lines.size() > 10);
+        for (const auto& line : lines) {
+            CHECK(std::fmod(line.elevation, 20.0f) == 0);
+            CHECK(line.primary == (std::fmod(line.elevation, 100.0f) == 0));
+            REQUIRE(line.points.size() >= 2);
+            for (const auto& p : line.points) {
+                CHECK((p.x == std::floor(p.x) || p.y == std::floor(p.y)));
+                CHECK(std::abs(height_on_edge(heights, p) - line.elevation * 8) < 0.05f);
+            }
+            // open lines end on the border
+            if (!line.is_closed()) {
+                const auto last = float(heights.width() - 1);
+                for (const auto& p : { line.points.front(), line.points.back() })
+                    CHECK((p.x == 0 || p.y == 0 || p.x == last || p.y == last));
+            }
+        }
+    }
+
+    SECTION("serialised lines round trip with their settings")
+    {
+        const contours::Settings settings = { 100, 20, 0.1f };
+        const auto lines = contours::generate(test_tile(), settings);
+        REQUIRE(!lines.empty());
+        const auto bytes = contours::serialise(lines, settings);
+        const auto read_back = contours::deserialise(bytes, settings);
+        REQUIRE(read_back.has_value());
+        REQUIRE(read_back->size() == lines.size());
+        for (unsigned i = 0; i < lines.size(); ++i) {
+            CHECK(read_back->at(i).elevation == lines[i].elevation);
+            CHECK(read_back->at(i).primary == lines[i].primary);
+            CHECK(read_back->at(i).points == lines[i].points);
+        }
+        CHECK(contours::deserialise(contours::serialise({}, settings), settings).value().empty());
+
+        // stale or broken cache entries
+        CHECK(!contours::deserialise(bytes, { 100, 50, 0.1f }).has_value());
+        CHECK(!contours::deserialise({}, settings).has_value());
+        CHECK(!contours::deserialise(bytes.left(bytes.size() / 2), settings).has_value());
+    }
+
+    SECTION("simplification keeps the end points")
+    {
+        const auto heights = test_tile();
+        const auto full = contours::generate(heights, { 100, 20, 0 });
+        const auto simplified = contours::generate(heights, { 100, 20, 0.5f });
+        REQUIRE(full.size() == simplified.size());
+        size_t n_full = 0;
+        size_t n_simplified = 0;
+        for (size_t i = 0; i < full.size(); ++i) {
+            CHECK(full[i].elevation == simplified[i].elevation);
+            CHECK(full[i].points.front() == simplified[i].points.front());
+            CHECK(full[i].points.back() == simplified[i].points.back());
+            n_full += full[i].points.size();
+            n_simplified += simplified[i].points.size();
+        }
+        CHECK(n_simplified < n_full / 2);
+
+        const std::vector<glm::vec2> zigzag = { { 0, 0 }, { 1, 0.1f }, { 2, -0.1f }, { 3, 0.1f }, { 4, 2 }, { 5, 0 } };
+        CHECK(contours::simplify(zigzag, 0.2f) == std::vector<glm::vec2> { { 0, 0 }, { 3, 0.1f }, { 4, 2 }, { 5, 0 } });
+        CHECK(contours::simplify(zigzag, 10.0f) == std::vector<glm::vec2> { { 0, 0 }, { 5, 0 } });
+    }
+
+    SECTION("lines continue across tile borders")
+    {
+        const auto quad = Id { 14, { 8800, 10700 } };
+        const auto quad_bounds = nucleus::srs::tile_bounds(quad);
+        std::vector<contours::WorldLine> lines;
+        for (const auto& id : quad.children()) {
+            const auto tile_lines = world_lines(id, {});
+            lines.insert(lines.end(), tile_lines.begin(), tile_lines.end());
+        }
+
+        // every end point inside the quad (i.e., on a shared border) meets exactly one end point of the same elevation in the neighbour
+        unsigned n_inner_ends = 0;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            if (lines[i].is_closed())
+                continue;
+            for (const auto& p : { lines[i].points.front(), lines[i].points.back() }) {
+                if (!is_inside(p, quad_bounds, 1e-6))
+                    continue;
+                ++n_inner_ends;
+                unsigned n_matches = 0;
+                for (size_t j = 0; j < lines.size(); ++j) {
+                    if (j == i || lines[j].is_closed() || lines[j].elevation != lines[i].elevation)
+                        continue;
+                    for (const auto& q : { lines[j].points.front(), lines[j].points.back() })
+                        n_matches += glm::distance(p, q) < 1e-6 ? 1 : 0;
+                }
+                CHECK(n_matches == 1);
+            }
+        }
+        CHECK(n_inner_ends > 20);
+
+        const auto stitched = contours::stitch(lines, 1e-3);
+        CHECK(stitched.size() < lines.size());
+        for (const auto& line : stitched) {
+            if (line.is_closed())
+                continue;
+            CHECK(!is_inside(line.points.front(), quad_bounds, 1e-6));
+            CHECK(!is_inside(line.points.back(), quad_bounds, 1e-6));
+        }
+    }
+
+    SECTION("stitching closes rings")
+    {
+        const std::vector<contours::WorldLine> halves = {
+            { 100, false, { { 0, 0 }, { 1, 1 }, { 2, 0 } } },
+            { 100, false, { { 0, 0 }, { 1, -1 }, { 2, 0 } } },
+            { 150, false, { { 0, 0 }, { 5, 5 } } },
+        };
+        const auto stitched = contours::stitch(halves, 1e-3);
+        REQUIRE(stitched.size() == 2);
+        CHECK(stitched[0].is_closed());
+        CHECK(stitched[0].points.size() == 5);
+        CHECK(stitched[1].points.size() == 2);
+    }
+}
+
+TEST_CASE("nucleus/utils/contours benchmarks")
+{
+    const auto heights = test_tile();
+    const auto image_bytes = [] {
+        QFile file(QString("%1%2").arg(ALP_TEST_DATA_DIR, "test-tile.png"));
+        REQUIRE(file.open(QFile::ReadOnly));
+        return file.readAll();
+    }();
+
+    BENCHMARK("decode test-tile.png (for reference)") { return nucleus::tile::conversion::to_u16raster(image_loader::rgba8(image_bytes).value()).width(); };
+    BENCHMARK("contours of test-tile.png, 250/50 m") { return contours::generate(heights, {}).size(); };
+    BENCHMARK("contours of test-tile.png, 100/20 m") { return contours::generate(heights, { 100, 20, 0.1f }).size(); };
+
+    const auto quad = Id { 14, { 8800, 10700 } };
+    std::vector<contours::WorldLine> lines;
+    for (const auto& id : quad.children()) {
+        const auto tile_lines = world_lines(id, {});
+        lines.insert(lines.end(), tile_lines.begin(), tile_lines.end());
+    }
+    BENCHMARK("stitch a quad") { return contours::stitch(lines, 1e-3).size(); };
+}
@@ -0,0 +1,267 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtEndian>
+#include <bit>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <map>
+
+#include <nucleus/Raster.h>
+#include <nucleus/utils/geotiff_writer.h>
+#include <nucleus/utils/image_writer.h>
+
+using namespace nucleus::utils::geotiff;
+
+namespace {
+// just enough of a reader for the files of StreamingWriter (little endian, one directory, tiled, interleaved)
+struct Tiff {
+    std::map<uint16_t, std::vector<double>> tags;
+    std::vector<uint8_t> pixels; // tightly packed rows
+
+    [[nodiscard]] unsigned tag(uint16_t id) const { return unsigned(tags.at(id).front()); }
+};
+
+template <typename T> T read(const QByteArray& bytes, qsizetype offset)
+{
+    T value;
+    std::memcpy(&value, bytes.constData() + offset, sizeof(T));
+    return qFromLittleEndian(value);
+}
+
+Tiff read_tiff(const QString& path, size_t bytes_per_pixel)
+{
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::ReadOnly));
+    const auto bytes = file.readAll();
+    REQUIRE(bytes.left(2) == "II");
+    REQUIRE(read<uint16_t>(bytes, 2) == 42);
+    const auto ifd = read<uint32_t>(bytes, 4);
+    REQUIRE(ifd % 2 == 0);
+
+    Tiff tiff;
+    const auto n_entries = read<uint16_t>(bytes, ifd);
+    for (unsigned i = 0; i < n_entries; ++i) {
+        const auto entry = ifd + 2 + 12 * i;
+        const auto tag = read<uint16_t>(bytes, entry);
+        const auto type = read<uint16_t>(bytes, entry + 2);
+        const auto count = read<uint32_t>(bytes, entry + 4);
+        const auto size = type == 3 ? 2u : (type == 4 ? 4u : 8u);
+        const auto values = count * size <= 4 ? entry + 8 : read<uint32_t>(bytes, entry + 8);
+        auto& v = tiff.tags[tag];
+        for (unsigned j = 0; j < count; ++j) {
+            if (type == 3)
+                v.push_back(read<uint16_t>(bytes, values + j * size));
+            else if (type == 4)
+                v.push_back(read<uint32_t>(bytes, values + j * size));
+            else
+                v.push_back(std::bit_cast<double>(read<uint64_t>(bytes, values + j * size)));
+        }
+    }
+
+    const auto width = tiff.tag(256);
+    const auto height = tiff.tag(257);
+    const auto tile_size = tiff.tag(322);
+    const auto n_tiles_x = (width + tile_size - 1) / tile_size;
+    const auto& offsets = tiff.tags.at(324);
+    const auto& byte_counts = tiff.tags.at(325);
+    REQUIRE(offsets.size() == n_tiles_x * ((height + tile_size - 1) / tile_size));
+    tiff.pixels.resize(size_t(width) * height * bytes_per_pixel);
+    for (size_t i = 0; i < offsets.size(); ++i) {
+        auto tile = bytes.mid(qsizetype(offsets[i]), qsizetype(byte_counts[i]));
+        const auto tile_bytes = size_t(tile_size) * tile_size * bytes_per_pixel;
+        if (tiff.tag(259) == 8) {
+            QByteArray size_prefix(4, 0);
+            qToBigEndian(uint32_t(tile_bytes), size_prefix.data());
+            tile = qUncompress(size_prefix + tile);
+        }
+        REQUIRE(size_t(tile.size()) == tile_bytes);
+        const auto x0 = unsigned(i % n_tiles_x) * tile_size;
+        const auto y0 = unsigned(i / n_tiles_x) * tile_size;
+        for (unsigned y = y0; y < std::min(height, y0 + tile_size); ++y) {
+            const auto n_columns = std::min(width - x0, tile_size);
+            std::memcpy(&tiff.pixels[(size_t(y) * width + x0) * bytes_per_pixel], tile.constData() + (y - y0) * tile_size * bytes_per_pixel, n_columns * bytes_per_pixel);
+        }
+    }
+    return tiff;
+}
+
+nucleus::Raster<glm::u8vec4> synthetic_rgba(glm::uvec2 size)
+{
+    nucleus::Raster<glm::u8vec4> raster(size);
+    for (unsigned y = 0; y < size.y; ++y) {
+        for (unsigned x = 0; x < size.x; ++x)
+            raster.pixel({ x, y }) = glm::u8vec4(x, y, (x * 31 + y * 17) % 256, ((x ^ y) * 2654435761u) >> 24);
+    }
+    return raster;
+}
+
+std::span<const uint8_t> bytes_of(const nucleus::Raster<glm::u8vec4>& raster) { return { raster.bytes(), raster.size_in_bytes() }; }
+} // namespace
+
+TEST_CASE("nucleus/utils/geotiff_writer")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+
+    SECTION("rgba8 with georeference")
+    {
+        const auto image = synthetic_rgba({ 300, 200 });
+        const auto bounds = radix::geometry::Aabb<2, double> { { 1000.0, 5000.0 }, { 4000.0, 7000.0 } };
+        const auto path = dir.filePath("rgba.tif");
+        StreamingWriter writer(path, { image.size(), 4, 1 }, bounds);
+        writer.write_rows(bytes_of(image));
+        REQUIRE(writer.finish().has_value());
+
+        const auto tiff = read_tiff(path, 4);
+        CHECK(tiff.tag(256) == 300);
+        CHECK(tiff.tag(257) == 200);
+        CHECK(tiff.tags.at(258) == std::vector<double> { 8, 8, 8, 8 });
+        CHECK(tiff.tag(259) == 8);
+        CHECK(tiff.tag(262) == 2);
+        CHECK(tiff.tag(338) == 2);
+        CHECK(tiff.tags.at(33550) == std::vector<double> { 10.0, 10.0, 0.0 });
+        CHECK(tiff.tags.at(33922) == std::vector<double> { 0.0, 0.0, 0.0, 1000.0, 7000.0, 0.0 });
+        CHECK(tiff.tags.at(34735).back() == 3857);
+        CHECK(std::memcmp(tiff.pixels.data(), image.bytes(), image.size_in_bytes()) == 0);
+    }
+
+    SECTION("uint32 without compression")
+    {
+        nucleus::Raster<uint32_t> image({ 70, 530 });
+        for (unsigned i = 0; i < image.buffer_length(); ++i)
+            image.buffer()[i] = i * 2654435761u;
+        const auto path = dir.filePath("uint32.tif");
+        StreamingWriter writer(path, { image.size(), 1, 4, SampleFormat::UnsignedInteger }, {}, 64, 0);
+        writer.write_rows({ image.bytes(), image.size_in_bytes() });
+        REQUIRE(writer.finish().has_value());
+
+        const auto tiff = read_tiff(path, 4);
+        CHECK(tiff.tag(259) == 1);
+        CHECK(tiff.tag(262) == 1);
+        CHECK(tiff.tag(339) == 1);
+        CHECK(!tiff.tags.contains(338));
+        CHECK(!tiff.tags.contains(34735));
+        CHECK(std::memcmp(tiff.pixels.data(), image.bytes(), image.size_in_bytes()) == 0);
+    }
+
+    SECTION("float32 samples")
+    {
+        nucleus::Raster<float> image({ 90, 40 });
+        for (unsigned i = 0; i < image.buffer_length(); ++i)
+            image.buffer()[i] = float(i) * 0.37f - 500.0f;
+        const auto path = dir.filePath("float32.tif");
+        StreamingWriter writer(path, { image.size(), 1, 4, SampleFormat::Float }, {}, 32);
+        writer.write_rows({ image.bytes(), image.size_in_bytes() });
+        REQUIRE(writer.finish().has_value());
+
+        const auto tiff = read_tiff(path, 4);
+        CHECK(tiff.tag(258) == 32);
+        CHECK(tiff.tag(339) == 3);
+        CHECK(std::memcmp(tiff.pixels.data(), image.bytes(), image.size_in_bytes()) == 0);
+    }
+
+    SECTION("rows may come in any chunks")
+    {
+        const auto image = synthetic_rgba({ 100, 300 });
+        const auto all_at_once = dir.filePath("all_at_once.tif");
+        const auto row_by_row = dir.filePath("row_by_row.tif");
+        {
+            StreamingWriter writer(all_at_once, { image.size(), 4, 1 }, {}, 32);
+            writer.write_rows(bytes_of(image));
+            REQUIRE(writer.finish().has_value());
+        }
+        {
+            StreamingWriter writer(row_by_row, { image.size(), 4, 1 }, {}, 32);
+            for (unsigned row = 0; row < image.height(); ++row)
+                writer.write_rows(bytes_of(image).subspan(row * image.size_per_line(), image.size_per_line()));
+            CHECK(writer.n_written_rows() == 300);
+            REQUIRE(writer.finish().has_value());
+        }
+        QFile a(all_at_once);
+        QFile b(row_by_row);
+        REQUIRE(a.open(QIODevice::ReadOnly));
+        REQUIRE(b.open(QIODevice::ReadOnly));
+        CHECK(a.readAll() == b.readAll());
+    }
+
+    SECTION("errors")
+    {
+        const auto image = synthetic_rgba({ 64, 64 });
+        {
+            StreamingWriter writer(dir.filePath("missing_rows.tif"), { { 64, 65 }, 4, 1 });
+            writer.write_rows(bytes_of(image));
+            CHECK(!writer.finish().has_value());
+        }
+        {
+            StreamingWriter writer(dir.filePath("too_many_rows.tif"), { { 64, 63 }, 4, 1 });
+            writer.write_rows(bytes_of(image));
+            CHECK(!writer.finish().has_value());
+        }
+        {
+            StreamingWriter writer(dir.filePath("does_not_exist/a.tif"), { { 64, 64 }, 4, 1 });
+            writer.write_rows(bytes_of(image));
+            CHECK(!writer.finish().has_value());
+        }
+        if (QFile::exists("/dev/full")) {
+            // every write fails with "no space left on device", the export must fail as well (uncompressed and compressed tiles)
+            for (const auto compression_level : { 0, 6 }) {
+                StreamingWriter writer("/dev/full", { { 64, 64 }, 4, 1 }, {}, 64, compression_level);
+                writer.write_rows(bytes_of(image));
+                CHECK(!writer.finish().has_value());
+            }
+        }
+    }
+
+    SECTION("memory is bounded by one strip")
+    {
+        StreamingWriter writer(dir.filePath("tall.tif"), { { 1000, 100000 }, 4, 1 }, {}, 256);
+        CHECK(writer.buffer_size_in_bytes() == (1000 * 256 + 256 * 256) * 4);
+    }
+}
+
+TEST_CASE("nucleus/utils/geotiff_writer benchmarks")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const auto image = synthetic_rgba({ 2048, 2048 });
+
+    BENCHMARK("GeoTIFF 2048x2048 rgba8, streamed in strips of 256 rows")
+    {
+        StreamingWriter writer(dir.filePath("bench.tif"), { image.size(), 4, 1 }, radix::geometry::Aabb<2, double> { { 0.0, 0.0 }, { 1.0, 1.0 } });
+        for (unsigned row = 0; row < image.height(); row += 256)
+            writer.write_rows(bytes_of(image).subspan(row * image.size_per_line(), 256 * image.size_per_line()));
+        return writer.finish().has_value();
+    };
+
+    BENCHMARK("GeoTIFF 2048x2048 rgba8, uncompressed")
+    {
+        StreamingWriter writer(dir.filePath("bench_uncompressed.tif"), { image.size(), 4, 1 }, {}, 256, 0);
+        writer.write_rows(bytes_of(image));
+        return writer.finish().has_value();
+    };
+
+    BENCHMARK("png 2048x2048 rgba8 (whole image)")
+    {
+        nucleus::utils::image_writer::rgba8_as_png(image, dir.filePath("bench.png"));
+        return image.width();
+    };
+}
@@ -0,0 +1,127 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QFile>
+#include <QString>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <random>
+
+#include <nucleus/tile/conversion.h>
+#include <nucleus/utils/height_codec.h>
+#include <nucleus/utils/image_loader.h>
+
+using namespace nucleus::utils;
+
+namespace {
+QByteArray test_tile_png()
+{
+    QFile file(QString("%1%2").arg(ALP_TEST_DATA_DIR, "test-tile.png"));
+    REQUIRE(file.open(QFile::ReadOnly));
+    return file.readAll();
+}
+
+void check_round_trip(const nucleus::Raster<uint16_t>& heights)
+{
+    const auto encoded = height_codec::encode(heights);
+    CHECK(height_codec::is_encoded(encoded));
+    const auto decoded = height_codec::decode(encoded);
+    REQUIRE(decoded.has_value());
+    CHECK(decoded->size() == heights.size());
+    CHECK(decoded->buffer() == heights.buffer());
+}
+} // namespace
+
+TEST_CASE("nucleus/utils/height_codec")
+{
+    SECTION("round trip of the test tile, smaller than the png")
+    {
+        const auto png = test_tile_png();
+        const auto heights = nucleus::tile::conversion::to_u16raster(image_loader::rgba8(png).value());
+        check_round_trip(heights);
+        CHECK(!height_codec::is_encoded(png));
+        CHECK(height_codec::encode(heights).size() < png.size() * 3 / 4);
+    }
+
+    SECTION("round trips of other sizes and contents")
+    {
+        std::mt19937 rng(42);
+        for (const auto width : { 0u, 1u, 2u, 3u, 17u, 65u, 256u }) {
+            for (const auto height : { 0u, 1u, 2u, 15u, 65u }) {
+                nucleus::Raster<uint16_t> random({ width, height });
+                for (auto& v : random)
+                    v = uint16_t(rng());
+                check_round_trip(random);
+
+                // residuals at the extremes of the 16 bit range
+                nucleus::Raster<uint16_t> checker({ width, height });
+                for (unsigned i = 0; i < checker.buffer().size(); ++i)
+                    checker.buffer()[i] = ((i + i / std::max(width, 1u)) % 2) ? 0 : 65535;
+                check_round_trip(checker);
+
+                check_round_trip(nucleus::Raster<uint16_t>({ width, height }, uint16_t(1234)));
+            }
+        }
+    }
+
+    SECTION("flat tiles take about a bit per sample")
+    {
+        const auto encoded = height_codec::encode(nucleus::Raster<uint16_t>({ 65, 65 }, uint16_t(8000)));
+        CHECK(encoded.size() < 65 * 65 / 8 + 200);
+    }
+
+    SECTION("invalid data is rejected")
+    {
+        CHECK(!height_codec::decode(QByteArray()).has_value());
+        CHECK(!height_codec::decode(test_tile_png()).has_value());
+
+        const auto png = test_tile_png();
+        const auto encoded = height_codec::encode(nucleus::tile::conversion::to_u16raster(image_loader::rgba8(png).value()));
+        for (const auto size : { qsizetype(4), qsizetype(8), qsizetype(100), encoded.size() / 2, encoded.size() - 1 })
+            CHECK(!height_codec::decode(encoded.first(size)).has_value());
+
+        // a header claiming more samples than there are bits
+        auto huge = encoded.first(40);
+        huge[4] = huge[5] = huge[6] = huge[7] = char(0xff);
+        CHECK(!height_codec::decode(huge).has_value());
+    }
+
+    SECTION("height tiles decode from both formats")
+    {
+        const auto png = test_tile_png();
+        const auto from_png = nucleus::tile::conversion::height_tile_to_u16raster(png);
+        REQUIRE(from_png.has_value());
+        const auto from_codec = nucleus::tile::conversion::height_tile_to_u16raster(height_codec::encode(from_png.value()));
+        REQUIRE(from_codec.has_value());
+        CHECK(from_codec->buffer() == from_png->buffer());
+        CHECK(!nucleus::tile::conversion::height_tile_to_u16raster(QByteArray("garbage")).has_value());
+    }
+}
+
+TEST_CASE("nucleus/utils/height_codec benchmarks")
+{
+    // compare the mean times; the sizes are 6139 bytes (png) and about 4000 bytes (height_codec) for the 65x65 test tile
+    const auto png = test_tile_png();
+    const auto heights = nucleus::tile::conversion::to_u16raster(image_loader::rgba8(png).value());
+    const auto encoded = height_codec::encode(heights);
+
+    BENCHMARK("decode png (image_loader + to_u16raster)") { return nucleus::tile::conversion::to_u16raster(image_loader::rgba8(png).value()).width(); };
+    BENCHMARK("decode height_codec") { return height_codec::decode(encoded)->width(); };
+    BENCHMARK("encode height_codec") { return height_codec::encode(heights).size(); };
+    BENCHMARK("transcode png to height_codec (once per received tile)") { return height_codec::encode(nucleus::tile::conversion::height_tile_to_u16raster(png).value()).size(); };
+}
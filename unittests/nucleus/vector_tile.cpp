@@ -19,6 +19,7 @@
 
 #include <QSignalSpy>
 #include <catch2/catch_test_macros.hpp>
+#include <nucleus/srs.h>
 #include <nucleus/tile/TileLoadService.h>
 #include <nucleus/tile/utils.h>
 #include <nucleus/vector_tile/parse.h>
@@ -80,6 +81,11 @@ TEST_CASE("nucleus/vector_tiles")
             CHECK(all_ids.contains(osm_id));
             all_ids.erase(osm_id);
 
+            const auto world_space_pos = nucleus::srs::lat_long_alt_to_world(poi.lat_long_alt);
+            CHECK(std::abs(poi.world_space_pos.x - world_space_pos.x) <= nucleus::srs::batch_max_world_error);
+            CHECK(std::abs(poi.world_space_pos.y - world_space_pos.y) <= nucleus::srs::batch_max_world_error);
+            CHECK(std::abs(poi.world_space_pos.z - world_space_pos.z) <= nucleus::srs::batch_max_relative_altitude_error * std::max(1.0, std::abs(world_space_pos.z)));
+
             // qDebug() << poi.name << " (" << poi.id << "): " << poi.attributes;
 
             if (osm_id == 26863041ul) {
@@ -0,0 +1,278 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QFile>
+#include <QTemporaryDir>
+#include <catch2/catch_test_macros.hpp>
+#include <webgpu/compute/NodeGraph.h>
+#include <webgpu/compute/nodes/GPXTrackNode.h>
+
+using namespace webgpu_compute::nodes;
+
+namespace {
+// cpu only, completes synchronously. output = input + value (or just value, if the input is not connected)
+class AddNode : public Node {
+public:
+    NODE_TYPE_NAME(AddNode)
+
+    explicit AddNode(unsigned value, bool cacheable = true)
+        : Node({ InputSocket(*this, "in", data_type<glm::uvec2>()) }, { OutputSocket(*this, "out", data_type<glm::uvec2>(), [this]() { return m_output; }) })
+        , m_value(value)
+        , m_cacheable(cacheable)
+    {
+    }
+
+    void serialize_settings(QJsonObject& out) const override { out["value"] = int(m_value); }
+    void deserialize_settings(const QJsonObject& in) override { m_value = unsigned(in["value"].toInt()); }
+    [[nodiscard]] bool is_cacheable() const override { return m_cacheable; }
+
+    unsigned m_value = 0;
+    bool m_fail = false;
+    unsigned m_n_run_impl_calls = 0;
+
+protected:
+    void run_impl() override
+    {
+        ++m_n_run_impl_calls;
+        if (m_fail) {
+            fail_run("asked to fail");
+            return;
+        }
+        m_output = glm::uvec2(m_value);
+        if (input_socket("in").is_socket_connected())
+            m_output += std::get<glm::uvec2>(get_input_data("in"));
+        complete_run();
+    }
+
+private:
+    glm::uvec2 m_output = {};
+    bool m_cacheable = true;
+};
+
+// source -> a -> b, and an independent node c
+struct Fixture {
+    NodeGraph graph;
+    AddNode* source = nullptr;
+    AddNode* a = nullptr;
+    AddNode* b = nullptr;
+    AddNode* c = nullptr;
+    unsigned n_completed = 0;
+    unsigned n_failed = 0;
+
+    Fixture()
+    {
+        source = static_cast<AddNode*>(graph.add_node("source", std::make_unique<AddNode>(1)));
+        a = static_cast<AddNode*>(graph.add_node("a", std::make_unique<AddNode>(10)));
+        b = static_cast<AddNode*>(graph.add_node("b", std::make_unique<AddNode>(100)));
+        c = static_cast<AddNode*>(graph.add_node("c", std::make_unique<AddNode>(1000)));
+        source->output_socket("out").connect(a->input_socket("in"));
+        a->output_socket("out").connect(b->input_socket("in"));
+        graph.connect_node_signals_and_slots();
+        QObject::connect(&graph, &NodeGraph::run_completed, [this]() { ++n_completed; });
+        QObject::connect(&graph, &NodeGraph::run_failed, [this]() { ++n_failed; });
+    }
+
+    [[nodiscard]] unsigned result() { return std::get<glm::uvec2>(b->output_socket("out").get_data()).x; }
+    [[nodiscard]] std::vector<unsigned> executions() const { return { source->m_n_run_impl_calls, a->m_n_run_impl_calls, b->m_n_run_impl_calls, c->m_n_run_impl_calls }; }
+};
+} // namespace
+
+TEST_CASE("webgpu_compute/NodeGraph caching")
+{
+    Fixture f;
+    f.graph.run();
+    REQUIRE(f.n_completed == 1);
+    CHECK(f.result() == 111);
+    CHECK(f.executions() == std::vector<unsigned> { 1, 1, 1, 1 });
+    CHECK(f.graph.get_reused_node_names().empty());
+
+    SECTION("unchanged graph reuses everything")
+    {
+        f.graph.run();
+        REQUIRE(f.n_completed == 2);
+        CHECK(f.result() == 111);
+        CHECK(f.executions() == std::vector<unsigned> { 1, 1, 1, 1 });
+        CHECK(f.graph.get_reused_node_names() == std::vector<std::string> { "a", "b", "c", "source" });
+    }
+
+    SECTION("changed settings propagate downstream only")
+    {
+        f.a->m_value = 20;
+        f.graph.run();
+        CHECK(f.result() == 121);
+        CHECK(f.executions() == std::vector<unsigned> { 1, 2, 2, 1 });
+        CHECK(f.graph.get_reused_node_names() == std::vector<std::string> { "c", "source" });
+
+        f.source->m_value = 2;
+        f.graph.run();
+        CHECK(f.result() == 122);
+        CHECK(f.executions() == std::vector<unsigned> { 2, 3, 3, 1 });
+    }
+
+    SECTION("only the last result is kept")
+    {
+        f.b->m_value = 200;
+        f.graph.run();
+        CHECK(f.result() == 211);
+        f.b->m_value = 100;
+        f.graph.run();
+        CHECK(f.result() == 111);
+        CHECK(f.executions() == std::vector<unsigned> { 1, 1, 3, 1 });
+    }
+
+    SECTION("disabling a node changes the downstream fingerprint")
+    {
+        const auto fingerprint = f.b->get_fingerprint();
+        f.a->set_enabled(false);
+        f.graph.run();
+        CHECK(f.executions() == std::vector<unsigned> { 1, 1, 2, 1 });
+        CHECK(f.b->get_fingerprint() != fingerprint);
+        // a still holds its result from before it was disabled
+        f.a->set_enabled(true);
+        f.graph.run();
+        CHECK(f.executions() == std::vector<unsigned> { 1, 1, 3, 1 });
+        CHECK(f.b->get_fingerprint() == fingerprint);
+    }
+
+    SECTION("rewiring changes the fingerprint")
+    {
+        f.b->input_socket("in").connect(f.c->output_socket("out"));
+        f.graph.connect_node_signals_and_slots();
+        f.graph.run();
+        CHECK(f.result() == 1100);
+        CHECK(f.executions() == std::vector<unsigned> { 1, 1, 2, 1 });
+    }
+
+    SECTION("rerun forces execution and updates downstream")
+    {
+        f.a->m_value = 30;
+        f.a->rerun();
+        CHECK(f.result() == 131);
+        CHECK(f.executions() == std::vector<unsigned> { 1, 2, 2, 1 });
+    }
+
+    SECTION("invalidation")
+    {
+        f.graph.invalidate_cached_results();
+        f.graph.run();
+        CHECK(f.executions() == std::vector<unsigned> { 2, 2, 2, 2 });
+        CHECK(f.graph.get_reused_node_names().empty());
+    }
+
+    SECTION("caching can be disabled")
+    {
+        f.graph.set_caching_enabled(false);
+        f.graph.run();
+        CHECK(f.executions() == std::vector<unsigned> { 2, 2, 2, 2 });
+        CHECK(!f.a->get_fingerprint());
+        f.graph.set_caching_enabled(true);
+        f.graph.run();
+        f.graph.run();
+        CHECK(f.executions() == std::vector<unsigned> { 3, 3, 3, 3 });
+        CHECK(f.graph.get_reused_node_names().size() == 4);
+    }
+
+    SECTION("failed runs are not cached")
+    {
+        f.a->m_value = 40;
+        f.a->m_fail = true;
+        f.graph.run();
+        CHECK(f.n_failed == 1);
+        f.a->m_fail = false;
+        f.graph.run();
+        CHECK(f.result() == 141);
+        CHECK(f.executions() == std::vector<unsigned> { 1, 3, 2, 1 });
+    }
+}
+
+TEST_CASE("webgpu_compute/NodeGraph caching of nodes with side effects")
+{
+    NodeGraph graph;
+    auto* export_like = static_cast<AddNode*>(graph.add_node("export", std::make_unique<AddNode>(1, false)));
+    auto* downstream = static_cast<AddNode*>(graph.add_node("downstream", std::make_unique<AddNode>(2)));
+    export_like->output_socket("out").connect(downstream->input_socket("in"));
+    graph.connect_node_signals_and_slots();
+
+    graph.run();
+    graph.run();
+    CHECK(export_like->m_n_run_impl_calls == 2);
+    CHECK(downstream->m_n_run_impl_calls == 2);
+    CHECK(graph.get_reused_node_names().empty());
+}
+
+TEST_CASE("webgpu_compute/NodeGraph caching of nodes reading files")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const auto path = dir.filePath("track.gpx");
+    const auto write_track = [&](const QString& points) {
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        file.write(QString("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<gpx version=\"1.1\"><trk><trkseg>%1</trkseg></trk></gpx>\n").arg(points).toUtf8());
+    };
+    write_track("<trkpt lat=\"47.0\" lon=\"12.0\"><ele>1000</ele></trkpt><trkpt lat=\"47.1\" lon=\"12.1\"><ele>1000</ele></trkpt>");
+
+    NodeGraph graph;
+    auto* gpx = static_cast<GPXTrackNode*>(graph.add_node("gpx", std::make_unique<GPXTrackNode>()));
+    gpx->set_settings({ path.toStdString(), true });
+    graph.connect_node_signals_and_slots();
+    const auto region = [&]() { return *std::get<const radix::geometry::Aabb<3, double>*>(gpx->output_socket("region").get_data()); };
+
+    graph.run();
+    const auto first_region = region();
+    graph.run();
+    CHECK(gpx->was_last_run_reused());
+
+    SECTION("rewriting the file invalidates the cached result")
+    {
+        write_track("<trkpt lat=\"46.0\" lon=\"11.0\"><ele>1000</ele></trkpt><trkpt lat=\"46.25\" lon=\"11.25\"><ele>1000</ele></trkpt>");
+        graph.run();
+        CHECK(!gpx->was_last_run_reused());
+        CHECK(region().min.x < first_region.min.x);
+        graph.run();
+        CHECK(gpx->was_last_run_reused());
+    }
+
+    SECTION("enable_caching = false reloads on every run")
+    {
+        gpx->set_settings({ path.toStdString(), false });
+        graph.run();
+        CHECK(!gpx->was_last_run_reused());
+        graph.run();
+        CHECK(!gpx->was_last_run_reused());
+    }
+}
+
+TEST_CASE("webgpu_compute/Node fingerprint")
+{
+    AddNode a(1);
+    AddNode b(1);
+    REQUIRE(a.compute_fingerprint());
+    CHECK(a.compute_fingerprint() == b.compute_fingerprint());
+    b.m_value = 2;
+    CHECK(a.compute_fingerprint() != b.compute_fingerprint());
+
+    // not yet run upstream nodes have no fingerprint, neither have their downstream nodes
+    AddNode upstream(1);
+    upstream.output_socket("out").connect(a.input_socket("in"));
+    CHECK(!a.compute_fingerprint());
+
+    a.set_caching_enabled(false);
+    CHECK(!b.get_fingerprint());
+    CHECK(!a.compute_fingerprint());
+}
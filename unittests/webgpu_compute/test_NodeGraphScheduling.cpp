@@ -0,0 +1,198 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <QTest>
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <thread>
+#include <webgpu/compute/NodeGraph.h>
+
+using namespace webgpu_compute::nodes;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+// cpu only. sleeps on the thread pool of the node and records when it started and finished.
+class TimedNode : public Node {
+public:
+    NODE_TYPE_NAME(TimedNode)
+
+    explicit TimedNode(std::chrono::milliseconds duration)
+        : Node({ InputSocket(*this, "a", data_type<glm::uvec2>()), InputSocket(*this, "b", data_type<glm::uvec2>()) },
+              { OutputSocket(*this, "out", data_type<glm::uvec2>(), [this]() { return m_output; }) })
+        , m_duration(duration)
+    {
+    }
+
+    std::chrono::milliseconds m_duration;
+    bool m_fail = false;
+    std::optional<Clock::time_point> m_started;
+    std::optional<Clock::time_point> m_finished;
+
+protected:
+    void run_impl() override
+    {
+        m_started = Clock::now();
+        const auto duration = m_duration;
+        run_on_thread_pool([duration]() { std::this_thread::sleep_for(duration); },
+            [this]() {
+                m_finished = Clock::now();
+                if (m_fail) {
+                    fail_run("asked to fail");
+                    return;
+                }
+                m_output = glm::uvec2(1);
+                for (const auto* name : { "a", "b" }) {
+                    if (input_socket(name).is_socket_connected())
+                        m_output += std::get<glm::uvec2>(get_input_data(name));
+                }
+                complete_run();
+            });
+    }
+
+private:
+    glm::uvec2 m_output = {};
+};
+
+[[nodiscard]] bool overlap(const TimedNode& a, const TimedNode& b) { return *a.m_started < *b.m_finished && *b.m_started < *a.m_finished; }
+
+// a source feeding two independent branches (e.g., snow and release points / trajectories), joined at the end
+struct Fixture {
+    NodeGraph graph;
+    TimedNode* source = nullptr;
+    TimedNode* snow_1 = nullptr;
+    TimedNode* snow_2 = nullptr;
+    TimedNode* release_1 = nullptr;
+    TimedNode* release_2 = nullptr;
+    TimedNode* join = nullptr;
+    unsigned n_completed = 0;
+    std::vector<GraphRunFailureInfo> failures;
+    std::vector<std::string> progress;
+
+    explicit Fixture(std::chrono::milliseconds duration)
+    {
+        const auto add = [&](const std::string& name) { return static_cast<TimedNode*>(graph.add_node(name, std::make_unique<TimedNode>(duration))); };
+        source = add("source");
+        snow_1 = add("snow_1");
+        snow_2 = add("snow_2");
+        release_1 = add("release_1");
+        release_2 = add("release_2");
+        join = add("join");
+        source->output_socket("out").connect(snow_1->input_socket("a"));
+        snow_1->output_socket("out").connect(snow_2->input_socket("a"));
+        source->output_socket("out").connect(release_1->input_socket("a"));
+        release_1->output_socket("out").connect(release_2->input_socket("a"));
+        snow_2->output_socket("out").connect(join->input_socket("a"));
+        release_2->output_socket("out").connect(join->input_socket("b"));
+        graph.connect_node_signals_and_slots();
+        graph.set_caching_enabled(false);
+        QObject::connect(&graph, &NodeGraph::run_completed, [this]() { ++n_completed; });
+        QObject::connect(&graph, &NodeGraph::run_failed, [this](GraphRunFailureInfo info) { failures.push_back(info); });
+        QObject::connect(&graph, &NodeGraph::node_completed, [this](const std::string& name, unsigned, unsigned) { progress.push_back(name); });
+    }
+
+    [[nodiscard]] bool run_and_wait()
+    {
+        graph.run();
+        return QTest::qWaitFor([this]() { return !graph.is_running(); }, 10000);
+    }
+
+    [[nodiscard]] unsigned result() { return std::get<glm::uvec2>(join->output_socket("out").get_data()).x; }
+};
+} // namespace
+
+TEST_CASE("webgpu_compute/NodeGraph scheduling")
+{
+    SECTION("independent branches run concurrently")
+    {
+        Fixture f(std::chrono::milliseconds(20));
+        REQUIRE(f.run_and_wait());
+        CHECK(f.n_completed == 1);
+        CHECK(f.failures.empty());
+        CHECK(f.result() == 7);
+
+        // both branches are started before either of them finished (independent of the number of threads in the pool)
+        CHECK(overlap(*f.snow_1, *f.release_1));
+        CHECK(overlap(*f.snow_2, *f.release_2));
+        CHECK(*f.release_1->m_started < *f.snow_1->m_finished);
+        // dependencies are respected
+        CHECK(*f.source->m_finished <= *f.snow_1->m_started);
+        CHECK(*f.snow_1->m_finished <= *f.snow_2->m_started);
+        CHECK(*f.snow_2->m_finished <= *f.join->m_started);
+        CHECK(*f.release_2->m_finished <= *f.join->m_started);
+
+        REQUIRE(f.progress.size() == 6);
+        CHECK(f.progress.front() == "source");
+        CHECK(f.progress.back() == "join");
+    }
+
+    SECTION("a failing branch skips its downstream nodes, the other branch completes")
+    {
+        Fixture f(std::chrono::milliseconds(10));
+        f.release_1->m_fail = true;
+        REQUIRE(f.run_and_wait());
+        CHECK(f.n_completed == 0);
+        REQUIRE(f.failures.size() == 1);
+        CHECK(f.failures.front().node_name() == "release_1");
+        CHECK(f.failures.front().skipped_node_names() == std::vector<std::string> { "join", "release_2" });
+        CHECK(f.snow_2->m_finished);
+        CHECK(!f.release_2->m_started);
+        CHECK(!f.join->m_started);
+
+        f.release_1->m_fail = false;
+        REQUIRE(f.run_and_wait());
+        CHECK(f.n_completed == 1);
+        CHECK(f.result() == 7);
+    }
+
+    SECTION("run while running is deferred")
+    {
+        Fixture f(std::chrono::milliseconds(10));
+        f.graph.run();
+        f.graph.run();
+        REQUIRE(QTest::qWaitFor([&]() { return f.n_completed == 2; }, 10000));
+        CHECK(!f.graph.is_running());
+        CHECK(f.progress.size() == 12);
+    }
+
+    SECTION("a node rerun during a run updates its downstream nodes afterwards")
+    {
+        Fixture f(std::chrono::milliseconds(10));
+        REQUIRE(f.run_and_wait());
+        f.graph.run();
+        // source is done already in the new run, its rerun completes while the branches are still running
+        REQUIRE(QTest::qWaitFor([&]() { return f.progress.size() >= 7; }, 10000));
+        f.source->rerun();
+        REQUIRE(QTest::qWaitFor([&]() { return f.n_completed == 3; }, 10000));
+        CHECK(!f.graph.is_running());
+        CHECK(*f.join->m_started > *f.source->m_finished);
+    }
+
+    SECTION("a rerun node updates its downstream nodes only")
+    {
+        Fixture f(std::chrono::milliseconds(10));
+        REQUIRE(f.run_and_wait());
+        const auto snow_2_finished = *f.snow_2->m_finished;
+        const auto join_finished = *f.join->m_finished;
+        f.progress.clear();
+        f.release_1->rerun();
+        REQUIRE(QTest::qWaitFor([&]() { return f.n_completed == 2; }, 10000));
+        CHECK(f.progress == std::vector<std::string> { "release_1", "release_2", "join" });
+        CHECK(*f.snow_2->m_finished == snow_2_finished);
+        CHECK(*f.join->m_finished > join_finished);
+    }
+}
@@ -0,0 +1,233 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <nucleus/srs.h>
+#include <random>
+#include <webgpu/compute/NodeGraph.h>
+#include <webgpu/compute/WorkTiling.h>
+#include <webgpu/compute/nodes/SelectTilesNode.h>
+
+using namespace webgpu_compute;
+
+namespace {
+RectangularTileRegion make_region(glm::uvec2 min, glm::uvec2 max, unsigned zoom_level) { return { min, max, zoom_level, radix::tile::Scheme::Tms }; }
+
+// a "computation" with a reach of 1 pixel: 3x3 box filter, clamped at the border of the image
+nucleus::Raster<float> box_filter(const nucleus::Raster<float>& image)
+{
+    nucleus::Raster<float> result(image.size());
+    const auto size = glm::ivec2(image.size());
+    for (int y = 0; y < size.y; ++y) {
+        for (int x = 0; x < size.x; ++x) {
+            float sum = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx)
+                    sum += image.pixel(glm::uvec2(glm::clamp(glm::ivec2(x + dx, y + dy), glm::ivec2(0), size - 1)));
+            }
+            result.pixel(glm::uvec2(x, y)) = sum / 9;
+        }
+    }
+    return result;
+}
+
+// input of the whole zoom level, row 0 is north
+float input_value(glm::uvec2 level_pixel) { return float((level_pixel.x * 7919u + level_pixel.y * 104729u) % 1000u); }
+
+// stitched image of a tile region, like TileStitchNode
+nucleus::Raster<float> stitch(const RectangularTileRegion& region, glm::uvec2 tile_size)
+{
+    const auto last_tile = (1u << region.zoom_level) - 1;
+    nucleus::Raster<float> image((region.max - region.min + 1u) * tile_size);
+    const auto origin = glm::uvec2(region.min.x, last_tile - region.max.y) * tile_size;
+    for (unsigned y = 0; y < image.height(); ++y) {
+        for (unsigned x = 0; x < image.width(); ++x)
+            image.pixel({ x, y }) = input_value(origin + glm::uvec2(x, y));
+    }
+    return image;
+}
+} // namespace
+
+TEST_CASE("webgpu_compute/WorkTiling")
+{
+    SECTION("small regions are a single work tile")
+    {
+        const auto region = make_region({ 10, 20 }, { 12, 25 }, 8);
+        const auto tiling = split_into_work_tiles(region, { glm::uvec2(64), 8192, 100 });
+        REQUIRE(tiling.has_value());
+        REQUIRE(tiling->tiles.size() == 1);
+        CHECK(tiling->n_bands == 1);
+        CHECK(tiling->output_size == glm::uvec2(3 * 64, 6 * 64));
+        const auto& tile = tiling->tiles.front();
+        CHECK(tile.core.min == region.min);
+        CHECK(tile.core.max == region.max);
+        // 100 pixels are 2 tiles
+        CHECK(tile.padded.min == glm::uvec2(8, 18));
+        CHECK(tile.padded.max == glm::uvec2(14, 27));
+        CHECK(tile.core_offset == glm::uvec2(128, 128));
+        CHECK(tile.output_offset == glm::uvec2(0, 0));
+        CHECK(tile.core_size == tiling->output_size);
+    }
+
+    SECTION("large regions are partitioned")
+    {
+        const auto region = make_region({ 1000, 2000 }, { 1299, 2199 }, 12);
+        const auto settings = WorkTilingSettings { glm::uvec2(64), 8192, 100 };
+        const auto tiling = split_into_work_tiles(region, settings);
+        REQUIRE(tiling.has_value());
+        // 128 tiles per work tile, minus 2 * 2 halo tiles
+        CHECK(tiling->n_bands == 2);
+        REQUIRE(tiling->tiles.size() == 6);
+
+        std::vector<unsigned> n_covered(300 * 200, 0);
+        for (const auto& tile : tiling->tiles) {
+            CAPTURE(tile.core.min.x, tile.core.min.y, tile.band);
+            const auto padded_size = (tile.padded.max - tile.padded.min + 1u) * settings.tile_size;
+            CHECK(padded_size.x <= 8192);
+            CHECK(padded_size.y <= 8192);
+            CHECK(tile.padded.min + 2u == tile.core.min);
+            CHECK(tile.padded.max == tile.core.max + 2u);
+            CHECK(tile.core_offset == glm::uvec2(128, 128));
+            CHECK(tile.core_size == (tile.core.max - tile.core.min + 1u) * settings.tile_size);
+            CHECK(tile.output_offset == glm::uvec2(tile.core.min.x - region.min.x, region.max.y - tile.core.max.y) * settings.tile_size);
+            for (unsigned y = tile.core.min.y; y <= tile.core.max.y; ++y) {
+                for (unsigned x = tile.core.min.x; x <= tile.core.max.x; ++x)
+                    ++n_covered[(y - region.min.y) * 300 + x - region.min.x];
+            }
+        }
+        CHECK(std::all_of(n_covered.begin(), n_covered.end(), [](unsigned n) { return n == 1; }));
+
+        // north to south
+        CHECK(tiling->tiles.front().core.max.y == region.max.y);
+        CHECK(tiling->tiles.front().band == 0);
+        CHECK(tiling->tiles.back().core.min.y == region.min.y);
+        CHECK(tiling->tiles.back().band == 1);
+    }
+
+    SECTION("halo is clamped to the zoom level")
+    {
+        const auto tiling = split_into_work_tiles(make_region({ 0, 14 }, { 3, 15 }, 4), { glm::uvec2(64), 8192, 64 });
+        REQUIRE(tiling.has_value());
+        REQUIRE(tiling->tiles.size() == 1);
+        const auto& tile = tiling->tiles.front();
+        CHECK(tile.padded.min == glm::uvec2(0, 13));
+        CHECK(tile.padded.max == glm::uvec2(4, 15));
+        CHECK(tile.core_offset == glm::uvec2(0, 0));
+    }
+
+    SECTION("errors")
+    {
+        CHECK(!split_into_work_tiles(make_region({ 2, 2 }, { 1, 2 }, 4), {}).has_value());
+        CHECK(!split_into_work_tiles(make_region({ 0, 0 }, { 16, 2 }, 4), {}).has_value());
+        CHECK(!split_into_work_tiles(make_region({ 0, 0 }, { 1, 1 }, 4), { glm::uvec2(64), 8192, 4096 }).has_value());
+        CHECK(split_into_work_tiles(make_region({ 0, 0 }, { 1, 1 }, 4), { glm::uvec2(64), 8192, 4000 }).has_value());
+    }
+
+    SECTION("halo for distance")
+    {
+        CHECK(halo_for_distance(0, 16, 64) == 0);
+        const auto pixel_size = nucleus::srs::tile_width(16) / 64;
+        CHECK(halo_for_distance(1000, 16, 64) == unsigned(std::ceil(1000 / pixel_size)));
+        CHECK(halo_for_distance(pixel_size * 0.5, 16, 64) == 1);
+    }
+}
+
+TEST_CASE("webgpu_compute/WorkTileMerger")
+{
+    // 4 pixel tiles, work tiles of at most 6x6 tiles with 1 tile halo, i.e., cores of 4x4 tiles
+    const auto settings = WorkTilingSettings { glm::uvec2(4), 24, 1 };
+    const auto region = make_region({ 3, 7 }, { 12, 31 }, 5);
+    const auto tiling = split_into_work_tiles(region, settings);
+    REQUIRE(tiling.has_value());
+    REQUIRE(tiling->tiles.size() == 21);
+    REQUIRE(tiling->n_bands == 7);
+
+    const auto reference = box_filter(stitch(region, settings.tile_size));
+    // the reference is computed on the region only. away from the border of the region, it is equal to the computation on the whole level
+    const auto interior = [&](glm::uvec2 p) { return p.x > 0 && p.y > 0 && p.x + 1 < tiling->output_size.x && p.y + 1 < tiling->output_size.y; };
+
+    nucleus::Raster<float> output(tiling->output_size, -1.0f);
+    std::vector<unsigned> rows;
+    WorkTileMerger<float> merger(*tiling, [&](unsigned row, std::span<const float> pixels) {
+        REQUIRE(pixels.size() == output.width());
+        rows.push_back(row);
+        std::copy(pixels.begin(), pixels.end(), &output.pixel({ 0, row }));
+    });
+
+    auto tiles = tiling->tiles;
+    SECTION("in order")
+    {
+        for (const auto& tile : tiles) {
+            merger.add(tile, box_filter(stitch(tile.padded, settings.tile_size)));
+            CHECK(merger.n_buffered_bands() <= 1);
+        }
+    }
+    SECTION("out of order")
+    {
+        std::shuffle(tiles.begin(), tiles.end(), std::mt19937(42));
+        for (const auto& tile : tiles)
+            merger.add(tile, box_filter(stitch(tile.padded, settings.tile_size)));
+    }
+
+    CHECK(merger.is_finished());
+    CHECK(merger.n_buffered_bands() == 0);
+    REQUIRE(rows.size() == tiling->output_size.y);
+    for (unsigned i = 0; i < rows.size(); ++i)
+        CHECK(rows[i] == i);
+    unsigned n_mismatches = 0;
+    for (unsigned y = 0; y < output.height(); ++y) {
+        for (unsigned x = 0; x < output.width(); ++x) {
+            if (interior({ x, y }) && output.pixel({ x, y }) != reference.pixel({ x, y }))
+                ++n_mismatches;
+        }
+    }
+    CHECK(n_mismatches == 0);
+}
+
+TEST_CASE("webgpu_compute/SelectTilesNode tile region override")
+{
+    nodes::NodeGraph graph;
+    auto* node = static_cast<nodes::SelectTilesNode*>(graph.add_node("select_tiles", std::make_unique<nodes::SelectTilesNode>()));
+    graph.connect_node_signals_and_slots();
+    unsigned n_completed = 0;
+    QObject::connect(&graph, &nodes::NodeGraph::run_completed, [&]() { ++n_completed; });
+
+    const auto tile_ids = [&]() { return *std::get<nodes::data_type<const std::vector<radix::tile::Id>*>()>(node->output_socket("tile ids").get_data()); };
+
+    node->set_tile_region_override(make_region({ 3, 4 }, { 4, 6 }, 10));
+    graph.run();
+    REQUIRE(n_completed == 1);
+    CHECK(tile_ids().size() == 6);
+    CHECK(tile_ids().front() == radix::tile::Id { 10, { 3, 4 }, radix::tile::Scheme::Tms });
+    const auto fingerprint = node->get_fingerprint();
+
+    // another work tile is not mistaken for the cached result
+    node->set_tile_region_override(make_region({ 5, 4 }, { 5, 4 }, 10));
+    graph.run();
+    REQUIRE(n_completed == 2);
+    CHECK(tile_ids().size() == 1);
+    CHECK(node->get_fingerprint() != fingerprint);
+    CHECK(graph.get_reused_node_names().empty());
+
+    // the override isn't saved with the graph
+    QJsonObject settings;
+    node->serialize_settings(settings);
+    CHECK(!settings.contains("tile_region_override"));
+}
@@ -0,0 +1,225 @@
+/*****************************************************************************
+ * AlpineMaps.org
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <webgpu/compute/avalanche_trajectories_cpu.h>
+
+using namespace webgpu_compute::avalanche_trajectories_cpu;
+using TrajectoriesNode = webgpu_compute::nodes::ComputeAvalancheTrajectoriesNode;
+
+namespace {
+// 32x32 cells of 10m, inclined southwards (i.e., towards increasing rows) with the given slope
+Input inclined_plane(float slope_degrees, const std::vector<glm::uvec2>& release_cells)
+{
+    const glm::uvec2 size = { 32, 32 };
+    const auto tan_slope = std::tan(glm::radians(slope_degrees));
+    Input input { nucleus::Raster<glm::vec3>(size, glm::normalize(glm::vec3(0, -tan_slope, 1))), nucleus::Raster<float>(size), nucleus::Raster<uint8_t>(size, 0), { 320, 320 } };
+    for (unsigned row = 0; row < size.y; ++row) {
+        for (unsigned col = 0; col < size.x; ++col)
+            input.heights.pixel({ col, row }) = 2000.0f - (float(row) + 0.5f) * 10.0f * tan_slope;
+    }
+    for (const auto& cell : release_cells)
+        input.release_points.pixel(cell) = 255;
+    return input;
+}
+
+Settings default_settings()
+{
+    Settings settings;
+    settings.num_paths_per_release_cell = 16;
+    settings.active_model = TrajectoriesNode::WEBIGEO_AVALANCHE_SIMULATION;
+    settings.max_perturbation = 0;
+    settings.runout_flowpy.alpha = 25;
+    return settings;
+}
+
+uint32_t max_of(const nucleus::Raster<uint32_t>& raster) { return *std::max_element(raster.buffer().begin(), raster.buffer().end()); }
+
+// columns and lowest row of the cells that were touched
+std::pair<glm::uvec2, unsigned> footprint(const nucleus::Raster<uint32_t>& cell_counts)
+{
+    glm::uvec2 columns = { std::numeric_limits<unsigned>::max(), 0 };
+    unsigned max_row = 0;
+    for (unsigned row = 0; row < cell_counts.height(); ++row) {
+        for (unsigned col = 0; col < cell_counts.width(); ++col) {
+            if (cell_counts.pixel({ col, row }) == 0)
+                continue;
+            columns = { std::min(columns.x, col), std::max(columns.y, col) };
+            max_row = std::max(max_row, row);
+        }
+    }
+    return { columns, max_row };
+}
+} // namespace
+
+TEST_CASE("webgpu_compute/avalanche_trajectories_cpu")
+{
+    SECTION("random numbers match random.wgsl")
+    {
+        Random random(glm::uvec4(1, 2, 3, 4));
+        const auto r = random.rand4();
+        CHECK(r.x == float(908250390u) / 4294967296.0f);
+        CHECK(r.y == float(4044648920u) / 4294967296.0f);
+        CHECK(r.z == float(3775961919u) / 4294967296.0f);
+        CHECK(r.w == float(45698095u) / 4294967296.0f);
+        CHECK(random.rand4() != r);
+    }
+
+    SECTION("sampling")
+    {
+        nucleus::Raster<float> heights({ 4, 4 });
+        nucleus::Raster<glm::vec3> normals({ 4, 4 });
+        for (unsigned row = 0; row < 4; ++row) {
+            for (unsigned col = 0; col < 4; ++col) {
+                heights.pixel({ col, row }) = float(col);
+                normals.pixel({ col, row }) = glm::vec3(float(row), 0, 0);
+            }
+        }
+        CHECK(sample_bilinear(normals, { 0.375f, 0.375f }).x == 1.0f);
+        CHECK(sample_bilinear(normals, { 0.5f, 0.5f }).x == 1.5f);
+        CHECK(sample_bilinear(normals, { 0.0f, 0.0f }).x == 0.0f); // clamped
+        CHECK(std::abs(sample_gather(heights, { 0.5f, 0.5f }) - 1.5f) < 0.01f);
+        CHECK(std::abs(sample_gather(heights, { 0.625f, 0.125f }) - 2.0f) < 0.01f);
+    }
+
+    SECTION("steep slope, trajectories run straight down to the border")
+    {
+        auto settings = default_settings();
+        Statistics statistics;
+        const auto layers = simulate(inclined_plane(35, { { 16, 2 } }), settings, 0, &statistics);
+        CHECK(statistics.n_paths == 16);
+        CHECK(layers.resolution == glm::uvec2(256));
+        const auto [columns, max_row] = footprint(layers.cell_counts);
+        CHECK(columns.x >= 16 * 8);
+        CHECK(columns.y < 17 * 8);
+        CHECK(max_row >= 250);
+
+        // ~290m travelled, z_delta = travel * (tan(slope) - tan(alpha)), the travel angle is the slope
+        CHECK(max_of(layers.travel_length) > 270);
+        CHECK(max_of(layers.travel_length) < 300);
+        CHECK(max_of(layers.zdelta) > 60);
+        CHECK(max_of(layers.zdelta) < 75);
+        CHECK(max_of(layers.travel_angle) >= 34);
+        CHECK(max_of(layers.travel_angle) <= 35);
+        CHECK(max_of(layers.altitude_difference) > 190);
+        CHECK(max_of(layers.altitude_difference) < 210);
+    }
+
+    SECTION("slope below the runout angle stops immediately")
+    {
+        Statistics statistics;
+        const auto layers = simulate(inclined_plane(20, { { 16, 2 } }), default_settings(), 0, &statistics);
+        CHECK(statistics.n_paths == 16);
+        CHECK(max_of(layers.cell_counts) == 0);
+    }
+
+    SECTION("physics model with coulomb friction")
+    {
+        auto settings = default_settings();
+        settings.active_model = TrajectoriesNode::PHYSICS_LESS_SIMPLE;
+        settings.active_runout_model = TrajectoriesNode::Coulomb;
+        const auto steep = simulate(inclined_plane(35, { { 16, 2 } }), settings);
+        CHECK(footprint(steep.cell_counts).second >= 250);
+        CHECK(max_of(steep.zdelta) > 0);
+
+        // much more friction than slope. note that the shader applies the tangential acceleration twice per step, so the
+        // friction coefficient has to be well above tan(slope) for the avalanche to stop.
+        settings.model2.friction_coeff = 0.5f;
+        const auto flat = simulate(inclined_plane(5, { { 16, 2 } }), settings);
+        CHECK(max_of(flat.cell_counts) > 0);
+        CHECK(max_of(flat.travel_length) < 100);
+        CHECK(footprint(flat.cell_counts).second < 128);
+
+        settings.model2.friction_coeff = 0.155f;
+        for (const auto model : { TrajectoriesNode::Voellmy, TrajectoriesNode::VoellmyMinShear, TrajectoriesNode::SamosAt }) {
+            settings.active_runout_model = model;
+            const auto layers = simulate(inclined_plane(35, { { 16, 2 } }), settings);
+            CHECK(footprint(layers.cell_counts).second >= 250);
+            CHECK(max_of(layers.travel_angle) >= 34);
+        }
+    }
+
+    SECTION("deterministic and independent of the number of threads")
+    {
+        auto settings = default_settings();
+        settings.max_perturbation = glm::radians(25.0f);
+        settings.num_runs = 2;
+        const auto input = inclined_plane(35, { { 4, 2 }, { 16, 2 }, { 20, 10 }, { 28, 3 } });
+        const auto a = simulate(input, settings, 1);
+        const auto b = simulate(input, settings, 4);
+        CHECK(a.cell_counts.buffer() == b.cell_counts.buffer());
+        CHECK(a.zdelta.buffer() == b.zdelta.buffer());
+        CHECK(a.travel_length.buffer() == b.travel_length.buffer());
+        CHECK(a.travel_angle.buffer() == b.travel_angle.buffer());
+        CHECK(a.altitude_difference.buffer() == b.altitude_difference.buffer());
+
+        settings.random_seed = 2;
+        const auto c = simulate(input, settings, 4);
+        CHECK(a.cell_counts.buffer() != c.cell_counts.buffer());
+    }
+
+    SECTION("disabled layers are empty")
+    {
+        auto settings = default_settings();
+        settings.output_layer.layer3_travelLength_enabled = 0;
+        settings.output_layer.layer5_altitudeDifference_enabled = 0;
+        const auto layers = simulate(inclined_plane(35, { { 16, 2 } }), settings);
+        CHECK(layers.travel_length.buffer().empty());
+        CHECK(layers.altitude_difference.buffer().empty());
+        CHECK(max_of(layers.cell_counts) > 0);
+    }
+
+    SECTION("missing terrain stops the trajectories")
+    {
+        auto input = inclined_plane(35, { { 16, 2 } });
+        for (unsigned row = 16; row < 32; ++row) {
+            for (unsigned col = 0; col < 32; ++col)
+                input.heights.pixel({ col, row }) = 0;
+        }
+        const auto layers = simulate(input, default_settings());
+        CHECK(footprint(layers.cell_counts).second < 16 * 8);
+    }
+}
+
+TEST_CASE("webgpu_compute/avalanche_trajectories_cpu benchmark")
+{
+    auto settings = default_settings();
+    settings.max_perturbation = glm::radians(25.0f);
+    settings.num_paths_per_release_cell = 256;
+    std::vector<glm::uvec2> release_cells;
+    for (unsigned i = 0; i < 16; ++i)
+        release_cells.push_back({ 2 * i, 1 + i % 4 });
+    const auto input = inclined_plane(35, release_cells);
+
+    // 4096 paths per iteration, paths per second = 4096 / mean
+    BENCHMARK("4096 paths, all threads")
+    {
+        Statistics statistics;
+        const auto layers = simulate(input, settings, 0, &statistics);
+        return statistics.n_paths + layers.resolution.x;
+    };
+    BENCHMARK("4096 paths, single thread")
+    {
+        Statistics statistics;
+        const auto layers = simulate(input, settings, 1, &statistics);
+        return statistics.n_paths + layers.resolution.x;
+    };
+}
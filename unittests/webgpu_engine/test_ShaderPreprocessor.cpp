@@ -489,6 +489,109 @@ TEST_CASE("ShaderPreprocessor - Cache Management")
     }
 }
 
+TEST_CASE("ShaderPreprocessor - Bundle")
+{
+    ShaderPreprocessor preprocessor;
+    setup_error_callback(preprocessor);
+    MockFileSystem fs;
+    unsigned n_reads = 0;
+    fs.add_file("lib::main", "///use common\n///ifdef FEATURE\nconst FEATURE_ON: bool = true;\n///endif\nfn main() -> i32 { return VALUE; }\n");
+    fs.add_file("lib::common", "const VALUE: i32 = 42;\n");
+    preprocessor.set_file_reader([&fs, &n_reads](const std::string& name) {
+        ++n_reads;
+        return fs.read_file(name);
+    });
+
+    SECTION("results are memoised per set of global defines")
+    {
+        const auto plain = preprocessor.preprocess_file("lib::main");
+        CHECK(plain.find("const VALUE: i32 = 42;") != std::string::npos);
+        CHECK(plain.find("FEATURE_ON") == std::string::npos);
+        CHECK(preprocessor.n_bundled_results() == 1);
+        const auto revision = preprocessor.bundle_revision();
+        CHECK(preprocessor.preprocess_file("lib::main") == plain);
+        CHECK(preprocessor.bundle_revision() == revision);
+
+        preprocessor.define("FEATURE");
+        const auto with_feature = preprocessor.preprocess_file("lib::main");
+        CHECK(with_feature.find("FEATURE_ON") != std::string::npos);
+        CHECK(preprocessor.n_bundled_results() == 2);
+        CHECK(preprocessor.bundle_revision() > revision);
+
+        preprocessor.undefine("FEATURE");
+        CHECK(preprocessor.preprocess_file("lib::main") == plain);
+        CHECK(n_reads == 2); // every file is read once
+    }
+
+    SECTION("changed includes invalidate results")
+    {
+        const auto old_result = preprocessor.preprocess_file("lib::main");
+        fs.add_file("lib::common", "const VALUE: i32 = 99;\n");
+        CHECK(preprocessor.preprocess_file("lib::main") == old_result); // file cache
+        preprocessor.clear_cache();
+        const auto new_result = preprocessor.preprocess_file("lib::main");
+        CHECK(new_result.find("const VALUE: i32 = 99;") != std::string::npos);
+        CHECK(preprocessor.n_bundled_results() == 1);
+    }
+
+    SECTION("export and import")
+    {
+        preprocessor.preprocess_file("lib::main");
+        preprocessor.define("FEATURE");
+        preprocessor.preprocess_file("lib::main");
+        const auto bundle = preprocessor.export_bundle();
+
+        ShaderPreprocessor warm;
+        setup_error_callback(warm);
+        warm.set_file_reader([&fs](const std::string& name) { return fs.read_file(name); });
+        REQUIRE(warm.import_bundle(bundle));
+        CHECK(warm.n_bundled_results() == 2);
+        warm.define("FEATURE");
+        const auto revision = warm.bundle_revision();
+        CHECK(warm.preprocess_file("lib::main") == preprocessor.preprocess_file("lib::main"));
+        CHECK(warm.bundle_revision() == revision); // served from the bundle
+        CHECK(warm.export_bundle() == bundle);
+
+        // stale entries are recomputed
+        fs.add_file("lib::common", "const VALUE: i32 = 7;\n");
+        ShaderPreprocessor stale;
+        stale.set_file_reader([&fs](const std::string& name) { return fs.read_file(name); });
+        REQUIRE(stale.import_bundle(bundle));
+        CHECK(stale.preprocess_file("lib::main").find("const VALUE: i32 = 7;") != std::string::npos);
+    }
+
+    SECTION("invalid bundles are rejected")
+    {
+        preprocessor.preprocess_file("lib::main");
+        const auto bundle = preprocessor.export_bundle();
+        ShaderPreprocessor other;
+        CHECK(!other.import_bundle(""));
+        CHECK(!other.import_bundle("garbage\n"));
+        CHECK(!other.import_bundle(bundle.substr(0, bundle.size() / 2)));
+        CHECK(!other.import_bundle(bundle + "x"));
+        // written by another version of the preprocessor
+        const auto other_version = "weBIGeo shader bundle, preprocessor 0" + bundle.substr(bundle.find('\n'));
+        CHECK(!other.import_bundle(other_version));
+        CHECK(other.n_bundled_results() == 0);
+    }
+
+    SECTION("results with errors and uncached results are not memoised")
+    {
+        ShaderPreprocessor tolerant;
+        unsigned n_errors = 0;
+        tolerant.set_error_callback([&n_errors](const std::string&) { ++n_errors; });
+        fs.add_file("lib::broken", "///ifdef FEATURE\n");
+        tolerant.set_file_reader([&fs](const std::string& name) { return fs.read_file(name); });
+        tolerant.preprocess_file("lib::broken");
+        CHECK(n_errors == 1);
+        CHECK(tolerant.n_bundled_results() == 0);
+
+        preprocessor.set_cache_enabled(false);
+        preprocessor.preprocess_file("lib::main");
+        CHECK(preprocessor.n_bundled_results() == 0);
+    }
+}
+
 TEST_CASE("ShaderPreprocessor - Define and Macro Replacement Tests")
 {
     ShaderPreprocessor preprocessor;
@@ -741,6 +844,42 @@ TEST_CASE("ShaderPreprocessor - Benchmark")
         return total;
     };
 
+    {
+        ShaderPreprocessor first_run;
+        setup_error_callback(first_run);
+        first_run.set_file_reader(create_file_reader());
+        for (const auto& shader_file : shader_files)
+            first_run.preprocess_file(shader_file);
+        const auto bundle = first_run.export_bundle();
+
+        BENCHMARK("Preprocess all shaders (start with bundle)")
+        {
+            ShaderPreprocessor preprocessor;
+            setup_error_callback(preprocessor);
+            preprocessor.set_file_reader(create_file_reader());
+            preprocessor.import_bundle(bundle);
+
+            size_t total = 0;
+            for (const auto& shader_file : shader_files) {
+                total += preprocessor.preprocess_file(shader_file).size();
+            }
+            return total;
+        };
+
+        BENCHMARK("Preprocess all shaders (start without bundle)")
+        {
+            ShaderPreprocessor preprocessor;
+            setup_error_callback(preprocessor);
+            preprocessor.set_file_reader(create_file_reader());
+
+            size_t total = 0;
+            for (const auto& shader_file : shader_files) {
+                total += preprocessor.preprocess_file(shader_file).size();
+            }
+            return total;
+        };
+    }
+
     BENCHMARK("Preprocess all shaders (cache disabled)")
     {
         ShaderPreprocessor preprocessor;
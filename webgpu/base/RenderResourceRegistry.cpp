@@ -33,6 +33,19 @@ RenderResourceRegistry::RenderResourceRegistry()
 
 void RenderResourceRegistry::set_local_shader_path(const std::string& target, const std::string& path) { m_local_shader_paths[target] = path; }
 
+void RenderResourceRegistry::set_shader_bundle_path(const std::string& path)
+{
+    m_shader_bundle_path = path;
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    if (!m_preprocessor.import_bundle(file.readAll().toStdString())) {
+        qWarning() << "Ignoring invalid shader bundle" << QString::fromStdString(path);
+        return;
+    }
+    m_written_bundle_revision = m_preprocessor.bundle_revision();
+}
+
 void RenderResourceRegistry::register_shader(const std::string& name, const std::string& source_path)
 {
     if (has_shader(name)) // treat re-registration as a no-op
@@ -89,6 +102,9 @@ void RenderResourceRegistry::recreate_all(WGPUDevice device)
     for (auto& entry : m_shaders)
         entry.module = compile_shader(device, entry.source_path);
 
+    if (!m_shader_bundle_path.empty() && m_preprocessor.bundle_revision() != m_written_bundle_revision)
+        write_shader_bundle();
+
     for (auto& entry : m_layouts)
         entry.layout = entry.factory(device);
 
@@ -124,6 +140,18 @@ std::string RenderResourceRegistry::read_shader_source(const std::string& source
     return file.readAll().toStdString();
 }
 
+void RenderResourceRegistry::write_shader_bundle()
+{
+    QFile file(QString::fromStdString(m_shader_bundle_path));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not write shader bundle" << QString::fromStdString(m_shader_bundle_path);
+        return;
+    }
+    const auto bundle = m_preprocessor.export_bundle();
+    file.write(bundle.data(), qint64(bundle.size()));
+    m_written_bundle_revision = m_preprocessor.bundle_revision();
+}
+
 std::unique_ptr<raii::ShaderModule> RenderResourceRegistry::compile_shader_from_code(WGPUDevice device, const std::string& code, const std::string& label)
 {
     const std::string preprocessed = m_preprocessor.preprocess_code(code);
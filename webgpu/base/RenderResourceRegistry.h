@@ -18,6 +18,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -37,6 +38,10 @@ public:
     // Set the local filesystem path prefix for a targets shaders (for hot-reload).
     void set_local_shader_path(const std::string& target, const std::string& path);
 
+    // Preprocessed shaders are loaded from this file (if it exists), and written back by recreate_all when new shader permutations
+    // were preprocessed. Later starts skip preprocessing for all shaders whose sources are unchanged.
+    void set_shader_bundle_path(const std::string& path);
+
     // Register a shader by name and source path.
     void register_shader(const std::string& name, const std::string& source_path);
     [[nodiscard]] bool has_shader(const std::string& name) const;
@@ -59,6 +64,7 @@ public:
 
 private:
     std::string read_shader_source(const std::string& source_path) const;
+    void write_shader_bundle();
     std::unique_ptr<raii::ShaderModule> compile_shader(WGPUDevice device, const std::string& source_path);
 
 private:
@@ -66,6 +72,8 @@ private:
     std::unordered_map<std::string, std::string> m_local_shader_paths; // target namespace -> local dir prefix
 
     webgpu::util::ShaderPreprocessor m_preprocessor;
+    std::string m_shader_bundle_path;
+    uint64_t m_written_bundle_revision = 0;
 
     struct ShaderEntry {
         std::string source_path;
@@ -35,7 +35,8 @@ public:
 
     GenericRenderPipeline(WGPUDevice device, const ShaderModule& vertex_shader, const ShaderModule& fragment_shader,
         const VertexBufferInfos& vertex_buffer_infos, const FramebufferFormat& framebuffer_format, const BindGroupLayouts& bind_group_layouts,
-        const std::vector<std::optional<WGPUBlendState>>& blend_states = {});
+        const std::vector<std::optional<WGPUBlendState>>& blend_states = {},
+        WGPUPrimitiveTopology topology = WGPUPrimitiveTopology_TriangleStrip);
 
     const RenderPipeline& pipeline() const;
     const FramebufferFormat& framebuffer_format() const;
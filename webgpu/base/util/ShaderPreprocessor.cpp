@@ -17,11 +17,13 @@
  *****************************************************************************/
 #include "ShaderPreprocessor.h"
 
+#include <charconv>
 #include <functional>
 #include <iostream>
 #include <regex>
 #include <sstream>
 #include <stack>
+#include <string_view>
 
 namespace webgpu::util {
 
@@ -45,6 +47,74 @@ namespace {
             return first;
         return std::string::npos;
     }
+
+    // FNV-1a, stable across platforms and runs (unlike std::hash), so hashes can be persisted in bundles
+    uint64_t content_hash(const std::string& str)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (const auto c : str) {
+            hash ^= uint64_t(uint8_t(c));
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // bundle format: a version line, followed by length prefixed strings and numbers, each on its own line.
+    // the version is a hash of the preprocessor sources (computed by cmake), so that results of another preprocessor are never reused.
+    // changed shader sources are detected by the hashes stored with each result.
+    constexpr std::string_view bundle_version = "weBIGeo shader bundle, preprocessor " ALP_SHADER_PREPROCESSOR_HASH;
+
+    void write_bundle_number(std::string& out, uint64_t number)
+    {
+        out += std::to_string(number);
+        out += '\n';
+    }
+
+    void write_bundle_string(std::string& out, const std::string& str)
+    {
+        write_bundle_number(out, str.size());
+        out += str;
+        out += '\n';
+    }
+
+    class BundleReader {
+    public:
+        explicit BundleReader(std::string_view data)
+            : m_data(data)
+        {
+        }
+        bool read_line(std::string_view& line)
+        {
+            const auto end = m_data.find('\n', m_pos);
+            if (end == std::string_view::npos)
+                return false;
+            line = m_data.substr(m_pos, end - m_pos);
+            m_pos = end + 1;
+            return true;
+        }
+        bool read_number(uint64_t& number)
+        {
+            std::string_view line;
+            if (!read_line(line))
+                return false;
+            const auto result = std::from_chars(line.data(), line.data() + line.size(), number);
+            return result.ec == std::errc() && result.ptr == line.data() + line.size();
+        }
+        bool read_string(std::string& str)
+        {
+            uint64_t size = 0;
+            if (!read_number(size) || size >= m_data.size() - m_pos || m_data[m_pos + size] != '\n')
+                return false;
+            str = m_data.substr(m_pos, size);
+            m_pos += size + 1;
+            return true;
+        }
+        [[nodiscard]] bool at_end() const { return m_pos == m_data.size(); }
+
+    private:
+        std::string_view m_data;
+        size_t m_pos = 0;
+    };
 } // namespace
 
 ShaderPreprocessor::ShaderPreprocessor() { initialize_platform_defines(); }
@@ -98,7 +168,7 @@ std::string ShaderPreprocessor::get_value(const std::string& symbol) const
     return "";
 }
 
-void ShaderPreprocessor::clear_cache() { m_shader_name_to_code.clear(); }
+void ShaderPreprocessor::clear_cache() { m_shader_name_to_file.clear(); }
 
 void ShaderPreprocessor::set_cache_enabled(bool enabled)
 {
@@ -108,38 +178,151 @@ void ShaderPreprocessor::set_cache_enabled(bool enabled)
     }
 }
 
+std::string ShaderPreprocessor::export_bundle() const
+{
+    std::string out;
+    out += bundle_version;
+    out += '\n';
+    write_bundle_number(out, m_bundle.size());
+    for (const auto& [key, result] : m_bundle) {
+        write_bundle_string(out, key);
+        write_bundle_string(out, result.code);
+        write_bundle_number(out, result.sources.size());
+        for (const auto& [name, hash] : result.sources) {
+            write_bundle_string(out, name);
+            write_bundle_number(out, hash);
+        }
+    }
+    return out;
+}
+
+bool ShaderPreprocessor::import_bundle(const std::string& bundle)
+{
+    BundleReader in(bundle);
+    std::string_view version;
+    if (!in.read_line(version) || version != bundle_version)
+        return false;
+    uint64_t n_results = 0;
+    if (!in.read_number(n_results))
+        return false;
+
+    std::map<std::string, BundledResult> imported;
+    for (uint64_t i = 0; i < n_results; ++i) {
+        std::string key;
+        BundledResult result;
+        uint64_t n_sources = 0;
+        if (!in.read_string(key) || !in.read_string(result.code) || !in.read_number(n_sources) || n_sources == 0)
+            return false;
+        for (uint64_t j = 0; j < n_sources; ++j) {
+            std::string name;
+            uint64_t hash = 0;
+            if (!in.read_string(name) || !in.read_number(hash))
+                return false;
+            result.sources.emplace_back(std::move(name), hash);
+        }
+        imported[std::move(key)] = std::move(result);
+    }
+    if (!in.at_end())
+        return false;
+
+    m_bundle.merge(imported); // results computed in this run win
+    ++m_bundle_revision;
+    return true;
+}
+
+size_t ShaderPreprocessor::n_bundled_results() const { return m_bundle.size(); }
+
+uint64_t ShaderPreprocessor::bundle_revision() const { return m_bundle_revision; }
+
+void ShaderPreprocessor::clear_bundle() { m_bundle.clear(); }
+
 void ShaderPreprocessor::set_file_reader(std::function<std::string(const std::string&)> reader) { m_file_reader = std::move(reader); }
 
 void ShaderPreprocessor::set_error_callback(std::function<void(const std::string&)> callback) { m_error_callback = std::move(callback); }
 
 void ShaderPreprocessor::report_error(const std::string& message)
 {
+    ++m_n_errors;
     if (m_error_callback) {
         m_error_callback(message);
     }
 }
 
-std::string ShaderPreprocessor::get_file_contents_with_cache(const std::string& name)
+std::vector<ShaderPreprocessor::Chunk> ShaderPreprocessor::split_at_uses(const std::string& code)
+{
+    // ///use relpath            -> include from current_namespace
+    // ///use target::relpath    -> include from the given target namespace
+    static const std::regex use_regex(R"(^///use\s+(?:([a-zA-Z_][a-zA-Z0-9_]*)::)?([/a-zA-Z0-9 ._-]+?)\s*$)");
+
+    std::istringstream input(code);
+    std::vector<Chunk> chunks;
+    std::string line;
+
+    while (std::getline(input, line)) {
+        std::smatch match;
+        const size_t off = directive_offset(line);
+        if (off != std::string::npos && std::regex_match(line.cbegin() + static_cast<std::ptrdiff_t>(off), line.cend(), match, use_regex)) {
+            Chunk chunk;
+            chunk.is_use = true;
+            if (match[1].matched)
+                chunk.use_namespace = match[1].str();
+            chunk.use_relpath = match[2].str();
+            chunks.push_back(std::move(chunk));
+            continue;
+        }
+        if (chunks.empty() || chunks.back().is_use)
+            chunks.emplace_back();
+        chunks.back().text += line;
+        chunks.back().text += '\n';
+    }
+    return chunks;
+}
+
+std::shared_ptr<ShaderPreprocessor::SourceFile> ShaderPreprocessor::get_file_with_cache(const std::string& name)
 {
     if (m_cache_enabled) {
-        const auto found_it = m_shader_name_to_code.find(name);
-        if (found_it != m_shader_name_to_code.end()) {
+        const auto found_it = m_shader_name_to_file.find(name);
+        if (found_it != m_shader_name_to_file.end()) {
             return found_it->second;
         }
     }
 
     if (!m_file_reader) {
         report_error("No file reader set for ShaderPreprocessor");
-        return "";
+        return std::make_shared<SourceFile>();
     }
 
-    const auto file_contents = m_file_reader(name);
+    auto file = std::make_shared<SourceFile>();
+    file->code = m_file_reader(name);
+    file->hash = content_hash(file->code);
 
     if (m_cache_enabled) {
-        m_shader_name_to_code[name] = file_contents;
+        m_shader_name_to_file[name] = file;
     }
 
-    return file_contents;
+    return file;
+}
+
+std::string ShaderPreprocessor::bundle_key(const std::string& name) const
+{
+    std::string key = name;
+    for (const auto& [symbol, value] : m_global_defines) {
+        key += '\n';
+        key += symbol;
+        key += '=';
+        key += value;
+    }
+    return key;
+}
+
+bool ShaderPreprocessor::is_up_to_date(const BundledResult& result)
+{
+    // in inclusion order, so that files, which are not included anymore, are not read (an including file has changed before)
+    for (const auto& [name, hash] : result.sources) {
+        if (get_file_with_cache(name)->hash != hash)
+            return false;
+    }
+    return true;
 }
 
 std::string ShaderPreprocessor::process_defines(const std::string& code, std::map<std::string, std::string>& local_defines)
@@ -174,41 +357,29 @@ std::string ShaderPreprocessor::process_defines(const std::string& code, std::ma
     return output.str();
 }
 
-std::string ShaderPreprocessor::process_includes(const std::string& code,
-    std::unordered_set<std::string>& already_included,
-    std::map<std::string, std::string>& local_defines,
-    const std::string& current_namespace)
+void ShaderPreprocessor::process_includes(const std::vector<Chunk>& chunks, Inclusions& already_included, const std::string& current_namespace, std::string& output)
 {
-    // ///use relpath            -> include from current_namespace
-    // ///use target::relpath    -> include from the given target namespace
-    static const std::regex use_regex(R"(^///use\s+(?:([a-zA-Z_][a-zA-Z0-9_]*)::)?([/a-zA-Z0-9 ._-]+?)\s*$)");
-
-    std::istringstream input(code);
-    std::ostringstream output;
-    std::string line;
-
-    while (std::getline(input, line)) {
-        std::smatch match;
-        const size_t off = directive_offset(line);
-        if (off != std::string::npos && std::regex_match(line.cbegin() + static_cast<std::ptrdiff_t>(off), line.cend(), match, use_regex)) {
-            const std::string included_namespace = match[1].matched ? match[1].str() : current_namespace;
-            const std::string relpath = match[2].str();
-            // When no namespace is in play (e.g. inline shaders / tests) the name is just the relpath.
-            const std::string full_name = included_namespace.empty() ? relpath : included_namespace + "::" + relpath;
-
-            if (already_included.contains(full_name))
-                continue; // pragma-once: skip files already pulled in
-
-            // NOTE: mark as included BEFORE processing to prevent infinite recursion
-            already_included.insert(full_name);
-            const std::string included_file_contents = get_file_contents_with_cache(full_name);
-            output << process_includes(included_file_contents, already_included, local_defines, included_namespace) << '\n';
-        } else {
-            output << line << '\n';
+    for (const auto& chunk : chunks) {
+        if (!chunk.is_use) {
+            output += chunk.text;
+            continue;
         }
+        const std::string included_namespace = chunk.use_namespace.value_or(current_namespace);
+        // When no namespace is in play (e.g. inline shaders / tests) the name is just the relpath.
+        const std::string full_name = included_namespace.empty() ? chunk.use_relpath : included_namespace + "::" + chunk.use_relpath;
+
+        if (already_included.names.contains(full_name))
+            continue; // pragma-once: skip files already pulled in
+
+        // NOTE: mark as included BEFORE processing to prevent infinite recursion
+        already_included.names.insert(full_name);
+        already_included.in_order.push_back(full_name);
+        const auto included_file = get_file_with_cache(full_name);
+        if (!included_file->chunks)
+            included_file->chunks = split_at_uses(included_file->code);
+        process_includes(*included_file->chunks, already_included, included_namespace, output);
+        output += '\n';
     }
-
-    return output.str();
 }
 
 std::string ShaderPreprocessor::process_conditionals(const std::string& code, const std::map<std::string, std::string>& local_defines)
@@ -431,19 +602,46 @@ std::string ShaderPreprocessor::replace_macros(const std::string& code, const st
 
 std::string ShaderPreprocessor::preprocess_file(const std::string& name)
 {
-    const std::string code = get_file_contents_with_cache(name);
+    const std::string key = m_cache_enabled ? bundle_key(name) : std::string();
+    if (m_cache_enabled) {
+        const auto found_it = m_bundle.find(key);
+        if (found_it != m_bundle.end() && is_up_to_date(found_it->second))
+            return found_it->second.code;
+    }
+
+    const auto n_errors = m_n_errors;
+    const auto file = get_file_with_cache(name);
     // The root file's namespace (the part before "::") is inherited by its bare `///use` includes.
     const auto sep = name.find("::");
     const std::string current_namespace = (sep != std::string::npos) ? name.substr(0, sep) : std::string();
-    return preprocess_code(code, current_namespace);
+    Inclusions already_included;
+    std::string code = preprocess(file->code, current_namespace, already_included);
+
+    if (m_cache_enabled && m_n_errors == n_errors) {
+        BundledResult result;
+        result.sources.emplace_back(name, file->hash);
+        for (const auto& included : already_included.in_order)
+            result.sources.emplace_back(included, get_file_with_cache(included)->hash);
+        result.code = code;
+        m_bundle[key] = std::move(result);
+        ++m_bundle_revision;
+    }
+    return code;
 }
 
 std::string ShaderPreprocessor::preprocess_code(const std::string& code, const std::string& current_namespace)
+{
+    Inclusions already_included;
+    return preprocess(code, current_namespace, already_included);
+}
+
+std::string ShaderPreprocessor::preprocess(const std::string& code, const std::string& current_namespace, Inclusions& already_included)
 {
     std::map<std::string, std::string> local_defines;
     std::string code_with_defines = process_defines(code, local_defines);
-    std::unordered_set<std::string> already_included;
-    std::string code_with_includes = process_includes(code_with_defines, already_included, local_defines, current_namespace);
+    std::string code_with_includes;
+    code_with_includes.reserve(code_with_defines.size());
+    process_includes(split_at_uses(code_with_defines), already_included, current_namespace, code_with_includes);
     std::string code_with_conditionals = process_conditionals(code_with_includes, local_defines);
     std::string final_code = replace_macros(code_with_conditionals, local_defines);
     return final_code;
@@ -17,11 +17,15 @@
  *****************************************************************************/
 #pragma once
 
+#include <cstdint>
 #include <filesystem>
 #include <functional>
 #include <map>
+#include <memory>
+#include <optional>
 #include <string>
 #include <unordered_set>
+#include <vector>
 
 namespace webgpu::util {
 
@@ -37,7 +41,10 @@ namespace webgpu::util {
  * - Value-based conditionals with ///if / ///elif / ///else / ///endif (equality only)
  * - Macro definitions with ///define SYMBOL or ///define SYMBOL value
  * - Environment variable defines (global, persist across calls)
- * - File content caching
+ * - File content caching (files are split at their ///use directives only once)
+ * - Memoisation of preprocess_file results, keyed on the file name and the global defines. Results remember the content hashes
+ *   of all files they were made from and are only reused while those are unchanged. They can be exported as a bundle and
+ *   imported on the next start, which then skips preprocessing.
  */
 class ShaderPreprocessor {
 public:
@@ -84,15 +91,41 @@ public:
 
     /**
      * Clears the file cache. Useful for hot-reloading shaders during development.
+     * Memoised results stay, they are checked against the content hashes of the freshly read files.
      */
     void clear_cache();
 
     /**
-     * Enables or disables file caching. When disabled, files are read fresh each time.
+     * Enables or disables file caching and memoisation of results. When disabled, files are read and preprocessed fresh each time.
      * Caching is enabled by default.
      */
     void set_cache_enabled(bool enabled);
 
+    /**
+     * Serialises the memoised preprocess_file results, e.g., to write them to disk.
+     */
+    std::string export_bundle() const;
+
+    /**
+     * Adds the results of a previously exported bundle. Returns false and imports nothing if the bundle is invalid.
+     */
+    bool import_bundle(const std::string& bundle);
+
+    /**
+     * Number of memoised preprocess_file results, i.e., of permutations in the bundle.
+     */
+    size_t n_bundled_results() const;
+
+    /**
+     * Increases whenever results are added to the bundle, i.e., it needs to be exported again to keep them.
+     */
+    uint64_t bundle_revision() const;
+
+    /**
+     * Drops all memoised results.
+     */
+    void clear_bundle();
+
     /**
      * Sets the file reading callback. This allows the preprocessor to read files
      * without depending on specific file I/O implementations.
@@ -107,12 +140,34 @@ public:
     void set_error_callback(std::function<void(const std::string&)> callback);
 
 private:
-    std::string get_file_contents_with_cache(const std::string& name);
+    // a run of verbatim lines (each terminated with '\n') or a ///use directive
+    struct Chunk {
+        std::string text;
+        bool is_use = false;
+        std::optional<std::string> use_namespace; // empty: inherit the namespace of the including file
+        std::string use_relpath;
+    };
+    struct SourceFile {
+        std::string code;
+        uint64_t hash = 0;
+        std::optional<std::vector<Chunk>> chunks; // split when the file is included for the first time
+    };
+    struct Inclusions {
+        std::unordered_set<std::string> names;
+        std::vector<std::string> in_order;
+    };
+    struct BundledResult {
+        std::vector<std::pair<std::string, uint64_t>> sources; // name and content hash of the root file, followed by its includes in inclusion order
+        std::string code;
+    };
+
+    static std::vector<Chunk> split_at_uses(const std::string& code);
+    std::shared_ptr<SourceFile> get_file_with_cache(const std::string& name);
+    std::string bundle_key(const std::string& name) const;
+    bool is_up_to_date(const BundledResult& result);
+    std::string preprocess(const std::string& code, const std::string& current_namespace, Inclusions& already_included);
     std::string process_defines(const std::string& code, std::map<std::string, std::string>& local_defines);
-    std::string process_includes(const std::string& code,
-        std::unordered_set<std::string>& already_included,
-        std::map<std::string, std::string>& local_defines,
-        const std::string& current_namespace);
+    void process_includes(const std::vector<Chunk>& chunks, Inclusions& already_included, const std::string& current_namespace, std::string& output);
     std::string process_conditionals(const std::string& code, const std::map<std::string, std::string>& local_defines);
     std::string replace_macros(const std::string& code, const std::map<std::string, std::string>& local_defines);
     void initialize_platform_defines();
@@ -120,11 +175,14 @@ private:
     void report_error(const std::string& message);
 
 private:
-    std::map<std::string, std::string> m_shader_name_to_code; // Cache of file contents
+    std::map<std::string, std::shared_ptr<SourceFile>> m_shader_name_to_file; // Cache of file contents
+    std::map<std::string, BundledResult> m_bundle; // Memoised preprocess_file results by bundle_key
     std::map<std::string, std::string> m_global_defines; // Global preprocessor symbols and their values (persist across calls, "1" if no value specified)
     std::function<std::string(const std::string&)> m_file_reader; // Callback for reading files
     std::function<void(const std::string&)> m_error_callback; // Callback for error reporting
     bool m_cache_enabled = true;
+    unsigned m_n_errors = 0; // results with errors are not memoised
+    uint64_t m_bundle_revision = 0;
 };
 
 } // namespace webgpu::util
@@ -22,14 +22,16 @@
 
 #include <QDateTime>
 #include <QDebug>
+#include <algorithm>
 #include <memory>
 #include <tl/expected.hpp>
 
 namespace webgpu_compute::nodes {
 
-GraphRunFailureInfo::GraphRunFailureInfo(const std::string& node_name, NodeRunFailureInfo node_run_failure_info)
+GraphRunFailureInfo::GraphRunFailureInfo(const std::string& node_name, NodeRunFailureInfo node_run_failure_info, std::vector<std::string> skipped_node_names)
     : m_node_name(node_name)
     , m_node_run_failure_info(node_run_failure_info)
+    , m_skipped_node_names(std::move(skipped_node_names))
 {
 }
 
@@ -37,10 +39,13 @@ const std::string& GraphRunFailureInfo::node_name() const { return m_node_name;
 
 const NodeRunFailureInfo& GraphRunFailureInfo::node_run_failure_info() const { return m_node_run_failure_info; }
 
+const std::vector<std::string>& GraphRunFailureInfo::skipped_node_names() const { return m_skipped_node_names; }
+
 Node* NodeGraph::add_node(const std::string& name, std::unique_ptr<Node> node)
 {
     assert(!m_nodes.contains(name));
     node->set_node_name(name);
+    node->set_caching_enabled(m_caching_enabled);
     m_nodes.emplace(name, std::move(node));
     return m_nodes.at(name).get();
 }
@@ -51,6 +56,12 @@ void NodeGraph::remove_node(const std::string& name)
     assert(it != m_nodes.end());
     Node* node = it->second.get();
 
+    if (m_run_state) {
+        m_run_state->n_pending_inputs.erase(node);
+        m_run_state->unfinished.erase(node);
+    }
+    std::erase_if(m_pending_node_reruns, [node](const auto& pending) { return pending.first == node; });
+
     for (auto& socket : node->input_sockets())
         socket.disconnect();
 
@@ -145,40 +156,212 @@ void NodeGraph::connect_node_signals_and_slots()
     if (!order_result) {
         qFatal() << "NodeGraph::connect_node_signals_and_slots:" << QString::fromStdString(order_result.error());
     }
-    const std::vector<Node*>& topological_ordering = *order_result;
 
     for (auto& conn : m_topology_connections)
         QObject::disconnect(conn);
     m_topology_connections.clear();
 
-    m_topology_connections.push_back(connect(this, &NodeGraph::run_triggered, topological_ordering.front(), &Node::run));
-    for (uint32_t i = 0; i < topological_ordering.size() - 1; i++) {
-        m_topology_connections.push_back(connect(topological_ordering[i], &Node::run_completed, topological_ordering[i + 1], &Node::run));
+    for (auto& [_, node] : m_nodes) {
+        Node* n = node.get();
+        m_topology_connections.push_back(connect(n, &Node::run_completed, this, [this, n](webgpu_compute::GraphRunContext ctx) { on_node_completed(n, ctx); }));
+        m_topology_connections.push_back(connect(n, &Node::run_failed, this, &NodeGraph::emit_graph_failure));
     }
-    m_topology_connections.push_back(
-        connect(topological_ordering.back(), &Node::run_completed, this, [this](webgpu_compute::GraphRunContext ctx) { emit run_completed(ctx); }));
+}
 
-    for (auto& [_, node] : m_nodes) {
-        m_topology_connections.push_back(connect(node.get(), &Node::run_failed, this, &NodeGraph::emit_graph_failure));
+bool NodeGraph::is_running() const { return m_run_state.has_value(); }
+
+void NodeGraph::set_caching_enabled(bool enabled)
+{
+    m_caching_enabled = enabled;
+    for (auto& [_, node] : m_nodes)
+        node->set_caching_enabled(enabled);
+}
+
+bool NodeGraph::is_caching_enabled() const { return m_caching_enabled; }
+
+void NodeGraph::invalidate_cached_results()
+{
+    for (auto& [_, node] : m_nodes)
+        node->invalidate_cached_result();
+}
+
+std::vector<std::string> NodeGraph::get_reused_node_names() const
+{
+    std::vector<std::string> names;
+    for (const auto& [name, node] : m_nodes) {
+        if (node->was_last_run_reused())
+            names.push_back(name);
     }
+    std::sort(names.begin(), names.end());
+    return names;
 }
 
 void NodeGraph::run()
 {
     qDebug() << "running node graph ...";
 
+    if (m_run_state) {
+        qDebug() << "node graph is running already, the run is deferred";
+        m_run_requested = true;
+        return;
+    }
+
     ++m_run_id;
 
     std::string run_datetime = QDateTime::currentDateTime().toString("yyyy-MM-ddTHH-mm-ss").toStdString();
+    const webgpu_compute::GraphRunContext context { m_run_id, run_datetime };
 
-    emit run_triggered(webgpu_compute::GraphRunContext { m_run_id, run_datetime });
+    emit run_triggered(context);
+
+    std::unordered_set<Node*> nodes;
+    for (auto& [_, node] : m_nodes)
+        nodes.insert(node.get());
+    start_run(context, nodes);
 }
 
 void NodeGraph::emit_graph_failure(NodeRunFailureInfo info)
 {
     auto it = std::find_if(m_nodes.begin(), m_nodes.end(), [&info](const auto& key_value_pair) { return key_value_pair.second.get() == &info.node(); });
     assert(it != m_nodes.end());
-    emit run_failed(GraphRunFailureInfo(it->first, info));
+    Node* node = it->second.get();
+
+    // everything downstream is skipped, independent branches continue
+    std::vector<std::string> skipped;
+    if (m_run_state && m_run_state->unfinished.contains(node)) {
+        m_run_state->failed = true;
+        m_run_state->unfinished.erase(node);
+        for (Node* downstream : downstream_closure(node)) {
+            if (m_run_state->n_pending_inputs.erase(downstream)) {
+                m_run_state->unfinished.erase(downstream);
+                skipped.push_back(downstream->get_node_name());
+            }
+        }
+        std::sort(skipped.begin(), skipped.end());
+    }
+    emit run_failed(GraphRunFailureInfo(it->first, info, std::move(skipped)));
+    check_run_finished();
+}
+
+void NodeGraph::on_node_completed(Node* node, const webgpu_compute::GraphRunContext& context)
+{
+    if (!m_run_state) {
+        // the node was rerun on its own (e.g., after its settings were changed in the ui), update everything downstream
+        start_run(context, downstream_closure(node), node);
+        return;
+    }
+    if (!m_run_state->unfinished.contains(node)) {
+        // rerun on its own while the graph was running, its downstream nodes are updated once the current run finished
+        qDebug() << node->get_node_name() << "completed outside of the current run, its downstream nodes are updated afterwards";
+        const auto it = std::find_if(m_pending_node_reruns.begin(), m_pending_node_reruns.end(), [node](const auto& pending) { return pending.first == node; });
+        if (it != m_pending_node_reruns.end())
+            it->second = context;
+        else
+            m_pending_node_reruns.emplace_back(node, context);
+        return;
+    }
+    std::vector<Node*> ready;
+    finish_node(node, &ready);
+    start_nodes(ready);
+    check_run_finished();
+}
+
+void NodeGraph::start_run(const webgpu_compute::GraphRunContext& context, const std::unordered_set<Node*>& nodes, Node* completed_node)
+{
+    assert(!m_run_state);
+    m_run_state = RunState { context, {}, nodes, unsigned(nodes.size()), false };
+    for (Node* node : nodes) {
+        unsigned n_pending = 0;
+        for (auto& socket : node->input_sockets()) {
+            if (socket.is_socket_connected() && nodes.contains(&socket.connected_socket().node()))
+                ++n_pending;
+        }
+        m_run_state->n_pending_inputs[node] = n_pending;
+    }
+
+    std::vector<Node*> ready;
+    if (completed_node) {
+        m_run_state->n_pending_inputs.erase(completed_node);
+        finish_node(completed_node, &ready);
+    } else {
+        for (const auto& [node, n_pending] : m_run_state->n_pending_inputs) {
+            if (n_pending == 0)
+                ready.push_back(node);
+        }
+        // deterministic start order
+        std::sort(ready.begin(), ready.end(), [](const Node* a, const Node* b) { return a->get_node_name() < b->get_node_name(); });
+    }
+    start_nodes(ready);
+    check_run_finished();
+}
+
+void NodeGraph::start_nodes(const std::vector<Node*>& nodes)
+{
+    // nodes may complete synchronously and start their downstream nodes from within run(). the run can't finish
+    // in between though, because the nodes in this list are unfinished.
+    for (Node* node : nodes) {
+        assert(m_run_state);
+        m_run_state->n_pending_inputs.erase(node);
+        node->run(m_run_state->context);
+    }
+}
+
+void NodeGraph::finish_node(Node* node, std::vector<Node*>* ready_nodes)
+{
+    auto& state = *m_run_state;
+    state.unfinished.erase(node);
+    for (auto& output_socket : node->output_sockets()) {
+        for (auto* connected_socket : output_socket.connected_sockets()) {
+            const auto it = state.n_pending_inputs.find(&connected_socket->node());
+            if (it == state.n_pending_inputs.end())
+                continue;
+            assert(it->second > 0);
+            if (--it->second == 0)
+                ready_nodes->push_back(it->first);
+        }
+    }
+    emit node_completed(node->get_node_name(), state.n_nodes - unsigned(state.unfinished.size()), state.n_nodes);
+}
+
+void NodeGraph::check_run_finished()
+{
+    if (!m_run_state || !m_run_state->unfinished.empty())
+        return;
+    const auto state = std::move(m_run_state.value());
+    m_run_state.reset();
+    if (!state.failed) {
+        if (const auto reused = get_reused_node_names(); !reused.empty())
+            qDebug() << "reused the results of" << reused.size() << "nodes (run" << state.context.run_id << ")";
+        emit run_completed(state.context);
+    }
+    if (m_run_requested) {
+        // a full run also updates everything downstream of rerun nodes
+        m_run_requested = false;
+        m_pending_node_reruns.clear();
+        run();
+        return;
+    }
+    if (!m_pending_node_reruns.empty()) {
+        const auto [node, context] = m_pending_node_reruns.front();
+        m_pending_node_reruns.erase(m_pending_node_reruns.begin());
+        start_run(context, downstream_closure(node), node);
+    }
+}
+
+std::unordered_set<Node*> NodeGraph::downstream_closure(Node* node) const
+{
+    std::unordered_set<Node*> closure = { node };
+    std::vector<Node*> stack = { node };
+    while (!stack.empty()) {
+        Node* current = stack.back();
+        stack.pop_back();
+        for (auto& output_socket : current->output_sockets()) {
+            for (auto* connected_socket : output_socket.connected_sockets()) {
+                if (closure.insert(&connected_socket->node()).second)
+                    stack.push_back(&connected_socket->node());
+            }
+        }
+    }
+    return closure;
 }
 
 } // namespace webgpu_compute::nodes
@@ -22,8 +22,10 @@
 #include "GraphRunContext.h"
 #include "nodes/Node.h"
 #include <memory>
+#include <optional>
 #include <string>
 #include <tl/expected.hpp>
+#include <unordered_set>
 #include <webgpu/base/Context.h>
 
 namespace webgpu_compute::nodes {
@@ -33,14 +35,17 @@ public:
     GraphRunFailureInfo() = delete;
     GraphRunFailureInfo(const GraphRunFailureInfo&) = default;
 
-    GraphRunFailureInfo(const std::string& node_name, NodeRunFailureInfo node_run_failure_info);
+    GraphRunFailureInfo(const std::string& node_name, NodeRunFailureInfo node_run_failure_info, std::vector<std::string> skipped_node_names = {});
 
     [[nodiscard]] const std::string& node_name() const;
     [[nodiscard]] const NodeRunFailureInfo& node_run_failure_info() const;
+    /// Nodes downstream of the failed one, they are not run. Independent branches continue.
+    [[nodiscard]] const std::vector<std::string>& skipped_node_names() const;
 
 private:
     std::string m_node_name;
     NodeRunFailureInfo m_node_run_failure_info;
+    std::vector<std::string> m_skipped_node_names;
 };
 
 // TODO define interface - or maybe for now, just use hardcoded graph for complete normals setup
@@ -72,25 +77,65 @@ public:
         return static_cast<const NodeType&>(get_node(node_name));
     }
 
-    // finds topological order of nodes and connects run_finished and run slots accordingly
+    // finds topological order of nodes and connects the run_completed and run_failed signals of all nodes to the graph
     // safe to call multiple times
     [[nodiscard]] tl::expected<std::vector<Node*>, std::string> compute_topological_order();
     void connect_node_signals_and_slots();
 
+    /// True from run() until all nodes have completed, failed or were skipped.
+    [[nodiscard]] bool is_running() const;
+
+    /// Nodes reuse their previous result if their settings and inputs didn't change (see Node). Enabled by default.
+    void set_caching_enabled(bool enabled);
+    [[nodiscard]] bool is_caching_enabled() const;
+    /// Forces all nodes to execute on the next run.
+    void invalidate_cached_results();
+    /// Names of the nodes that reused their previous result in the last run, sorted.
+    [[nodiscard]] std::vector<std::string> get_reused_node_names() const;
+
 public slots:
+    /// Runs the graph as a dependency dag: a node starts as soon as all nodes connected to its inputs have completed,
+    /// so independent branches run concurrently (their gpu submissions interleave, cpu work of nodes goes to a thread
+    /// pool, see Node::run_on_thread_pool). A run() while running is deferred until the current run finished.
     void run();
     void emit_graph_failure(NodeRunFailureInfo info);
 
 signals:
     void run_triggered(webgpu_compute::GraphRunContext context);
     void run_completed(webgpu_compute::GraphRunContext context);
+    /// Emitted for every failed node, as soon as it failed. Other branches keep running, run_completed is not emitted.
     void run_failed(GraphRunFailureInfo info);
+    /// Progress, emitted whenever a node completed (or reused its result).
+    void node_completed(const std::string& node_name, unsigned n_finished_nodes, unsigned n_nodes);
 
 private:
+    void on_node_completed(Node* node, const webgpu_compute::GraphRunContext& context);
+    // runs the given nodes in dependency order. completed_node is treated as completed already (used for propagating a Node::rerun())
+    void start_run(const webgpu_compute::GraphRunContext& context, const std::unordered_set<Node*>& nodes, Node* completed_node = nullptr);
+    void start_nodes(const std::vector<Node*>& nodes);
+    void finish_node(Node* node, std::vector<Node*>* ready_nodes);
+    void check_run_finished();
+    // the node and everything connected to its outputs, transitively
+    [[nodiscard]] std::unordered_set<Node*> downstream_closure(Node* node) const;
+
+    // state of the current run
+    struct RunState {
+        webgpu_compute::GraphRunContext context;
+        std::unordered_map<Node*, unsigned> n_pending_inputs; // only nodes that didn't start yet
+        std::unordered_set<Node*> unfinished;
+        unsigned n_nodes = 0;
+        bool failed = false;
+    };
+
     std::unordered_map<std::string, std::unique_ptr<Node>> m_nodes;
     std::vector<QMetaObject::Connection> m_topology_connections;
+    std::optional<RunState> m_run_state;
+    bool m_run_requested = false;
+    // nodes that were rerun on their own while another run was active. their downstream nodes are updated after that run.
+    std::vector<std::pair<Node*, webgpu_compute::GraphRunContext>> m_pending_node_reruns;
 
     uint64_t m_run_id = 0;
+    bool m_caching_enabled = true;
 };
 
 } // namespace webgpu_compute::nodes
@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * weBIGeo
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "TiledGraphRunner.h"
+
+#include "nodes/SelectTilesNode.h"
+#include <QDebug>
+#include <nucleus/srs.h>
+#include <cstring>
+#include <filesystem>
+
+namespace webgpu_compute {
+
+TiledGraphRunner::TiledGraphRunner(webgpu::Context& ctx, nodes::NodeGraph& graph, Settings settings)
+    : m_ctx(&ctx)
+    , m_graph(&graph)
+    , m_settings(std::move(settings))
+{
+}
+
+TiledGraphRunner::~TiledGraphRunner() { cancel(); }
+
+tl::expected<void, std::string> TiledGraphRunner::start(const RectangularTileRegion& region)
+{
+    if (m_running)
+        return tl::unexpected("a tiled run is in progress already");
+    if (!m_graph->exists_node(m_settings.select_tiles_node) || !dynamic_cast<nodes::SelectTilesNode*>(&m_graph->get_node(m_settings.select_tiles_node)))
+        return tl::unexpected("graph has no SelectTilesNode named " + m_settings.select_tiles_node);
+    if (!m_graph->exists_node(m_settings.result_node) || !m_graph->get_node(m_settings.result_node).has_output_socket(m_settings.result_socket))
+        return tl::unexpected("graph has no output socket " + m_settings.result_node + "." + m_settings.result_socket);
+    if (m_graph->get_node(m_settings.result_node).output_socket(m_settings.result_socket).type() != nodes::data_type<const webgpu::raii::TextureWithSampler*>())
+        return tl::unexpected("result socket " + m_settings.result_node + "." + m_settings.result_socket + " is not a texture");
+
+    auto tiling = split_into_work_tiles(region, m_settings.tiling);
+    if (!tiling)
+        return tl::unexpected(tiling.error());
+    m_tiling = std::move(tiling.value());
+
+    if (const auto dir = std::filesystem::path(m_settings.output_file).parent_path(); !dir.empty())
+        std::filesystem::create_directories(dir);
+    auto bounds = nucleus::srs::tile_bounds({ region.zoom_level, region.min, region.scheme });
+    bounds.expand_by(nucleus::srs::tile_bounds({ region.zoom_level, region.max, region.scheme }));
+    m_output = std::make_unique<nucleus::utils::geotiff::StreamingWriter>(
+        QString::fromStdString(m_settings.output_file), nucleus::utils::geotiff::Format { m_tiling.output_size, 4, 1 }, bounds, 256, m_settings.compression_level);
+    if (m_output->has_failed()) {
+        const auto result = m_output->finish();
+        m_output.reset();
+        return tl::unexpected(result.error());
+    }
+
+    m_merger = std::make_unique<WorkTileMerger<glm::u8vec4>>(m_tiling, [this](unsigned, std::span<const glm::u8vec4> pixels) {
+        m_output->write_rows({ reinterpret_cast<const uint8_t*>(pixels.data()), pixels.size_bytes() });
+    });
+
+    m_connections.push_back(connect(m_graph, &nodes::NodeGraph::run_completed, this, &TiledGraphRunner::on_graph_run_completed));
+    m_connections.push_back(connect(m_graph, &nodes::NodeGraph::run_failed, this, [this](const nodes::GraphRunFailureInfo& info) {
+        if (m_running)
+            finish("work tile " + std::to_string(m_current_work_tile) + " failed in node " + info.node_name() + ": " + info.node_run_failure_info().message());
+    }));
+
+    qDebug() << "[TiledGraphRunner] " << m_tiling.tiles.size() << " work tiles for an output of " << m_tiling.output_size.x << "x" << m_tiling.output_size.y
+             << " pixels";
+    m_running = true;
+    m_current_work_tile = 0;
+    run_next_work_tile();
+    return {};
+}
+
+void TiledGraphRunner::cancel()
+{
+    if (m_running)
+        finish("cancelled");
+}
+
+bool TiledGraphRunner::is_running() const { return m_running; }
+
+const WorkTiling& TiledGraphRunner::tiling() const { return m_tiling; }
+
+void TiledGraphRunner::run_next_work_tile()
+{
+    const auto& work_tile = m_tiling.tiles[m_current_work_tile];
+    m_graph->get_node_as<nodes::SelectTilesNode>(m_settings.select_tiles_node).set_tile_region_override(work_tile.padded);
+    m_graph->run();
+}
+
+void TiledGraphRunner::on_graph_run_completed()
+{
+    if (!m_running)
+        return;
+    const auto& texture = *std::get<nodes::data_type<const webgpu::raii::TextureWithSampler*>()>(
+        m_graph->get_node(m_settings.result_node).output_socket(m_settings.result_socket).get_data());
+    const auto size = glm::uvec2(texture.texture().width(), texture.texture().height());
+    const auto& work_tile = m_tiling.tiles[m_current_work_tile];
+    const auto expected_size = (work_tile.padded.max - work_tile.padded.min + 1u) * m_settings.tiling.tile_size;
+    if (size != expected_size) {
+        finish("result of work tile " + std::to_string(m_current_work_tile) + " has " + std::to_string(size.x) + "x" + std::to_string(size.y) + " pixels, expected "
+            + std::to_string(expected_size.x) + "x" + std::to_string(expected_size.y));
+        return;
+    }
+    texture.texture().read_back_async(m_ctx->device(), 0, [this]([[maybe_unused]] size_t, std::shared_ptr<QByteArray> data) { on_result_read_back(data); });
+}
+
+void TiledGraphRunner::on_result_read_back(std::shared_ptr<QByteArray> data)
+{
+    if (!m_running)
+        return;
+    const auto& work_tile = m_tiling.tiles[m_current_work_tile];
+    nucleus::Raster<glm::u8vec4> result((work_tile.padded.max - work_tile.padded.min + 1u) * m_settings.tiling.tile_size);
+    if (size_t(data->size()) != result.size_in_bytes()) {
+        finish("result of work tile " + std::to_string(m_current_work_tile) + " is not rgba8");
+        return;
+    }
+    std::memcpy(result.bytes(), data->constData(), result.size_in_bytes());
+    m_merger->add(work_tile, result);
+
+    ++m_current_work_tile;
+    emit work_tile_completed(m_current_work_tile, unsigned(m_tiling.tiles.size()));
+    if (m_current_work_tile < m_tiling.tiles.size()) {
+        run_next_work_tile();
+        return;
+    }
+    assert(m_merger->is_finished());
+    finish({});
+}
+
+void TiledGraphRunner::finish(const std::string& error)
+{
+    for (const auto& connection : m_connections)
+        disconnect(connection);
+    m_connections.clear();
+    m_running = false;
+    m_merger.reset();
+    auto result = m_output->finish();
+    m_output.reset();
+    if (m_graph->exists_node(m_settings.select_tiles_node))
+        m_graph->get_node_as<nodes::SelectTilesNode>(m_settings.select_tiles_node).set_tile_region_override({});
+
+    const auto message = error.empty() && !result ? result.error() : error;
+    if (!message.empty()) {
+        std::error_code ec;
+        std::filesystem::remove(m_settings.output_file, ec);
+        qWarning() << "[TiledGraphRunner] " << QString::fromStdString(message);
+        emit failed(message);
+        return;
+    }
+    qDebug() << "[TiledGraphRunner] written to" << QString::fromStdString(m_settings.output_file);
+    emit completed();
+}
+
+} // namespace webgpu_compute
@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * weBIGeo
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include "NodeGraph.h"
+#include "WorkTiling.h"
+#include <memory>
+#include <nucleus/utils/geotiff_writer.h>
+
+namespace webgpu_compute {
+
+// Runs a graph on a region that is too large for a single run. The region is split into work tiles (see WorkTiling.h), which are
+// selected one after the other through the tile region override of a SelectTilesNode. After each graph run, an rgba8 texture output
+// is read back and its core merged into the output file, which is written row by row as a georeferenced GeoTIFF. Only one work
+// tile and one band of the output are held in memory.
+//
+// The halo must cover the reach of all nodes between the tile selection and the result, e.g., the maximum trajectory length.
+class TiledGraphRunner : public QObject {
+    Q_OBJECT
+
+public:
+    struct Settings {
+        std::string select_tiles_node = "select_tiles";
+        std::string result_node;
+        std::string result_socket = "texture"; // must provide a const webgpu::raii::TextureWithSampler* in rgba8
+        WorkTilingSettings tiling;
+        std::string output_file; // GeoTIFF
+        int compression_level = 6;
+    };
+
+    TiledGraphRunner(webgpu::Context& ctx, nodes::NodeGraph& graph, Settings settings);
+    ~TiledGraphRunner() override;
+
+    // starts the first work tile. fails if the settings don't match the graph or the region can't be tiled.
+    [[nodiscard]] tl::expected<void, std::string> start(const RectangularTileRegion& region);
+    void cancel();
+
+    [[nodiscard]] bool is_running() const;
+    [[nodiscard]] const WorkTiling& tiling() const;
+
+signals:
+    void work_tile_completed(unsigned n_finished_work_tiles, unsigned n_work_tiles);
+    void completed();
+    void failed(const std::string& message);
+
+private:
+    void run_next_work_tile();
+    void on_graph_run_completed();
+    void on_result_read_back(std::shared_ptr<QByteArray> data);
+    void finish(const std::string& error);
+
+    webgpu::Context* m_ctx;
+    nodes::NodeGraph* m_graph;
+    Settings m_settings;
+    WorkTiling m_tiling;
+    std::unique_ptr<WorkTileMerger<glm::u8vec4>> m_merger;
+    std::unique_ptr<nucleus::utils::geotiff::StreamingWriter> m_output;
+    std::vector<QMetaObject::Connection> m_connections;
+    unsigned m_current_work_tile = 0;
+    bool m_running = false;
+};
+
+} // namespace webgpu_compute
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * weBIGeo
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "WorkTiling.h"
+
+#include <cmath>
+#include <nucleus/srs.h>
+
+namespace webgpu_compute {
+
+tl::expected<WorkTiling, std::string> split_into_work_tiles(const RectangularTileRegion& region, const WorkTilingSettings& settings)
+{
+    if (region.min.x > region.max.x || region.min.y > region.max.y)
+        return tl::unexpected("empty region");
+    if (region.zoom_level >= 32 || region.max.x >= (1u << region.zoom_level) || region.max.y >= (1u << region.zoom_level))
+        return tl::unexpected("region is outside of zoom level " + std::to_string(region.zoom_level));
+    if (settings.tile_size.x == 0 || settings.tile_size.y == 0)
+        return tl::unexpected("tile size must not be 0");
+
+    const auto ts = settings.tile_size;
+    const auto last_tile = (1u << region.zoom_level) - 1;
+    const glm::uvec2 halo_tiles = (glm::uvec2(settings.halo) + ts - 1u) / ts;
+    const glm::uvec2 max_tiles = glm::uvec2(settings.max_image_size) / ts;
+    if (max_tiles.x <= 2 * halo_tiles.x || max_tiles.y <= 2 * halo_tiles.y)
+        return tl::unexpected("halo of " + std::to_string(settings.halo) + " pixels doesn't leave room for a core within " + std::to_string(settings.max_image_size)
+            + " pixels");
+    const glm::uvec2 core_tiles = max_tiles - 2u * halo_tiles;
+
+    WorkTiling tiling;
+    tiling.region = region;
+    tiling.output_size = (region.max - region.min + 1u) * ts;
+    // TMS: y grows northwards, bands start at region.max.y
+    for (unsigned top = region.max.y;; top -= core_tiles.y) {
+        const auto bottom = top - std::min(top - region.min.y, core_tiles.y - 1);
+        for (unsigned left = region.min.x; left <= region.max.x; left += core_tiles.x) {
+            const auto right = std::min(region.max.x, left + core_tiles.x - 1);
+            WorkTile tile;
+            tile.core = { { left, bottom }, { right, top }, region.zoom_level, region.scheme };
+            tile.padded = { { left - std::min(left, halo_tiles.x), bottom - std::min(bottom, halo_tiles.y) },
+                { std::min(last_tile, right + halo_tiles.x), std::min(last_tile, top + halo_tiles.y) }, region.zoom_level, region.scheme };
+            tile.core_offset = glm::uvec2(left - tile.padded.min.x, tile.padded.max.y - top) * ts;
+            tile.output_offset = glm::uvec2(left - region.min.x, region.max.y - top) * ts;
+            tile.core_size = glm::uvec2(right - left + 1, top - bottom + 1) * ts;
+            tile.band = tiling.n_bands;
+            tiling.tiles.push_back(tile);
+        }
+        ++tiling.n_bands;
+        if (bottom == region.min.y)
+            break;
+    }
+    return tiling;
+}
+
+unsigned halo_for_distance(double distance, unsigned zoom_level, unsigned tile_size)
+{
+    if (distance <= 0)
+        return 0;
+    const auto pixel_size = nucleus::srs::tile_width(int(zoom_level)) / tile_size;
+    return unsigned(std::ceil(distance / pixel_size));
+}
+
+} // namespace webgpu_compute
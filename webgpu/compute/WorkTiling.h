@@ -0,0 +1,127 @@
+/*****************************************************************************
+ * weBIGeo
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include "RectangularTileRegion.h"
+#include <functional>
+#include <map>
+#include <nucleus/Raster.h>
+#include <span>
+#include <string>
+#include <tl/expected.hpp>
+#include <vector>
+
+// Splitting of regions that are too large for a single graph run (see MAX_STITCHED_IMAGE_SIZE of TileStitchNode) into work tiles.
+// A work tile is a rectangle of tiles (the core) plus a halo of neighbouring tiles. The graph runs on the core and halo, but only the
+// core of the result is kept. If the halo covers the reach of the computation (kernel radius, trajectory length), the core is the same
+// as if the whole region had been computed at once.
+//
+// Pixel coordinates are those of the stitched images, i.e., row 0 is north (TileStitchNode with stitch_inverted_y).
+namespace webgpu_compute {
+
+struct WorkTilingSettings {
+    glm::uvec2 tile_size = glm::uvec2(64); // pixels per tile in the stitched image, i.e., without the border
+    unsigned max_image_size = 8192; // per side, including the halo. MAX_STITCHED_IMAGE_SIZE
+    unsigned halo = 0; // in pixels, rounded up to whole tiles
+};
+
+struct WorkTile {
+    RectangularTileRegion core;
+    RectangularTileRegion padded; // core plus halo, clamped to the tiles of the zoom level. the graph runs on these tiles
+    glm::uvec2 core_offset = {}; // pixel position of the core within the stitched image of the padded region
+    glm::uvec2 output_offset = {}; // pixel position of the core within the output
+    glm::uvec2 core_size = {}; // in pixels
+    unsigned band = 0; // index of the row of work tiles, bands are ordered north to south
+};
+
+struct WorkTiling {
+    RectangularTileRegion region;
+    glm::uvec2 output_size = {}; // in pixels
+    unsigned n_bands = 0;
+    std::vector<WorkTile> tiles; // band by band, west to east within a band
+};
+
+[[nodiscard]] tl::expected<WorkTiling, std::string> split_into_work_tiles(const RectangularTileRegion& region, const WorkTilingSettings& settings);
+
+// halo in pixels that covers the given distance in world space (srs units) at the zoom level
+[[nodiscard]] unsigned halo_for_distance(double distance, unsigned zoom_level, unsigned tile_size);
+
+// Assembles the cores of work tile results into the output and streams it row by row, north to south. Only the bands that
+// have results but are not complete yet (or wait for a band further north) are kept in memory, i.e., memory is bounded by the
+// output width times the band height if results arrive in the order of WorkTiling::tiles.
+template <typename T>
+class WorkTileMerger {
+public:
+    using RowSink = std::function<void(unsigned row, std::span<const T> pixels)>;
+
+    WorkTileMerger(const WorkTiling& tiling, RowSink sink)
+        : m_tiling(tiling)
+        , m_sink(std::move(sink))
+        , m_n_missing(tiling.n_bands, 0)
+    {
+        for (const auto& tile : m_tiling.tiles)
+            ++m_n_missing[tile.band];
+    }
+
+    // result: the image computed for tile.padded. every tile must be added once.
+    void add(const WorkTile& tile, const nucleus::Raster<T>& result)
+    {
+        assert(tile.band < m_tiling.n_bands);
+        assert(m_n_missing[tile.band] > 0);
+        assert(tile.core_offset.x + tile.core_size.x <= result.width());
+        assert(tile.core_offset.y + tile.core_size.y <= result.height());
+        auto& band = m_bands[tile.band];
+        if (band.buffer_length() == 0) {
+            band = nucleus::Raster<T>(glm::uvec2(m_tiling.output_size.x, tile.core_size.y));
+            m_band_offsets[tile.band] = tile.output_offset.y;
+        }
+        for (unsigned row = 0; row < tile.core_size.y; ++row) {
+            const auto* src = &result.pixel({ tile.core_offset.x, tile.core_offset.y + row });
+            std::copy(src, src + tile.core_size.x, &band.pixel({ tile.output_offset.x, row }));
+        }
+        --m_n_missing[tile.band];
+        flush();
+    }
+
+    [[nodiscard]] bool is_finished() const { return m_n_flushed_bands == m_tiling.n_bands; }
+    [[nodiscard]] unsigned n_buffered_bands() const { return unsigned(m_bands.size()); }
+
+private:
+    void flush()
+    {
+        while (m_n_flushed_bands < m_tiling.n_bands && m_n_missing[m_n_flushed_bands] == 0) {
+            const auto& band = m_bands[m_n_flushed_bands];
+            const auto offset = m_band_offsets[m_n_flushed_bands];
+            for (unsigned row = 0; row < band.height(); ++row)
+                m_sink(offset + row, std::span<const T>(&band.pixel({ 0, row }), band.width()));
+            m_bands.erase(m_n_flushed_bands);
+            m_band_offsets.erase(m_n_flushed_bands);
+            ++m_n_flushed_bands;
+        }
+    }
+
+    WorkTiling m_tiling;
+    RowSink m_sink;
+    std::vector<unsigned> m_n_missing; // per band
+    std::map<unsigned, nucleus::Raster<T>> m_bands;
+    std::map<unsigned, unsigned> m_band_offsets;
+    unsigned m_n_flushed_bands = 0;
+};
+
+} // namespace webgpu_compute
@@ -0,0 +1,406 @@
+/*****************************************************************************
+ * weBIGeo
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#include "avalanche_trajectories_cpu.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <glm/gtc/constants.hpp>
+#include <limits>
+#include <thread>
+
+namespace webgpu_compute::avalanche_trajectories_cpu {
+
+using TrajectoriesNode = nodes::ComputeAvalancheTrajectoriesNode;
+
+namespace {
+    // constants of avalanche_trajectories_compute.wgsl
+    constexpr float TEXTURE_GATHER_OFFSET = 1.0f / 512.0f;
+    constexpr float g = 9.81f;
+    constexpr float density = 200.0f;
+    constexpr float slab_thickness = 1.0f;
+    constexpr float cfl = 0.5f;
+    constexpr float mass_per_area = density * slab_thickness;
+    const glm::vec3 acceleration_gravity = { 0.0f, 0.0f, -g };
+    constexpr float velocity_threshold = 0.01f;
+    constexpr float pi = glm::pi<float>();
+
+    // wgsl float to u32 conversions saturate, in c++ they are undefined outside the range
+    uint32_t to_u32(float v)
+    {
+        if (!(v > 0.0f))
+            return 0;
+        if (v >= 4294967040.0f) // largest float below 2^32
+            return std::numeric_limits<uint32_t>::max();
+        return uint32_t(v);
+    }
+
+    // the layers are written concurrently, max and add are commutative, so the result doesn't depend on the order
+    struct AtomicLayer {
+        std::vector<std::atomic<uint32_t>> data;
+
+        explicit AtomicLayer(size_t size, bool enabled)
+            : data(enabled ? size : 0)
+        {
+        }
+        [[nodiscard]] bool enabled() const { return !data.empty(); }
+        void max(size_t index, uint32_t value)
+        {
+            auto& cell = data[index];
+            auto current = cell.load(std::memory_order_relaxed);
+            while (current < value && !cell.compare_exchange_weak(current, value, std::memory_order_relaxed)) { }
+        }
+        void add(size_t index, uint32_t value) { data[index].fetch_add(value, std::memory_order_relaxed); }
+        [[nodiscard]] nucleus::Raster<uint32_t> to_raster(const glm::uvec2& resolution) const
+        {
+            if (!enabled())
+                return {};
+            nucleus::Raster<uint32_t> raster(resolution);
+            std::transform(data.begin(), data.end(), raster.buffer().begin(), [](const std::atomic<uint32_t>& v) { return v.load(std::memory_order_relaxed); });
+            return raster;
+        }
+    };
+
+    struct Output {
+        glm::uvec2 resolution;
+        AtomicLayer zdelta;
+        AtomicLayer cell_counts;
+        AtomicLayer travel_length;
+        AtomicLayer travel_angle;
+        AtomicLayer altitude_difference;
+
+        Output(const glm::uvec2& resolution, const TrajectoriesNode::OutputLayerParams& layers)
+            : resolution(resolution)
+            , zdelta(size_t(resolution.x) * resolution.y, layers.layer1_zdelta_enabled != 0)
+            , cell_counts(size_t(resolution.x) * resolution.y, layers.layer2_cellCounts_enabled != 0)
+            , travel_length(size_t(resolution.x) * resolution.y, layers.layer3_travelLength_enabled != 0)
+            , travel_angle(size_t(resolution.x) * resolution.y, layers.layer4_travelAngle_enabled != 0)
+            , altitude_difference(size_t(resolution.x) * resolution.y, layers.layer5_altitudeDifference_enabled != 0)
+        {
+        }
+
+        // bresenham, as draw_line_pos in the shader. pixels outside of the raster are dropped (like out of bounds writes on the gpu).
+        void draw_line(const glm::vec2& start_uv, const glm::vec2& end_uv, float z_delta, float travel_length_value, float travel_angle_value, float altitude_difference_value)
+        {
+            const auto start = glm::ivec2(glm::floor(start_uv * glm::vec2(resolution)));
+            const auto end = glm::ivec2(glm::floor(end_uv * glm::vec2(resolution)));
+            const int dx = std::abs(end.x - start.x);
+            const int sx = start.x < end.x ? 1 : -1;
+            const int dy = -std::abs(end.y - start.y);
+            const int sy = start.y < end.y ? 1 : -1;
+            int error = dx + dy;
+            int x = start.x;
+            int y = start.y;
+
+            const auto zdelta_value = to_u32(z_delta);
+            const auto length_value = to_u32(travel_length_value);
+            const auto angle_value = to_u32(glm::degrees(travel_angle_value));
+            const auto altitude_value = to_u32(altitude_difference_value);
+            while (true) {
+                if (x >= 0 && y >= 0 && unsigned(x) < resolution.x && unsigned(y) < resolution.y) {
+                    const auto index = size_t(y) * resolution.x + unsigned(x);
+                    if (zdelta.enabled())
+                        zdelta.max(index, zdelta_value);
+                    if (cell_counts.enabled())
+                        cell_counts.add(index, 1);
+                    if (travel_length.enabled())
+                        travel_length.max(index, length_value);
+                    if (travel_angle.enabled())
+                        travel_angle.max(index, angle_value);
+                    if (altitude_difference.enabled())
+                        altitude_difference.max(index, altitude_value);
+                }
+                if (x == end.x && y == end.y)
+                    break;
+                const int e2 = 2 * error;
+                if (e2 >= dy) {
+                    error += dy;
+                    x += sx;
+                }
+                if (e2 <= dx) {
+                    error += dx;
+                    y += sy;
+                }
+            }
+        }
+    };
+
+    glm::vec3 perturb(const glm::vec3& v, float max_perturbation, Random& random)
+    {
+        const auto cos_max_angle_rad = std::cos(max_perturbation);
+        const auto r = random.rand2();
+        const auto cos_theta = cos_max_angle_rad + (1.0f - cos_max_angle_rad) * r.x;
+        const auto sin_theta = std::sqrt(1.0f - cos_theta * cos_theta);
+        const auto phi = 2.0f * pi * r.y;
+        const auto up = std::abs(v.z) >= 0.999f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 1.0f);
+        const auto tangent = glm::normalize(glm::cross(up, v));
+        const auto bitangent = glm::cross(v, tangent);
+        return v * cos_theta + tangent * sin_theta * std::cos(phi) + bitangent * sin_theta * std::sin(phi);
+    }
+
+    float acceleration_by_friction(const Settings& settings, const glm::vec3& acceleration_normal, const glm::vec3& velocity)
+    {
+        const auto velocity_magnitude = glm::length(velocity);
+        const auto model = uint32_t(settings.active_runout_model);
+        if (velocity_magnitude < velocity_threshold || model == 4)
+            return 0.0f;
+        const auto friction_coefficient = settings.model2.friction_coeff;
+        const auto drag_coefficient = settings.model2.drag_coeff;
+        const auto normal_stress = glm::length(acceleration_normal * mass_per_area);
+        constexpr float min_shear_stress = 70.0f;
+        const auto v2 = velocity_magnitude * velocity_magnitude;
+        float shear_stress = 0.0f;
+        switch (settings.active_runout_model) {
+        case TrajectoriesNode::Coulomb:
+            shear_stress = friction_coefficient * normal_stress;
+            break;
+        case TrajectoriesNode::Voellmy:
+            shear_stress = friction_coefficient * normal_stress + density * g * v2 / drag_coefficient;
+            break;
+        case TrajectoriesNode::VoellmyMinShear:
+            shear_stress = min_shear_stress + friction_coefficient * normal_stress + density * g * v2 / drag_coefficient;
+            break;
+        case TrajectoriesNode::SamosAt: {
+            constexpr float rs0 = 0.222f;
+            constexpr float kappa = 0.43f;
+            constexpr float r = 0.05f;
+            constexpr float b = 4.13f;
+            const auto rs = density * v2 / (normal_stress + 0.001f);
+            auto div = std::max(slab_thickness / r, 1.0f);
+            div = std::log(div) / kappa + b;
+            shear_stress = normal_stress * friction_coefficient * (1.0f + rs0 / (rs0 + rs)) + density * v2 / (div * div);
+            break;
+        }
+        }
+        return shear_stress / mass_per_area;
+    }
+
+    bool is_release_point(const nucleus::Raster<uint8_t>& raster, const glm::vec2& uv)
+    {
+        const auto pos = glm::uvec2(uv * glm::vec2(raster.size()));
+        return pos.x < raster.width() && pos.y < raster.height() && raster.pixel(pos) > 0;
+    }
+
+    // trajectory_overlay of the shader, returns the number of steps. state is kept in single precision, as on the gpu.
+    uint32_t trajectory(const Input& input, const Settings& settings, const glm::uvec3& id, uint32_t seed, Output& output, bool* started)
+    {
+        const auto model = settings.active_model;
+        const auto runout_alpha = glm::radians(settings.runout_flowpy.alpha);
+        Random random(glm::uvec4(id, seed));
+        const auto dimensions = glm::vec2(input.normals.size());
+        const auto pixel_size = input.region_size / dimensions;
+        const auto dx = std::min(pixel_size.x, pixel_size.y);
+
+        const auto texel_size_uv = 1.0f / dimensions;
+        const auto uv = glm::vec2(id.x, id.y) * texel_size_uv + random.rand2() * texel_size_uv;
+        *started = is_release_point(input.release_points, uv);
+        if (!*started)
+            return 0;
+
+        const auto start_normal = sample_bilinear(input.normals, uv);
+        glm::vec3 velocity = {};
+        const auto start_point_height = sample_gather(input.heights, uv);
+        float world_space_travel_distance = 0.0f;
+        glm::vec2 last_uv = uv;
+        glm::vec2 world_space_offset = {};
+        const auto start_acceleration_tangential = acceleration_gravity - g * start_normal.z * start_normal;
+        float dt = std::sqrt(2.0f * dx / glm::length(start_acceleration_tangential));
+        glm::vec2 last_direction = {};
+        float z_delta = 0.0f;
+        float velocity_magnitude = 0.0f;
+
+        uint32_t i = 0;
+        for (; i < settings.num_steps; i++) {
+            const auto current_uv = uv + glm::vec2(world_space_offset.x, -world_space_offset.y) / input.region_size;
+            if (current_uv.x < 0 || current_uv.x > 1 || current_uv.y < 0 || current_uv.y > 1)
+                break;
+            const auto current_height = sample_gather(input.heights, current_uv);
+            // missing values
+            if (current_height < 10)
+                break;
+            const auto normal = sample_bilinear(input.normals, current_uv);
+
+            if (i > 0) {
+                const auto height_difference = start_point_height - current_height;
+                const auto z_alpha = std::tan(runout_alpha) * world_space_travel_distance;
+                z_delta = height_difference - z_alpha;
+                const auto gamma = std::atan(height_difference / world_space_travel_distance);
+                if (model == TrajectoriesNode::WEBIGEO_AVALANCHE_SIMULATION && z_delta <= 0)
+                    break;
+                if (model == TrajectoriesNode::PHYSICS_LESS_SIMPLE)
+                    z_delta = velocity_magnitude * velocity_magnitude / (2 * g);
+                output.draw_line(last_uv, current_uv, z_delta, world_space_travel_distance, gamma, height_difference);
+            }
+            last_uv = current_uv;
+
+            if (model == TrajectoriesNode::WEBIGEO_AVALANCHE_SIMULATION) {
+                const auto perturbed_normal_2d = glm::vec2(perturb(normal, settings.max_perturbation, random));
+                const auto step_velocity = std::max(std::sqrt(z_delta * 2 * g), 1.0f);
+                const auto current_direction
+                    = last_direction * settings.persistence_contribution + perturbed_normal_2d / step_velocity * (1.0f - settings.persistence_contribution);
+                const auto dir_magnitude = glm::length(current_direction);
+                if (dir_magnitude < 0.001f)
+                    break;
+                last_direction = current_direction / dir_magnitude;
+                const auto relative_trajectory = last_direction * 2.0f * settings.step_length;
+                world_space_offset += relative_trajectory;
+                world_space_travel_distance += glm::length(relative_trajectory);
+            } else if (model == TrajectoriesNode::PHYSICS_LESS_SIMPLE) {
+                const auto acceleration_normal = g * normal.z * normal;
+                const auto acceleration_tangential = acceleration_gravity + acceleration_normal;
+                dt = cfl * dx / glm::length(velocity + acceleration_tangential * dt);
+                const auto acceleration_friction_magnitude = acceleration_by_friction(settings, acceleration_normal, velocity);
+                velocity += acceleration_tangential * dt;
+                // friction stop criterion, it has to use the new timestep
+                if (glm::length(velocity) < acceleration_friction_magnitude * dt) {
+                    dt = glm::length(velocity) / acceleration_friction_magnitude;
+                    const auto relative_trajectory = velocity * dt;
+                    world_space_offset += glm::vec2(relative_trajectory);
+                    world_space_travel_distance += glm::length(glm::vec2(relative_trajectory));
+                    break;
+                }
+                // the shader applies the tangential acceleration twice, kept for equal results
+                velocity += acceleration_tangential * dt;
+                velocity -= acceleration_friction_magnitude * glm::normalize(velocity) * dt;
+                const auto relative_trajectory = velocity * dt;
+                world_space_offset += glm::vec2(relative_trajectory);
+                world_space_travel_distance += glm::length(glm::vec2(relative_trajectory));
+                velocity_magnitude = glm::length(velocity);
+                if (velocity_magnitude < velocity_threshold)
+                    break;
+            }
+        }
+        return i;
+    }
+} // namespace
+
+Random::Random(const glm::uvec4& seed)
+    : m_state(seed)
+{
+}
+
+glm::vec4 Random::rand4()
+{
+    auto& v = m_state;
+    v = v * 1664525u + 1013904223u;
+    v.x += v.y * v.w;
+    v.y += v.z * v.x;
+    v.z += v.x * v.y;
+    v.w += v.y * v.z;
+    v ^= v >> 16u;
+    v.x += v.y * v.w;
+    v.y += v.z * v.x;
+    v.z += v.x * v.y;
+    v.w += v.y * v.z;
+    return glm::vec4(v) / 4294967296.0f;
+}
+
+glm::vec2 Random::rand2() { return glm::vec2(rand4()); }
+
+glm::vec3 sample_bilinear(const nucleus::Raster<glm::vec3>& raster, const glm::vec2& uv)
+{
+    const auto max_index = glm::ivec2(raster.size()) - 1;
+    const auto p = uv * glm::vec2(raster.size()) - 0.5f;
+    const auto i0 = glm::ivec2(glm::floor(p));
+    const auto w = p - glm::floor(p);
+    const auto texel = [&](int dx, int dy) { return raster.pixel(glm::uvec2(glm::clamp(i0 + glm::ivec2(dx, dy), glm::ivec2(0), max_index))); };
+    return glm::mix(glm::mix(texel(0, 0), texel(1, 0), w.x), glm::mix(texel(0, 1), texel(1, 1), w.x), w.y);
+}
+
+float sample_gather(const nucleus::Raster<float>& raster, const glm::vec2& uv)
+{
+    const auto max_index = glm::ivec2(raster.size()) - 1;
+    const auto p = uv * glm::vec2(raster.size()) - 0.5f;
+    // the gathered texels are those of the footprint, the weights are computed with an offset in the shader
+    const auto i0 = glm::ivec2(glm::floor(p));
+    const auto w = glm::fract(p + TEXTURE_GATHER_OFFSET);
+    const auto texel = [&](int dx, int dy) { return raster.pixel(glm::uvec2(glm::clamp(i0 + glm::ivec2(dx, dy), glm::ivec2(0), max_index))); };
+    return (1.0f - w.x) * w.y * texel(0, 1) + w.x * w.y * texel(1, 1) + w.x * (1.0f - w.y) * texel(1, 0) + (1.0f - w.x) * (1.0f - w.y) * texel(0, 0);
+}
+
+Layers simulate(const Input& input, const Settings& settings, unsigned n_threads, Statistics* statistics)
+{
+    const auto size = input.normals.size();
+    assert(input.heights.size() == size);
+    assert(input.release_points.size() == size);
+    const auto resolution = size * settings.resolution_multiplier;
+    Output output(resolution, settings.output_layer);
+
+    // texels whose starting points can't land in a release cell are skipped (the random offset stays within the texel,
+    // rounding might move it to the next one)
+    const auto may_start = [&](unsigned x, unsigned y) {
+        for (unsigned j = y; j <= std::min(y + 1, size.y - 1); ++j) {
+            for (unsigned i = x; i <= std::min(x + 1, size.x - 1); ++i) {
+                if (input.release_points.pixel({ i, j }) > 0)
+                    return true;
+            }
+        }
+        return false;
+    };
+
+    // work items are rows of a run, handed out dynamically because the path lengths vary a lot
+    const auto n_items = size.y * settings.num_runs;
+    std::atomic<unsigned> next_item = 0;
+    std::atomic<uint64_t> n_paths = 0;
+    std::atomic<uint64_t> n_steps = 0;
+    const auto worker = [&]() {
+        uint64_t local_paths = 0;
+        uint64_t local_steps = 0;
+        for (auto item = next_item++; item < n_items; item = next_item++) {
+            const auto run = item / size.y;
+            const auto y = item % size.y;
+            for (unsigned x = 0; x < size.x; ++x) {
+                if (!may_start(x, y))
+                    continue;
+                for (unsigned z = 0; z < settings.num_paths_per_release_cell; ++z) {
+                    bool started = false;
+                    local_steps += trajectory(input, settings, { x, y, z }, settings.random_seed + run, output, &started);
+                    local_paths += started ? 1 : 0;
+                }
+            }
+        }
+        n_paths += local_paths;
+        n_steps += local_steps;
+    };
+
+    if (n_threads == 0)
+        n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    n_threads = std::min(n_threads, std::max(n_items, 1u));
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < n_threads; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+
+    if (statistics)
+        *statistics = { n_paths.load(), n_steps.load() };
+
+    return {
+        resolution,
+        output.zdelta.to_raster(resolution),
+        output.cell_counts.to_raster(resolution),
+        output.travel_length.to_raster(resolution),
+        output.travel_angle.to_raster(resolution),
+        output.altitude_difference.to_raster(resolution),
+    };
+}
+
+} // namespace webgpu_compute::avalanche_trajectories_cpu
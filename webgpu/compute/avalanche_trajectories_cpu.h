@@ -0,0 +1,74 @@
+/*****************************************************************************
+ * weBIGeo
+ * Copyright (C) 2025 Adam Celarek
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *****************************************************************************/
+
+#pragma once
+
+#include "nodes/ComputeAvalancheTrajectoriesNode.h"
+#include <glm/glm.hpp>
+#include <nucleus/Raster.h>
+
+// Cpu implementation of avalanche_trajectories_compute.wgsl: same models, random numbers, sampling and output layers.
+// It serves as a reference for tests and profiling on machines without a gpu, and as a backend for headless batch runs.
+// Results are deterministic and independent of the number of threads. They are not bit identical to the gpu, which
+// has different precision in its transcendental functions and texture filtering.
+namespace webgpu_compute::avalanche_trajectories_cpu {
+
+using Settings = nodes::ComputeAvalancheTrajectoriesNode::AvalancheTrajectoriesSettings;
+
+struct Input {
+    nucleus::Raster<glm::vec3> normals; // unit length, i.e., decoded from the normal texture
+    nucleus::Raster<float> heights; // in m
+    nucleus::Raster<uint8_t> release_points; // > 0 for release cells
+    glm::vec2 region_size = {}; // world space width and height of the region (row 0 is north)
+};
+
+// same layout and units as the layer buffers of ComputeAvalancheTrajectoriesNode. disabled layers are empty.
+struct Layers {
+    glm::uvec2 resolution = {};
+    nucleus::Raster<uint32_t> zdelta;
+    nucleus::Raster<uint32_t> cell_counts;
+    nucleus::Raster<uint32_t> travel_length;
+    nucleus::Raster<uint32_t> travel_angle;
+    nucleus::Raster<uint32_t> altitude_difference;
+};
+
+struct Statistics {
+    uint64_t n_paths = 0; // paths started in a release cell
+    uint64_t n_steps = 0;
+};
+
+// n_threads = 0 uses all hardware threads. input rasters must have the same size.
+[[nodiscard]] Layers simulate(const Input& input, const Settings& settings, unsigned n_threads = 0, Statistics* statistics = nullptr);
+
+// pcg based generator of random.wgsl
+class Random {
+public:
+    explicit Random(const glm::uvec4& seed);
+    glm::vec4 rand4();
+    glm::vec2 rand2();
+
+private:
+    glm::uvec4 m_state;
+};
+
+// bilinear, clamped to the edge, texel centers at (i + 0.5) / size. like the normal sampler of the node.
+[[nodiscard]] glm::vec3 sample_bilinear(const nucleus::Raster<glm::vec3>& raster, const glm::vec2& uv);
+// like sample_height_texture in the shader (texture gather with offset weights)
+[[nodiscard]] float sample_gather(const nucleus::Raster<float>& raster, const glm::vec2& uv);
+
+} // namespace webgpu_compute::avalanche_trajectories_cpu
@@ -22,12 +22,16 @@
 #include <QDebug>
 #include <QFile>
 #include <QTextStream>
+#include <algorithm>
 #include <assert.h>
 #include <filesystem>
 #include <limits>
 #include <memory>
+#include <optional>
+#include <span>
 #include <nucleus/Raster.h>
 #include <nucleus/utils/geopng_decoder.h>
+#include <nucleus/utils/geotiff_writer.h>
 #include <nucleus/utils/image_writer.h>
 
 namespace webgpu_compute::nodes {
@@ -53,6 +57,12 @@ static void ensure_parent_dir(const std::string& file_path) { std::filesystem::c
 static void write_texture_file(const QByteArray& data, glm::uvec2 dims, const std::string& file_path)
 {
     const uint32_t bpp = static_cast<uint32_t>(data.size()) / (dims.x * dims.y);
+    ensure_parent_dir(file_path);
+    if (bpp == 4) {
+        nucleus::utils::image_writer::rgba8_as_png(data, dims, QString::fromStdString(file_path));
+        qDebug() << "[ExportNode] texture written to" << QString::fromStdString(file_path);
+        return;
+    }
     nucleus::Raster<glm::u8vec4> raster(dims);
     auto& buf = raster.buffer();
     for (uint32_t y = 0; y < dims.y; y++) {
@@ -64,7 +74,6 @@ static void write_texture_file(const QByteArray& data, glm::uvec2 dims, const st
                 bpp > 3 ? static_cast<uint8_t>(data.at(idx + 3)) : 255u);
         }
     }
-    ensure_parent_dir(file_path);
     nucleus::utils::image_writer::rgba8_as_png(raster, QString::fromStdString(file_path));
     qDebug() << "[ExportNode] texture written to" << QString::fromStdString(file_path);
 }
@@ -79,6 +88,61 @@ static void write_buffer_file(const std::vector<uint32_t>& data, glm::uvec2 dims
     qDebug() << "[ExportNode] buffer written to" << QString::fromStdString(file_path);
 }
 
+// streams the rows straight from the read back data
+static void write_geotiff_file(std::span<const uint8_t> data, const nucleus::utils::geotiff::Format& format,
+    const std::optional<radix::geometry::Aabb<2, double>>& bounds, int compression_level, const std::string& file_path)
+{
+    ensure_parent_dir(file_path);
+    nucleus::utils::geotiff::StreamingWriter writer(QString::fromStdString(file_path), format, bounds, 256, compression_level);
+    writer.write_rows(data);
+    if (const auto result = writer.finish(); !result) {
+        qWarning() << "[ExportNode] writing" << QString::fromStdString(file_path) << "failed:" << QString::fromStdString(result.error());
+        return;
+    }
+    qDebug() << "[ExportNode] GeoTIFF written to" << QString::fromStdString(file_path);
+}
+
+// GeoTIFF samples for the texture formats that map to plain integer or float samples. others (e.g., bgra or half floats) are not supported.
+static std::optional<nucleus::utils::geotiff::Format> geotiff_format(WGPUTextureFormat texture_format, glm::uvec2 dims)
+{
+    using nucleus::utils::geotiff::Format;
+    using nucleus::utils::geotiff::SampleFormat;
+    switch (texture_format) {
+    case WGPUTextureFormat_R8Unorm:
+    case WGPUTextureFormat_R8Uint:
+        return Format { dims, 1, 1 };
+    case WGPUTextureFormat_RG8Unorm:
+    case WGPUTextureFormat_RG8Uint:
+        return Format { dims, 2, 1 };
+    case WGPUTextureFormat_RGBA8Unorm:
+    case WGPUTextureFormat_RGBA8UnormSrgb:
+    case WGPUTextureFormat_RGBA8Uint:
+        return Format { dims, 4, 1 };
+    case WGPUTextureFormat_R16Uint:
+        return Format { dims, 1, 2 };
+    case WGPUTextureFormat_RG16Uint:
+        return Format { dims, 2, 2 };
+    case WGPUTextureFormat_RGBA16Uint:
+        return Format { dims, 4, 2 };
+    case WGPUTextureFormat_R32Uint:
+        return Format { dims, 1, 4 };
+    case WGPUTextureFormat_RG32Uint:
+        return Format { dims, 2, 4 };
+    case WGPUTextureFormat_RGBA32Uint:
+        return Format { dims, 4, 4 };
+    case WGPUTextureFormat_R32Float:
+        return Format { dims, 1, 4, SampleFormat::Float };
+    case WGPUTextureFormat_RG32Float:
+        return Format { dims, 2, 4, SampleFormat::Float };
+    case WGPUTextureFormat_RGBA32Float:
+        return Format { dims, 4, 4, SampleFormat::Float };
+    default:
+        return std::nullopt;
+    }
+}
+
+static std::string with_tif_extension(const std::string& file_path) { return std::filesystem::path(file_path).replace_extension(".tif").string(); }
+
 static void write_aabb_file(const std::string& file_path, const radix::geometry::Aabb<2, double>& bounds)
 {
     ensure_parent_dir(file_path);
@@ -122,6 +186,11 @@ void ExportNode::run_impl()
     const bool has_texture = input_socket("texture").is_socket_connected();
     const bool has_buffer = input_socket("buffer").is_socket_connected();
     const bool has_aabb = input_socket("region aabb").is_socket_connected();
+    const bool geotiff = m_settings.file_format == FileFormat::GeoTiff;
+    const int compression_level = std::clamp(m_settings.compression_level, 0, 9);
+    std::optional<radix::geometry::Aabb<2, double>> bounds;
+    if (has_aabb)
+        bounds = *std::get<data_type<const radix::geometry::Aabb<2, double>*>()>(input_socket("region aabb").get_connected_data());
 
     // Shared counter: both GPU readbacks are queued simultaneously; run_completed
     // fires only when all pending async ops have finished.
@@ -135,11 +204,26 @@ void ExportNode::run_impl()
         const auto& texture = *std::get<data_type<const webgpu::raii::TextureWithSampler*>()>(input_socket("texture").get_connected_data());
         const glm::uvec2 dims { texture.texture().width(), texture.texture().height() };
         const std::string path = resolve_placeholders(m_settings.texture_output_file, node_name, run_id, run_datetime);
-        (*pending)++;
-        texture.texture().read_back_async(m_ctx->device(), 0, [path, dims, on_done]([[maybe_unused]] size_t, std::shared_ptr<QByteArray> data) {
-            write_texture_file(*data, dims, path);
-            on_done();
-        });
+        const auto format = geotiff_format(texture.texture().descriptor().format, dims);
+        if (geotiff && !format) {
+            qWarning() << "[ExportNode] texture format" << texture.texture().descriptor().format << "can't be exported as GeoTIFF";
+        } else {
+            (*pending)++;
+            texture.texture().read_back_async(
+                m_ctx->device(), 0, [this, path, dims, geotiff, format, bounds, compression_level, on_done]([[maybe_unused]] size_t, std::shared_ptr<QByteArray> data) {
+                    // encoding is slow, don't block the other branches of the graph
+                    run_on_thread_pool(
+                        [path, dims, geotiff, format, bounds, compression_level, data]() {
+                            if (!geotiff) {
+                                write_texture_file(*data, dims, path);
+                                return;
+                            }
+                                const auto bytes = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(data->constData()), size_t(data->size()));
+                            write_geotiff_file(bytes, *format, bounds, compression_level, with_tif_extension(path));
+                        },
+                        on_done);
+                });
+        }
     }
 
     if (has_buffer) {
@@ -155,22 +239,32 @@ void ExportNode::run_impl()
             } else {
                 const std::string path = resolve_placeholders(m_settings.buffer_output_file, node_name, run_id, run_datetime);
                 (*pending)++;
-                buffer.read_back_async(m_ctx->device(), [path, dims, on_done](WGPUMapAsyncStatus status, std::vector<uint32_t> data) {
-                    if (status == WGPUMapAsyncStatus_Success)
-                        write_buffer_file(data, dims, path);
-                    else
+                buffer.read_back_async(m_ctx->device(), [this, path, dims, geotiff, bounds, compression_level, on_done](WGPUMapAsyncStatus status, std::vector<uint32_t> data) {
+                    if (status != WGPUMapAsyncStatus_Success) {
                         qWarning() << "[ExportNode] buffer readback failed:" << status;
-                    on_done();
+                        on_done();
+                        return;
+                    }
+                    auto shared_data = std::make_shared<std::vector<uint32_t>>(std::move(data));
+                    run_on_thread_pool(
+                        [path, dims, geotiff, bounds, compression_level, shared_data]() {
+                            if (!geotiff) {
+                                write_buffer_file(*shared_data, dims, path);
+                                return;
+                            }
+                            const auto format = nucleus::utils::geotiff::Format { dims, 1, 4, nucleus::utils::geotiff::SampleFormat::UnsignedInteger };
+                            const auto bytes = std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(shared_data->data()), shared_data->size() * sizeof(uint32_t));
+                            write_geotiff_file(bytes, format, bounds, compression_level, with_tif_extension(path));
+                        },
+                        on_done);
                 });
             }
         }
     }
 
-    // AABB is synchronous -> write immediately
-    if (has_aabb) {
-        const auto& aabb = *std::get<data_type<const radix::geometry::Aabb<2, double>*>()>(input_socket("region aabb").get_connected_data());
-        write_aabb_file(resolve_placeholders(m_settings.aabb_output_file, node_name, run_id, run_datetime), aabb);
-    }
+    // AABB is synchronous -> write immediately. GeoTIFFs carry it themselves
+    if (bounds && !geotiff)
+        write_aabb_file(resolve_placeholders(m_settings.aabb_output_file, node_name, run_id, run_datetime), *bounds);
 
     if (*pending == 0)
         complete_run();
@@ -178,6 +272,8 @@ void ExportNode::run_impl()
 
 void ExportNode::serialize_settings(QJsonObject& out) const
 {
+    out["file_format"] = m_settings.file_format == FileFormat::GeoTiff ? "geotiff" : "png";
+    out["compression_level"] = m_settings.compression_level;
     out["buffer_output_file"] = QString::fromStdString(m_settings.buffer_output_file);
     out["texture_output_file"] = QString::fromStdString(m_settings.texture_output_file);
     out["aabb_output_file"] = QString::fromStdString(m_settings.aabb_output_file);
@@ -185,6 +281,10 @@ void ExportNode::serialize_settings(QJsonObject& out) const
 
 void ExportNode::deserialize_settings(const QJsonObject& in)
 {
+    if (in.contains("file_format"))
+        m_settings.file_format = in["file_format"].toString() == "geotiff" ? FileFormat::GeoTiff : FileFormat::Png;
+    if (in.contains("compression_level"))
+        m_settings.compression_level = in["compression_level"].toInt(m_settings.compression_level);
     if (in.contains("buffer_output_file"))
         m_settings.buffer_output_file = in["buffer_output_file"].toString().toStdString();
     if (in.contains("texture_output_file"))
@@ -27,18 +27,27 @@ namespace webgpu_compute::nodes {
 // General-purpose export node. Connect any combination of:
 //   - "texture" -> exports a GPU texture to an image file
 //   - "buffer" + "dimensions" -> exports a uint32 GPU buffer to an image file
-//   - "region aabb" -> writes a bounding-box text file
+//   - "region aabb" -> writes a bounding-box text file (png), or georeferences the images (GeoTIFF)
+// Files are encoded on the thread pool, the graph continues meanwhile. GeoTIFFs are tiled, compressed and written strip by strip
+// from the read back data. Buffers are stored as uint32 GeoTIFFs, i.e., without the float encoding of the pngs.
 class ExportNode : public Node {
     Q_OBJECT
 
 public:
     NODE_TYPE_NAME(ExportNode)
 
+    enum class FileFormat {
+        Png,
+        GeoTiff,
+    };
+
     struct ExportSettings {
-        // Supported placeholders: {node_name}, {run_datetime}, {run_id}
+        FileFormat file_format = FileFormat::Png;
+        int compression_level = 6; // GeoTIFF only, 0 (uncompressed) to 9
+        // Supported placeholders: {node_name}, {run_datetime}, {run_id}. The extension is replaced by .tif for GeoTIFFs
         std::string buffer_output_file = "export/{run_datetime}_{run_id}/exp_{node_name}_buff.png";
         std::string texture_output_file = "export/{run_datetime}_{run_id}/exp_{node_name}_tex.png";
-        std::string aabb_output_file = "export/{run_datetime}_{run_id}/exp_aabb.txt";
+        std::string aabb_output_file = "export/{run_datetime}_{run_id}/exp_aabb.txt"; // png only
     };
 
     explicit ExportNode(webgpu::Context& ctx);
@@ -48,6 +57,8 @@ public:
     void set_settings(const ExportSettings& settings);
     void serialize_settings(QJsonObject& out) const override;
     void deserialize_settings(const QJsonObject& in) override;
+    // writes files, so it runs every time
+    [[nodiscard]] bool is_cacheable() const override { return false; }
 
 public slots:
     void run_impl() override;
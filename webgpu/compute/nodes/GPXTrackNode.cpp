@@ -17,6 +17,7 @@
  *****************************************************************************/
 
 #include "GPXTrackNode.h"
+#include "util.h"
 
 #include "nucleus/track/GPX.h"
 #include <QDebug>
@@ -34,11 +35,6 @@ GPXTrackNode::GPXTrackNode()
 
 void GPXTrackNode::run_impl()
 {
-    if (m_settings.enable_caching && m_has_cached && m_settings.file_path == m_cached_path) {
-        complete_run();
-        return;
-    }
-
     std::unique_ptr<nucleus::track::Gpx> gpx = nucleus::track::parse(QString::fromStdString(m_settings.file_path));
     if (!gpx) {
         fail_run("could not parse GPX file: " + m_settings.file_path);
@@ -46,8 +42,6 @@ void GPXTrackNode::run_impl()
     }
 
     m_output_region = nucleus::track::compute_world_aabb(*gpx);
-    m_cached_path = m_settings.file_path;
-    m_has_cached = true;
 
     qDebug() << Qt::fixed << "gpx region=[(" << m_output_region.min.x << ", " << m_output_region.min.y << "), (" << m_output_region.max.x << ", "
              << m_output_region.max.y << ")]";
@@ -61,6 +55,8 @@ void GPXTrackNode::serialize_settings(QJsonObject& out) const
     out["enable_caching"] = m_settings.enable_caching;
 }
 
+void GPXTrackNode::serialize_transient_state(QJsonObject& out) const { serialize_file_state(m_settings.file_path, out); }
+
 void GPXTrackNode::deserialize_settings(const QJsonObject& in)
 {
     if (in.contains("file_path"))
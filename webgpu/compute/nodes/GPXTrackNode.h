@@ -39,6 +39,9 @@ public:
     const GPXTrackNodeSettings& get_settings() const { return m_settings; }
     void serialize_settings(QJsonObject& out) const override;
     void deserialize_settings(const QJsonObject& in) override;
+    void serialize_transient_state(QJsonObject& out) const override;
+    /// With caching, the track is reloaded only if the path or the file (size, modification time) changed.
+    [[nodiscard]] bool is_cacheable() const override { return m_settings.enable_caching; }
 
 public slots:
     void run_impl() override;
@@ -46,9 +49,6 @@ public slots:
 private:
     GPXTrackNodeSettings m_settings;
     radix::geometry::Aabb<3, double> m_output_region;
-
-    std::string m_cached_path;
-    bool m_has_cached = false;
 };
 
 } // namespace webgpu_compute::nodes
@@ -45,19 +45,22 @@ void LoadTextureNode::run_impl()
 
     qDebug() << "loading texture from " << m_settings.file_path;
 
-    auto path = QString::fromStdString(m_settings.file_path);
-    tl::expected<nucleus::Raster<glm::u8vec4>, QString> expected_image = nucleus::utils::image_loader::rgba8(path);
-    if (!expected_image.has_value()) {
-        fail_run("Failed to load image file at " + m_settings.file_path + ": " + expected_image.error().toStdString());
-        return;
-    }
-
-    nucleus::Raster<glm::u8vec4> image = expected_image.value();
-    m_output_texture = create_texture(m_ctx->device(), image.width(), image.height(), m_settings.format, m_settings.usage);
-    m_output_texture->texture().write(m_ctx->queue(), image);
-
-    // TODO not sure if we need to wait for the queue here?
-    complete_run();
+    const auto path = QString::fromStdString(m_settings.file_path);
+    auto expected_image = std::make_shared<tl::expected<nucleus::Raster<glm::u8vec4>, QString>>(tl::unexpected(QString()));
+    // decoding runs on the thread pool, the upload on the thread of the node
+    run_on_thread_pool([path, expected_image]() { *expected_image = nucleus::utils::image_loader::rgba8(path); },
+        [this, expected_image]() {
+            if (!expected_image->has_value()) {
+                fail_run("Failed to load image file at " + m_settings.file_path + ": " + expected_image->error().toStdString());
+                return;
+            }
+            const auto& image = expected_image->value();
+            m_output_texture = create_texture(m_ctx->device(), image.width(), image.height(), m_settings.format, m_settings.usage);
+            m_output_texture->texture().write(m_ctx->queue(), image);
+
+            // TODO not sure if we need to wait for the queue here?
+            complete_run();
+        });
 }
 
 std::unique_ptr<webgpu::raii::TextureWithSampler> LoadTextureNode::create_texture(
@@ -96,6 +99,8 @@ void LoadTextureNode::serialize_settings(QJsonObject& out) const
     out["usage"] = wgpu_usage_to_json(m_settings.usage);
 }
 
+void LoadTextureNode::serialize_transient_state(QJsonObject& out) const { serialize_file_state(m_settings.file_path, out); }
+
 void LoadTextureNode::deserialize_settings(const QJsonObject& in)
 {
     auto s = m_settings;
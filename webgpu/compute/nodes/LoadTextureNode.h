@@ -46,6 +46,7 @@ public:
     const LoadTextureNodeSettings& get_settings() const { return m_settings; }
     void serialize_settings(QJsonObject& out) const override;
     void deserialize_settings(const QJsonObject& in) override;
+    void serialize_transient_state(QJsonObject& out) const override;
 
 public slots:
     void run_impl() override;
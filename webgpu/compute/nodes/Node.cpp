@@ -19,9 +19,25 @@
 #include "Node.h"
 
 #include <QDebug>
+#include <QJsonDocument>
+#include <QThreadPool>
 
 namespace webgpu_compute::nodes {
 
+namespace {
+    // fnv-1a, stable across runs and platforms (unlike std::hash or qHash with a random seed)
+    uint64_t hash_bytes(const QByteArray& bytes, uint64_t hash = 14695981039346656037ull)
+    {
+        for (const auto c : bytes) {
+            hash ^= uint64_t(uint8_t(c));
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    uint64_t hash_value(uint64_t value, uint64_t hash) { return hash_bytes(QByteArray(reinterpret_cast<const char*>(&value), sizeof(value)), hash); }
+} // namespace
+
 Socket::Socket(Node& node, const std::string& name, DataType type, FlowDirection direction)
     : m_node(&node)
     , m_name(name)
@@ -112,7 +128,19 @@ Node::Node(const std::vector<InputSocket>& input_sockets, const std::vector<Outp
 {
 }
 
-void Node::rerun() { run(m_run_context); }
+Node::~Node()
+{
+#if QT_CONFIG(thread)
+    std::unique_lock lock(m_thread_pool_mutex);
+    m_thread_pool_idle.wait(lock, [this]() { return m_n_thread_pool_jobs == 0; });
+#endif
+}
+
+void Node::rerun()
+{
+    invalidate_cached_result();
+    run(m_run_context);
+}
 
 void Node::run(webgpu_compute::GraphRunContext context)
 {
@@ -121,10 +149,18 @@ void Node::run(webgpu_compute::GraphRunContext context)
         return;
     }
     m_run_context = context;
-    if (m_enabled) {
+    m_fingerprint = compute_fingerprint();
+    m_last_run_reused = false;
+    if (m_enabled && m_fingerprint && m_fingerprint == m_completed_fingerprint) {
+        m_last_run_reused = true;
+        qDebug() << m_node_name << "unchanged, reusing previous result (run" << m_run_context.run_id << ")";
+        emit run_completed(m_run_context);
+        process_pending();
+    } else if (m_enabled) {
         m_is_running = true;
         m_last_run_started = std::chrono::high_resolution_clock::now();
         qDebug() << m_node_name << "started (run" << m_run_context.run_id << ")";
+        ++m_n_executions;
         emit run_started();
         run_impl();
     } else {
@@ -138,6 +174,7 @@ void Node::complete_run()
     m_last_run_finished = std::chrono::high_resolution_clock::now();
     m_last_run_duration_in_ms = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(m_last_run_finished - m_last_run_started).count());
     m_is_running = false;
+    m_completed_fingerprint = m_fingerprint;
     qDebug() << m_node_name << "done. Execution took" << m_last_run_duration_in_ms << "ms (run " << m_run_context.run_id << ")";
     emit run_completed(m_run_context);
     process_pending();
@@ -146,11 +183,32 @@ void Node::complete_run()
 void Node::fail_run(const std::string& message)
 {
     m_is_running = false;
+    m_completed_fingerprint.reset();
     while (!m_pending_contexts.empty())
         m_pending_contexts.pop();
     emit run_failed(NodeRunFailureInfo(*this, message));
 }
 
+void Node::run_on_thread_pool(std::function<void()> work, std::function<void()> then)
+{
+#if QT_CONFIG(thread)
+    {
+        std::scoped_lock lock(m_thread_pool_mutex);
+        ++m_n_thread_pool_jobs;
+    }
+    QThreadPool::globalInstance()->start([this, work = std::move(work), then = std::move(then)]() {
+        work();
+        QMetaObject::invokeMethod(this, then, Qt::QueuedConnection);
+        std::scoped_lock lock(m_thread_pool_mutex);
+        --m_n_thread_pool_jobs;
+        m_thread_pool_idle.notify_all();
+    });
+#else
+    work();
+    then();
+#endif
+}
+
 void Node::process_pending()
 {
     if (!m_pending_contexts.empty()) {
@@ -160,6 +218,39 @@ void Node::process_pending()
     }
 }
 
+std::optional<uint64_t> Node::compute_fingerprint() const
+{
+    if (!m_caching_enabled)
+        return {};
+    QJsonObject settings;
+    serialize_settings(settings);
+    QJsonObject transient_state;
+    serialize_transient_state(transient_state);
+    if (!transient_state.isEmpty())
+        settings["transient_state"] = transient_state;
+    // QJsonObject keeps its keys sorted, so the compact json is canonical
+    uint64_t hash = hash_bytes(QByteArray::fromStdString(get_type_name()));
+    hash = hash_bytes(QJsonDocument(settings).toJson(QJsonDocument::Compact), hash);
+    hash = hash_value(m_enabled ? 1 : 0, hash);
+    // the results of a node that always runs differ every time, and so do the results computed from them
+    if (!is_cacheable())
+        hash = hash_value(m_n_executions, hash);
+    for (const auto& socket : m_input_sockets) {
+        hash = hash_bytes(QByteArray::fromStdString(socket.name()), hash);
+        if (!socket.is_socket_connected()) {
+            hash = hash_value(0, hash);
+            continue;
+        }
+        const auto& upstream = socket.connected_socket();
+        const auto upstream_fingerprint = upstream.node().get_fingerprint();
+        if (!upstream_fingerprint)
+            return {};
+        hash = hash_value(*upstream_fingerprint, hash);
+        hash = hash_bytes(QByteArray::fromStdString(upstream.name()), hash);
+    }
+    return hash;
+}
+
 bool Node::has_input_socket(const std::string& name) const
 {
     return std::find_if(m_input_sockets.begin(), m_input_sockets.end(), [&name](const InputSocket& s) { return s.name() == name; }) != m_input_sockets.end();
@@ -230,6 +321,11 @@ int Node::get_last_run_duration_in_ms() const { return m_last_run_duration_in_ms
 bool Node::is_enabled() const { return m_enabled; }
 void Node::set_enabled(bool enabled) { m_enabled = enabled; }
 bool Node::is_running() const { return m_is_running; }
+bool Node::is_caching_enabled() const { return m_caching_enabled; }
+void Node::set_caching_enabled(bool enabled) { m_caching_enabled = enabled; }
+std::optional<uint64_t> Node::get_fingerprint() const { return m_fingerprint; }
+void Node::invalidate_cached_result() { m_completed_fingerprint.reset(); }
+bool Node::was_last_run_reused() const { return m_last_run_reused; }
 void Node::set_node_name(const std::string& name) { m_node_name = name; }
 const std::string& Node::get_node_name() const { return m_node_name; }
 uint64_t Node::get_run_id() const { return m_run_context.run_id; }
@@ -25,6 +25,10 @@
 #include <QByteArray>
 #include <QJsonObject>
 #include <QObject>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
 #include <queue>
 #include <variant>
 #include <vector>
@@ -165,17 +169,24 @@ private:
 /// fail_run(). The base class owns the run lifecycle: it buffers the GraphRunContext,
 /// queues concurrent run() calls received while an async op is in-flight, and emits
 /// run_completed / run_failed.
+///
+/// Results are cached: at the start of a run, a node fingerprints its type, settings (serialize_settings),
+/// enabled state and the fingerprints of the nodes connected to its inputs. Upstream nodes run first, so a
+/// change anywhere upstream changes the fingerprint. If it matches the fingerprint of the last successful run,
+/// run_impl() is skipped and the output sockets keep returning the previous result.
 class Node : public QObject {
     Q_OBJECT
 
 public:
     Node(const std::vector<InputSocket>& input_sockets, const std::vector<OutputSocket>& output_sockets);
-    virtual ~Node() = default;
+    virtual ~Node();
 
     virtual std::string get_type_name() const = 0;
 
     virtual void serialize_settings(QJsonObject& out) const { }
     virtual void deserialize_settings(const QJsonObject& in) { }
+    /// State that changes the result but is not saved with the graph (e.g., set from outside for a single run). Part of the fingerprint.
+    virtual void serialize_transient_state(QJsonObject& out) const { }
 
     [[nodiscard]] bool has_input_socket(const std::string& name) const;
     [[nodiscard]] InputSocket& input_socket(const std::string& name);
@@ -199,6 +210,19 @@ public:
 
     [[nodiscard]] bool is_running() const;
 
+    /// Nodes with side effects (or inputs that are not covered by serialize_settings) return false and always run.
+    [[nodiscard]] virtual bool is_cacheable() const { return true; }
+    [[nodiscard]] bool is_caching_enabled() const;
+    void set_caching_enabled(bool enabled);
+    /// Empty if caching is disabled or an upstream node has no fingerprint.
+    [[nodiscard]] std::optional<uint64_t> compute_fingerprint() const;
+    /// Fingerprint of the current (or last) run.
+    [[nodiscard]] std::optional<uint64_t> get_fingerprint() const;
+    /// Forgets the cached result, the next run executes run_impl() again.
+    void invalidate_cached_result();
+    /// True if the last run reused the previous result instead of executing.
+    [[nodiscard]] bool was_last_run_reused() const;
+
     void set_node_name(const std::string& name);
     [[nodiscard]] const std::string& get_node_name() const;
     [[nodiscard]] uint64_t get_run_id() const;
@@ -222,6 +246,11 @@ protected:
     void complete_run();
     void fail_run(const std::string& message);
 
+    /// Runs cpu heavy work (decoding, encoding, file io) on the global thread pool, so that other branches of the graph can continue.
+    /// then() is called afterwards on the thread of the node, where webgpu can be used and complete_run() or fail_run() called.
+    /// work must not access the node, pass inputs by value and results through captured shared state.
+    void run_on_thread_pool(std::function<void()> work, std::function<void()> then);
+
     [[nodiscard]] Data get_output_data(const std::string& output_socket_name);
     [[nodiscard]] Data get_input_data(const std::string& input_socket_name);
 
@@ -240,8 +269,22 @@ private:
     std::chrono::high_resolution_clock::time_point m_last_run_finished;
     int m_last_run_duration_in_ms = 0;
 
+    std::optional<uint64_t> m_fingerprint;
+    std::optional<uint64_t> m_completed_fingerprint; // fingerprint of the result currently held by the output sockets
+    uint64_t m_n_executions = 0;
+    bool m_last_run_reused = false;
+    bool m_caching_enabled = true;
+
     bool m_enabled = true;
     bool m_is_running = false;
+
+#if QT_CONFIG(thread)
+    // work started by run_on_thread_pool that didn't post its then() yet. the destructor waits for it, pending then() calls are
+    // posted events, which QObject removes on destruction.
+    std::mutex m_thread_pool_mutex;
+    std::condition_variable m_thread_pool_idle;
+    unsigned m_n_thread_pool_jobs = 0;
+#endif
 };
 
 } // namespace webgpu_compute::nodes
@@ -20,6 +20,7 @@
 
 #include "webgpu/compute/RectangularTileRegion.h"
 #include <QDebug>
+#include <QJsonArray>
 #include <nucleus/srs.h>
 
 namespace webgpu_compute::nodes {
@@ -36,6 +37,12 @@ SelectTilesNode::SelectTilesNode()
 
 void SelectTilesNode::run_impl()
 {
+    if (m_tile_region_override) {
+        m_has_cached = false;
+        select(*m_tile_region_override);
+        return;
+    }
+
     if (!input_socket("region").is_socket_connected()) {
         fail_run("no region input connected");
         return;
@@ -57,12 +64,23 @@ void SelectTilesNode::run_impl()
         .zoom_level = upper_right_tile.zoom_level,
         .scheme = radix::tile::Scheme::Tms,
     };
+    m_has_cached = false;
+    if (!select(tile_region))
+        return;
+
+    m_cached_region = *region;
+    m_cached_zoom = m_settings.zoomlevel;
+    m_has_cached = true;
+}
+
+bool SelectTilesNode::select(const RectangularTileRegion& tile_region)
+{
     const auto tile_ids = tile_region.get_tiles();
 
     m_output_tile_ids.clear();
     if (tile_ids.empty()) {
         qWarning() << "no tiles selected";
-        return;
+        return false;
     }
     qDebug() << tile_ids.size() << " tiles selected";
 
@@ -75,15 +93,20 @@ void SelectTilesNode::run_impl()
 
     m_output_tile_ids.insert(m_output_tile_ids.begin(), tile_ids.begin(), tile_ids.end());
 
-    m_cached_region = *region;
-    m_cached_zoom = m_settings.zoomlevel;
-    m_has_cached = true;
-
     complete_run();
+    return true;
 }
 
 void SelectTilesNode::serialize_settings(QJsonObject& out) const { out["zoomlevel"] = static_cast<int>(m_settings.zoomlevel); }
 
+void SelectTilesNode::serialize_transient_state(QJsonObject& out) const
+{
+    if (!m_tile_region_override)
+        return;
+    const auto& r = *m_tile_region_override;
+    out["tile_region_override"] = QJsonArray { int(r.min.x), int(r.min.y), int(r.max.x), int(r.max.y), int(r.zoom_level), int(r.scheme) };
+}
+
 void SelectTilesNode::deserialize_settings(const QJsonObject& in)
 {
     if (in.contains("zoomlevel"))
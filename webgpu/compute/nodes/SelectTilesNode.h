@@ -19,6 +19,8 @@
 #pragma once
 
 #include "Node.h"
+#include "webgpu/compute/RectangularTileRegion.h"
+#include <optional>
 
 namespace webgpu_compute::nodes {
 
@@ -38,12 +40,21 @@ public:
     const SelectTilesNodeSettings& get_settings() const { return m_settings; }
     void serialize_settings(QJsonObject& out) const override;
     void deserialize_settings(const QJsonObject& in) override;
+    void serialize_transient_state(QJsonObject& out) const override;
+
+    /// Selects exactly these tiles instead of the tiles covering the region input (used by TiledGraphRunner for its work tiles).
+    void set_tile_region_override(const std::optional<RectangularTileRegion>& tile_region) { m_tile_region_override = tile_region; }
+    [[nodiscard]] const std::optional<RectangularTileRegion>& get_tile_region_override() const { return m_tile_region_override; }
 
 public slots:
     void run_impl() override;
 
 private:
+    // outputs the tiles of the region and completes the run. false if the region is empty (the run stays incomplete)
+    bool select(const RectangularTileRegion& tile_region);
+
     SelectTilesNodeSettings m_settings;
+    std::optional<RectangularTileRegion> m_tile_region_override;
     std::vector<radix::tile::Id> m_output_tile_ids;
     radix::geometry::Aabb<2, double> m_output_bounds;
 
@@ -82,80 +82,101 @@ void TileStitchNode::run_impl()
     // Check if inside bounds
     if (size_pixels.x > MAX_STITCHED_IMAGE_SIZE || size_pixels.y > MAX_STITCHED_IMAGE_SIZE) {
         fail_run("Stitched image size would exceeds maximum size of " + std::to_string(MAX_STITCHED_IMAGE_SIZE) + "x"
-            + std::to_string(MAX_STITCHED_IMAGE_SIZE) + " pixel for zoom level " + std::to_string(zl));
+            + std::to_string(MAX_STITCHED_IMAGE_SIZE) + " pixel for zoom level " + std::to_string(zl) + " (larger regions can be split with a TiledGraphRunner)");
         return;
     }
 
-    // create output texture
-    WGPUTextureDescriptor texture_desc {};
-    texture_desc.label = WGPUStringView { .data = "compute storage texture", .length = WGPU_STRLEN };
-    texture_desc.dimension = WGPUTextureDimension::WGPUTextureDimension_2D;
-    texture_desc.size = { size_pixels.x, size_pixels.y, 1 };
-    texture_desc.mipLevelCount = 1;
-    texture_desc.sampleCount = 1;
-    texture_desc.format = m_settings.texture_format;
-    texture_desc.usage = m_settings.texture_usage;
-
-    WGPUSamplerDescriptor sampler_desc {};
-    sampler_desc.label = WGPUStringView { .data = "compute storage sampler", .length = WGPU_STRLEN };
-    sampler_desc.addressModeU = WGPUAddressMode::WGPUAddressMode_ClampToEdge;
-    sampler_desc.addressModeV = WGPUAddressMode::WGPUAddressMode_ClampToEdge;
-    sampler_desc.addressModeW = WGPUAddressMode::WGPUAddressMode_ClampToEdge;
-    sampler_desc.magFilter = WGPUFilterMode::WGPUFilterMode_Nearest;
-    sampler_desc.minFilter = WGPUFilterMode::WGPUFilterMode_Nearest;
-    sampler_desc.mipmapFilter = WGPUMipmapFilterMode::WGPUMipmapFilterMode_Nearest;
-    sampler_desc.lodMinClamp = 0.0f;
-    sampler_desc.lodMaxClamp = 1.0f;
-    sampler_desc.compare = WGPUCompareFunction::WGPUCompareFunction_Undefined;
-    sampler_desc.maxAnisotropy = 1;
-
-    m_output_texture = std::make_unique<webgpu::raii::TextureWithSampler>(m_ctx->device(), texture_desc, sampler_desc);
-    auto& tex = m_output_texture->texture();
-
-    // store them in this context, otherwise they get deleted too soon (might not be necessary...)
-    std::map<size_t, nucleus::Raster<glm::u8vec4>> images;
-    // Load the tiles and upload them directly to the gpu texture
+    // decoding the pngs is the expensive part, it runs on the thread pool. the inputs are copied (the byte arrays are implicitly shared).
+    struct DecodedTiles {
+        std::vector<radix::tile::Id> ids;
+        std::vector<QByteArray> data;
+        std::vector<nucleus::Raster<glm::u8vec4>> images;
+        std::string error;
+    };
+    auto decoded = std::make_shared<DecodedTiles>();
     for (size_t i = 0; i < tile_ids.size(); i++) {
-        const auto& tile_id = tile_ids[i];
-        const auto& texture_data = textures[i];
-
-        if (tile_id.zoom_level != zl)
+        if (tile_ids[i].zoom_level != zl)
             continue;
-
-        // Calculate the position of the tile in the stitched image
-        glm::uvec2 pos = glm::uvec2(tile_id.coords.x - bounds.x, tile_id.coords.y - bounds.y) * s;
-        if (m_settings.stitch_inverted_y) {
-            pos.y = size_pixels.y - pos.y - s.y;
-        }
-
-        // Load image (NOTE: Only supports u8vec4 so far)
-        images[i] = nucleus::utils::image_loader::rgba8(texture_data).value();
-        const auto& image = images[i];
-        assert(image.width() == so.x && image.height() == so.y);
-
-        WGPUTexelCopyTextureInfo image_copy_texture {};
-        image_copy_texture.texture = tex.handle();
-        image_copy_texture.aspect = WGPUTextureAspect::WGPUTextureAspect_All;
-        image_copy_texture.mipLevel = 0;
-        image_copy_texture.origin = { pos.x, pos.y, 0 };
-
-        WGPUTexelCopyBufferLayout texture_data_layout {};
-        texture_data_layout.bytesPerRow = uint32_t(sizeof(glm::u8vec4) * so.x);
-        texture_data_layout.rowsPerImage = uint32_t(so.y);
-        texture_data_layout.offset = 0;
-
-        WGPUExtent3D copy_extent {};
-        copy_extent.width = s.x;
-        copy_extent.height = s.y;
-        copy_extent.depthOrArrayLayers = 1;
-
-        wgpuQueueWriteTexture(m_ctx->queue(), &image_copy_texture, image.bytes(), uint32_t(image.size_in_bytes()), &texture_data_layout, &copy_extent);
+        decoded->ids.push_back(tile_ids[i]);
+        decoded->data.push_back(textures[i]);
     }
+    const auto work = [decoded, so]() {
+        decoded->images.reserve(decoded->data.size());
+        for (const auto& texture_data : decoded->data) {
+            // Load image (NOTE: Only supports u8vec4 so far)
+            auto image = nucleus::utils::image_loader::rgba8(texture_data);
+            if (!image.has_value() || image->width() != so.x || image->height() != so.y) {
+                decoded->error = "Failed to decode a tile of size " + std::to_string(so.x) + "x" + std::to_string(so.y);
+                return;
+            }
+            decoded->images.push_back(std::move(image.value()));
+        }
+        decoded->data.clear();
+    };
+    run_on_thread_pool(work, [this, decoded, so, s, bounds, size_pixels]() {
+        if (!decoded->error.empty()) {
+            fail_run(decoded->error);
+            return;
+        }
 
-    complete_run();
+        // create output texture
+        WGPUTextureDescriptor texture_desc {};
+        texture_desc.label = WGPUStringView { .data = "compute storage texture", .length = WGPU_STRLEN };
+        texture_desc.dimension = WGPUTextureDimension::WGPUTextureDimension_2D;
+        texture_desc.size = { size_pixels.x, size_pixels.y, 1 };
+        texture_desc.mipLevelCount = 1;
+        texture_desc.sampleCount = 1;
+        texture_desc.format = m_settings.texture_format;
+        texture_desc.usage = m_settings.texture_usage;
+
+        WGPUSamplerDescriptor sampler_desc {};
+        sampler_desc.label = WGPUStringView { .data = "compute storage sampler", .length = WGPU_STRLEN };
+        sampler_desc.addressModeU = WGPUAddressMode::WGPUAddressMode_ClampToEdge;
+        sampler_desc.addressModeV = WGPUAddressMode::WGPUAddressMode_ClampToEdge;
+        sampler_desc.addressModeW = WGPUAddressMode::WGPUAddressMode_ClampToEdge;
+        sampler_desc.magFilter = WGPUFilterMode::WGPUFilterMode_Nearest;
+        sampler_desc.minFilter = WGPUFilterMode::WGPUFilterMode_Nearest;
+        sampler_desc.mipmapFilter = WGPUMipmapFilterMode::WGPUMipmapFilterMode_Nearest;
+        sampler_desc.lodMinClamp = 0.0f;
+        sampler_desc.lodMaxClamp = 1.0f;
+        sampler_desc.compare = WGPUCompareFunction::WGPUCompareFunction_Undefined;
+        sampler_desc.maxAnisotropy = 1;
+
+        m_output_texture = std::make_unique<webgpu::raii::TextureWithSampler>(m_ctx->device(), texture_desc, sampler_desc);
+        auto& tex = m_output_texture->texture();
+
+        // upload the decoded tiles directly to the gpu texture
+        for (size_t i = 0; i < decoded->ids.size(); i++) {
+            const auto& tile_id = decoded->ids[i];
+            const auto& image = decoded->images[i];
+
+            // Calculate the position of the tile in the stitched image
+            glm::uvec2 pos = glm::uvec2(tile_id.coords.x - bounds.x, tile_id.coords.y - bounds.y) * s;
+            if (m_settings.stitch_inverted_y) {
+                pos.y = size_pixels.y - pos.y - s.y;
+            }
+
+            WGPUTexelCopyTextureInfo image_copy_texture {};
+            image_copy_texture.texture = tex.handle();
+            image_copy_texture.aspect = WGPUTextureAspect::WGPUTextureAspect_All;
+            image_copy_texture.mipLevel = 0;
+            image_copy_texture.origin = { pos.x, pos.y, 0 };
+
+            WGPUTexelCopyBufferLayout texture_data_layout {};
+            texture_data_layout.bytesPerRow = uint32_t(sizeof(glm::u8vec4) * so.x);
+            texture_data_layout.rowsPerImage = uint32_t(so.y);
+            texture_data_layout.offset = 0;
+
+            WGPUExtent3D copy_extent {};
+            copy_extent.width = s.x;
+            copy_extent.height = s.y;
+            copy_extent.depthOrArrayLayers = 1;
+
+            wgpuQueueWriteTexture(m_ctx->queue(), &image_copy_texture, image.bytes(), uint32_t(image.size_in_bytes()), &texture_data_layout, &copy_extent);
+        }
 
-    // Weird that this works here. Is wgpuQueueWriteTexture blocking after all?
-    // m_output_texture->texture().save_to_file(m_ctx->device(), "C:\\tmp\\asd.png");
+        complete_run();
+    });
 }
 
 void TileStitchNode::serialize_settings(QJsonObject& out) const
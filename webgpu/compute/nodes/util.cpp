@@ -21,6 +21,7 @@
 
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
 #include <QJsonDocument>
 
 namespace webgpu_compute::nodes {
@@ -232,6 +233,17 @@ nucleus::tile::TileLoadService::UrlPattern url_pattern_from_string(const QString
     return fallback;
 }
 
+// ---- file inputs ----
+
+void serialize_file_state(const std::string& path, QJsonObject& out)
+{
+    const QFileInfo info(QString::fromStdString(path));
+    if (!info.exists())
+        return;
+    out["file_size"] = QString::number(info.size());
+    out["file_last_modified"] = QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
 // ---- glm helpers ----
 
 QJsonArray vec2_to_json(glm::vec2 v) { return { static_cast<double>(v.x), static_cast<double>(v.y) }; }
@@ -51,6 +51,11 @@ WGPUMipmapFilterMode wgpu_mipmap_filter_mode_from_string(const QString& str, WGP
 QString url_pattern_to_string(nucleus::tile::TileLoadService::UrlPattern pattern);
 nucleus::tile::TileLoadService::UrlPattern url_pattern_from_string(const QString& str, nucleus::tile::TileLoadService::UrlPattern fallback);
 
+// ---- file inputs ----
+
+// Writes size and modification time of the file at path (or nothing if it doesn't exist), for the fingerprints of nodes that read files.
+void serialize_file_state(const std::string& path, QJsonObject& out);
+
 // ---- glm <-> JSON array helpers ----
 
 QJsonArray vec2_to_json(glm::vec2 v);
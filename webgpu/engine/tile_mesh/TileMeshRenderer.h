@@ -25,6 +25,7 @@
 #include <QObject>
 #include <nucleus/tile/GpuArrayHelper.h>
 #include <nucleus/tile/types.h>
+#include <nucleus/utils/terrain_mesh_index_generator.h>
 #include <webgpu/base/Buffer.h>
 #include <webgpu/base/Context.h>
 #include <webgpu/base/raii/BindGroup.h>
@@ -54,6 +55,8 @@ public:
 
     size_t capacity() const;
     void set_tile_limit(unsigned new_limit);
+    /// must be called before init
+    void set_index_layout(nucleus::utils::terrain_mesh_index_generator::Layout layout);
 
 signals:
     void tiles_changed();
@@ -71,6 +74,7 @@ private:
 
     webgpu::Context* m_ctx = nullptr;
 
+    nucleus::utils::terrain_mesh_index_generator::Layout m_index_layout = nucleus::utils::terrain_mesh_index_generator::Layout::CacheOptimisedList;
     size_t m_index_buffer_size;
     std::unique_ptr<webgpu::raii::RawBuffer<uint16_t>> m_index_buffer;
     std::unique_ptr<webgpu::raii::RawBuffer<glm::vec4>> m_bounds_buffer;
@@ -126,10 +126,20 @@ void TrackRenderer::init(webgpu::Context& ctx)
 
 void TrackRenderer::add_track(const Track& track, const glm::vec4& color)
 {
+    std::vector<double> x(track.size());
+    std::vector<double> y(track.size());
+    std::vector<double> z(track.size());
+    for (size_t i = 0; i < track.size(); ++i) {
+        x[i] = track[i].x;
+        y[i] = track[i].y;
+        z[i] = track[i].z;
+    }
+    nucleus::srs::lat_long_alt_to_world(x, y, z);
+
     std::vector<glm::fvec4> gpu_points;
     gpu_points.reserve(track.size());
-    for (const glm::dvec3& coords : track) {
-        gpu_points.push_back(glm::fvec4(nucleus::srs::lat_long_alt_to_world(coords), 1));
+    for (size_t i = 0; i < track.size(); ++i) {
+        gpu_points.push_back(glm::fvec4(x[i], y[i], z[i], 1));
     }
     add_world_positions(gpu_points, color);
 }